@@ -0,0 +1,306 @@
+#include "musket_components.h"
+#include <algorithm>
+#include <cmath>
+
+// ═══════════════════════════════════════════════════════════════
+// M7.5 §12.1: FORMATION LAYOUT + SLOT MATCHING
+//
+// Slots are in the battalion frame (-Z = forward, see
+// battalion_to_world). Each shape is one straight loop over the slot
+// index with no per-slot branches, so the compiler vectorizes it; the
+// Square picks its face from small per-side tables instead of an
+// if-chain. Spacing and rank rules are those of the original
+// order_formation; each layout is then shifted onto its own centroid,
+// because the anchor it hangs from is the members' live centroid.
+//
+// Matching is greedy: members are taken outermost-first (they have the
+// fewest nearby options) and each claims the nearest free slot through
+// a k-d tree over the slots that tracks free counts per subtree.
+// ═══════════════════════════════════════════════════════════════
+
+static constexpr float FORM_SP_X = 0.8f; // Shoulder-to-shoulder
+static constexpr float FORM_SP_Z = 1.2f; // Rank depth
+static constexpr int FORM_RANKS = 3;
+
+void FormationRoster::layout(int base, int n, FormationShape shape,
+                             float &ext_w, float &ext_d) {
+  if (n <= 0)
+    return;
+  float *sx = slot_x + base;
+  float *sz = slot_z + base;
+  int16_t *fx = slot_face_x + base;
+  int16_t *fz = slot_face_z + base;
+  uint8_t *rank = slot_rank + base;
+  uint8_t *shoot = slot_can_shoot + base;
+
+  if (shape == SHAPE_LINE) {
+    const int cols = (n + FORM_RANKS - 1) / FORM_RANKS;
+    const int half_cols = cols / 2;
+    for (int k = 0; k < n; k++) {
+      int r = k % FORM_RANKS;
+      int c = k / FORM_RANKS;
+      sx[k] = (float)(c - half_cols) * FORM_SP_X;
+      sz[k] = (float)r * FORM_SP_Z;
+      fx[k] = face_snorm(0.0f);
+      fz[k] = face_snorm(-1.0f);
+      rank[k] = (uint8_t)r;
+      shoot[k] = 1;
+    }
+    ext_w = (cols * FORM_SP_X) / 2.0f + 2.0f;
+    ext_d = (FORM_RANKS * FORM_SP_Z) / 2.0f + 2.0f;
+  } else if (shape == SHAPE_COLUMN) {
+    constexpr int cols = 16; // 16-wide column
+    const int ranks = (n + cols - 1) / cols;
+    for (int k = 0; k < n; k++) {
+      int r = k / cols;
+      int c = k % cols;
+      sx[k] = (float)(c - cols / 2) * FORM_SP_X;
+      sz[k] = (float)r * FORM_SP_Z;
+      fx[k] = face_snorm(0.0f);
+      fz[k] = face_snorm(-1.0f);
+      rank[k] = (uint8_t)(r < 255 ? r : 255);
+      shoot[k] = (uint8_t)(r == 0); // Only front rank fires
+    }
+    ext_w = (cols * FORM_SP_X) / 2.0f + 2.0f;
+    ext_d = (ranks * FORM_SP_Z) / 2.0f + 2.0f;
+  } else { // SHAPE_SQUARE
+    // Side s: slot = along·T[s] + out·N[s], facing N[s] (front, right,
+    // rear, left). Ranks step outward from the hollow centre.
+    static constexpr float T_X[4] = {1.0f, 0.0f, 1.0f, 0.0f};
+    static constexpr float T_Z[4] = {0.0f, 1.0f, 0.0f, 1.0f};
+    static constexpr float N_X[4] = {0.0f, 1.0f, 0.0f, -1.0f};
+    static constexpr float N_Z[4] = {-1.0f, 0.0f, 1.0f, 0.0f};
+    const int per_side = (n + 3) / 4;
+    const float half = (per_side * FORM_SP_X) / 2.0f;
+    for (int k = 0; k < n; k++) {
+      int side = k & 3;
+      int pos = k >> 2;
+      int r = pos % FORM_RANKS;
+      float along = (float)(pos - per_side / 2) * FORM_SP_X;
+      float out = half + (float)r * FORM_SP_Z;
+      sx[k] = along * T_X[side] + out * N_X[side];
+      sz[k] = along * T_Z[side] + out * N_Z[side];
+      fx[k] = face_snorm(N_X[side]);
+      fz[k] = face_snorm(N_Z[side]);
+      rank[k] = (uint8_t)r;
+      shoot[k] = (uint8_t)(r == 0); // Only outermost rank fires per face
+    }
+    ext_w = (per_side * FORM_SP_X) / 2.0f + 2.0f;
+    ext_d = ext_w;
+  }
+
+  float mean_x = 0.0f, mean_z = 0.0f;
+  for (int k = 0; k < n; k++) {
+    mean_x += sx[k];
+    mean_z += sz[k];
+  }
+  mean_x /= (float)n;
+  mean_z /= (float)n;
+  for (int k = 0; k < n; k++) {
+    sx[k] -= mean_x;
+    sz[k] -= mean_z;
+  }
+}
+
+// ── Implicit k-d tree over slots ──
+// The node for range [lo, hi) sits at tree position (lo + hi) / 2; its
+// box bounds the still-free slots of the whole range and `free` counts
+// them. Ranges of KD_LEAF slots or fewer are leaves that keep their free
+// slots packed at the front, so a leaf is one short linear scan; larger
+// ranges hold their middle slot and split on the wider axis.
+// Claiming a slot decrements free counts and refits the boxes along its
+// path, so searches prune on where free slots actually remain and stay
+// short even when only a far flank has room left.
+static constexpr int KD_LEAF = 32;
+
+static void kd_build(FormationKdNode *kd, int lo, int hi) {
+  if (lo >= hi)
+    return;
+  float min_x = 1e30f, max_x = -1e30f, min_z = 1e30f, max_z = -1e30f;
+  for (int k = lo; k < hi; k++) {
+    min_x = std::min(min_x, kd[k].x);
+    max_x = std::max(max_x, kd[k].x);
+    min_z = std::min(min_z, kd[k].z);
+    max_z = std::max(max_z, kd[k].z);
+  }
+  const uint8_t axis = (max_z - min_z) > (max_x - min_x) ? 1 : 0;
+  const int mid = (lo + hi) >> 1;
+  if (hi - lo > KD_LEAF) {
+    std::nth_element(
+        kd + lo, kd + mid, kd + hi,
+        [axis](const FormationKdNode &a, const FormationKdNode &b) {
+          return axis ? a.z < b.z : a.x < b.x;
+        });
+  }
+  FormationKdNode &node = kd[mid];
+  node.min_x = min_x;
+  node.max_x = max_x;
+  node.min_z = min_z;
+  node.max_z = max_z;
+  node.axis = axis;
+  node.free = hi - lo;
+  if (hi - lo > KD_LEAF) {
+    kd_build(kd, lo, mid);
+    kd_build(kd, mid + 1, hi);
+  }
+}
+
+// Refits one node's box over its free slots: a leaf from its slots, an
+// inner node from its own slot and its children's boxes. Returns false
+// when the box did not change (so neither will its ancestors').
+static bool kd_refit(FormationKdNode *kd, int lo, int hi) {
+  const int mid = (lo + hi) >> 1;
+  FormationKdNode &node = kd[mid];
+  if (node.free == 0)
+    return true; // Never visited again; the parent must still refit
+  float min_x = 1e30f, max_x = -1e30f, min_z = 1e30f, max_z = -1e30f;
+  if (hi - lo <= KD_LEAF) {
+    for (int k = lo; k < lo + node.free; k++) {
+      min_x = std::min(min_x, kd[k].x);
+      max_x = std::max(max_x, kd[k].x);
+      min_z = std::min(min_z, kd[k].z);
+      max_z = std::max(max_z, kd[k].z);
+    }
+  } else {
+    if (!node.used) {
+      min_x = max_x = node.x;
+      min_z = max_z = node.z;
+    }
+    const int child[2] = {(lo + mid) >> 1, (mid + 1 + hi) >> 1};
+    const bool has[2] = {lo < mid, mid + 1 < hi};
+    for (int c = 0; c < 2; c++) {
+      if (!has[c] || kd[child[c]].free == 0)
+        continue;
+      const FormationKdNode &ch = kd[child[c]];
+      min_x = std::min(min_x, ch.min_x);
+      max_x = std::max(max_x, ch.max_x);
+      min_z = std::min(min_z, ch.min_z);
+      max_z = std::max(max_z, ch.max_z);
+    }
+  }
+  if (min_x == node.min_x && max_x == node.max_x && min_z == node.min_z &&
+      max_z == node.max_z)
+    return false;
+  node.min_x = min_x;
+  node.max_x = max_x;
+  node.min_z = min_z;
+  node.max_z = max_z;
+  return true;
+}
+
+// Nearest free slot to (mx, mz); returns its tree position. Depth-first
+// with an explicit stack, nearer child first.
+static int kd_nearest(const FormationKdNode *kd, int n, float mx, float mz) {
+  int stack_lo[64], stack_hi[64], top = 0;
+  stack_lo[top] = 0;
+  stack_hi[top++] = n;
+  float best_d2 = 1e30f;
+  int best = -1;
+  while (top > 0) {
+    --top;
+    const int lo = stack_lo[top], hi = stack_hi[top];
+    const int mid = (lo + hi) >> 1;
+    const FormationKdNode &node = kd[mid];
+    if (node.free == 0)
+      continue;
+    float bx = std::max(0.0f, std::max(node.min_x - mx, mx - node.max_x));
+    float bz = std::max(0.0f, std::max(node.min_z - mz, mz - node.max_z));
+    if (bx * bx + bz * bz >= best_d2)
+      continue;
+
+    if (hi - lo <= KD_LEAF) {
+      for (int k = lo; k < lo + node.free; k++) {
+        float dx = kd[k].x - mx, dz = kd[k].z - mz;
+        float d2 = dx * dx + dz * dz;
+        if (d2 < best_d2) {
+          best_d2 = d2;
+          best = k;
+        }
+      }
+      continue;
+    }
+
+    if (!node.used) {
+      float dx = node.x - mx, dz = node.z - mz;
+      float d2 = dx * dx + dz * dz;
+      if (d2 < best_d2) {
+        best_d2 = d2;
+        best = mid;
+      }
+    }
+    bool near_left = (node.axis ? mz - node.z : mx - node.x) < 0.0f;
+    // Push the far child first so the near one is searched first
+    int far_lo = near_left ? mid + 1 : lo, far_hi = near_left ? hi : mid;
+    int near_lo = near_left ? lo : mid + 1, near_hi = near_left ? mid : hi;
+    if (far_lo < far_hi) {
+      stack_lo[top] = far_lo;
+      stack_hi[top++] = far_hi;
+    }
+    if (near_lo < near_hi) {
+      stack_lo[top] = near_lo;
+      stack_hi[top++] = near_hi;
+    }
+  }
+  return best;
+}
+
+void FormationRoster::match(int base, int n) {
+  if (n <= 0)
+    return;
+
+  FormationKdNode *tree = kd + base;
+  for (int k = 0; k < n; k++) {
+    tree[k].x = slot_x[base + k];
+    tree[k].z = slot_z[base + k];
+    tree[k].slot = base + k;
+    tree[k].used = 0;
+  }
+  kd_build(tree, 0, n);
+
+  // ── Outermost members first ──
+  for (int m = 0; m < n; m++) {
+    float x = member_x[base + m], z = member_z[base + m];
+    match_key[base + m] = -(x * x + z * z);
+    match_order[base + m] = base + m;
+  }
+  const float *key = match_key;
+  std::sort(match_order + base, match_order + base + n,
+            [key](int32_t a, int32_t b) { return key[a] < key[b]; });
+
+  // ── Greedy nearest free slot ──
+  for (int o = base; o < base + n; o++) {
+    const int m = match_order[o];
+    // n members, n slots: a free slot always exists
+    const int pos = kd_nearest(tree, n, member_x[m], member_z[m]);
+
+    // Claim it: decrement free counts root → node (a leaf swaps the slot
+    // out of its free prefix, an inner node marks it used), then refit
+    // the boxes back up the same path
+    assigned[m] = tree[pos].slot;
+    int path_lo[32], path_hi[32], depth = 0;
+    int lo = 0, hi = n;
+    for (;;) {
+      int mid = (lo + hi) >> 1;
+      tree[mid].free--;
+      path_lo[depth] = lo;
+      path_hi[depth++] = hi;
+      if (hi - lo <= KD_LEAF) {
+        int last = lo + tree[mid].free;
+        std::swap(tree[pos].x, tree[last].x);
+        std::swap(tree[pos].z, tree[last].z);
+        std::swap(tree[pos].slot, tree[last].slot);
+        break;
+      }
+      if (mid == pos) {
+        tree[pos].used = 1;
+        break;
+      }
+      if (pos < mid)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    while (depth-- > 0 && kd_refit(tree, path_lo[depth], path_hi[depth])) {
+    }
+  }
+}
@@ -0,0 +1,855 @@
+#include "macro_sync.h"
+#include "musket_systems.h"
+#include "sim_profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace musket {
+
+// ═══════════════════════════════════════════════════════════════
+// MACRO-SYNC WIRE FORMAT (little-endian, version 1)
+//
+//   u8 magic 'M'  u8 version  u32 seq  u32 baseline_seq (0 = full)
+//   u32 tick
+//   BATTALIONS  varint id_end, u16 count, count × record:
+//               varint id gap, u8 field mask, changed fields
+//               (id_end covers the baseline's ids too, so removals
+//               past the current live end stay below it)
+//   GRIDS       u8 layer mask, per changed layer: (varint skip,
+//               varint len, len × u8 delta) pairs until 4096 cells
+//   DEATHS      varint groups, per battalion: varint id gap,
+//               varint n, n × varint slot gap (sorted)
+//
+// Positions, facing and alive counts go as zigzag varint deltas from
+// the baseline record (from zero when there is none): a battalion
+// marching at 1.5m/s moves ~1 step per snapshot, one byte per axis.
+// Grid layers go as byte deltas with zero runs skipped; unchanged gaps
+// shorter than three cells stay inside a literal run.
+// ═══════════════════════════════════════════════════════════════
+
+static constexpr uint8_t MACRO_SYNC_MAGIC = 'M';
+static constexpr uint8_t MACRO_SYNC_VERSION = 1;
+static constexpr int MACRO_SYNC_MIN_SKIP = 3; // Cells before a run splits
+
+enum MacroSnapField : uint8_t {
+  SNAP_CENTROID = 1 << 0,
+  SNAP_ANCHOR = 1 << 1,
+  SNAP_FACING = 1 << 2,
+  SNAP_ALIVE = 1 << 3,
+  SNAP_TEAM = 1 << 4, // Alone with team = ABSENT: battalion removed
+  SNAP_MODE = 1 << 5,
+  SNAP_COHESION = 1 << 6,
+  SNAP_COMMAND = 1 << 7
+};
+
+static constexpr float TWO_PI = 6.28318530718f;
+
+void MacroSnap::facing_dir(float &dir_x, float &dir_z) const {
+  float a = facing * (TWO_PI / 65536.0f);
+  dir_x = std::sin(a);
+  dir_z = std::cos(a);
+}
+
+static MacroSnap absent_snap() {
+  MacroSnap s = {};
+  s.team = MACRO_SYNC_ABSENT;
+  return s;
+}
+
+static void clear_frame(MacroSyncFrame &f) {
+  const MacroSnap absent = absent_snap();
+  for (int i = 0; i < MAX_BATTALIONS; i++)
+    f.bat[i] = absent;
+  std::memset(f.grid, 0, sizeof(f.grid));
+  f.id_end = 0;
+}
+
+// ── Ring storage ───────────────────────────────────────────────
+void MacroSyncHistory::allocate() {
+  frames = new MacroSyncFrame[MACRO_SYNC_HISTORY](); // seq 0 = empty
+  deaths = new MacroSyncDeath[MACRO_SYNC_DEATH_LOG]();
+  death_total = 0;
+  latest_seq = 0;
+}
+
+void MacroSyncHistory::release() {
+  delete[] frames;
+  delete[] deaths;
+  frames = nullptr;
+  deaths = nullptr;
+}
+
+const MacroSyncFrame *MacroSyncHistory::find(uint32_t seq) const {
+  if (seq == 0 || !frames)
+    return nullptr;
+  const MacroSyncFrame &f = frames[seq % MACRO_SYNC_HISTORY];
+  return f.seq == seq ? &f : nullptr;
+}
+
+void MacroSyncReceiver::allocate() {
+  frames = new MacroSyncFrame[MACRO_SYNC_HISTORY]();
+  deaths = new MacroSyncDeath[MACRO_SYNC_DEATH_LOG]();
+  death_count = 0;
+  latest_seq = 0;
+}
+
+void MacroSyncReceiver::release() {
+  delete[] frames;
+  delete[] deaths;
+  frames = nullptr;
+  deaths = nullptr;
+}
+
+const MacroSyncFrame *MacroSyncReceiver::find(uint32_t seq) const {
+  if (seq == 0 || !frames)
+    return nullptr;
+  const MacroSyncFrame &f = frames[seq % MACRO_SYNC_HISTORY];
+  return f.seq == seq ? &f : nullptr;
+}
+
+// ── Quantization ───────────────────────────────────────────────
+static inline int16_t quant_pos(double v) {
+  double q = std::round(v * MACRO_SYNC_POS_SCALE);
+  q = q < -32768.0 ? -32768.0 : (q > 32767.0 ? 32767.0 : q);
+  return (int16_t)q;
+}
+
+static inline uint8_t quant_unit(float v) {
+  if (!(v > 0.0f))
+    return 0;
+  return v >= 1.0f ? 255 : (uint8_t)(v * 255.0f + 0.5f);
+}
+
+static inline uint16_t quant_angle(float dir_x, float dir_z) {
+  if (dir_x == 0.0f && dir_z == 0.0f)
+    return 0;
+  double turns = std::atan2((double)dir_x, (double)dir_z) / TWO_PI;
+  return (uint16_t)(int32_t)std::lround(turns * 65536.0); // Wraps mod 2^16
+}
+
+// ═══════════════════════════════════════════════════════════════
+// CAPTURE (server, 10Hz)
+// ═══════════════════════════════════════════════════════════════
+uint32_t capture_macro_sync(MacroSyncHistory &h, uint64_t tick,
+                            const PanicGrid *panic, const CivicGrid *civic) {
+  if (!h.frames)
+    return 0;
+  const uint32_t seq = h.latest_seq + 1;
+  MacroSyncFrame &f = h.frames[seq % MACRO_SYNC_HISTORY];
+  clear_frame(f);
+
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const int id = g_battalion_pool.live[k];
+    const MacroBattalion &mb = g_macro_battalions[id];
+    if (mb.alive_count <= 0)
+      continue; // Emptied: reclaimed next tick, clients drop it now
+    MacroSnap &s = f.bat[id];
+    s.cx = quant_pos(mb.cx);
+    s.cz = quant_pos(mb.cz);
+    s.ax = quant_pos(mb.anchor_x);
+    s.az = quant_pos(mb.anchor_z);
+    s.facing = quant_angle(mb.dir_x, mb.dir_z);
+    s.alive = (uint16_t)std::min(mb.alive_count, 65535);
+    s.team = (uint8_t)std::min<uint32_t>(mb.team_id, MACRO_SYNC_ABSENT - 1);
+    s.mode = (uint8_t)((mb.fire_discipline & 0x0F) | (mb.shape << 4));
+    s.cohesion = quant_unit(mb.flag_cohesion);
+    s.command = (uint8_t)((mb.flag_alive ? 1 : 0) |
+                          (mb.drummer_alive ? 2 : 0) |
+                          (mb.officer_alive ? 4 : 0));
+    f.id_end = (uint16_t)(id + 1); // Live list is ascending
+  }
+
+  if (panic) {
+    for (int t = 0; t < PanicGrid::TEAMS; t++)
+      for (int c = 0; c < MACRO_SYNC_CELLS; c++)
+        f.grid[t][c] = quant_unit(panic->read_buf[t][c]);
+  }
+  if (civic) {
+    for (int c = 0; c < MACRO_SYNC_CELLS; c++) {
+      f.grid[2][c] = quant_unit(civic->market_access[c]);
+      f.grid[3][c] = quant_unit(civic->pollution[c]); // Overlay: saturates
+    }
+  }
+
+  f.tick = (uint32_t)tick;
+  f.death_end = h.death_total;
+  f.seq = seq;
+  h.latest_seq = seq;
+  return seq;
+}
+
+void log_macro_sync_death(MacroSyncHistory &h, uint32_t bat, uint32_t slot) {
+  if (!h.deaths)
+    return; // Released (world teardown removes IsAlive from everyone)
+  MacroSyncDeath &d = h.deaths[h.death_total % MACRO_SYNC_DEATH_LOG];
+  d.slot = slot;
+  d.bat = (uint16_t)bat;
+  d.pad = 0;
+  h.death_total++;
+}
+
+// ── Byte stream primitives ─────────────────────────────────────
+struct SyncWriter {
+  uint8_t *p;
+  uint8_t *end;
+
+  inline void u8(uint8_t v) {
+    if (p < end)
+      *p++ = v;
+  }
+  inline void u16(uint16_t v) {
+    u8((uint8_t)v);
+    u8((uint8_t)(v >> 8));
+  }
+  inline void u32(uint32_t v) {
+    u16((uint16_t)v);
+    u16((uint16_t)(v >> 16));
+  }
+  inline void varint(uint32_t v) {
+    while (v >= 0x80) {
+      u8((uint8_t)(v | 0x80));
+      v >>= 7;
+    }
+    u8((uint8_t)v);
+  }
+  inline void zigzag(int32_t v) {
+    varint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+  }
+};
+
+struct SyncReader {
+  const uint8_t *p;
+  const uint8_t *end;
+  bool bad = false;
+
+  inline uint8_t u8() {
+    if (p >= end) {
+      bad = true;
+      return 0;
+    }
+    return *p++;
+  }
+  inline uint16_t u16() {
+    uint16_t lo = u8();
+    return (uint16_t)(lo | (u8() << 8));
+  }
+  inline uint32_t u32() {
+    uint32_t lo = u16();
+    return lo | ((uint32_t)u16() << 16);
+  }
+  inline uint32_t varint() {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      uint8_t b = u8();
+      v |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80))
+        return v;
+    }
+    bad = true;
+    return 0;
+  }
+  inline int32_t zigzag() {
+    uint32_t v = varint();
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+  }
+};
+
+// ═══════════════════════════════════════════════════════════════
+// ENCODE
+// ═══════════════════════════════════════════════════════════════
+static uint8_t snap_diff(const MacroSnap &c, const MacroSnap &b) {
+  if (c.team == MACRO_SYNC_ABSENT)
+    return b.team == MACRO_SYNC_ABSENT ? 0 : SNAP_TEAM;
+  uint8_t mask = 0;
+  if (c.cx != b.cx || c.cz != b.cz)
+    mask |= SNAP_CENTROID;
+  if (c.ax != b.ax || c.az != b.az)
+    mask |= SNAP_ANCHOR;
+  if (c.facing != b.facing)
+    mask |= SNAP_FACING;
+  if (c.alive != b.alive)
+    mask |= SNAP_ALIVE;
+  if (c.team != b.team)
+    mask |= SNAP_TEAM;
+  if (c.mode != b.mode)
+    mask |= SNAP_MODE;
+  if (c.cohesion != b.cohesion)
+    mask |= SNAP_COHESION;
+  if (c.command != b.command)
+    mask |= SNAP_COMMAND;
+  return mask;
+}
+
+static void encode_layer(SyncWriter &w, const uint8_t *cur,
+                         const uint8_t *base) {
+  int i = 0;
+  while (i < MACRO_SYNC_CELLS) {
+    int start = i;
+    while (start < MACRO_SYNC_CELLS && cur[start] == base[start])
+      start++;
+    if (start == MACRO_SYNC_CELLS) { // Unchanged tail
+      w.varint((uint32_t)(start - i));
+      w.varint(0);
+      return;
+    }
+    int end = start + 1;
+    while (end < MACRO_SYNC_CELLS) {
+      if (cur[end] != base[end]) {
+        end++;
+        continue;
+      }
+      int gap = 0;
+      while (end + gap < MACRO_SYNC_CELLS && cur[end + gap] == base[end + gap])
+        gap++;
+      if (gap >= MACRO_SYNC_MIN_SKIP || end + gap == MACRO_SYNC_CELLS)
+        break;
+      end += gap; // Short gap: cheaper inside the literal
+    }
+    w.varint((uint32_t)(start - i));
+    w.varint((uint32_t)(end - start));
+    for (int c = start; c < end; c++)
+      w.u8((uint8_t)(cur[c] - base[c]));
+    i = end;
+  }
+}
+
+static bool death_less(const MacroSyncDeath &a, const MacroSyncDeath &b) {
+  return a.bat != b.bat ? a.bat < b.bat : a.slot < b.slot;
+}
+
+size_t encode_macro_sync(const MacroSyncHistory &h, uint32_t seq,
+                         uint32_t baseline_seq, std::vector<uint8_t> &out) {
+  const MacroSyncFrame *cur = h.find(seq);
+  if (!cur) {
+    out.clear();
+    return 0;
+  }
+  const MacroSyncFrame *base =
+      baseline_seq < seq ? h.find(baseline_seq) : nullptr;
+  // Deaths after the baseline must still be in the log
+  if (base && h.death_total > (uint64_t)MACRO_SYNC_DEATH_LOG &&
+      base->death_end < h.death_total - MACRO_SYNC_DEATH_LOG)
+    base = nullptr;
+
+  out.resize(MACRO_SYNC_MAX_BYTES); // No-op once the buffer has grown
+  SyncWriter w = {out.data(), out.data() + out.size()};
+
+  w.u8(MACRO_SYNC_MAGIC);
+  w.u8(MACRO_SYNC_VERSION);
+  w.u32(seq);
+  w.u32(base ? base->seq : 0);
+  w.u32(cur->tick);
+
+  // ── Battalions ──
+  static const MacroSnap absent = absent_snap();
+  const int id_end = std::max<int>(cur->id_end, base ? base->id_end : 0);
+  w.varint((uint32_t)id_end);
+  uint8_t *count_at = w.p;
+  w.u16(0);
+  int count = 0, prev = -1;
+  for (int id = 0; id < id_end; id++) {
+    const MacroSnap &c = cur->bat[id];
+    const MacroSnap &b = base ? base->bat[id] : absent;
+    const uint8_t mask = snap_diff(c, b);
+    if (!mask)
+      continue;
+    // Fields of a new battalion are deltas from the all-zero absent
+    // record; a removal is the team byte alone
+    const MacroSnap &from = b.team == MACRO_SYNC_ABSENT ? absent : b;
+    w.varint((uint32_t)(id - prev - 1));
+    w.u8(mask);
+    if (mask & SNAP_TEAM)
+      w.u8(c.team);
+    if (mask & SNAP_CENTROID) {
+      w.zigzag(c.cx - from.cx);
+      w.zigzag(c.cz - from.cz);
+    }
+    if (mask & SNAP_ANCHOR) {
+      w.zigzag(c.ax - from.ax);
+      w.zigzag(c.az - from.az);
+    }
+    if (mask & SNAP_FACING)
+      w.zigzag((int16_t)(uint16_t)(c.facing - from.facing)); // Short way
+    if (mask & SNAP_ALIVE)
+      w.zigzag((int32_t)c.alive - (int32_t)from.alive);
+    if (mask & SNAP_MODE)
+      w.u8(c.mode);
+    if (mask & SNAP_COHESION)
+      w.u8(c.cohesion);
+    if (mask & SNAP_COMMAND)
+      w.u8(c.command);
+    prev = id;
+    count++;
+  }
+  count_at[0] = (uint8_t)count;
+  count_at[1] = (uint8_t)(count >> 8);
+
+  // ── Grids ──
+  static const uint8_t zero_layer[MACRO_SYNC_CELLS] = {};
+  uint8_t layer_mask = 0;
+  for (int l = 0; l < MACRO_SYNC_LAYERS; l++) {
+    const uint8_t *b = base ? base->grid[l] : zero_layer;
+    if (std::memcmp(cur->grid[l], b, MACRO_SYNC_CELLS) != 0)
+      layer_mask |= (uint8_t)(1 << l);
+  }
+  w.u8(layer_mask);
+  for (int l = 0; l < MACRO_SYNC_LAYERS; l++) {
+    if (layer_mask & (1 << l))
+      encode_layer(w, cur->grid[l], base ? base->grid[l] : zero_layer);
+  }
+
+  // ── Deaths (only on top of a baseline: a full snapshot resets the
+  // client, which rebuilds from alive counts) ──
+  static MacroSyncDeath batch[MACRO_SYNC_DEATH_LOG];
+  int n = 0;
+  if (base) {
+    for (uint64_t k = base->death_end; k < cur->death_end; k++)
+      batch[n++] = h.deaths[k % MACRO_SYNC_DEATH_LOG];
+    std::sort(batch, batch + n, death_less);
+  }
+  int groups = 0;
+  for (int i = 0; i < n; i++)
+    groups += (i == 0 || batch[i].bat != batch[i - 1].bat);
+  w.varint((uint32_t)groups);
+  int prev_bat = -1;
+  for (int i = 0; i < n;) {
+    int j = i;
+    while (j < n && batch[j].bat == batch[i].bat)
+      j++;
+    w.varint((uint32_t)(batch[i].bat - prev_bat - 1));
+    w.varint((uint32_t)(j - i));
+    uint32_t prev_slot = 0;
+    for (int k = i; k < j; k++) {
+      w.varint(batch[k].slot - prev_slot);
+      prev_slot = batch[k].slot;
+    }
+    prev_bat = batch[i].bat;
+    i = j;
+  }
+
+  const size_t bytes = (size_t)(w.p - out.data());
+  out.resize(bytes);
+  return bytes;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// DECODE (client)
+// ═══════════════════════════════════════════════════════════════
+static bool decode_layer(SyncReader &in, uint8_t *layer) {
+  int i = 0;
+  while (i < MACRO_SYNC_CELLS) {
+    const uint32_t skip = in.varint();
+    const uint32_t len = in.varint();
+    if (in.bad || skip + len == 0 ||
+        skip + len > (uint32_t)(MACRO_SYNC_CELLS - i))
+      return false;
+    i += (int)skip;
+    for (uint32_t c = 0; c < len; c++)
+      layer[i++] += in.u8();
+  }
+  return !in.bad;
+}
+
+const MacroSyncFrame *decode_macro_sync(MacroSyncReceiver &r,
+                                        const uint8_t *data, size_t size) {
+  SyncReader in = {data, data + size};
+  if (in.u8() != MACRO_SYNC_MAGIC || in.u8() != MACRO_SYNC_VERSION)
+    return nullptr;
+  const uint32_t seq = in.u32();
+  const uint32_t baseline = in.u32();
+  const uint32_t tick = in.u32();
+  if (in.bad || seq == 0 || seq + MACRO_SYNC_HISTORY <= r.latest_seq)
+    return nullptr; // Too old to keep: its slot belongs to a newer frame
+
+  const MacroSyncFrame *base = nullptr;
+  if (baseline != 0) {
+    if (baseline >= seq || seq - baseline >= (uint32_t)MACRO_SYNC_HISTORY)
+      return nullptr;
+    base = r.find(baseline);
+    if (!base)
+      return nullptr;
+  }
+
+  MacroSyncFrame &f = r.frames[seq % MACRO_SYNC_HISTORY];
+  if (base)
+    std::memcpy(&f, base, sizeof(MacroSyncFrame));
+  else
+    clear_frame(f);
+  f.seq = 0; // Not a baseline until fully decoded
+  f.tick = tick;
+  f.death_end = 0;
+
+  // ── Battalions ──
+  static const MacroSnap absent = absent_snap();
+  const uint32_t id_end = in.varint();
+  const int count = in.u16();
+  if (id_end > (uint32_t)MAX_BATTALIONS || (uint32_t)count > id_end)
+    return nullptr;
+  int id = -1;
+  for (int k = 0; k < count && !in.bad; k++) {
+    // Gaps are checked before they are added: a huge varint must not
+    // wrap id negative
+    const uint32_t gap = in.varint();
+    if (gap >= (uint32_t)((int)id_end - 1 - id))
+      return nullptr;
+    id += (int)gap + 1;
+    const uint8_t mask = in.u8();
+    MacroSnap &s = f.bat[id];
+    if (mask & SNAP_TEAM) {
+      const uint8_t team = in.u8();
+      if (team == MACRO_SYNC_ABSENT) {
+        s = absent;
+        continue;
+      }
+      if (s.team == MACRO_SYNC_ABSENT)
+        s = {}; // New battalion: deltas from the zero record
+      s.team = team;
+    }
+    if (mask & SNAP_CENTROID) {
+      s.cx = (int16_t)(s.cx + in.zigzag());
+      s.cz = (int16_t)(s.cz + in.zigzag());
+    }
+    if (mask & SNAP_ANCHOR) {
+      s.ax = (int16_t)(s.ax + in.zigzag());
+      s.az = (int16_t)(s.az + in.zigzag());
+    }
+    if (mask & SNAP_FACING)
+      s.facing = (uint16_t)(s.facing + in.zigzag());
+    if (mask & SNAP_ALIVE)
+      s.alive = (uint16_t)(s.alive + in.zigzag());
+    if (mask & SNAP_MODE)
+      s.mode = in.u8();
+    if (mask & SNAP_COHESION)
+      s.cohesion = in.u8();
+    if (mask & SNAP_COMMAND)
+      s.command = in.u8();
+  }
+  int live_end = (int)id_end;
+  while (live_end > 0 && f.bat[live_end - 1].team == MACRO_SYNC_ABSENT)
+    live_end--;
+  f.id_end = (uint16_t)live_end;
+
+  // ── Grids ──
+  const uint8_t layer_mask = in.u8();
+  for (int l = 0; l < MACRO_SYNC_LAYERS; l++) {
+    if ((layer_mask & (1 << l)) && !decode_layer(in, f.grid[l]))
+      return nullptr;
+  }
+
+  // ── Deaths ──
+  r.death_count = 0;
+  const uint32_t groups = in.varint();
+  int bat = -1;
+  for (uint32_t g = 0; g < groups && !in.bad; g++) {
+    const uint32_t gap = in.varint();
+    if (gap >= (uint32_t)(MAX_BATTALIONS - 1 - bat))
+      return nullptr;
+    bat += (int)gap + 1;
+    const uint32_t n = in.varint();
+    if (n > (uint32_t)MACRO_SYNC_DEATH_LOG)
+      return nullptr;
+    uint32_t slot = 0;
+    for (uint32_t k = 0; k < n && !in.bad; k++) {
+      slot += in.varint();
+      if (r.death_count < MACRO_SYNC_DEATH_LOG)
+        r.deaths[r.death_count++] = {slot, (uint16_t)bat, 0};
+    }
+  }
+  if (in.bad)
+    return nullptr;
+
+  f.seq = seq;
+  if (seq > r.latest_seq)
+    r.latest_seq = seq;
+  return &f;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// REGISTRATION
+// ═══════════════════════════════════════════════════════════════
+void register_macro_sync(flecs::world &ecs) {
+  MacroSyncHistory h = {};
+  h.allocate();
+  ecs.set<MacroSyncHistory>(h);
+
+  // Last phase of the tick: captures what this tick's systems produced
+  ecs.system("MacroSyncCapture")
+      .kind(flecs::OnStore)
+      .tick_source(sim_group_source(ecs, SIM_GROUP_NET))
+      .run([](flecs::iter &it) {
+        flecs::world w = it.world();
+        const SimClock *clock = w.try_get<SimClock>();
+        capture_macro_sync(w.get_mut<MacroSyncHistory>(),
+                           clock ? clock->tick : 0, w.try_get<PanicGrid>(),
+                           w.try_get<CivicGrid>());
+      });
+
+  ecs.observer<const RenderSlot>("MacroSyncDeathLog")
+      .event(flecs::OnRemove)
+      .with<IsAlive>()
+      .each([](flecs::entity e, const RenderSlot &rs) {
+        log_macro_sync_death(e.world().get_mut<MacroSyncHistory>(),
+                             rs.battalion_id, rs.mm_slot);
+      });
+}
+
+// ═══════════════════════════════════════════════════════════════
+// CLIENT VISUAL ECS
+// ═══════════════════════════════════════════════════════════════
+void MacroSyncClient::allocate() {
+  rx = {};
+  rx.allocate();
+  bat = new VisualBattalionSlots[MAX_BATTALIONS]();
+  applied_seq = 0;
+  id_end = 0;
+  play_tick = 0.0;
+  picked = 0;
+}
+
+void MacroSyncClient::release() {
+  rx.release();
+  delete[] bat;
+  bat = nullptr;
+}
+
+static SoldierFormationTarget visual_target(const FormationRoster &r, int k) {
+  SoldierFormationTarget t = {};
+  t.offset_x = r.slot_x[k];
+  t.offset_z = r.slot_z[k];
+  t.base_stiffness = 50.0f;
+  t.damping_multiplier = 2.0f;
+  t.face_x = r.slot_face_x[k];
+  t.face_z = r.slot_face_z[k];
+  t.can_shoot = r.slot_can_shoot[k] != 0;
+  t.rank_index = r.slot_rank[k];
+  return t;
+}
+
+// Lays the battalion out for alive + add soldiers in the snapshot's
+// shape. Survivors keep their order (the k-th living slot takes layout
+// slot k); the `add` new soldiers take the tail, standing in place.
+static void layout_visual(flecs::world &ecs, uint32_t id, const MacroSnap &s,
+                          VisualBattalionSlots &vb, int add) {
+  FormationRoster &r = ecs.get_mut<FormationRoster>();
+  const int total = std::min(vb.alive + add, FORMATION_ROSTER_CAPACITY);
+  add = std::max(total - vb.alive, 0);
+  float ext_w, ext_d;
+  r.layout(0, total, s.shape(), ext_w, ext_d);
+  vb.shape = (uint8_t)s.shape();
+
+  int k = 0;
+  for (size_t slot = 0; slot < vb.entity.size(); slot++) {
+    if (vb.living[slot])
+      ecs.entity(vb.entity[slot])
+          .set<SoldierFormationTarget>(visual_target(r, k++));
+  }
+  if (add == 0)
+    return;
+
+  float dir_x, dir_z;
+  s.facing_dir(dir_x, dir_z);
+  std::vector<Position> pos(add);
+  std::vector<SoldierFormationTarget> target(add);
+  for (int j = 0; j < add; j++, k++) {
+    target[j] = visual_target(r, k);
+    float gx, gz;
+    battalion_to_world(r.slot_x[k], r.slot_z[k], dir_x, dir_z, gx, gz);
+    pos[j] = {s.anchor_x() + gx, s.anchor_z() + gz};
+  }
+
+  InfantryBlock block = {};
+  block.count = add;
+  block.bat_id = id;
+  block.team = s.team;
+  block.first_slot = (uint32_t)vb.entity.size();
+  block.pos = pos.data();
+  block.target = target.data();
+  block.stats = {4.0f, 8.0f};
+  block.musket = {0.0f, 30, 13};
+  block.defense = {formation_defense(s.shape())};
+  const flecs::entity_t *ids = spawn_infantry_block(ecs, block);
+  vb.entity.insert(vb.entity.end(), ids, ids + add);
+  vb.living.resize(vb.entity.size(), 1);
+  vb.alive = total;
+}
+
+// Idempotent: a death repeats in every snapshot until acked
+static void kill_visual(flecs::world &ecs, VisualBattalionSlots &vb,
+                        uint32_t slot) {
+  if (slot >= vb.living.size() || !vb.living[slot])
+    return;
+  vb.living[slot] = 0;
+  vb.alive--;
+  ecs.entity(vb.entity[slot]).remove<IsAlive>();
+}
+
+// The next living slot from a stream position that depends only on the
+// battalion and its count, so every client in the same state picks the
+// same soldier. Seed 0: clients never learn the world seed.
+static void pick_visual_death(flecs::world &ecs, uint32_t id,
+                              VisualBattalionSlots &vb) {
+  static const uint64_t key = sim_rng_key(0, RNG_STREAM_VISUAL);
+  const uint32_t n = (uint32_t)vb.living.size();
+  const uint64_t who = ((uint64_t)id << 32) | (uint32_t)vb.alive;
+  uint32_t slot = sim_rand_u32(key, sim_rng_counter(0, who)) % n;
+  while (!vb.living[slot])
+    slot = (slot + 1) % n;
+  kill_visual(ecs, vb, slot);
+}
+
+static void clear_visual(flecs::world &ecs, VisualBattalionSlots &vb) {
+  for (flecs::entity_t e : vb.entity)
+    ecs.entity(e).destruct();
+  vb.entity.clear();
+  vb.living.clear();
+  vb.alive = 0;
+  vb.server_alive = 0;
+}
+
+// Brings every battalion's soldiers in line with the frame. Counts only
+// grow on a server-side increase: a frame's alive count can trail the
+// deaths that came with it by a tick, which is not a reinforcement.
+static void apply_visual_frame(flecs::world &ecs, MacroSyncClient &c,
+                               const MacroSyncFrame &f) {
+  const int id_end = std::max<int>(f.id_end, c.id_end);
+  int live_end = 0;
+  for (int id = 0; id < id_end; id++) {
+    const MacroSnap &s = f.bat[id];
+    VisualBattalionSlots &vb = c.bat[id];
+    if (!vb.entity.empty() &&
+        (s.team == MACRO_SYNC_ABSENT || s.team != vb.team))
+      clear_visual(ecs, vb);
+    if (s.team == MACRO_SYNC_ABSENT)
+      continue;
+
+    vb.team = s.team;
+    const int grown = vb.entity.empty() ? s.alive : s.alive - vb.server_alive;
+    vb.server_alive = s.alive;
+    while (vb.alive > s.alive) {
+      pick_visual_death(ecs, (uint32_t)id, vb);
+      c.picked++;
+    }
+    if (grown > 0)
+      layout_visual(ecs, (uint32_t)id, s, vb, grown);
+    else if (vb.shape != (uint8_t)s.shape())
+      layout_visual(ecs, (uint32_t)id, s, vb, 0);
+    live_end = id + 1;
+  }
+  c.id_end = (uint16_t)live_end;
+}
+
+uint32_t receive_macro_sync(flecs::world &ecs, const uint8_t *data,
+                            size_t size) {
+  ProfileScope profile(ecs, PROFILE_MACRO_RECEIVE);
+  MacroSyncClient &c = ecs.get_mut<MacroSyncClient>();
+  const MacroSyncFrame *f = decode_macro_sync(c.rx, data, size);
+  if (!f)
+    return c.rx.latest_seq;
+
+  // Deaths first: the frame's counts already exclude them
+  for (int k = 0; k < c.rx.death_count; k++) {
+    const MacroSyncDeath &d = c.rx.deaths[k];
+    kill_visual(ecs, c.bat[d.bat], d.slot);
+  }
+  // A late packet still delivers its deaths, never older counts
+  if (f->seq > c.applied_seq) {
+    apply_visual_frame(ecs, c, *f);
+    c.applied_seq = f->seq;
+  }
+  return c.rx.latest_seq;
+}
+
+// Advances the playback cursor one tick and writes the interpolated
+// frames. The cursor trails the newest snapshot by
+// MACRO_SYNC_INTERP_TICKS and eases toward that target, so a late
+// packet bends the timeline rather than jumping it.
+static void play_visual_frames(flecs::world &w) {
+  MacroSyncClient &c = w.get_mut<MacroSyncClient>();
+  const MacroSyncFrame *latest = c.rx.find(c.rx.latest_seq);
+  if (!latest)
+    return;
+  const double target = (double)latest->tick - MACRO_SYNC_INTERP_TICKS;
+  const double lag = target - c.play_tick;
+  if (std::fabs(lag) > 4.0 * MACRO_SYNC_INTERP_TICKS)
+    c.play_tick = target; // First packet or a stalled stream: snap
+  else
+    c.play_tick += 1.0 + 0.05 * lag;
+  c.play_tick = std::min(c.play_tick, (double)latest->tick);
+
+  // Newest frame at or before the cursor, and the one after it
+  const MacroSyncFrame *a = nullptr, *b = nullptr;
+  for (uint32_t seq = c.rx.latest_seq;
+       seq > 0 && c.rx.latest_seq - seq < (uint32_t)MACRO_SYNC_HISTORY;
+       seq--) {
+    const MacroSyncFrame *f = c.rx.find(seq);
+    if (!f)
+      continue;
+    if (f->tick <= c.play_tick) {
+      a = f;
+      break;
+    }
+    b = f;
+  }
+  if (!a)
+    a = b; // Cursor before the oldest frame: hold it
+  if (!b)
+    b = a; // At the newest: hold it
+  const float alpha =
+      b->tick > a->tick
+          ? (float)((c.play_tick - a->tick) / (double)(b->tick - a->tick))
+          : 0.0f;
+
+  VisualBattalions &vis = w.get_mut<VisualBattalions>();
+  for (int id = 0; id < c.id_end; id++) {
+    const MacroSnap *sa = &a->bat[id];
+    const MacroSnap *sb = &b->bat[id];
+    if (sa->team == MACRO_SYNC_ABSENT)
+      sa = sb;
+    if (sb->team == MACRO_SYNC_ABSENT)
+      sb = sa;
+    if (sa->team == MACRO_SYNC_ABSENT)
+      continue;
+    vis.anchor_x[id] =
+        sa->anchor_x() + (sb->anchor_x() - sa->anchor_x()) * alpha;
+    vis.anchor_z[id] =
+        sa->anchor_z() + (sb->anchor_z() - sa->anchor_z()) * alpha;
+    const int16_t turn = (int16_t)(uint16_t)(sb->facing - sa->facing);
+    const float angle = (sa->facing + turn * alpha) * (TWO_PI / 65536.0f);
+    vis.dir_x[id] = std::sin(angle);
+    vis.dir_z[id] = std::cos(angle);
+    vis.cohesion[id] = sa->cohesion_unit() +
+                       (sb->cohesion_unit() - sa->cohesion_unit()) * alpha;
+  }
+}
+
+void register_visual_client(flecs::world &ecs) {
+  // layout() scratch (heap-built: ~8MB, same as the server's)
+  {
+    auto *roster = new FormationRoster();
+    memset(roster, 0, sizeof(FormationRoster));
+    memset(roster->pending_shape, -1, sizeof(roster->pending_shape));
+    ecs.set<FormationRoster>(*roster);
+    delete roster;
+  }
+  {
+    auto *vis = new VisualBattalions();
+    memset(vis, 0, sizeof(VisualBattalions));
+    ecs.set<VisualBattalions>(*vis);
+    delete vis;
+  }
+  MacroSyncClient c = {};
+  c.allocate();
+  ecs.set<MacroSyncClient>(c);
+
+  // First phase of the tick: frames are in place before the springs
+  ecs.system("MacroSyncPlayback")
+      .kind(flecs::OnLoad)
+      .run([](flecs::iter &it) {
+        flecs::world w = it.world();
+        play_visual_frames(w);
+      });
+  register_visual_spring_system(ecs);
+}
+
+} // namespace musket
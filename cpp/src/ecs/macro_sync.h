@@ -0,0 +1,176 @@
+#ifndef MUSKET_MACRO_SYNC_H
+#define MUSKET_MACRO_SYNC_H
+
+#include "../../flecs/flecs.h"
+#include "musket_components.h"
+#include <cstdint>
+#include <vector>
+
+// ═══════════════════════════════════════════════════════════════
+// MACRO-STATE SYNC (GDD §4.3: the Brain, never the Muscle)
+//
+// The server samples macro state at 10Hz (SIM_GROUP_NET) into a ring
+// of quantized frames: one MacroSnap per battalion id plus 8-bit panic
+// and civic layers. A snapshot is encoded against whichever frame the
+// client last acknowledged (or from nothing), so a standing army costs
+// a header and a few bytes. Deaths logged between the two frames ride
+// along, batched per battalion. Everything is Godot-free; the transport
+// (ENet RPC) only moves the bytes.
+// ═══════════════════════════════════════════════════════════════
+
+namespace musket {
+
+constexpr int MACRO_SYNC_HISTORY = 32;      // Frames kept (3.2s of acks)
+constexpr int MACRO_SYNC_DEATH_LOG = 16384; // Deaths kept for deltas
+constexpr int MACRO_SYNC_LAYERS = 4;        // Panic ×2 teams, civic ×2
+constexpr int MACRO_SYNC_CELLS = PanicGrid::CELLS;
+constexpr size_t MACRO_SYNC_MAX_BYTES = 256 * 1024; // Worst case ~205KB
+constexpr float MACRO_SYNC_POS_SCALE = 8.0f; // 1/8m steps, ±4096m range
+constexpr uint8_t MACRO_SYNC_ABSENT = 255;   // team of a free battalion id
+
+static_assert(CivicGrid::CELLS == MACRO_SYNC_CELLS, "grid layers share size");
+
+// ── One battalion, quantized (16 bytes) ─────────────────────
+// Centroid and anchor in 1/8m, facing as a full-turn angle. Absent ids
+// are all-zero with team = MACRO_SYNC_ABSENT.
+struct MacroSnap {
+  int16_t cx, cz;    // Centroid of the living soldiers
+  int16_t ax, az;    // Formation anchor (slot origin)
+  uint16_t facing;   // atan2(dir_x, dir_z), 65536 = one turn
+  uint16_t alive;    // alive_count
+  uint8_t team;      // MACRO_SYNC_ABSENT = id not live
+  uint8_t mode;      // fire_discipline | shape << 4
+  uint8_t cohesion;  // flag_cohesion × 255
+  uint8_t command;   // flag | drummer << 1 | officer << 2
+
+  inline float centroid_x() const { return cx / MACRO_SYNC_POS_SCALE; }
+  inline float centroid_z() const { return cz / MACRO_SYNC_POS_SCALE; }
+  inline float anchor_x() const { return ax / MACRO_SYNC_POS_SCALE; }
+  inline float anchor_z() const { return az / MACRO_SYNC_POS_SCALE; }
+  inline FireDiscipline discipline() const {
+    return (FireDiscipline)(mode & 0x0F);
+  }
+  inline FormationShape shape() const { return (FormationShape)(mode >> 4); }
+  inline float cohesion_unit() const { return cohesion / 255.0f; }
+  void facing_dir(float &dir_x, float &dir_z) const;
+}; // 16 bytes
+
+// ── One 10Hz sample ─────────────────────────────────────────
+struct MacroSyncFrame {
+  uint32_t seq;       // 0 = empty slot
+  uint32_t tick;      // SimClock.tick (low 32 bits) when captured
+  uint64_t death_end; // Server: death log head when captured
+  uint16_t id_end;    // Highest live battalion id + 1
+  MacroSnap bat[MAX_BATTALIONS];
+  uint8_t grid[MACRO_SYNC_LAYERS][MACRO_SYNC_CELLS]; // 0..255 = 0..1
+}; // ~80KB
+
+// A soldier that died: its battalion and stable RenderSlot index
+struct MacroSyncDeath {
+  uint32_t slot;
+  uint16_t bat;
+  uint16_t pad;
+}; // 8 bytes
+
+// ── Server side: frame ring + death log (pointer-only singleton) ──
+// Heap arrays (~2.6MB) like VoxelGrid; copying the struct into Flecs
+// copies pointers only.
+struct MacroSyncHistory {
+  MacroSyncFrame *frames; // MACRO_SYNC_HISTORY, slot = seq % size
+  MacroSyncDeath *deaths; // MACRO_SYNC_DEATH_LOG ring
+  uint64_t death_total;   // Deaths ever logged (ring head)
+  uint32_t latest_seq;    // 0 until the first capture
+
+  void allocate();
+  void release();
+  const MacroSyncFrame *find(uint32_t seq) const;
+};
+
+// ── Client side: decoded frames (the baselines it acks) ──────
+struct MacroSyncReceiver {
+  MacroSyncFrame *frames; // MACRO_SYNC_HISTORY, slot = seq % size
+  MacroSyncDeath *deaths; // Deaths carried by the last decoded snapshot
+  int death_count;
+  uint32_t latest_seq; // Newest decoded: the seq to acknowledge
+
+  void allocate();
+  void release();
+  const MacroSyncFrame *find(uint32_t seq) const;
+};
+
+// Samples g_macro_battalions (live ids) and the grids into the next
+// frame. Either grid may be null (layers stay zero). Returns its seq.
+uint32_t capture_macro_sync(MacroSyncHistory &h, uint64_t tick,
+                            const PanicGrid *panic, const CivicGrid *civic);
+
+// Deaths are ordered by the log, not by tick: a snapshot carries log
+// entries [baseline.death_end, frame.death_end), whenever they happened.
+void log_macro_sync_death(MacroSyncHistory &h, uint32_t bat, uint32_t slot);
+
+// Encodes frame `seq` against `baseline_seq` (0 = full snapshot) into
+// `out`, resized to the byte count; out keeps its capacity, so a reused
+// buffer never reallocates. Falls back to a full snapshot when the
+// baseline has left the ring or deaths logged since it were overwritten.
+// Returns 0 if `seq` itself is gone.
+size_t encode_macro_sync(const MacroSyncHistory &h, uint32_t seq,
+                         uint32_t baseline_seq, std::vector<uint8_t> &out);
+
+// Rebuilds the frame into the receiver's ring (its deaths into
+// r.deaths). Returns null on a malformed packet or a baseline the
+// client no longer holds — keep acking latest_seq and the server
+// falls back. Deaths repeat until acked; applying one twice is a no-op.
+const MacroSyncFrame *decode_macro_sync(MacroSyncReceiver &r,
+                                        const uint8_t *data, size_t size);
+
+// Singleton + 10Hz capture system + death observer. Needs the sim clock.
+void register_macro_sync(flecs::world &ecs);
+
+// ═══════════════════════════════════════════════════════════════
+// CLIENT VISUAL ECS
+//
+// A client world rebuilds soldiers from snapshots alone. Each battalion
+// is laid out with FormationRoster::layout at the snapshot's alive
+// count and shape; VisualSpringDamper pulls the soldiers toward the
+// anchor and facing, interpolated MACRO_SYNC_INTERP_TICKS behind the
+// newest packet. A death removes the soldier at the server's slot. When
+// counts still disagree (late join, lost packet), the extra deaths come
+// from the RNG_STREAM_VISUAL stream, so every client drops the same men.
+// ═══════════════════════════════════════════════════════════════
+
+constexpr int MACRO_SYNC_INTERP_TICKS = 12; // Two snapshots: one may drop
+
+// One battalion's visual soldiers, indexed by RenderSlot
+struct VisualBattalionSlots {
+  std::vector<flecs::entity_t> entity; // Slot → soldier, spawn order
+  std::vector<uint8_t> living;         // Slot → 1 while IsAlive
+  int alive;
+  uint16_t server_alive; // Count in the last applied frame
+  uint8_t team;
+  uint8_t shape;
+};
+
+// ── Client side: receiver + visual soldiers (pointer-only singleton) ──
+struct MacroSyncClient {
+  MacroSyncReceiver rx;
+  VisualBattalionSlots *bat; // MAX_BATTALIONS
+  uint32_t applied_seq;      // Newest frame reconciled into soldiers
+  uint16_t id_end;           // Highest id with soldiers + 1
+  double play_tick;          // Interpolation cursor, in server ticks
+  uint64_t picked;           // Deaths chosen locally (counts disagreed)
+
+  void allocate();
+  void release();
+};
+
+// Roster, VisualBattalions and client singletons + the playback and
+// spring systems, on a world that runs nothing else. Needs the sim clock.
+void register_visual_client(flecs::world &ecs);
+
+// Decodes a snapshot and reconciles the visual soldiers with it. Returns
+// the seq to acknowledge (unchanged when the packet was rejected).
+uint32_t receive_macro_sync(flecs::world &ecs, const uint8_t *data,
+                            size_t size);
+
+} // namespace musket
+
+#endif // MUSKET_MACRO_SYNC_H
@@ -38,15 +38,158 @@ enum FireDiscipline : uint8_t {
   DISCIPLINE_MASS_VOLLEY = 3 // All fire in 0.5s window → HOLD
 };
 
-struct alignas(64) SoldierFormationTarget {
-  double target_x, target_z;    // Slot position (double: Trap 10 precision)
-  float base_stiffness;         // Modified by morale/uniforms
-  float damping_multiplier;     // ~2.0 for critical damping
-  float face_dir_x, face_dir_z; // Per-soldier facing vector (§12.8)
-  bool can_shoot;               // Enforces Column/Square fire limits
-  uint8_t rank_index;           // 0=Front, 1=Mid, 2=Rear
-  uint8_t pad[6];               // Explicit padding to 64 bytes
-}; // 64 bytes — 1 soldier = 1 L1 cache line (Trap 25)
+// Facing components are stored as snorm16 (±32767 = ±1.0).
+constexpr int16_t face_snorm(float v) { return (int16_t)(v * 32767.0f); }
+
+// Slot target = MacroBattalion anchor (double) + battalion-relative float
+// offset rotated by the battalion facing. Offsets stay within a few
+// hundred metres, so float keeps sub-millimetre precision anywhere on the
+// map (Trap 10) without a per-soldier double, and marching or wheeling a
+// formation rewrites one anchor and one facing vector.
+struct SoldierFormationTarget {
+  float offset_x, offset_z; // Slot in the battalion frame (-Z = forward)
+  float base_stiffness;     // Modified by morale/uniforms
+  float damping_multiplier; // ~2.0 for critical damping
+  int16_t face_x, face_z;   // Facing in the battalion frame, snorm16 (§12.8)
+  bool can_shoot;           // Enforces Column/Square fire limits
+  uint8_t rank_index;       // 0=Front, 1=Mid, 2=Rear
+  uint8_t pad[2];
+
+  inline float face_dir_x() const { return (float)face_x / 32767.0f; }
+  inline float face_dir_z() const { return (float)face_z / 32767.0f; }
+  inline void set_face_dir(float x, float z) {
+    face_x = face_snorm(x);
+    face_z = face_snorm(z);
+  }
+}; // 24 bytes — 8 soldiers per 3 cache lines (Trap 25)
+
+// Battalion frame → world, for a battalion facing (dir_x, dir_z).
+// Facing (0, -1) is the identity, so spawn offsets are world offsets.
+inline void battalion_to_world(float lx, float lz, float dir_x, float dir_z,
+                               float &gx, float &gz) {
+  gx = -lx * dir_z - lz * dir_x;
+  gz = lx * dir_x - lz * dir_z;
+}
+// Inverse (transpose) of battalion_to_world.
+inline void world_to_battalion(float gx, float gz, float dir_x, float dir_z,
+                               float &lx, float &lz) {
+  lx = -gx * dir_z + gz * dir_x;
+  lz = -gx * dir_x - gz * dir_z;
+}
+
+// ─── Simulation RNG (counter-based, Squares) ──────────────
+// Every draw is a pure function of (world seed, stream, tick, entity,
+// draw index): no generator state, so results never depend on float
+// time, iteration order or which thread asked. Lockstep peers and
+// replays that share the seed and tick see the same rolls.
+enum RngStream : uint32_t {
+  RNG_STREAM_VOLLEY = 1,   // Musket hit rolls
+  RNG_STREAM_CANISTER = 2, // Canister ball rolls
+  RNG_STREAM_GUN_AIM = 3,  // Per-gun aim spread
+  RNG_STREAM_HAZARD = 4,   // Workplace spark ignition
+  RNG_STREAM_RUBBLE = 5,   // Which stone becomes rubble
+  RNG_STREAM_SPAWN = 6,    // Spawn jitter
+  RNG_STREAM_VISUAL = 7    // Client: which visual soldier falls
+};
+
+struct SimRng {
+  uint64_t seed; // World seed (singleton; same seed → same battle)
+}; // 8 bytes
+
+// ─── Simulation Clock (Singleton) ─────────────────────────
+// The world always advances in fixed 60Hz ticks. The renderer's
+// variable frame delta is banked in `accumulator` and drained one whole
+// tick at a time, at most `max_catchup` per frame: after a hitch the
+// sim drops time instead of spiralling. `tick` is the frame id every
+// system reads (never float world time).
+//
+// Slower system groups tick every SIM_TICK_HZ / group_hz ticks through
+// Flecs rate filters (see register_sim_clock), so their dt is the
+// group's own period.
+constexpr int SIM_TICK_HZ = 60;
+constexpr double SIM_TICK_DT = 1.0 / SIM_TICK_HZ;
+
+enum SimGroup : uint8_t {
+  SIM_GROUP_PHYSICS = 0, // Every tick: movement, combat, artillery
+  SIM_GROUP_CA = 1,      // Cellular automata (panic diffusion), 5Hz
+  SIM_GROUP_ECONOMY = 2, // Slow aggregates (zeitgeist), 1Hz
+  SIM_GROUP_NET = 3,     // Macro-state snapshots for clients, 10Hz
+  SIM_GROUP_COUNT = 4
+};
+
+struct SimClock {
+  uint64_t tick;             // Fixed ticks simulated so far
+  double accumulator;        // Banked real time not yet simulated
+  float alpha;               // accumulator / tick: render blend in [0, 1)
+  int32_t max_catchup;       // Ticks per frame before time is dropped
+  uint32_t steps_last_frame; // Ticks run by the last advance
+  uint64_t dropped_ticks;    // Ticks discarded by the catch-up cap
+  uint16_t group_hz[SIM_GROUP_COUNT];
+
+  // Banks a frame's real delta; returns how many ticks to run now.
+  inline int bank(double real_dt) {
+    accumulator += real_dt > 0.0 ? real_dt : 0.0;
+    // Tolerance so 1/60 banked 60 times is 60 ticks, not 59
+    int steps = (int)((accumulator + 1e-9) / SIM_TICK_DT);
+    if (steps > max_catchup) {
+      dropped_ticks += (uint64_t)(steps - max_catchup);
+      accumulator -= (double)(steps - max_catchup) * SIM_TICK_DT;
+      steps = max_catchup;
+    }
+    accumulator -= (double)steps * SIM_TICK_DT;
+    if (accumulator < 0.0)
+      accumulator = 0.0;
+    alpha = (float)(accumulator / SIM_TICK_DT);
+    steps_last_frame = (uint32_t)steps;
+    return steps;
+  }
+};
+
+inline uint64_t sim_mix64(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// Squares key for one stream of one world (odd, well mixed)
+inline uint64_t sim_rng_key(uint64_t seed, RngStream stream) {
+  return sim_mix64(seed ^ ((uint64_t)stream * 0x9E3779B97F4A7C15ULL)) | 1ULL;
+}
+
+// Counter for one (tick, entity, draw): entities are spread by a mix,
+// ticks then step the counter like a Weyl sequence.
+inline uint64_t sim_rng_counter(uint64_t tick, uint64_t entity,
+                                uint32_t draw = 0) {
+  return sim_mix64(entity ^ ((uint64_t)draw << 48)) + tick;
+}
+
+// Widynski's Squares: four rounds of square-and-swap over ctr·key
+inline uint32_t sim_rand_u32(uint64_t key, uint64_t ctr) {
+  uint64_t x = ctr * key, y = x, z = y + key;
+  x = x * x + y;
+  x = (x >> 32) | (x << 32);
+  x = x * x + z;
+  x = (x >> 32) | (x << 32);
+  x = x * x + y;
+  x = (x >> 32) | (x << 32);
+  return (uint32_t)((x * x + z) >> 32);
+}
+
+// Uniform [0, 1) with 24 bits
+inline float sim_rand_unit(uint64_t key, uint64_t ctr) {
+  return (float)(sim_rand_u32(key, ctr) >> 8) * (1.0f / 16777216.0f);
+}
+
+// One roll per entity for this tick. A straight loop with no branches,
+// so a whole battalion's rolls vectorize in one call.
+inline void sim_rand_batch(uint64_t key, uint64_t tick, const uint64_t *entity,
+                           int n, float *out) {
+  for (int i = 0; i < n; i++)
+    out[i] = sim_rand_unit(key, sim_rng_counter(tick, entity[i]));
+}
 
 // ─── Stats ────────────────────────────────────────────────
 struct MovementStats {
@@ -71,10 +214,6 @@ struct MusketState {
 }; // 6 bytes
 
 // ─── Combat: Orders ───────────────────────────────────────
-struct MovementOrder {
-  float target_x, target_z;
-  bool arrived;
-}; // 12 bytes
 struct HaltOrder {}; // Tag
 struct FireOrder {
   float target_x, target_z;
@@ -91,6 +230,88 @@ struct ArtilleryShot {
   bool active;
 }; // 32 bytes
 
+// ─── M5: Projectile Pool (Singleton) ──────────────────────
+// Shots are not Flecs entities: a spent shot's slot is refilled by the
+// last live shot (swap-remove), so [0, count) is always exactly the
+// shots in flight. Per-frame cost tracks live shots, not shots ever
+// fired, and spawning never touches an archetype table.
+constexpr int PROJECTILE_POOL_CAPACITY = 4096;
+
+struct alignas(64) ProjectilePool {
+  float x[PROJECTILE_POOL_CAPACITY];
+  float y[PROJECTILE_POOL_CAPACITY];
+  float z[PROJECTILE_POOL_CAPACITY];
+  float vx[PROJECTILE_POOL_CAPACITY];
+  float vy[PROJECTILE_POOL_CAPACITY];
+  float vz[PROJECTILE_POOL_CAPACITY];
+  float kinetic_energy[PROJECTILE_POOL_CAPACITY];
+  uint8_t ammo[PROJECTILE_POOL_CAPACITY]; // ArtilleryAmmoType
+  uint8_t team[PROJECTILE_POOL_CAPACITY];
+  uint8_t active[PROJECTILE_POOL_CAPACITY]; // Cleared mid-frame, reaped
+                                            // by compact()
+  int32_t count;
+  uint32_t dropped; // Spawns refused because the pool was full
+
+  // Returns the slot, or -1 when all slots are in flight.
+  inline int spawn(const ArtilleryShot &s, uint8_t shot_team) {
+    if (count >= PROJECTILE_POOL_CAPACITY) {
+      dropped++;
+      return -1;
+    }
+    int i = count++;
+    x[i] = s.x;
+    y[i] = s.y;
+    z[i] = s.z;
+    vx[i] = s.vx;
+    vy[i] = s.vy;
+    vz[i] = s.vz;
+    kinetic_energy[i] = s.kinetic_energy;
+    ammo[i] = (uint8_t)s.ammo;
+    team[i] = shot_team;
+    active[i] = 1;
+    return i;
+  }
+
+  // Swap-removes every inactive slot. Slot order is not preserved.
+  inline void compact() {
+    int i = 0;
+    while (i < count) {
+      if (active[i]) {
+        i++;
+        continue;
+      }
+      int last = --count;
+      x[i] = x[last];
+      y[i] = y[last];
+      z[i] = z[last];
+      vx[i] = vx[last];
+      vy[i] = vy[last];
+      vz[i] = vz[last];
+      kinetic_energy[i] = kinetic_energy[last];
+      ammo[i] = ammo[last];
+      team[i] = team[last];
+      active[i] = active[last];
+    }
+  }
+
+  // Gravity + position over the live range. Branch-free so the loop
+  // vectorizes; off-map or spent shots are flagged, not removed.
+  inline void integrate(float dt, float half_extent) {
+    const float g_dt = 9.81f * dt;
+    const int n = count;
+    for (int i = 0; i < n; i++) {
+      vy[i] -= g_dt;
+      x[i] += vx[i] * dt;
+      y[i] += vy[i] * dt;
+      z[i] += vz[i] * dt;
+      uint8_t keep = (kinetic_energy[i] > 0.0f) & (x[i] >= -half_extent) &
+                     (x[i] <= half_extent) & (z[i] >= -half_extent) &
+                     (z[i] <= half_extent);
+      active[i] &= keep;
+    }
+  }
+}; // ~124 KB — heap-built once, same as SpatialHashGrid
+
 struct ArtilleryBattery {
   int num_guns;
   float reload_timer;
@@ -147,12 +368,92 @@ struct MacroBattalion {
   float ext_w = 0.0f;                // OBB half-width + 2m buffer
   float ext_d = 0.0f;                // OBB half-depth + 2m buffer
   int target_bat_id = -1;            // Hoisted macro targeting (Trap 26)
+  FormationShape shape = SHAPE_LINE; // Current layout (wheels keep it)
+
+  // ── Formation anchor (Persistent) ──
+  // World origin of every SoldierFormationTarget offset in the battalion.
+  // Double so long marches accumulate without drift (Trap 10).
+  double anchor_x = 0.0, anchor_z = 0.0;
+
+  // ── March (Persistent — advanced by BattalionMarchSystem) ──
+  double march_x = 0.0, march_z = 0.0; // Anchor destination
+  bool marching = false;
 };
 
 // EXTERN: declared here, defined ONCE in world_manager.cpp
-constexpr int MAX_BATTALIONS = 256;
+// One id space for MacroBattalion, PendingOrder, the formation roster
+// and the rendering bridge's shadow buffers (no aliasing by modulo).
+constexpr int MAX_BATTALIONS = 4096;
 extern MacroBattalion g_macro_battalions[MAX_BATTALIONS];
 
+// ─── Client Visual ECS: interpolated battalion frames (Singleton) ──
+// A client world never reads g_macro_battalions: its springs pull toward
+// anchors interpolated between macro snapshots, written here each tick.
+struct VisualBattalions {
+  float anchor_x[MAX_BATTALIONS];
+  float anchor_z[MAX_BATTALIONS];
+  float dir_x[MAX_BATTALIONS];
+  float dir_z[MAX_BATTALIONS];
+  float cohesion[MAX_BATTALIONS];
+}; // 80KB — heap-built once
+
+// ─── Battalion Id Pool ────────────────────────────────────
+// Hands out battalion ids lowest-first and keeps the live ones in an
+// ascending dense list, so per-battalion passes walk live[0..live_count)
+// instead of MAX_BATTALIONS. Ids of emptied battalions are reclaimed by
+// the centroid pass. Invariant: every BattalionId in the world is live
+// (spawn paths acquire or claim first). Zero-initialized = empty pool.
+struct BattalionPool {
+  int32_t live_count;
+  uint16_t live[MAX_BATTALIONS];   // Live ids, ascending (stable order)
+  uint8_t is_live[MAX_BATTALIONS]; // id → 1 if live
+
+  void reset() {
+    live_count = 0;
+    std::memset(is_live, 0, sizeof(is_live));
+  }
+
+  // Marks a specific id live (no-op if it already is)
+  bool claim(int id) {
+    if (id < 0 || id >= MAX_BATTALIONS)
+      return false;
+    if (is_live[id])
+      return true;
+    int k = live_count;
+    while (k > 0 && live[k - 1] > id) { // Sorted insert: O(live), rare
+      live[k] = live[k - 1];
+      k--;
+    }
+    live[k] = (uint16_t)id;
+    live_count++;
+    is_live[id] = 1;
+    return true;
+  }
+
+  // Lowest free id, now live; -1 when every id is in use
+  int acquire() {
+    for (int id = 0; id < MAX_BATTALIONS; id++)
+      if (!is_live[id]) {
+        claim(id);
+        return id;
+      }
+    return -1;
+  }
+
+  void release(int id) {
+    if (id < 0 || id >= MAX_BATTALIONS || !is_live[id])
+      return;
+    int k = 0;
+    while (live[k] != id)
+      k++;
+    for (; k + 1 < live_count; k++)
+      live[k] = live[k + 1];
+    live_count--;
+    is_live[id] = 0;
+  }
+};
+extern BattalionPool g_battalion_pool;
+
 struct ChargeOrder {
   uint32_t target_battalion_id;
   bool is_committed;
@@ -193,6 +494,88 @@ struct PendingOrder {
 };
 extern PendingOrder g_pending_orders[MAX_BATTALIONS];
 
+// Reclaims an emptied battalion: the id returns to the pool and its
+// macro/order state to defaults, so a reused id starts clean.
+inline void release_battalion(int id) {
+  if (id < 0 || id >= MAX_BATTALIONS)
+    return;
+  g_battalion_pool.release(id);
+  g_macro_battalions[id] = MacroBattalion{};
+  g_pending_orders[id] = PendingOrder{};
+}
+
+// ─── M7.5: Formation Roster (Singleton) ───────────────────
+// order_formation / order_wheel queue a re-form; FormationSolveSystem
+// services every queued battalion in one frame. Members are packed
+// per battalion (counting sort over the live soldiers — no stale
+// alive_count), slots are laid out in one branch-free pass per shape,
+// and members claim the nearest free slot so re-forming and wheeling
+// don't send files crossing through each other. Fixed arrays, no heap
+// traffic per order (Trap 29).
+constexpr int FORMATION_ROSTER_CAPACITY = 131072; // = SPATIAL_MAX_ENTITIES
+
+// One node per slot of an implicit k-d tree (see formation_layout.cpp)
+struct FormationKdNode {
+  float min_x, max_x, min_z, max_z; // Box over the subtree's free slots
+  float x, z;                       // This node's slot position
+  int32_t slot;                     // Roster slot index
+  int32_t free;                     // Free slots in the subtree
+  uint8_t axis;                     // Split: 0 = x, 1 = z
+  uint8_t used;                     // Inner node: its slot is claimed
+  uint8_t pad[2];
+}; // 36 bytes
+
+struct alignas(64) FormationRoster {
+  // ── Requests (held until FormationSolveSystem services them) ──
+  int8_t pending_shape[MAX_BATTALIONS]; // FormationShape, -1 = none
+  float pending_dir_x[MAX_BATTALIONS];
+  float pending_dir_z[MAX_BATTALIONS];
+  int32_t pending_count;
+
+  // ── Members packed by battalion: [bat_start[b], bat_start[b+1]) ──
+  int32_t bat_start[MAX_BATTALIONS + 1];
+  int32_t bat_fill[MAX_BATTALIONS];           // Pack / write-back cursor
+  float member_x[FORMATION_ROSTER_CAPACITY];  // Battalion frame
+  float member_z[FORMATION_ROSTER_CAPACITY];
+  int32_t assigned[FORMATION_ROSTER_CAPACITY]; // Slot per member
+  uint32_t dropped; // Members past capacity (keep their old slot)
+
+  // ── Slots, same packing as members ──
+  float slot_x[FORMATION_ROSTER_CAPACITY];
+  float slot_z[FORMATION_ROSTER_CAPACITY];
+  int16_t slot_face_x[FORMATION_ROSTER_CAPACITY]; // snorm16
+  int16_t slot_face_z[FORMATION_ROSTER_CAPACITY];
+  uint8_t slot_rank[FORMATION_ROSTER_CAPACITY];
+  uint8_t slot_can_shoot[FORMATION_ROSTER_CAPACITY];
+
+  // ── Matching scratch ──
+  int32_t match_order[FORMATION_ROSTER_CAPACITY];
+  float match_key[FORMATION_ROSTER_CAPACITY];
+  FormationKdNode kd[FORMATION_ROSTER_CAPACITY]; // Slot k-d tree
+
+  inline void request(int bat, FormationShape shape, float dir_x,
+                      float dir_z) {
+    if (pending_shape[bat] < 0)
+      pending_count++;
+    pending_shape[bat] = (int8_t)shape;
+    pending_dir_x[bat] = dir_x;
+    pending_dir_z[bat] = dir_z;
+  }
+
+  // Fills slots [base, base+n) for the shape; returns OBB half extents.
+  // Implemented in formation_layout.cpp
+  void layout(int base, int n, FormationShape shape, float &ext_w,
+              float &ext_d);
+  // Greedy nearest-free-slot assignment of members [base, base+n),
+  // outermost members first. Implemented in formation_layout.cpp
+  void match(int base, int n);
+}; // ~8 MB — heap-built once, same as SpatialHashGrid
+
+// FormationDefense per shape (Line 0.2, Column 0.5, Square 0.9)
+inline float formation_defense(FormationShape shape) {
+  return shape == SHAPE_SQUARE ? 0.9f : shape == SHAPE_COLUMN ? 0.5f : 0.2f;
+}
+
 // ─── Combat: Medical ──────────────────────────────────────
 struct Downed {
   float bleed_timer;
@@ -215,7 +598,6 @@ struct PanicGrid {
 
   float read_buf[TEAMS][CELLS];
   float write_buf[TEAMS][CELLS];
-  float tick_accum; // accumulates dt, fires at 5Hz
 
   // World → grid index (clamped)
   static int world_to_idx(float wx, float wz) {
@@ -233,6 +615,29 @@ struct PanicGrid {
   }
 };
 
+// ─── M4: Flee Field (Singleton) ───────────────────────────
+// Per team layer: the nearest enemy battalion to each coarse cell,
+// rebuilt by jump flooding whenever anyone is routing. A routing soldier
+// reads its cell once instead of scanning all battalions.
+struct FleeField {
+  static constexpr int WIDTH = 64;
+  static constexpr int HEIGHT = 64;
+  static constexpr int CELLS = WIDTH * HEIGHT;
+  static constexpr int TEAMS = PanicGrid::TEAMS;
+  static constexpr float CELL_SIZE = 64.0f; // Covers the 4096m spatial map
+
+  int16_t nearest[TEAMS][CELLS]; // Enemy battalion index, -1 = none
+
+  // World → cell index with +2048 offset (Trap 31), clamped
+  static int world_to_idx(float wx, float wz) {
+    int cx = (int)((wx + 2048.0f) / CELL_SIZE);
+    int cz = (int)((wz + 2048.0f) / CELL_SIZE);
+    cx = cx < 0 ? 0 : (cx >= WIDTH ? WIDTH - 1 : cx);
+    cz = cz < 0 ? 0 : (cz >= HEIGHT ? HEIGHT - 1 : cz);
+    return cz * WIDTH + cx;
+  }
+}; // 16 KB
+
 // ─── M8: Spatial Hash Grid (Singleton) ────────────────────
 // Flat-array SoA spatial hash. Rebuilt from scratch every frame.
 // Head/next linked list pattern — ZERO heap allocations.
@@ -252,6 +657,14 @@ struct alignas(64) SpatialHashGrid {
   // Entity → next entity in same cell (-1 = end of chain)
   int32_t entity_next[SPATIAL_MAX_ENTITIES];
 
+  // Battalion → first member, member → next in the same battalion.
+  // Volley fire walks its one target battalion instead of ~7x7 cells.
+  int32_t bat_head[MAX_BATTALIONS];
+  int32_t bat_next[SPATIAL_MAX_ENTITIES];
+  // Battalion member bounds (valid while bat_head != -1)
+  float bat_min_x[MAX_BATTALIONS], bat_max_x[MAX_BATTALIONS];
+  float bat_min_z[MAX_BATTALIONS], bat_max_z[MAX_BATTALIONS];
+
   // SoA data: cache-coherent filtering without loading full components
   uint64_t entity_id[SPATIAL_MAX_ENTITIES];
   float pos_x[SPATIAL_MAX_ENTITIES];
@@ -275,7 +688,7 @@ struct alignas(64) SpatialHashGrid {
     else if (cz >= SPATIAL_HEIGHT)
       cz = SPATIAL_HEIGHT - 1;
   }
-}; // ~4.2 MB — fits in L3 cache
+}; // ~4.7 MB — fits in L3 cache
 
 // S-LOD: Off-screen agents skip 60Hz physics/targeting
 struct MacroSimulated {}; // Tag — entity runs 0.1Hz abstract tick only
@@ -477,19 +890,91 @@ constexpr float VOXEL_KE_RESISTANCE[] = {
     2000.0f,  // RUBBLE
 };
 
-// ─── The Chunk (4,160 Bytes, alignas(64)) ────────────────────
+// ─── Chunk Storage (M13.5: Palette + RLE Residency) ──────────
+// Most chunks hold 2-3 of the 5 materials. Instead of 4KB of raw
+// bytes per chunk, every allocated chunk keeps a 64B header plus a
+// compressed payload. Raw 4KB copies exist ONLY in the hot cache
+// for chunks that are actively being edited.
 constexpr int CHUNK_SIZE = 16;
 constexpr int CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE; // 4096
 
-struct alignas(64) VoxelChunk {
-  uint8_t voxels[CHUNK_VOLUME]; // Flat 1D array of materials (4KB)
+enum VoxelStorageMode : uint8_t {
+  VSTORE_PALETTE = 0, // Bit-packed palette indices (0/1/2/4 bits per voxel)
+  VSTORE_RLE = 1,     // Sorted (end, material) runs — layered cold chunks
+  VSTORE_RAW = 2      // >16 materials: 4KB verbatim payload (fallback)
+};
+
+constexpr int VOXEL_PALETTE_MAX = 16;
+constexpr uint16_t VOXEL_NO_HOT_SLOT = 0xFFFF;
+constexpr int VOXEL_HOT_SLOTS = 1024; // 4MB write-through edit cache
+
+// One RLE run: voxels [prev.end, end) hold `mat` (4B, aligned)
+struct VoxelRun {
+  uint16_t end; // Exclusive local index (1..4096)
+  uint8_t mat;
+  uint8_t pad;
+}; // 4 bytes
 
-  // 64-Byte Metadata Header
-  uint16_t solid_count;        // Fast-skip for DDA/Meshing if 0
-  uint8_t dirty_mesh;          // Flagged for Godot rendering bridge
-  uint8_t dirty_flow;          // Flagged for M8 Flow Field thread
+// ─── The Chunk Header (64 Bytes, alignas(64)) ────────────────
+// Resident for every allocated chunk. Payload layout by storage:
+//   PALETTE: CHUNK_VOLUME * bits / 8 bytes (bits == 0 → uniform, no payload)
+//   RLE:     payload_bytes / sizeof(VoxelRun) runs, sorted by end
+//   RAW:     CHUNK_VOLUME bytes
+struct alignas(64) VoxelChunk {
+  uint8_t *payload;       // 8B: heap-owned, or inside the mapped save file
+  uint32_t edit_gen;      // VoxelGrid::edit_generation of the last edit
+  uint16_t solid_count;   // Fast-skip for DDA/Meshing if 0
+  uint16_t payload_bytes; // Size of payload allocation
+  uint16_t hot_slot;      // VOXEL_NO_HOT_SLOT when cold
+  uint8_t dirty_mesh;     // Flagged for Godot rendering bridge
+  uint8_t dirty_flow;     // Flagged for M8 Flow Field thread
+  uint8_t dirty_height;   // Consumed by TerrainHeightmap::refresh
   uint8_t needs_stability_bfs; // Flagged for Structural Integrity thread
-  uint8_t pad[59];             // Pad to exactly 4160 bytes
+  uint8_t storage;             // VoxelStorageMode
+  uint8_t bits;                // Palette index width: 0, 1, 2 or 4
+  uint8_t palette_count;       // Live palette entries (1..16)
+  uint8_t payload_stale;       // Hot copy holds writes the payload missed
+  uint8_t payload_mapped;      // Payload is read-only file memory (M13.8)
+  uint8_t palette[VOXEL_PALETTE_MAX]; // Index → VoxelMaterial
+  uint8_t pad[21];                    // Pad to exactly 64 bytes
+
+  // Decode one voxel from the compressed payload (cold path)
+  inline uint8_t read_packed(int local) const {
+    if (storage == VSTORE_PALETTE) {
+      if (bits == 0)
+        return palette[0];
+      int bit = local * bits;
+      int idx = (payload[bit >> 3] >> (bit & 7)) & ((1 << bits) - 1);
+      return palette[idx];
+    }
+    if (storage == VSTORE_RAW)
+      return payload[local];
+
+    // RLE: binary search for the first run whose end > local
+    const VoxelRun *runs = reinterpret_cast<const VoxelRun *>(payload);
+    int lo = 0;
+    int hi = payload_bytes / (int)sizeof(VoxelRun) - 1;
+    while (lo < hi) {
+      int mid = (lo + hi) >> 1;
+      if (runs[mid].end <= local)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return runs[lo].mat;
+  }
+}; // 64 bytes — 1 chunk header = 1 L1 cache line
+
+// ─── Hot Cache Slot (4,160 Bytes, alignas(64)) ───────────────
+// Decompressed working copy of a chunk under edit. Reads hit the
+// raw bytes; writes land here AND in the packed payload when the
+// palette already holds the material (write-through). Otherwise the
+// header is marked payload_stale and repacked on eviction.
+struct alignas(64) VoxelHotChunk {
+  uint8_t voxels[CHUNK_VOLUME]; // Flat 1D array of materials (4KB)
+  uint32_t chunk_idx;           // Owning pool index (0 = free slot)
+  uint8_t pinned;               // Clock skips it (destruction wave)
+  uint8_t pad[59];              // Pad to exactly 4160 bytes
 };
 
 // ─── Sparse Voxel World (Singleton) ──────────────────────────
@@ -500,40 +985,103 @@ constexpr int MAP_CHUNKS_Z = 256;
 constexpr int MAP_CHUNKS_Y = 8; // 128m / 16
 constexpr int TOTAL_MAP_CHUNKS =
     MAP_CHUNKS_X * MAP_CHUNKS_Y * MAP_CHUNKS_Z; // 524,288
-constexpr int MAX_ACTIVE_CHUNKS = 65535;        // Pool limit (~272 MB)
+// Header pool grows geometrically from VOXEL_POOL_INITIAL. A full
+// terrain needs ~1-2 surface chunks per column (65,536 columns), so
+// pool indices are 32-bit (M13.9).
+constexpr int VOXEL_POOL_INITIAL = 4096;        // 256 KB of headers
+constexpr int MAX_ACTIVE_CHUNKS = 1 << 20;      // Header pool limit (64 MB)
 constexpr float VOXEL_WORLD_OFFSET = 2048.0f;   // Trap 61
 
+// ─── Region Edit (M13.6: Chunk-Coherent Destruction) ─────────
+// Handed to edit_region() callbacks: one chunk's clipped box in
+// local coordinates (inclusive) plus the chunk origin in voxel space.
+struct VoxelEditSpan {
+  int ox, oy, oz;       // Chunk origin (voxel coords)
+  int lx0, ly0, lz0;    // Local min (inclusive)
+  int lx1, ly1, lz1;    // Local max (inclusive)
+};
+
+struct VoxelEditResult {
+  int changed;     // Voxels rewritten (0 → chunk left clean)
+  int solid_delta; // Net change to solid_count
+};
+
+struct VoxelFileMap; // Memory-mapped save file (voxel_file.cpp)
+
+// ─── Terrain Generation (M13.9, voxel_terrain.cpp) ───────────
+// Heights in voxels (1m). Rolling fbm hills, ridged-noise escarpments
+// with exposed stone caps, and meandering river channels lined with
+// gravel (VMAT_RUBBLE). Same seed → byte-identical grid.
+struct TerrainParams {
+  uint32_t seed = 1805;
+  int base_height = 24;          // Plain level
+  int hill_amplitude = 20;       // Rolling fbm hills
+  float hill_frequency = 1.0f / 384.0f;
+  int ridge_amplitude = 36;      // Ridge crest height above the hills
+  float ridge_frequency = 1.0f / 768.0f;
+  float river_frequency = 1.0f / 1536.0f;
+  float river_width = 0.035f;    // Channel half-width in noise units
+  int river_depth = 6;           // Bed depth below the plain
+  int stone_cap_depth = 3;       // Exposed rock thickness on ridges
+};
+
 struct VoxelGrid {
   // Spatial Lookup: 3D chunk coord → pool index (HEAP-ALLOCATED)
   // 0 = Empty Air, 1 = Solid Earth, >=2 = index into chunk_pool
-  // WHY POINTER: The map is 1MB. A fixed array blows the stack
-  // when Flecs copies the singleton. Pointer makes VoxelGrid ~24B.
-  uint16_t *chunk_map; // heap: new uint16_t[TOTAL_MAP_CHUNKS]()
+  // WHY POINTER: The map is 2MB. A fixed array blows the stack
+  // when Flecs copies the singleton. Pointer makes VoxelGrid ~50B.
+  uint32_t *chunk_map; // heap: new uint32_t[TOTAL_MAP_CHUNKS]()
 
-  // Contiguous memory pool (heap-allocated once at init)
+  // Chunk headers (heap, 64B each; grown ×2 by alloc_chunk)
   VoxelChunk *chunk_pool;
-  uint16_t active_chunk_count;
+  // Write-through edit cache (heap-allocated once at init)
+  VoxelHotChunk *hot_pool;
+  uint32_t active_chunk_count;
+  uint32_t chunk_capacity; // Headers allocated in chunk_pool
+  uint16_t hot_cursor;     // Clock hand for hot-slot eviction
+  uint8_t hot_frozen;      // Workers hold hot pointers: no faults allowed
+
+  // M13.8: Persistence. Every edit stamps chunk.edit_gen with
+  // edit_generation; a save records saved_generation and bumps the
+  // counter, so a delta save writes only chunks with edit_gen > it.
+  uint32_t edit_generation;
+  uint32_t saved_generation;
+  VoxelFileMap *file_map; // Open mapping backing payload_mapped chunks
+
+  // Allocates chunk_map / chunk_pool / hot_pool (all air)
+  void allocate();
+  // Frees all payloads and pools
+  void release();
+
+  static inline int chunk_index(int cx, int cy, int cz) {
+    return (cy * MAP_CHUNKS_Z + cz) * MAP_CHUNKS_X + cx;
+  }
+  static inline int local_index(int x, int y, int z) {
+    return (y % CHUNK_SIZE) * (CHUNK_SIZE * CHUNK_SIZE) +
+           (z % CHUNK_SIZE) * CHUNK_SIZE + (x % CHUNK_SIZE);
+  }
 
   // Inline O(1) accessor (Trap 61: offset applied here)
+  // Hot chunks read raw bytes; cold chunks decode in place.
   inline uint8_t get_voxel(int x, int y, int z) const {
     if (x < 0 || x >= MAP_CHUNKS_X * CHUNK_SIZE || y < 0 ||
         y >= MAP_CHUNKS_Y * CHUNK_SIZE || z < 0 ||
         z >= MAP_CHUNKS_Z * CHUNK_SIZE)
       return VMAT_AIR;
 
-    int cx = x / CHUNK_SIZE;
-    int cy = y / CHUNK_SIZE;
-    int cz = z / CHUNK_SIZE;
-    uint16_t pool_idx = chunk_map[(cy * MAP_CHUNKS_Z + cz) * MAP_CHUNKS_X + cx];
+    uint32_t pool_idx = chunk_map[chunk_index(
+        x / CHUNK_SIZE, y / CHUNK_SIZE, z / CHUNK_SIZE)];
 
     if (pool_idx == 0)
       return VMAT_AIR;
     if (pool_idx == 1)
       return VMAT_EARTH;
 
-    return chunk_pool[pool_idx]
-        .voxels[(y % CHUNK_SIZE) * (CHUNK_SIZE * CHUNK_SIZE) +
-                (z % CHUNK_SIZE) * CHUNK_SIZE + (x % CHUNK_SIZE)];
+    const VoxelChunk &chunk = chunk_pool[pool_idx];
+    int local = local_index(x, y, z);
+    if (chunk.hot_slot != VOXEL_NO_HOT_SLOT)
+      return hot_pool[chunk.hot_slot].voxels[local];
+    return chunk.read_packed(local);
   }
 
   // Set voxel — allocates chunk from pool if needed
@@ -543,34 +1091,25 @@ struct VoxelGrid {
         z >= MAP_CHUNKS_Z * CHUNK_SIZE)
       return;
 
-    int cx = x / CHUNK_SIZE;
-    int cy = y / CHUNK_SIZE;
-    int cz = z / CHUNK_SIZE;
-    int map_idx = (cy * MAP_CHUNKS_Z + cz) * MAP_CHUNKS_X + cx;
-    uint16_t pool_idx = chunk_map[map_idx];
+    int map_idx = chunk_index(x / CHUNK_SIZE, y / CHUNK_SIZE, z / CHUNK_SIZE);
+    uint32_t pool_idx = chunk_map[map_idx];
 
     // Allocate chunk from pool if currently implicit (air/earth)
     if (pool_idx < 2) {
-      if (active_chunk_count >= MAX_ACTIVE_CHUNKS)
+      pool_idx = alloc_chunk(map_idx);
+      if (pool_idx == 0)
         return; // Pool exhausted
-      uint16_t new_idx = active_chunk_count++;
-      chunk_map[map_idx] = new_idx;
-      // Initialize chunk with the implicit material
-      std::memset(chunk_pool[new_idx].voxels,
-                  (pool_idx == 0) ? VMAT_AIR : VMAT_EARTH, CHUNK_VOLUME);
-      chunk_pool[new_idx].solid_count = (pool_idx == 1) ? CHUNK_VOLUME : 0;
-      chunk_pool[new_idx].dirty_mesh = 0;
-      chunk_pool[new_idx].dirty_flow = 0;
-      chunk_pool[new_idx].needs_stability_bfs = 0;
-      pool_idx = new_idx;
     }
 
     VoxelChunk &chunk = chunk_pool[pool_idx];
-    int local = (y % CHUNK_SIZE) * (CHUNK_SIZE * CHUNK_SIZE) +
-                (z % CHUNK_SIZE) * CHUNK_SIZE + (x % CHUNK_SIZE);
+    int local = local_index(x, y, z);
+    uint8_t *voxels = hot_voxels(pool_idx);
 
-    uint8_t old = chunk.voxels[local];
-    chunk.voxels[local] = mat;
+    uint8_t old = voxels[local];
+    if (old == mat)
+      return;
+    voxels[local] = mat;
+    write_through(chunk, local, mat);
 
     // Update solid count
     if (old != VMAT_AIR && mat == VMAT_AIR)
@@ -579,11 +1118,182 @@ struct VoxelGrid {
       chunk.solid_count++;
 
     // Flag chunk as dirty
+    chunk.edit_gen = edit_generation;
+    chunk.dirty_mesh = 1;
+    chunk.dirty_flow = 1;
+    chunk.dirty_height = 1;
+    chunk.needs_stability_bfs = 1;
+  }
+
+  // Worker-safe set_voxel (M13.7): writes only into a chunk that is
+  // already resident in the hot cache — never allocates, faults or
+  // evicts, so disjoint chunk sets can be edited concurrently.
+  // Returns false (nothing written) when the chunk is not resident.
+  inline bool set_voxel_if_hot(int x, int y, int z, uint8_t mat) {
+    if (x < 0 || x >= MAP_CHUNKS_X * CHUNK_SIZE || y < 0 ||
+        y >= MAP_CHUNKS_Y * CHUNK_SIZE || z < 0 ||
+        z >= MAP_CHUNKS_Z * CHUNK_SIZE)
+      return true; // Off-map: dropped, same as set_voxel
+
+    uint32_t pool_idx =
+        chunk_map[chunk_index(x / CHUNK_SIZE, y / CHUNK_SIZE, z / CHUNK_SIZE)];
+    if (pool_idx < 2)
+      return false;
+    VoxelChunk &chunk = chunk_pool[pool_idx];
+    if (chunk.hot_slot == VOXEL_NO_HOT_SLOT)
+      return false;
+
+    uint8_t *voxels = hot_pool[chunk.hot_slot].voxels;
+    int local = local_index(x, y, z);
+    uint8_t old = voxels[local];
+    if (old == mat)
+      return true;
+    voxels[local] = mat;
+    chunk.payload_stale = 1; // Repacked on eviction
+    chunk.edit_gen = edit_generation;
+
+    if (old != VMAT_AIR && mat == VMAT_AIR)
+      chunk.solid_count--;
+    else if (old == VMAT_AIR && mat != VMAT_AIR)
+      chunk.solid_count++;
+
     chunk.dirty_mesh = 1;
     chunk.dirty_flow = 1;
+    chunk.dirty_height = 1;
     chunk.needs_stability_bfs = 1;
+    return true;
   }
 
+  // ── Region Edit (M13.6) ──
+  // Visits every chunk overlapping the voxel box [x0..x1]×[y0..y1]×[z0..z1]
+  // exactly once: one chunk_map lookup, one hot-cache fault, one bulk
+  // solid_count update and one set of dirty flags per chunk. The callback
+  // indexes the raw 4KB chunk directly:
+  //   VoxelEditResult fn(uint8_t *voxels, const VoxelEditSpan &span)
+  // skip_air: air sentinels and empty pool chunks are never visited
+  // (destruction cannot change them, and skipping avoids allocation).
+  template <typename Fn>
+  inline void edit_region(int x0, int y0, int z0, int x1, int y1, int z1,
+                          bool skip_air, Fn &&fn) {
+    constexpr int MAX_X = MAP_CHUNKS_X * CHUNK_SIZE - 1;
+    constexpr int MAX_Y = MAP_CHUNKS_Y * CHUNK_SIZE - 1;
+    constexpr int MAX_Z = MAP_CHUNKS_Z * CHUNK_SIZE - 1;
+    x0 = x0 < 0 ? 0 : x0;
+    y0 = y0 < 0 ? 0 : y0;
+    z0 = z0 < 0 ? 0 : z0;
+    x1 = x1 > MAX_X ? MAX_X : x1;
+    y1 = y1 > MAX_Y ? MAX_Y : y1;
+    z1 = z1 > MAX_Z ? MAX_Z : z1;
+    if (x0 > x1 || y0 > y1 || z0 > z1)
+      return;
+
+    for (int cy = y0 / CHUNK_SIZE; cy <= y1 / CHUNK_SIZE; cy++) {
+      for (int cz = z0 / CHUNK_SIZE; cz <= z1 / CHUNK_SIZE; cz++) {
+        for (int cx = x0 / CHUNK_SIZE; cx <= x1 / CHUNK_SIZE; cx++) {
+          int map_idx = chunk_index(cx, cy, cz);
+          uint32_t pool_idx = chunk_map[map_idx];
+          if (skip_air && (pool_idx == 0 ||
+                           (pool_idx >= 2 &&
+                            chunk_pool[pool_idx].solid_count == 0)))
+            continue;
+          if (pool_idx < 2) {
+            pool_idx = alloc_chunk(map_idx);
+            if (pool_idx == 0)
+              return; // Pool exhausted
+          }
+
+          VoxelEditSpan span;
+          span.ox = cx * CHUNK_SIZE;
+          span.oy = cy * CHUNK_SIZE;
+          span.oz = cz * CHUNK_SIZE;
+          span.lx0 = (x0 > span.ox ? x0 : span.ox) - span.ox;
+          span.ly0 = (y0 > span.oy ? y0 : span.oy) - span.oy;
+          span.lz0 = (z0 > span.oz ? z0 : span.oz) - span.oz;
+          span.lx1 = (x1 < span.ox + CHUNK_SIZE - 1 ? x1
+                                                    : span.ox + CHUNK_SIZE - 1) -
+                     span.ox;
+          span.ly1 = (y1 < span.oy + CHUNK_SIZE - 1 ? y1
+                                                    : span.oy + CHUNK_SIZE - 1) -
+                     span.oy;
+          span.lz1 = (z1 < span.oz + CHUNK_SIZE - 1 ? z1
+                                                    : span.oz + CHUNK_SIZE - 1) -
+                     span.oz;
+
+          VoxelEditResult res = fn(hot_voxels(pool_idx), span);
+          if (res.changed == 0)
+            continue;
+
+          VoxelChunk &chunk = chunk_pool[pool_idx];
+          chunk.solid_count = (uint16_t)(chunk.solid_count + res.solid_delta);
+          chunk.payload_stale = 1; // Bulk edits bypass write-through
+          chunk.edit_gen = edit_generation;
+          chunk.dirty_mesh = 1;
+          chunk.dirty_flow = 1;
+          chunk.dirty_height = 1;
+          chunk.needs_stability_bfs = 1;
+        }
+      }
+    }
+  }
+
+  // Rubble gravity: lowest y a voxel dropped at (x, y, z) comes to rest
+  // on. Skips whole air-sentinel chunks instead of probing voxel by voxel.
+  int column_floor(int x, int y, int z) const;
+
+  // ── Persistence (voxel_file.cpp, M13.8) ──
+  // File: 64B header | earth-sentinel runs | sparse chunk index (32B per
+  // chunk) | packed payloads, 4B-aligned, exactly as held in memory.
+  // save_file: full snapshot. save_delta: only chunks edited since the
+  // last save/load. Both return false on I/O failure.
+  bool save_file(const char *path);
+  bool save_delta(const char *path);
+  // Replaces the grid with a mapped file. Headers are built from the
+  // index; payloads stay in the mapping and page in on first touch.
+  bool load_file(const char *path);
+  // Applies a delta on top of the loaded state (must chain: its base
+  // generation must equal saved_generation).
+  bool apply_delta(const char *path);
+  // Region activation: copies mapped payloads of every chunk in the
+  // column box [cx0..cx1]×[cz0..cz1] to the heap, ahead of first use.
+  void stream_in(int cx0, int cz0, int cx1, int cz1);
+  void close_file_map();
+
+  // ── Terrain (voxel_terrain.cpp, M13.9) ──
+  // Replaces the grid with generated terrain. Chunk columns are built
+  // on up to max_threads workers of shared_worker_pool(); fully
+  // solid/empty chunks become the earth/air sentinels and only surface
+  // chunks reach the pool.
+  // Returns false, leaving an empty grid, if the pool cannot hold them.
+  bool generate_terrain(const TerrainParams &params, int max_threads);
+
+  // ── Storage management (voxel_storage.cpp) ──
+  // Promotes the implicit sentinel at map_idx to a uniform pool chunk.
+  // Returns 0 if the pool is exhausted.
+  uint32_t alloc_chunk(int map_idx);
+  // Grows chunk_pool to hold at least `count` headers. Invalidates
+  // VoxelChunk references. Returns false at MAX_ACTIVE_CHUNKS.
+  bool reserve_chunks(uint32_t count);
+  // Raw 4KB view of a chunk, faulting it into the hot cache if cold.
+  uint8_t *hot_voxels(uint32_t pool_idx);
+  // Faults a chunk in and keeps the clock off its slot until unpinned.
+  // Pins must leave most of the cache evictable.
+  void pin_hot(uint32_t pool_idx);
+  void unpin_hot(uint32_t pool_idx);
+  // Copies a chunk's voxels into out[4096] without touching the hot
+  // cache (reads the hot slot if resident, else decodes the payload).
+  void read_voxels(uint32_t pool_idx, uint8_t *out) const;
+  // Patches the packed payload for one write, or marks it stale.
+  void write_through(VoxelChunk &chunk, int local, uint8_t mat);
+  // Repacks stale hot chunks and returns every slot to the free state.
+  void flush_hot_cache();
+  // Repacks stale hot chunks but keeps them resident (pre-save).
+  void repack_stale();
+  // Encodes a raw 4KB chunk into a zeroed header (smallest encoding).
+  // Pure function of its inputs — safe on worker threads.
+  static void pack_voxels(VoxelChunk &chunk, const uint8_t *voxels);
+  // Header + payload + occupied hot-slot bytes for all pool chunks.
+  size_t storage_bytes() const;
+
   // World-space float → voxel int (Trap 61: +2048 offset)
   static inline void world_to_voxel(float wx, float wy, float wz, int &vx,
                                     int &vy, int &vz) {
@@ -593,6 +1303,41 @@ struct VoxelGrid {
   }
 };
 
+// ─── M13.10: Terrain Heightmap (Singleton) ───────────────────
+// Cached surface height (first air voxel above the ground) for every
+// 1m voxel column, derived from VoxelGrid. Lets ballistics find the
+// ground with one byte load instead of probing voxels per shot.
+// Kept in sync by refresh(): chunk columns whose chunks carry
+// dirty_height are re-derived and the flag is consumed (dirty_flow is
+// left for the flow-field thread).
+constexpr int HEIGHTMAP_WIDTH = MAP_CHUNKS_X * CHUNK_SIZE; // 4096
+constexpr int HEIGHTMAP_DEPTH = MAP_CHUNKS_Z * CHUNK_SIZE; // 4096
+
+struct TerrainHeightmap {
+  // 16MB heap array [z * HEIGHTMAP_WIDTH + x] — pointer keeps the
+  // singleton copy cheap, same as VoxelGrid.
+  uint8_t *height;
+
+  void allocate();
+  void release();
+
+  // Re-derives every column (after generate_terrain / load_file) and
+  // clears dirty_height on the whole pool.
+  void rebuild(VoxelGrid &grid);
+  // Re-derives chunk columns [cx0..cx1]×[cz0..cz1] that hold a chunk
+  // with dirty_height set. Cheap no-op for clean columns.
+  void refresh(VoxelGrid &grid, int cx0, int cz0, int cx1, int cz1);
+
+  // Ground height in meters under a world-space point (0 off-map).
+  inline float surface(float wx, float wz) const {
+    int x = (int)(wx + VOXEL_WORLD_OFFSET);
+    int z = (int)(wz + VOXEL_WORLD_OFFSET);
+    if (x < 0 || x >= HEIGHTMAP_WIDTH || z < 0 || z >= HEIGHTMAP_DEPTH)
+      return 0.0f;
+    return (float)height[z * HEIGHTMAP_WIDTH + x];
+  }
+};
+
 // ─── Destruction Event Queue (Transient Singleton) ───────────
 struct VoxelDestructionEvent {
   float x, y, z; // World-space center
@@ -13,17 +13,41 @@
 // ORDER MATTERS: Core managers first, then systems that depend on them.
 // ═════════════════════════════════════════════════════════════════════════════
 
-// 1. Core (component registration, spawn, process loop)
+// 1. Core (Godot node, process loop) + the host-agnostic world setup,
+// centroid pass and spawns + Godot's logging/file I/O + the worker
+// pool every fan-out shares
 #include "world_manager.cpp"
+#include "sim_world.cpp"
+#include "platform_godot.cpp"
+#include "worker_pool.cpp"
 
-// 2. Rendering Bridge (shadow buffers, transform packing)
+// 2. Rendering Bridge (shadow buffers, transform packing) + the
+// Godot-free frame ring behind its threaded render frames
 #include "rendering_bridge.cpp"
+#include "render_frame_ring.cpp"
 
 // 3. Data (JSON prefab loader)
 #include "prefab_loader.cpp"
 
-// 4. Systems (all gameplay systems)
+// 4. Voxel storage (palette/RLE codec + hot cache) + terrain generator
+#include "voxel_storage.cpp"
+#include "voxel_terrain.cpp"
+
+// 5. Systems (all gameplay systems) + formation layout/matching + the
+// order queue they drain + replay record/playback of those orders +
+// whole-world snapshots + the per-system profiler
+#include "formation_layout.cpp"
 #include "musket_systems.cpp"
+#include "sim_commands.cpp"
+#include "sim_replay.cpp"
+#include "sim_snapshot.cpp"
+#include "sim_profiler.cpp"
+
+// 6. Networking (10Hz macro-state snapshots)
+#include "macro_sync.cpp"
+
+// 7. Voxel save files (mmap — platform headers, so keep it last)
+#include "voxel_file.cpp"
 
 // ─────────────────────────────────────────────────────────────────────────────
 // Future Milestones — include here as you build them:
@@ -1,7 +1,13 @@
 #include "musket_systems.h"
 #include "musket_components.h"
+#include "sim_commands.h"
+#include "sim_profiler.h"
+#include "worker_pool.h"
+#include <algorithm>
 #include <cmath>
+#include <atomic>
 #include <cstring>
+#include <thread>
 #include <vector>
 
 // NOTE: g_macro_battalions is defined in world_manager.cpp (the golden TU).
@@ -10,6 +16,182 @@
 
 namespace musket {
 
+// ── Simulation RNG inputs ────────────────────────────────────
+// World seed from the SimRng singleton (0 when a test world omits it)
+// and the SimClock tick (frame count without one): never float time.
+static inline uint64_t sim_seed(const flecs::world &w) {
+  const SimRng *rng = w.try_get<SimRng>();
+  return rng ? rng->seed : 0;
+}
+static inline uint64_t sim_tick(const flecs::world &w) {
+  const SimClock *clock = w.try_get<SimClock>();
+  return clock ? clock->tick : (uint64_t)w.get_info()->frame_count_total;
+}
+
+// ═════════════════════════════════════════════════════════════
+// SIMULATION CLOCK (fixed 60Hz ticks, per-group rates)
+// ═════════════════════════════════════════════════════════════
+
+// Rate-filter entities that drive the slower groups (physics runs on
+// every tick and needs none)
+static const char *const SIM_GROUP_SOURCE[SIM_GROUP_COUNT] = {
+    nullptr, "SimGroupCA", "SimGroupEconomy", "SimGroupNet"};
+
+flecs::entity sim_group_source(flecs::world &ecs, int group) {
+  if (group <= SIM_GROUP_PHYSICS || group >= SIM_GROUP_COUNT)
+    return flecs::entity();
+  return ecs.lookup(SIM_GROUP_SOURCE[group]);
+}
+
+void set_sim_group_rate(flecs::world &ecs, int group, int hz) {
+  if (group <= SIM_GROUP_PHYSICS || group >= SIM_GROUP_COUNT)
+    return; // Physics is the tick itself
+  hz = hz < 1 ? 1 : (hz > SIM_TICK_HZ ? SIM_TICK_HZ : hz);
+  ecs.timer(sim_group_source(ecs, group)).rate(SIM_TICK_HZ / hz);
+  ecs.get_mut<SimClock>().group_hz[group] = (uint16_t)hz;
+}
+
+void register_sim_clock(flecs::world &ecs) {
+  SimClock clock = {};
+  clock.max_catchup = 4; // 15Hz render floor before the sim slows down
+  clock.group_hz[SIM_GROUP_PHYSICS] = SIM_TICK_HZ;
+  ecs.set<SimClock>(clock);
+
+  ecs.timer(SIM_GROUP_SOURCE[SIM_GROUP_CA]);
+  ecs.timer(SIM_GROUP_SOURCE[SIM_GROUP_ECONOMY]);
+  ecs.timer(SIM_GROUP_SOURCE[SIM_GROUP_NET]);
+  set_sim_group_rate(ecs, SIM_GROUP_CA, 5);
+  set_sim_group_rate(ecs, SIM_GROUP_ECONOMY, 1);
+  set_sim_group_rate(ecs, SIM_GROUP_NET, 10);
+
+  // Counts the tick before any other system runs, so every system in
+  // one progress() sees the same id and no two progress() calls share
+  // one (whoever drives the world: the fixed-step loop or a test)
+  ecs.system("SimClockTick").kind(flecs::OnLoad).run([](flecs::iter &it) {
+    it.world().get_mut<SimClock>().tick++;
+  });
+}
+
+int advance_simulation(flecs::world &ecs, double real_dt,
+                       void (*pre_tick)(flecs::world &)) {
+  const int steps = ecs.get_mut<SimClock>().bank(real_dt);
+  for (int s = 0; s < steps; s++)
+    step_simulation(ecs, pre_tick);
+  return steps;
+}
+
+void step_simulation(flecs::world &ecs, void (*pre_tick)(flecs::world &)) {
+  ProfileScope tick(ecs, PROFILE_TICK);
+  {
+    ProfileScope drain(ecs, PROFILE_COMMAND_DRAIN);
+    // Orders land before the centroid pass
+    drain.entities = (uint32_t)drain_sim_commands(ecs);
+  }
+  if (pre_tick) {
+    ProfileScope centroids(ecs, PROFILE_CENTROIDS);
+    pre_tick(ecs);
+    centroids.entities = (uint32_t)g_battalion_pool.live_count;
+  }
+  ecs.progress((float)SIM_TICK_DT);
+}
+
+// ═════════════════════════════════════════════════════════════
+// BULK SPAWN (one archetype insert per block)
+// ═════════════════════════════════════════════════════════════
+
+// ecs_bulk_init places every soldier straight into the final table:
+// one column grow + memcpy per component instead of ten archetype
+// moves per soldier. Block constants are expanded into columns here
+// (spawn-time scratch, not per-frame).
+const flecs::entity_t *spawn_infantry_block(flecs::world &ecs,
+                                            const InfantryBlock &b) {
+  const int n = b.count;
+  if (n <= 0)
+    return nullptr;
+
+  std::vector<Velocity> vel(n, Velocity{0.0f, 0.0f});
+  std::vector<MovementStats> stats(n, b.stats);
+  std::vector<TeamId> team(n, TeamId{b.team});
+  std::vector<BattalionId> bat(n, BattalionId{b.bat_id});
+  std::vector<MusketState> musket(n, b.musket);
+  std::vector<FormationDefense> defense(n, b.defense);
+  std::vector<RenderSlot> slot(n);
+  for (int i = 0; i < n; i++)
+    slot[i] = {b.bat_id, b.first_slot + (uint32_t)i};
+
+  ecs_bulk_desc_t desc = {};
+  desc.count = n;
+  const ecs_id_t ids[] = {ecs.id<Position>(),
+                          ecs.id<Velocity>(),
+                          ecs.id<SoldierFormationTarget>(),
+                          ecs.id<MovementStats>(),
+                          ecs.id<TeamId>(),
+                          ecs.id<BattalionId>(),
+                          ecs.id<MusketState>(),
+                          ecs.id<FormationDefense>(),
+                          ecs.id<RenderSlot>(),
+                          ecs.id<IsAlive>()};
+  void *data[] = {(void *)b.pos,
+                  vel.data(),
+                  (void *)b.target,
+                  stats.data(),
+                  team.data(),
+                  bat.data(),
+                  musket.data(),
+                  defense.data(),
+                  slot.data(),
+                  nullptr}; // IsAlive is a tag
+  static_assert(sizeof(ids) / sizeof(ids[0]) == sizeof(data) / sizeof(data[0]),
+                "one data column per id");
+  for (size_t k = 0; k < sizeof(ids) / sizeof(ids[0]); k++)
+    desc.ids[k] = ids[k];
+  desc.data = data;
+  return ecs_bulk_init(ecs, &desc);
+}
+
+// ── Spring-damper kernel (CORE_MATH.md §1) ─────────────────────
+constexpr float SPRING_MAX_SPEED = 4.0f; // m/s (infantry)
+
+// exp(-x) for x >= 0 as the reciprocal of its 4th-order Taylor series.
+// Stays in (0, 1] for every x — unconditionally stable like std::exp
+// (Trap 19) — and has no libm call, so the caller's loop vectorizes.
+// Relative error < 1e-4 for x <= 0.5 (a 60Hz tick gives x ≈ 0.24).
+static inline float decay_exp(float x) {
+  return 1.0f /
+         (1.0f +
+          x * (1.0f + x * (0.5f + x * (1.0f / 6.0f + x * (1.0f / 24.0f)))));
+}
+
+// Speed clamp — prevents supersonic rubber-banding. Branch-free: the
+// scale is exactly 1.0 below MAX_SPEED.
+static inline void clamp_and_integrate(Position &p, Velocity &v, float dt) {
+  constexpr float MAX_SQ = SPRING_MAX_SPEED * SPRING_MAX_SPEED;
+  float speed_sq = (v.vx * v.vx) + (v.vz * v.vz);
+  float scale =
+      SPRING_MAX_SPEED / std::sqrt(speed_sq > MAX_SQ ? speed_sq : MAX_SQ);
+  v.vx *= scale;
+  v.vz *= scale;
+
+  p.x += v.vx * dt;
+  p.z += v.vz * dt;
+}
+
+// slot_x/z: battalion anchor + the soldier's rotated offset, world space.
+static inline void spring_damper_step(Position &p, Velocity &v, float slot_x,
+                                      float slot_z, float stiffness,
+                                      float damping, float dt) {
+  float dx = slot_x - p.x;
+  float dz = slot_z - p.z;
+
+  v.vx += (stiffness * dx) * dt;
+  v.vz += (stiffness * dz) * dt;
+  float decay = decay_exp(damping * dt);
+  v.vx *= decay;
+  v.vz *= decay;
+
+  clamp_and_integrate(p, v, dt);
+}
+
 void register_movement_systems(flecs::world &ecs) {
 
   // ═════════════════════════════════════════════════════════════
@@ -19,100 +201,376 @@ void register_movement_systems(flecs::world &ecs) {
   // attached to formation slots via critically-damped springs.
   // O(1) per entity at 60Hz.
   //
-  // NOTE: CORE_MATH.md shows Flecs v3 .iter() syntax.
-  //       Flecs v4.1.4 system_builder only has .each().
-  //       Math is identical; only the lambda signature changed.
+  // Split by archetype so no soldier is probed for components:
+  //   1a. Line infantry  — stiffness × battalion flag cohesion
+  //   1b. Routing        — springs disconnected (stiffness 0)
+  //   1c. Cavalry        — walk (state 0) only; charges are ballistic
+  // Each runs over whole table columns via .run(); per-battalion
+  // terms are hoisted out of the soldier loop.
   // ═════════════════════════════════════════════════════════════
+
+  // ── 1a: Line infantry ───────────────────────────────────────
   ecs.system<Position, Velocity, const SoldierFormationTarget,
              const BattalionId>("SpringDamperPhysics")
       .with<IsAlive>()
-      .each([](flecs::entity e, Position &p, Velocity &v,
-               const SoldierFormationTarget &target, const BattalionId &bat) {
-        if (e.has<CavalryState>() && e.get<CavalryState>().state_flags != 0)
+      .without<Routing>()
+      .without<CavalryState>()
+      .run([](flecs::iter &it) {
+        float dt = it.delta_time();
+        if (dt <= 0.0f) {
+          it.fini();
           return;
+        }
 
-        float dt = e.world().delta_time();
-        if (dt <= 0.0f)
+        // M7 Phase A: flag cohesion scales stiffness (Trap 21: floor at
+        // 0.2). √(base·cohesion) = √base·√cohesion, so the cohesion root
+        // is taken once per battalion, not once per soldier. The double
+        // anchor is narrowed to float once per battalion too, and the
+        // slot is anchor + offset rotated by the battalion facing.
+        // Static scratch indexed by id; only live ids are filled.
+        static float bat_cohesion[MAX_BATTALIONS];
+        static float bat_sqrt_cohesion[MAX_BATTALIONS];
+        static float bat_anchor_x[MAX_BATTALIONS];
+        static float bat_anchor_z[MAX_BATTALIONS];
+        static float bat_dir_x[MAX_BATTALIONS];
+        static float bat_dir_z[MAX_BATTALIONS];
+        for (int k = 0; k < g_battalion_pool.live_count; k++) {
+          const int b = g_battalion_pool.live[k];
+          const MacroBattalion &mb = g_macro_battalions[b];
+          bat_cohesion[b] = mb.flag_cohesion;
+          bat_sqrt_cohesion[b] = std::sqrt(bat_cohesion[b]);
+          bat_anchor_x[b] = (float)mb.anchor_x;
+          bat_anchor_z[b] = (float)mb.anchor_z;
+          bat_dir_x[b] = mb.dir_x;
+          bat_dir_z[b] = mb.dir_z;
+        }
+
+        while (it.next()) {
+          Position *p = &it.field<Position>(0)[0];
+          Velocity *v = &it.field<Velocity>(1)[0];
+          const SoldierFormationTarget *t =
+              &it.field<const SoldierFormationTarget>(2)[0];
+          const BattalionId *bat = &it.field<const BattalionId>(3)[0];
+          const int n = (int)it.count();
+          for (int i = 0; i < n; i++) {
+            uint32_t b = bat[i].id % MAX_BATTALIONS;
+            float stiffness = t[i].base_stiffness * bat_cohesion[b];
+            float damping = t[i].damping_multiplier *
+                            std::sqrt(t[i].base_stiffness) *
+                            bat_sqrt_cohesion[b];
+            float gx, gz;
+            battalion_to_world(t[i].offset_x, t[i].offset_z, bat_dir_x[b],
+                               bat_dir_z[b], gx, gz);
+            spring_damper_step(p[i], v[i], bat_anchor_x[b] + gx,
+                               bat_anchor_z[b] + gz, stiffness, damping, dt);
+          }
+        }
+      });
+
+  // ── 1b: Routing (any arm) ───────────────────────────────────
+  // Stiffness and damping are 0: velocity comes from the routing
+  // behaviour and is only clamped and integrated. Charging cavalry
+  // (optional CavalryState, state != 0) is left to CavalryBallistics.
+  ecs.system<Position, Velocity, const CavalryState *>("SpringDamperRouting")
+      .with<IsAlive>()
+      .with<Routing>()
+      .with<SoldierFormationTarget>()
+      .with<BattalionId>()
+      .run([](flecs::iter &it) {
+        float dt = it.delta_time();
+        if (dt <= 0.0f) {
+          it.fini();
           return;
+        }
 
-        float dx = (float)target.target_x - p.x;
-        float dz = (float)target.target_z - p.z;
-
-        // M7 Phase A: Apply flag cohesion decay (Trap 21: floor at 0.2)
-        uint32_t bat_id = bat.id % MAX_BATTALIONS;
-        float stiffness =
-            target.base_stiffness * g_macro_battalions[bat_id].flag_cohesion;
-        if (e.has<Routing>())
-          stiffness = 0.0f; // Routing orthogonal override
-        float damping = target.damping_multiplier * std::sqrt(stiffness);
-
-        // Trap 19 Fix: Exponential decay damping (unconditionally stable)
-        v.vx += (stiffness * dx) * dt;
-        v.vz += (stiffness * dz) * dt;
-        float decay = std::exp(-damping * dt);
-        v.vx *= decay;
-        v.vz *= decay;
-
-        // Speed clamp — prevents supersonic rubber-banding
-        constexpr float MAX_SPEED = 4.0f; // m/s (infantry)
-        float speed_sq = (v.vx * v.vx) + (v.vz * v.vz);
-        if (speed_sq > (MAX_SPEED * MAX_SPEED)) {
-          float inv_speed = 1.0f / std::sqrt(speed_sq);
-          v.vx = v.vx * inv_speed * MAX_SPEED;
-          v.vz = v.vz * inv_speed * MAX_SPEED;
+        while (it.next()) {
+          Position *p = &it.field<Position>(0)[0];
+          Velocity *v = &it.field<Velocity>(1)[0];
+          const CavalryState *cs =
+              it.is_set(2) ? &it.field<const CavalryState>(2)[0] : nullptr;
+          const int n = (int)it.count();
+          for (int i = 0; i < n; i++) {
+            if (cs && cs[i].state_flags != 0)
+              continue;
+            clamp_and_integrate(p[i], v[i], dt);
+          }
         }
+      });
 
-        p.x += v.vx * dt;
-        p.z += v.vz * dt;
+  // ── 1c: Cavalry at the walk ─────────────────────────────────
+  // Same spring as the line; charging/disordered horses (state != 0)
+  // are skipped here and driven by CavalryBallistics.
+  ecs.system<Position, Velocity, const SoldierFormationTarget,
+             const BattalionId, const CavalryState>("SpringDamperCavalry")
+      .with<IsAlive>()
+      .without<Routing>()
+      .run([](flecs::iter &it) {
+        float dt = it.delta_time();
+        if (dt <= 0.0f) {
+          it.fini();
+          return;
+        }
+
+        while (it.next()) {
+          Position *p = &it.field<Position>(0)[0];
+          Velocity *v = &it.field<Velocity>(1)[0];
+          const SoldierFormationTarget *t =
+              &it.field<const SoldierFormationTarget>(2)[0];
+          const BattalionId *bat = &it.field<const BattalionId>(3)[0];
+          const CavalryState *cs = &it.field<const CavalryState>(4)[0];
+          const int n = (int)it.count();
+          for (int i = 0; i < n; i++) {
+            if (cs[i].state_flags != 0)
+              continue;
+            const MacroBattalion &mb =
+                g_macro_battalions[bat[i].id % MAX_BATTALIONS];
+            float stiffness = t[i].base_stiffness * mb.flag_cohesion;
+            float damping = t[i].damping_multiplier * std::sqrt(stiffness);
+            float gx, gz;
+            battalion_to_world(t[i].offset_x, t[i].offset_z, mb.dir_x,
+                               mb.dir_z, gx, gz);
+            spring_damper_step(p[i], v[i], (float)mb.anchor_x + gx,
+                               (float)mb.anchor_z + gz, stiffness, damping,
+                               dt);
+          }
+        }
       });
 
   // ═════════════════════════════════════════════════════════════
-  // SYSTEM 2: Formation March Order
+  // SYSTEM 2: Battalion March
   //
-  // When a soldier has a MovementOrder, slide their formation
-  // slot target toward the order destination each frame.
-  // Once the slot arrives, mark the order as complete.
+  // A march order moves the battalion, not its soldiers: the anchor
+  // advances toward march_x/z and the facing wheels toward the line
+  // of march. Slots are anchor + rotated offset at integration time,
+  // so the springs carry every soldier along. O(1) per battalion; no
+  // per-soldier component is written, added or removed.
   // ═════════════════════════════════════════════════════════════
-  ecs.system<SoldierFormationTarget, MovementOrder>("FormationOrderMove")
-      .with<IsAlive>()
-      .each([](flecs::entity e, SoldierFormationTarget &target,
-               MovementOrder &order) {
-        if (order.arrived)
-          return;
+  ecs.system("BattalionMarchSystem").run([](flecs::iter &it) {
+    float dt = it.delta_time();
+    if (dt <= 0.0f)
+      return;
 
-        float dt = e.world().delta_time();
-        if (dt <= 0.0f)
-          return;
+    constexpr float MARCH_SPEED = 3.0f;  // m/s (march pace)
+    constexpr float ARRIVAL_DIST = 0.05f; // Snap the last few cm
+
+    for (int k = 0; k < g_battalion_pool.live_count; k++) {
+      MacroBattalion &mb = g_macro_battalions[g_battalion_pool.live[k]];
+      if (!mb.marching)
+        continue;
+
+      double dx = mb.march_x - mb.anchor_x;
+      double dz = mb.march_z - mb.anchor_z;
+      float dist = (float)std::sqrt(dx * dx + dz * dz);
+      if (dist < ARRIVAL_DIST) {
+        mb.anchor_x = mb.march_x;
+        mb.anchor_z = mb.march_z;
+        mb.marching = false;
+        continue;
+      }
 
-        constexpr float MARCH_SPEED = 3.0f;  // m/s (march pace)
-        constexpr float ARRIVAL_DIST = 1.0f; // Close enough
+      // M7 Phase B: Drummer speed buff (+10%)
+      float speed = MARCH_SPEED * (mb.drummer_alive ? 1.10f : 1.0f);
+      float hx = (float)dx / dist, hz = (float)dz / dist;
+
+      // Wheel toward the heading. The rate is capped so the outer
+      // flank (ext_w from the anchor) never outpaces the march.
+      float cross = mb.dir_x * hz - mb.dir_z * hx;
+      float dot = mb.dir_x * hx + mb.dir_z * hz;
+      float turn = std::atan2(cross, dot);
+      float max_turn = speed / std::max(mb.ext_w, 1.0f) * dt;
+      turn = std::max(-max_turn, std::min(max_turn, turn));
+      float c = std::cos(turn), s = std::sin(turn);
+      float nx = mb.dir_x * c - mb.dir_z * s;
+      float nz = mb.dir_x * s + mb.dir_z * c;
+      float inv_len = 1.0f / std::sqrt(nx * nx + nz * nz);
+      mb.dir_x = nx * inv_len;
+      mb.dir_z = nz * inv_len;
+
+      float step = std::min(speed * dt, dist); // Don't overshoot
+      mb.anchor_x += hx * step;
+      mb.anchor_z += hz * step;
+    }
+  });
 
-        // M7 Phase B: Drummer speed buff (+10%)
-        uint32_t bat_id = 0;
-        if (e.has<BattalionId>()) {
-          bat_id = e.get<BattalionId>().id % MAX_BATTALIONS;
+  // ═════════════════════════════════════════════════════════════
+  // SYSTEM 3: Formation Solve (M7.5 §12.1)
+  //
+  // Services every battalion queued in the FormationRoster in one
+  // frame, in three passes over the same cached query (no structural
+  // changes in between, so the iteration order is identical — the
+  // Trap 29 running index, per battalion):
+  //   1. count live members + centroid (the new anchor)
+  //   2. pack member positions, in the new battalion frame
+  //   3. write the matched slot back into each soldier
+  // Layout + matching run between 2 and 3 on the packed arrays.
+  // ═════════════════════════════════════════════════════════════
+  auto roster_q = ecs.query_builder<const Position, const BattalionId,
+                                    SoldierFormationTarget, FormationDefense>()
+                      .with<IsAlive>()
+                      .cached()
+                      .build();
+
+  ecs.system("FormationSolveSystem").run([roster_q](flecs::iter &it) {
+    FormationRoster *fr = it.world().try_get_mut<FormationRoster>();
+    if (!fr || fr->pending_count == 0)
+      return;
+    FormationRoster &r = *fr;
+
+    // ── Pass 1: live counts + centroids ──
+    // Static scratch (main thread only): too large for the stack at
+    // MAX_BATTALIONS
+    static int32_t count[MAX_BATTALIONS];
+    static double sum_x[MAX_BATTALIONS];
+    static double sum_z[MAX_BATTALIONS];
+    std::memset(count, 0, sizeof(count));
+    std::memset(sum_x, 0, sizeof(sum_x));
+    std::memset(sum_z, 0, sizeof(sum_z));
+    roster_q.run([&](flecs::iter &qi) {
+      while (qi.next()) {
+        const Position *p = &qi.field<const Position>(0)[0];
+        const BattalionId *bat = &qi.field<const BattalionId>(1)[0];
+        const int n = (int)qi.count();
+        for (int i = 0; i < n; i++) {
+          uint32_t b = bat[i].id % MAX_BATTALIONS;
+          if (r.pending_shape[b] < 0)
+            continue;
+          count[b]++;
+          sum_x[b] += p[i].x;
+          sum_z[b] += p[i].z;
         }
-        float speed_mult =
-            g_macro_battalions[bat_id].drummer_alive ? 1.10f : 1.0f;
-
-        // Direction from current slot to order destination
-        float dx = order.target_x - target.target_x;
-        float dz = order.target_z - target.target_z;
-        float dist_sq = dx * dx + dz * dz;
-
-        if (dist_sq < ARRIVAL_DIST * ARRIVAL_DIST) {
-          order.arrived = true;
+      }
+    });
+
+    int32_t total = 0;
+    for (int b = 0; b < MAX_BATTALIONS; b++) {
+      r.bat_start[b] = total;
+      r.bat_fill[b] = 0;
+      int32_t room = FORMATION_ROSTER_CAPACITY - total;
+      if (count[b] > room) {
+        r.dropped += (uint32_t)(count[b] - room);
+        count[b] = room;
+      }
+      total += count[b];
+
+      if (r.pending_shape[b] < 0 || count[b] == 0)
+        continue;
+      MacroBattalion &mb = g_macro_battalions[b];
+      mb.anchor_x = sum_x[b] / (double)count[b];
+      mb.anchor_z = sum_z[b] / (double)count[b];
+      mb.dir_x = r.pending_dir_x[b];
+      mb.dir_z = r.pending_dir_z[b];
+    }
+    r.bat_start[MAX_BATTALIONS] = total;
+
+    // ── Pass 2: pack members into the new frame ──
+    roster_q.run([&](flecs::iter &qi) {
+      while (qi.next()) {
+        const Position *p = &qi.field<const Position>(0)[0];
+        const BattalionId *bat = &qi.field<const BattalionId>(1)[0];
+        const int n = (int)qi.count();
+        for (int i = 0; i < n; i++) {
+          uint32_t b = bat[i].id % MAX_BATTALIONS;
+          if (r.pending_shape[b] < 0 || r.bat_fill[b] >= count[b])
+            continue;
+          const MacroBattalion &mb = g_macro_battalions[b];
+          int m = r.bat_start[b] + r.bat_fill[b]++;
+          world_to_battalion(p[i].x - (float)mb.anchor_x,
+                             p[i].z - (float)mb.anchor_z, mb.dir_x, mb.dir_z,
+                             r.member_x[m], r.member_z[m]);
+        }
+      }
+    });
+
+    // ── Layout + matching per battalion ──
+    // Each battalion owns a disjoint roster range, so workers from the
+    // shared pool claim whole battalions; the main thread works too
+    static int jobs[MAX_BATTALIONS];
+    int job_count = 0;
+    for (int b = 0; b < MAX_BATTALIONS; b++) {
+      if (r.pending_shape[b] < 0 || count[b] == 0)
+        continue;
+      g_macro_battalions[b].shape = (FormationShape)r.pending_shape[b];
+      r.bat_fill[b] = 0;
+      jobs[job_count++] = b;
+    }
+    std::atomic<int> next_job(0);
+    auto worker = [&]() {
+      for (;;) {
+        int j = next_job.fetch_add(1);
+        if (j >= job_count)
           return;
+        int b = jobs[j];
+        MacroBattalion &mb = g_macro_battalions[b];
+        r.layout(r.bat_start[b], count[b], mb.shape, mb.ext_w, mb.ext_d);
+        r.match(r.bat_start[b], count[b]);
+      }
+    };
+    shared_worker_pool().run(job_count, [&](int) { worker(); });
+
+    // ── Pass 3: write back ──
+    roster_q.run([&](flecs::iter &qi) {
+      while (qi.next()) {
+        const BattalionId *bat = &qi.field<const BattalionId>(1)[0];
+        SoldierFormationTarget *t = &qi.field<SoldierFormationTarget>(2)[0];
+        FormationDefense *fd = &qi.field<FormationDefense>(3)[0];
+        const int n = (int)qi.count();
+        for (int i = 0; i < n; i++) {
+          uint32_t b = bat[i].id % MAX_BATTALIONS;
+          if (r.pending_shape[b] < 0 || r.bat_fill[b] >= count[b])
+            continue;
+          int s = r.assigned[r.bat_start[b] + r.bat_fill[b]++];
+          t[i].offset_x = r.slot_x[s];
+          t[i].offset_z = r.slot_z[s];
+          t[i].face_x = r.slot_face_x[s];
+          t[i].face_z = r.slot_face_z[s];
+          t[i].can_shoot = r.slot_can_shoot[s] != 0;
+          t[i].rank_index = r.slot_rank[s];
+          fd[i].defense = formation_defense(g_macro_battalions[b].shape);
         }
+      }
+    });
 
-        float dist = std::sqrt(dist_sq);
-        float step = MARCH_SPEED * speed_mult * dt;
-        if (step > dist)
-          step = dist; // Don't overshoot
+    for (int b = 0; b < MAX_BATTALIONS; b++)
+      r.pending_shape[b] = -1;
+    r.pending_count = 0;
+  });
+}
 
-        float inv_dist = 1.0f / dist;
-        target.target_x += dx * inv_dist * step;
-        target.target_z += dz * inv_dist * step;
+// ═════════════════════════════════════════════════════════════
+// CLIENT VISUAL ECS (GDD §4.3)
+// Same kernel as 1a, but the battalion frame comes from VisualBattalions
+// (interpolated macro snapshots), never from the process globals.
+// ═════════════════════════════════════════════════════════════
+void register_visual_spring_system(flecs::world &ecs) {
+  ecs.system<Position, Velocity, const SoldierFormationTarget,
+             const BattalionId>("VisualSpringDamper")
+      .with<IsAlive>()
+      .run([](flecs::iter &it) {
+        float dt = it.delta_time();
+        if (dt <= 0.0f) {
+          it.fini();
+          return;
+        }
+        const VisualBattalions &vb = it.world().get<VisualBattalions>();
+
+        while (it.next()) {
+          Position *p = &it.field<Position>(0)[0];
+          Velocity *v = &it.field<Velocity>(1)[0];
+          const SoldierFormationTarget *t =
+              &it.field<const SoldierFormationTarget>(2)[0];
+          const BattalionId *bat = &it.field<const BattalionId>(3)[0];
+          const int n = (int)it.count();
+          for (int i = 0; i < n; i++) {
+            uint32_t b = bat[i].id % MAX_BATTALIONS;
+            float stiffness = t[i].base_stiffness * vb.cohesion[b];
+            float damping = t[i].damping_multiplier * std::sqrt(stiffness);
+            float gx, gz;
+            battalion_to_world(t[i].offset_x, t[i].offset_z, vb.dir_x[b],
+                               vb.dir_z[b], gx, gz);
+            spring_damper_step(p[i], v[i], vb.anchor_x[b] + gx,
+                               vb.anchor_z[b] + gz, stiffness, damping, dt);
+          }
+        }
       });
 }
 
@@ -135,13 +593,13 @@ void register_combat_systems(flecs::world &ecs) {
                const TeamId &t) {
         SpatialHashGrid &grid = e.world().get_mut<SpatialHashGrid>();
 
-        // Detect frame boundary: world tick count changes → new frame
-        uint32_t current_frame =
-            (uint32_t)(e.world().get_info()->world_time_total * 60.0);
+        // Detect frame boundary: sim tick changes → new frame
+        uint32_t current_frame = (uint32_t)sim_tick(e.world());
         if (grid.last_frame_id != current_frame) {
           grid.last_frame_id = current_frame;
           grid.active_count = 0;
           memset(grid.cell_head, -1, sizeof(grid.cell_head));
+          memset(grid.bat_head, -1, sizeof(grid.bat_head));
         }
 
         if (grid.active_count >= SPATIAL_MAX_ENTITIES)
@@ -152,15 +610,27 @@ void register_combat_systems(flecs::world &ecs) {
         int cell_idx = cz * SPATIAL_WIDTH + cx;
         int idx = grid.active_count++;
 
+        const uint32_t bat = b.id % MAX_BATTALIONS;
         grid.entity_id[idx] = e.id();
         grid.pos_x[idx] = p.x;
         grid.pos_z[idx] = p.z;
-        grid.bat_id[idx] = b.id % MAX_BATTALIONS;
+        grid.bat_id[idx] = bat;
         grid.team_id[idx] = t.team;
 
-        // Insert at head of flat-array linked list
+        // Insert at head of flat-array linked lists (cell and battalion)
         grid.entity_next[idx] = grid.cell_head[cell_idx];
         grid.cell_head[cell_idx] = idx;
+        if (grid.bat_head[bat] == -1) {
+          grid.bat_min_x[bat] = grid.bat_max_x[bat] = p.x;
+          grid.bat_min_z[bat] = grid.bat_max_z[bat] = p.z;
+        } else {
+          grid.bat_min_x[bat] = std::min(grid.bat_min_x[bat], p.x);
+          grid.bat_max_x[bat] = std::max(grid.bat_max_x[bat], p.x);
+          grid.bat_min_z[bat] = std::min(grid.bat_min_z[bat], p.z);
+          grid.bat_max_z[bat] = std::max(grid.bat_max_z[bat], p.z);
+        }
+        grid.bat_next[idx] = grid.bat_head[bat];
+        grid.bat_head[bat] = idx;
       });
 
   // ── System 3: Musket Reload Tick (60Hz) ─────────────────────
@@ -179,157 +649,176 @@ void register_combat_systems(flecs::world &ecs) {
       });
 
   // ── System 4: Volley Fire (M8: Spatial Hash queries) ──────────
-  // O(N×K) where K = entities within musket range (~7x7 cells).
-  // Replaces the catastrophic O(N²) w.each() scan from M3.
-  // Fire discipline logic preserved from M7.5.
+  // O(N×K) where K = members of the one battalion Trap 26 picked as the
+  // target, walked through the grid's per-battalion chain. (Scanning the
+  // ~7x7 cells in musket range instead visited every soldier nearby, in
+  // both lines, for each shooter.) Replaces the O(N²) w.each() scan from
+  // M3. Fire discipline logic preserved from M7.5.
   ecs.system<const Position, MusketState, const SoldierFormationTarget,
-             const BattalionId, const TeamId>("VolleyFireSystem")
+             const BattalionId>("VolleyFireSystem")
       .with<IsAlive>()
+      .with<TeamId>()
       .without<Routing>()        // Trap 27: Routing soldiers DO NOT fire!
       .without<MacroSimulated>() // S-LOD: off-screen agents don't fire
-      .each([](flecs::entity e, const Position &pos, MusketState &ms,
-               const SoldierFormationTarget &tgt, const BattalionId &bat,
-               const TeamId &team) {
-        // §12.1: can_shoot enforces Column/Square fire limits
-        if (!tgt.can_shoot)
-          return;
-        if (ms.ammo_count == 0)
-          return;
-        // Soldiers continue reloading even while holding fire!
-        if (ms.reload_timer > 0.0f)
-          return;
-
-        constexpr float MAX_MUSKET_RANGE = 100.0f;
-        constexpr float BASE_ACCURACY = 0.35f;
-        constexpr float RELOAD_TIME = 8.0f;
-        constexpr float HUMIDITY_PENALTY = 0.05f;
+      .run([](flecs::iter &it) {
+        flecs::world w = it.world();
+        const uint64_t key = sim_rng_key(sim_seed(w), RNG_STREAM_VOLLEY);
+        const uint64_t tick = sim_tick(w);
+
+        auto fire = [&](flecs::entity e, const Position &pos, MusketState &ms,
+                        const SoldierFormationTarget &tgt,
+                        const BattalionId &bat, float roll) {
+          // §12.1: can_shoot enforces Column/Square fire limits
+          if (!tgt.can_shoot)
+            return;
+          if (ms.ammo_count == 0)
+            return;
+          // Soldiers continue reloading even while holding fire!
+          if (ms.reload_timer > 0.0f)
+            return;
 
-        uint32_t my_bat_id = bat.id % MAX_BATTALIONS;
-        auto &mb = g_macro_battalions[my_bat_id];
+          constexpr float MAX_MUSKET_RANGE = 100.0f;
+          constexpr float BASE_ACCURACY = 0.35f;
+          constexpr float RELOAD_TIME = 8.0f;
+          constexpr float HUMIDITY_PENALTY = 0.05f;
 
-        // ─── §12.7: DOCTRINE GATES ─────────────────────────────
-        if (mb.fire_discipline == DISCIPLINE_HOLD)
-          return;
+          uint32_t my_bat_id = bat.id % MAX_BATTALIONS;
+          auto &mb = g_macro_battalions[my_bat_id];
 
-        if (mb.fire_discipline == DISCIPLINE_BY_RANK) {
-          if (tgt.rank_index != mb.active_firing_rank)
+          // ─── §12.7: DOCTRINE GATES ─────────────────────────────
+          if (mb.fire_discipline == DISCIPLINE_HOLD)
             return;
-        }
 
-        // ─── §12.7: STATELESS AIM JITTER (KRRR-CRACK!) ────────
-        float my_jitter = (float)(e.id() % 100) / 200.0f; // 0.0–0.5s
+          if (mb.fire_discipline == DISCIPLINE_BY_RANK) {
+            if (tgt.rank_index != mb.active_firing_rank)
+              return;
+          }
 
-        if (mb.fire_discipline == DISCIPLINE_MASS_VOLLEY) {
-          float elapsed = 0.5f - mb.volley_timer;
-          if (elapsed < my_jitter)
-            return;
-        } else if (mb.fire_discipline == DISCIPLINE_BY_RANK) {
-          float elapsed = 3.0f - mb.volley_timer;
-          if (elapsed < my_jitter)
-            return;
-        }
+          // ─── §12.7: STATELESS AIM JITTER (KRRR-CRACK!) ────────
+          float my_jitter = (float)(e.id() % 100) / 200.0f; // 0.0–0.5s
+
+          if (mb.fire_discipline == DISCIPLINE_MASS_VOLLEY) {
+            float elapsed = 0.5f - mb.volley_timer;
+            if (elapsed < my_jitter)
+              return;
+          } else if (mb.fire_discipline == DISCIPLINE_BY_RANK) {
+            float elapsed = 3.0f - mb.volley_timer;
+            if (elapsed < my_jitter)
+              return;
+          }
 
-        // ─── Trap 26: O(1) MACRO TARGET LOOKUP ─────────────────
-        int best_bat_id = mb.target_bat_id;
-        if (best_bat_id == -1)
-          return; // All targets blocked or dead
+          // ─── Trap 26: O(1) MACRO TARGET LOOKUP ─────────────────
+          int best_bat_id = mb.target_bat_id;
+          if (best_bat_id == -1)
+            return; // All targets blocked or dead
 
-        auto &enemy_bat = g_macro_battalions[best_bat_id];
-        float bdx = enemy_bat.cx - pos.x;
-        float bdz = enemy_bat.cz - pos.z;
-        float bd2 = bdx * bdx + bdz * bdz;
-        if (bd2 > (MAX_MUSKET_RANGE * MAX_MUSKET_RANGE * 4.0f))
-          return; // Way out of range
+          auto &enemy_bat = g_macro_battalions[best_bat_id];
+          float bdx = enemy_bat.cx - pos.x;
+          float bdz = enemy_bat.cz - pos.z;
+          float bd2 = bdx * bdx + bdz * bdz;
+          if (bd2 > (MAX_MUSKET_RANGE * MAX_MUSKET_RANGE * 4.0f))
+            return; // Way out of range
 
-        // ─── M8: SPATIAL HASH MICRO TARGET (replaces O(N²) scan) ──
-        const SpatialHashGrid &grid = e.world().get<SpatialHashGrid>();
-        const int rad_cells =
-            static_cast<int>(MAX_MUSKET_RANGE / SPATIAL_CELL_SIZE) + 1;
-
-        int my_cx, my_cz;
-        SpatialHashGrid::world_to_cell(pos.x, pos.z, my_cx, my_cz);
-
-        float best_dist_sq = MAX_MUSKET_RANGE * MAX_MUSKET_RANGE;
-        uint64_t best_target_id = 0;
-        float final_shot_dot = 1.0f;
-
-        // Bounding box iteration (~7x7 cells for 100m range with 32m cells)
-        int z_min = (my_cz - rad_cells) < 0 ? 0 : (my_cz - rad_cells);
-        int z_max = (my_cz + rad_cells) >= SPATIAL_HEIGHT ? SPATIAL_HEIGHT - 1
-                                                          : (my_cz + rad_cells);
-        int x_min = (my_cx - rad_cells) < 0 ? 0 : (my_cx - rad_cells);
-        int x_max = (my_cx + rad_cells) >= SPATIAL_WIDTH ? SPATIAL_WIDTH - 1
-                                                         : (my_cx + rad_cells);
-
-        for (int z = z_min; z <= z_max; ++z) {
-          for (int x = x_min; x <= x_max; ++x) {
-            int curr_idx = grid.cell_head[z * SPATIAL_WIDTH + x];
-
-            while (curr_idx != -1) {
-              // SoA data locality — only touches pos_x/z, bat_id arrays
-              if (grid.bat_id[curr_idx] == (uint32_t)best_bat_id) {
-                float tdx = grid.pos_x[curr_idx] - pos.x;
-                float tdz = grid.pos_z[curr_idx] - pos.z;
-                float td2 = tdx * tdx + tdz * tdz;
-
-                if (td2 < best_dist_sq && td2 > 0.01f) {
-                  float dist = std::sqrt(td2);
-                  float nx = tdx / dist;
-                  float nz = tdz / dist;
-
-                  // §12.8: Firing arc — chest facing vs target direction
-                  float dot = nx * tgt.face_dir_x + nz * tgt.face_dir_z;
-                  if (dot > 0.5f) {
-                    best_dist_sq = td2;
-                    best_target_id = grid.entity_id[curr_idx];
-                    final_shot_dot = dot;
-                  }
-                }
-              }
-              curr_idx = grid.entity_next[curr_idx];
-            }
-          }
-        }
+          // ─── M8: SPATIAL HASH MICRO TARGET (replaces O(N²) scan) ──
+          const SpatialHashGrid &grid = e.world().get<SpatialHashGrid>();
 
-        if (best_target_id == 0)
-          return;
+          float face_x, face_z; // Chest facing in world space
+          battalion_to_world(tgt.face_dir_x(), tgt.face_dir_z(), mb.dir_x,
+                             mb.dir_z, face_x, face_z);
 
-        // ─── HIT CHANCE + ARC PENALTY ───────────────────────────
-        bool officer_alive = mb.officer_alive;
-        float current_max_range = officer_alive ? MAX_MUSKET_RANGE : 40.0f;
+          float best_dist_sq = MAX_MUSKET_RANGE * MAX_MUSKET_RANGE;
+          uint64_t best_target_id = 0;
 
-        float dist = std::sqrt(best_dist_sq);
-        if (dist > current_max_range)
-          return;
+          // A battalion wholly behind the chest can hold no target: the
+          // projection on the facing peaks at a corner of its bounds
+          if (grid.bat_head[best_bat_id] == -1)
+            return;
+          const float px = face_x > 0.0f ? grid.bat_max_x[best_bat_id]
+                                         : grid.bat_min_x[best_bat_id];
+          const float pz = face_z > 0.0f ? grid.bat_max_z[best_bat_id]
+                                         : grid.bat_min_z[best_bat_id];
+          if ((px - pos.x) * face_x + (pz - pos.z) * face_z <= 0.0f)
+            return;
+
+          // Nearest member of the target battalion inside the firing arc.
+          // Equal distances go to the lower entity id, so the pick does
+          // not depend on chain order.
+          float best_proj = 0.0f;
+          for (int k = grid.bat_head[best_bat_id]; k != -1;
+               k = grid.bat_next[k]) {
+            // SoA data locality — only touches pos_x/z, entity_id arrays
+            float tdx = grid.pos_x[k] - pos.x;
+            float tdz = grid.pos_z[k] - pos.z;
+            float td2 = tdx * tdx + tdz * tdz;
+            if (td2 > best_dist_sq || td2 <= 0.01f)
+              continue;
+            if (td2 == best_dist_sq &&
+                (best_target_id == 0 || grid.entity_id[k] > best_target_id))
+              continue;
 
-        float hit_chance = BASE_ACCURACY * (1.0f - (dist / current_max_range));
-        hit_chance *= (1.0f - HUMIDITY_PENALTY);
-        hit_chance *=
-            final_shot_dot; // §12.8: Accuracy penalty for angled shots
-        if (!officer_alive)
-          hit_chance *= 0.3f;
+            // §12.8: Firing arc — chest facing vs target direction,
+            // cos > 0.5 without the sqrt: proj > 0 and proj² > td2 / 4
+            float proj = tdx * face_x + tdz * face_z;
+            if (proj > 0.0f && proj * proj > 0.25f * td2) {
+              best_dist_sq = td2;
+              best_target_id = grid.entity_id[k];
+              best_proj = proj;
+            }
+          }
 
-        if (hit_chance < 0.0f)
-          hit_chance = 0.0f;
-        if (hit_chance > 1.0f)
-          hit_chance = 1.0f;
+          if (best_target_id == 0)
+            return;
 
-        // Deterministic hash-based random
-        flecs::world w = e.world();
-        uint64_t seed =
-            e.id() ^ (uint64_t)(w.get_info()->world_time_total * 100000.0);
-        seed ^= seed >> 33;
-        seed *= 0xff51afd7ed558ccdULL;
-        seed ^= seed >> 33;
-        float roll = (float)(seed & 0xFFFF) / 65535.0f;
-
-        // Fire!
-        ms.reload_timer = RELOAD_TIME;
-        ms.ammo_count--;
-
-        if (roll <= hit_chance) {
-          // Trap 32: Deferred removal for thread safety
-          w.entity(best_target_id).remove<IsAlive>();
+          // ─── HIT CHANCE + ARC PENALTY ───────────────────────────
+          bool officer_alive = mb.officer_alive;
+          float current_max_range = officer_alive ? MAX_MUSKET_RANGE : 40.0f;
+
+          float dist = std::sqrt(best_dist_sq);
+          if (dist > current_max_range)
+            return;
+          const float final_shot_dot = best_proj / dist;
+
+          float hit_chance = BASE_ACCURACY * (1.0f - (dist / current_max_range));
+          hit_chance *= (1.0f - HUMIDITY_PENALTY);
+          hit_chance *=
+              final_shot_dot; // §12.8: Accuracy penalty for angled shots
+          if (!officer_alive)
+            hit_chance *= 0.3f;
+
+          if (hit_chance < 0.0f)
+            hit_chance = 0.0f;
+          if (hit_chance > 1.0f)
+            hit_chance = 1.0f;
+
+          // `roll` comes from the table's batched RNG call (RNG_STREAM_VOLLEY)
+          // Fire!
+          ms.reload_timer = RELOAD_TIME;
+          ms.ammo_count--;
+
+          if (roll <= hit_chance) {
+            // Trap 32: Deferred removal for thread safety
+            w.entity(best_target_id).remove<IsAlive>();
+          }
+        };
+
+        // Rolls for a whole chunk of the table come from one batched call
+        constexpr int CHUNK = 256;
+        float rolls[CHUNK];
+        while (it.next()) {
+          auto pos = it.field<const Position>(0);
+          auto ms = it.field<MusketState>(1);
+          auto tgt = it.field<const SoldierFormationTarget>(2);
+          auto bat = it.field<const BattalionId>(3);
+          const uint64_t *ids = &it.entities()[0];
+          const int n = (int)it.count();
+          for (int base = 0; base < n; base += CHUNK) {
+            const int m = n - base < CHUNK ? n - base : CHUNK;
+            sim_rand_batch(key, tick, ids + base, m, rolls);
+            for (int k = 0; k < m; k++) {
+              const int i = base + k;
+              fire(it.entity(i), pos[i], ms[i], tgt[i], bat[i], rolls[k]);
+            }
+          }
         }
       });
 }
@@ -338,22 +827,101 @@ void register_combat_systems(flecs::world &ecs) {
 // M4: PANIC & MORALE SYSTEMS (CORE_MATH.md §4)
 // ═════════════════════════════════════════════════════════════
 
+// ── Flee field: jump flood over battalion centroids ──
+// Seeds each enemy battalion into its centroid's cell, then floods with
+// halving step (32, 16, ... 1) plus one extra step-1 pass to mend the
+// few cells plain JFA gets wrong. Each cell keeps whichever candidate's
+// centroid is nearest its centre: O(cells · log W) per team layer,
+// independent of how many soldiers are routing.
+static void build_flee_field(FleeField &ff) {
+  constexpr int W = FleeField::WIDTH, H = FleeField::HEIGHT;
+  static int16_t scratch[FleeField::CELLS];
+  static float bx[MAX_BATTALIONS], bz[MAX_BATTALIONS];
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const int b = g_battalion_pool.live[k];
+    bx[b] = g_macro_battalions[b].cx;
+    bz[b] = g_macro_battalions[b].cz;
+  }
+  auto centre = [](int c) {
+    return ((float)c + 0.5f) * FleeField::CELL_SIZE - 2048.0f;
+  };
+
+  for (int t = 0; t < FleeField::TEAMS; t++) {
+    int16_t *src = ff.nearest[t];
+    int16_t *dst = scratch;
+    std::fill(src, src + FleeField::CELLS, (int16_t)-1);
+
+    bool any = false;
+    for (int k = 0; k < g_battalion_pool.live_count; k++) {
+      const int b = g_battalion_pool.live[k];
+      const MacroBattalion &mb = g_macro_battalions[b];
+      if (mb.alive_count == 0 ||
+          (int)(mb.team_id % FleeField::TEAMS) == t)
+        continue;
+      int idx = FleeField::world_to_idx(mb.cx, mb.cz);
+      int cur = src[idx];
+      if (cur >= 0) {
+        float cx = centre(idx % W), cz = centre(idx / W);
+        float dc = (bx[cur] - cx) * (bx[cur] - cx) +
+                   (bz[cur] - cz) * (bz[cur] - cz);
+        float db = (bx[b] - cx) * (bx[b] - cx) + (bz[b] - cz) * (bz[b] - cz);
+        if (dc <= db)
+          continue;
+      }
+      src[idx] = (int16_t)b;
+      any = true;
+    }
+    if (!any)
+      continue; // No enemies: every cell stays -1
+
+    for (int step = W / 2;; step = step > 1 ? step / 2 : 0) {
+      const int k = step > 0 ? step : 1;
+      for (int z = 0; z < H; z++) {
+        const float cz = centre(z);
+        for (int x = 0; x < W; x++) {
+          const float cx = centre(x);
+          int best = -1;
+          float best_d2 = 1e30f;
+          for (int oz = -k; oz <= k; oz += k) {
+            int nz = z + oz;
+            if (nz < 0 || nz >= H)
+              continue;
+            for (int ox = -k; ox <= k; ox += k) {
+              int nx = x + ox;
+              if (nx < 0 || nx >= W)
+                continue;
+              int cand = src[nz * W + nx];
+              if (cand < 0)
+                continue;
+              float dx = bx[cand] - cx, dz = bz[cand] - cz;
+              float d2 = dx * dx + dz * dz;
+              if (d2 < best_d2) {
+                best_d2 = d2;
+                best = cand;
+              }
+            }
+          }
+          dst[z * W + x] = (int16_t)best;
+        }
+      }
+      std::swap(src, dst);
+      if (step == 0)
+        break;
+    }
+    // An odd pass count leaves the result in scratch
+    if (src != ff.nearest[t])
+      std::memcpy(ff.nearest[t], src, sizeof(ff.nearest[t]));
+  }
+}
+
 void register_panic_systems(flecs::world &ecs) {
 
-  // ── System 5: Panic CA Diffusion (5Hz) ──────────────────────
+  // ── System 5: Panic CA Diffusion (CA group, 5Hz) ────────────
   // Double-buffered Von Neumann diffusion with evaporation.
-  // Runs every 0.2s (5Hz). Swaps buffers after each pass.
+  // One pass per CA-group tick. Swaps buffers after each pass.
   ecs.system<PanicGrid>("PanicDiffusionSystem")
-      .each([](flecs::entity e, PanicGrid &grid) {
-        float dt = e.world().delta_time();
-        if (dt <= 0.0f)
-          return;
-
-        grid.tick_accum += dt;
-        if (grid.tick_accum < 0.2f)
-          return;                // 5Hz gate
-        grid.tick_accum -= 0.2f; // Trap 16 Fix: preserve fractional remainder
-
+      .tick_source(sim_group_source(ecs, SIM_GROUP_CA))
+      .each([](PanicGrid &grid) {
         constexpr float EVAPORATE = 0.95f;
         constexpr float SPREAD = 0.025f; // 2.5% per neighbor
         constexpr int W = PanicGrid::WIDTH;
@@ -438,6 +1006,21 @@ void register_panic_systems(flecs::world &ecs) {
         }
       });
 
+  // ── System 6b: Flee Field (60Hz, only while anyone routs) ────
+  // Rebuilds the per-team nearest-enemy grid RoutingBehaviorSystem reads.
+  auto routers_q = ecs.query_builder<>()
+                       .with<IsAlive>()
+                       .with<Routing>()
+                       .cached()
+                       .build();
+  ecs.system("FleeFieldSystem").run([routers_q](flecs::iter &it) {
+    flecs::world w = it.world();
+    FleeField *ff = w.try_get_mut<FleeField>();
+    if (!ff || !routers_q.is_true())
+      return;
+    build_flee_field(*ff);
+  });
+
   // ── System 7: Routing Behavior (60Hz) ───────────────────────
   // Per GDD §5.3: routing soldiers sprint away from nearest enemy
   // at 5.0 m/s and emit +0.05 panic/tick (contagion).
@@ -455,24 +1038,17 @@ void register_panic_systems(flecs::world &ecs) {
         constexpr float CONTAGION = 0.05f;   // panic/tick (GDD §5.3)
 
         // Find nearest enemy to flee FROM
-        float nearest_dist_sq = 1e18f;
         float enemy_x = pos.x;
         float enemy_z = pos.z;
 
-        // Trap 8+9 Fix: Use macro battalion centroid instead of O(N) scan
-        for (int i = 0; i < MAX_BATTALIONS; i++) {
-          if (g_macro_battalions[i].alive_count == 0)
-            continue;
-          if (g_macro_battalions[i].team_id == team.team)
-            continue;
-          float bdx = g_macro_battalions[i].cx - pos.x;
-          float bdz = g_macro_battalions[i].cz - pos.z;
-          float bd2 = bdx * bdx + bdz * bdz;
-          if (bd2 < nearest_dist_sq) {
-            nearest_dist_sq = bd2;
-            enemy_x = g_macro_battalions[i].cx;
-            enemy_z = g_macro_battalions[i].cz;
-          }
+        // Trap 8+9 Fix: one flee-field read names the nearest enemy
+        // battalion; its exact centroid sets the flee direction
+        const FleeField &ff = w.get<FleeField>();
+        int nearest = ff.nearest[team.team % FleeField::TEAMS]
+                                [FleeField::world_to_idx(pos.x, pos.z)];
+        if (nearest >= 0) {
+          enemy_x = g_macro_battalions[nearest].cx;
+          enemy_z = g_macro_battalions[nearest].cz;
         }
 
         // Flee direction = AWAY from nearest enemy
@@ -547,6 +1123,200 @@ void register_panic_systems(flecs::world &ecs) {
 // M5: ARTILLERY SYSTEMS (CORE_MATH.md §3, GDD §5.2)
 // ═════════════════════════════════════════════════════════════
 
+// ── M13.10: Terrain-aware ballistics ──────────────────────────
+// Elevation is solved against TerrainHeightmap columns (flat y=0 when
+// no heightmap singleton exists). Ground contact reads one heightmap
+// byte per shot — no voxel probing to find the impact point.
+constexpr float BALLISTIC_G = 9.81f;
+constexpr float MUZZLE_HEIGHT = 1.0f;   // Bore height above the gun's column
+constexpr float CREST_CLEARANCE = 0.5f; // Margin over masking ground
+constexpr float CREST_STEP = 2.0f;      // Heightmap samples along the line
+constexpr float GROUND_WETNESS = 0.2f;  // Dry day (0-1 scale)
+constexpr float MUD_THRESHOLD = 0.8f;
+
+// Low-angle root of the ballistic equation for a target at horizontal
+// distance d and height h above the muzzle, muzzle speed² = v2:
+//   tanθ = (v² − √(v⁴ − g(g·d² + 2·h·v²))) / (g·d)
+// Out of range falls back to 45° (maximum range). Branch-free.
+static inline float low_angle_tan(float d, float h, float v2) {
+  d = d < 1.0f ? 1.0f : d;
+  float disc = v2 * v2 - BALLISTIC_G * (BALLISTIC_G * d * d + 2.0f * h * v2);
+  float root = std::sqrt(disc > 0.0f ? disc : 0.0f);
+  float tan_theta = (v2 - root) / (BALLISTIC_G * d);
+  return disc >= 0.0f ? tan_theta : 1.0f;
+}
+
+// Solves every gun of a battery in one pass (SoA in, SoA out) so the
+// loop vectorizes across guns.
+void solve_battery_elevation(int guns, const float *dist, const float *rise,
+                             float speed, float *tan_out) {
+  const float v2 = speed * speed;
+  for (int g = 0; g < guns; g++)
+    tan_out[g] = low_angle_tan(dist[g], rise[g], v2);
+}
+
+// Smallest elevation that clears every heightmap sample strictly
+// between muzzle and target (ridges, walls, rubble on the line).
+static float crest_tan(const TerrainHeightmap &hm, float x0, float z0,
+                       float muzzle_y, float dir_x, float dir_z, float dist,
+                       float v2) {
+  float best = -1.0f;
+  const int samples = (int)(dist / CREST_STEP);
+  for (int k = 1; k < samples; k++) {
+    float s = (float)k * CREST_STEP;
+    float h = hm.surface(x0 + dir_x * s, z0 + dir_z * s) + CREST_CLEARANCE -
+              muzzle_y;
+    float t = low_angle_tan(s, h, v2);
+    best = t > best ? t : best;
+  }
+  return best;
+}
+
+// CORE_MATH.md §3 ground contact, shared by the ground system and
+// predict_grazes so prediction replays the simulation exactly.
+// Returns false when the ball dies (sinks in mud or rolls out).
+static inline bool ground_ricochet(float ground, float &y, float &vx,
+                                   float &vy, float &vz) {
+  // MUD: Ball sinks. Zero ricochet. (The Waterloo Effect)
+  if (GROUND_WETNESS > MUD_THRESHOLD)
+    return false;
+
+  // HARD EARTH: Ricochet!
+  y = ground + 0.1f;
+  vy = std::abs(vy) * 0.4f; // Lose 60% vertical
+  vx *= 0.7f;               // Friction
+  vz *= 0.7f;
+
+  // Ball stops if too slow
+  return !(vy < 1.0f && std::abs(vx) < 1.0f && std::abs(vz) < 1.0f);
+}
+
+struct BallisticGraze {
+  float x, y, z; // Ground contact point
+  float t;       // Seconds after firing
+};
+
+// Replays ArtilleryKinematics + GroundCollision at a fixed dt over the
+// heightmap (nullptr = flat ground) and records each graze. Ignores
+// formation and structure hits. Returns the number of grazes written.
+int predict_grazes(const TerrainHeightmap *hm, ArtilleryShot shot, float dt,
+                   BallisticGraze *out, int max_grazes,
+                   float max_time = 30.0f) {
+  int count = 0;
+  for (float t = dt; t <= max_time && count < max_grazes; t += dt) {
+    shot.vy -= BALLISTIC_G * dt;
+    shot.x += shot.vx * dt;
+    shot.y += shot.vy * dt;
+    shot.z += shot.vz * dt;
+    if (shot.kinetic_energy <= 0.0f || shot.x < -500.0f || shot.x > 500.0f ||
+        shot.z < -500.0f || shot.z > 500.0f)
+      break;
+
+    float ground = hm ? hm->surface(shot.x, shot.z) : 0.0f;
+    if (shot.y > ground)
+      continue;
+    out[count++] = {shot.x, ground, shot.z, t};
+    if (!ground_ricochet(ground, shot.y, shot.vx, shot.vy, shot.vz))
+      break;
+  }
+  return count;
+}
+
+// ── Canister: one cone resolved at the muzzle ────────────────
+// No shot is spawned. The cone's cells are read from the spatial hash,
+// enemies inside it are sorted by range, and a fixed ball budget is
+// spent front to back: near ranks soak the balls that would otherwise
+// reach the men behind them. Per-candidate odds and rolls are computed
+// in one straight pass; only spending the budget is sequential.
+constexpr float CANISTER_RANGE = 120.0f;
+constexpr float CANISTER_SPREAD = 0.1f;    // tan of the cone half-angle
+constexpr float CANISTER_MAN_WIDTH = 0.5f; // Target width across the cone
+constexpr int CANISTER_BALLS_PER_GUN = 40;
+constexpr float CANISTER_LETHAL = 0.25f; // Balls that strike to kill
+constexpr int CANISTER_MAX_CANDIDATES = 2048;
+
+// Fires `guns` canister rounds from (x, z) along unit (dir_x, dir_z).
+// Writes the entity ids of the men struck (nearest first) and returns
+// how many; the same battery, key, tick and grid always give the same
+// hits. Rolls are keyed on the battery too, so two batteries firing into
+// the same men on one tick roll independently.
+int fire_canister(const SpatialHashGrid &grid, float x, float z, float dir_x,
+                  float dir_z, uint8_t team, int guns, uint64_t battery,
+                  uint64_t key, uint64_t tick, uint64_t *hits_out,
+                  int max_hits) {
+  static float cand_r[CANISTER_MAX_CANDIDATES];
+  static int32_t cand_idx[CANISTER_MAX_CANDIDATES];
+  static int32_t order[CANISTER_MAX_CANDIDATES];
+  static float odds[CANISTER_MAX_CANDIDATES];
+  static float roll[CANISTER_MAX_CANDIDATES];
+
+  // ── Gather: cells whose centre could reach the cone, then men in it ──
+  const float half_diag = SPATIAL_CELL_SIZE * 0.7072f;
+  const float reach = CANISTER_RANGE + half_diag;
+  int cx0, cz0, cx1, cz1;
+  SpatialHashGrid::world_to_cell(x - reach, z - reach, cx0, cz0);
+  SpatialHashGrid::world_to_cell(x + reach, z + reach, cx1, cz1);
+  int count = 0;
+  for (int cz = cz0; cz <= cz1; cz++) {
+    for (int cx = cx0; cx <= cx1; cx++) {
+      float ccx = ((float)cx + 0.5f) * SPATIAL_CELL_SIZE - 2048.0f - x;
+      float ccz = ((float)cz + 0.5f) * SPATIAL_CELL_SIZE - 2048.0f - z;
+      float along = ccx * dir_x + ccz * dir_z;
+      float perp = std::abs(ccx * dir_z - ccz * dir_x);
+      if (along < -half_diag || along > reach ||
+          perp > (along + half_diag) * CANISTER_SPREAD + CANISTER_MAN_WIDTH +
+                     half_diag)
+        continue;
+      for (int k = grid.cell_head[cz * SPATIAL_WIDTH + cx]; k != -1;
+           k = grid.entity_next[k]) {
+        if (grid.team_id[k] == team)
+          continue;
+        float dx = grid.pos_x[k] - x, dz = grid.pos_z[k] - z;
+        float a = dx * dir_x + dz * dir_z;
+        float p = std::abs(dx * dir_z - dz * dir_x);
+        if (a <= 0.0f || a > CANISTER_RANGE ||
+            p > a * CANISTER_SPREAD + CANISTER_MAN_WIDTH)
+          continue;
+        if (count == CANISTER_MAX_CANDIDATES)
+          break; // Beyond this the budget is long spent
+        cand_r[count] = a;
+        cand_idx[count] = k;
+        order[count] = count;
+        count++;
+      }
+    }
+  }
+  if (count == 0)
+    return 0;
+
+  std::sort(order, order + count,
+            [](int32_t a, int32_t b) { return cand_r[a] < cand_r[b]; });
+
+  // ── Odds per ball and rolls, one straight pass ──
+  // A ball crosses the cone's width at range r; falloff halves its
+  // lethality by the cone's far end.
+  for (int i = 0; i < count; i++) {
+    float r = cand_r[order[i]];
+    float width = 2.0f * r * CANISTER_SPREAD + 2.0f * CANISTER_MAN_WIDTH;
+    odds[i] = CANISTER_MAN_WIDTH / width * (1.0f - 0.5f * r / CANISTER_RANGE);
+    const uint64_t target = grid.entity_id[cand_idx[order[i]]];
+    roll[i] = sim_rand_unit(key,
+                            sim_rng_counter(tick, target ^ (battery << 32)));
+  }
+
+  // ── Spend the ball budget front to back ──
+  float balls = (float)(guns * CANISTER_BALLS_PER_GUN) * CANISTER_LETHAL;
+  int hits = 0;
+  for (int i = 0; i < count && balls >= 1.0f && hits < max_hits; i++) {
+    float p = balls * odds[i];
+    if (roll[i] < (p < 1.0f ? p : 1.0f)) {
+      hits_out[hits++] = grid.entity_id[cand_idx[order[i]]];
+      balls -= 1.0f;
+    }
+  }
+  return hits;
+}
+
 void register_artillery_systems(flecs::world &ecs) {
 
   // ── System 8: Artillery Reload & Unlimber Tick (60Hz) ───────
@@ -575,8 +1345,8 @@ void register_artillery_systems(flecs::world &ecs) {
       });
 
   // ── System 9: Artillery Fire (spawn shots) ──────────────────
-  // When a battery has a FireOrder and is ready: spawn ArtilleryShot
-  // entities (one per gun). Uses traverse_angle to aim.
+  // When a battery has a FireOrder and is ready: spawn one shot per gun
+  // into the ProjectilePool. Uses traverse_angle to aim.
   ecs.system<const Position, ArtilleryBattery, const FireOrder, const TeamId>(
          "ArtilleryFireSystem")
       .each([](flecs::entity e, const Position &pos, ArtilleryBattery &bat,
@@ -603,6 +1373,7 @@ void register_artillery_systems(flecs::world &ecs) {
           return;
 
         flecs::world w = e.world();
+        constexpr float RELOAD_TIME = 15.0f; // seconds between volleys
 
         // Fire direction
         float dir_len = dist;
@@ -611,53 +1382,84 @@ void register_artillery_systems(flecs::world &ecs) {
         float dir_x = dx / dir_len;
         float dir_z = dz / dir_len;
 
+        // Canister resolves at the muzzle: no shot enters the pool
+        if (ammo_type == AMMO_CANISTER) {
+          if (const SpatialHashGrid *grid = w.try_get<SpatialHashGrid>()) {
+            uint64_t hits[256];
+            int n = fire_canister(*grid, pos.x, pos.z, dir_x, dir_z,
+                                  team.team, bat.num_guns, e.id(),
+                                  sim_rng_key(sim_seed(w), RNG_STREAM_CANISTER),
+                                  sim_tick(w), hits, 256);
+            for (int h = 0; h < n; h++)
+              w.entity(hits[h]).remove<IsAlive>(); // Trap 32: deferred
+          }
+          bat.ammo_canister -= 1;
+          bat.reload_timer = RELOAD_TIME;
+          e.remove<FireOrder>();
+          return;
+        }
+
+        ProjectilePool &pool = w.get_mut<ProjectilePool>();
+        const TerrainHeightmap *hm = w.try_get<TerrainHeightmap>();
+
         // Muzzle velocity calculation
         // For roundshot: ~450 m/s initial, 45° elevation adjusted for range
-        // For canister: ~350 m/s, flatter trajectory
         constexpr float ROUNDSHOT_SPEED = 200.0f; // scaled for gameplay
-        constexpr float CANISTER_SPEED = 150.0f;
-        constexpr float RELOAD_TIME = 15.0f; // seconds between volleys
-
-        float speed =
-            (ammo_type == AMMO_ROUNDSHOT) ? ROUNDSHOT_SPEED : CANISTER_SPEED;
-
-        // Calculate elevation angle for ballistic arc to target
-        // Using simplified ballistic formula: vy = (g*d) / (2*vx)
-        // for approximate targeting
-        float flat_speed = speed * 0.9f; // 90% horizontal
-        float time_to_target = dist / flat_speed;
-        if (time_to_target < 0.1f)
-          time_to_target = 0.1f;
-        float vy_needed =
-            0.5f * 9.81f * time_to_target; // compensate for gravity drop
+        constexpr int MAX_GUNS = 32;
+
+        float speed = ROUNDSHOT_SPEED;
+        float muzzle_y =
+            (hm ? hm->surface(pos.x, pos.z) : 0.0f) + MUZZLE_HEIGHT;
+
+        // Per-gun aim points: slight spread for visual variety, then one
+        // batched elevation solve against the target columns' heights
+        int guns = bat.num_guns < MAX_GUNS ? bat.num_guns : MAX_GUNS;
+        float aim_dx[MAX_GUNS], aim_dz[MAX_GUNS];
+        float aim_dist[MAX_GUNS] = {}, aim_rise[MAX_GUNS] = {};
+        float aim_tan[MAX_GUNS];
+        const uint64_t aim_key = sim_rng_key(sim_seed(w), RNG_STREAM_GUN_AIM);
+        const uint64_t tick = sim_tick(w);
+        for (int g = 0; g < guns; g++) {
+          uint64_t ctr_x = sim_rng_counter(tick, e.id(), 2 * g);
+          uint64_t ctr_z = sim_rng_counter(tick, e.id(), 2 * g + 1);
+          float spread_x = (sim_rand_unit(aim_key, ctr_x) - 0.5f) * 0.05f;
+          float spread_z = (sim_rand_unit(aim_key, ctr_z) - 0.5f) * 0.05f;
+          aim_dx[g] = dx + spread_x * dist;
+          aim_dz[g] = dz + spread_z * dist;
+          aim_dist[g] =
+              std::sqrt(aim_dx[g] * aim_dx[g] + aim_dz[g] * aim_dz[g]);
+          float ground = hm ? hm->surface(pos.x + aim_dx[g], pos.z + aim_dz[g])
+                            : 0.0f;
+          aim_rise[g] = ground - muzzle_y;
+        }
+        solve_battery_elevation(guns, aim_dist, aim_rise, speed, aim_tan);
+
+        // Masking crest on the centre line raises the whole battery
+        if (hm) {
+          float crest = crest_tan(*hm, pos.x, pos.z, muzzle_y, dir_x, dir_z,
+                                  dist, speed * speed);
+          for (int g = 0; g < guns; g++)
+            aim_tan[g] = crest > aim_tan[g] ? crest : aim_tan[g];
+        }
 
         // Spawn one shot per gun
-        int shots_to_fire = bat.num_guns;
-        for (int g = 0; g < shots_to_fire; g++) {
-          // Slight spread per gun for visual variety
-          uint32_t gun_seed = (uint32_t)(e.id() * 31 + g * 7);
-          float spread_x = ((float)(gun_seed % 100) / 100.0f - 0.5f) * 0.05f;
-          float spread_z =
-              ((float)((gun_seed * 13) % 100) / 100.0f - 0.5f) * 0.05f;
-
-          w.entity()
-              .set<ArtilleryShot>({pos.x, // x
-                                   1.0f,  // y (cannon height)
-                                   pos.z, // z
-                                   dir_x * flat_speed + spread_x * speed, // vx
-                                   vy_needed,                             // vy
-                                   dir_z * flat_speed + spread_z * speed, // vz
-                                   10.0f,     // kinetic_energy
-                                   ammo_type, // ammo type
-                                   true})     // active
-              .set<TeamId>({team.team});
+        for (int g = 0; g < guns; g++) {
+          float inv_len = 1.0f / (aim_dist[g] < 1.0f ? 1.0f : aim_dist[g]);
+          float flat_speed = speed / std::sqrt(1.0f + aim_tan[g] * aim_tan[g]);
+          pool.spawn({pos.x,                                // x
+                      muzzle_y,                             // y
+                      pos.z,                                // z
+                      aim_dx[g] * inv_len * flat_speed,     // vx
+                      flat_speed * aim_tan[g],              // vy
+                      aim_dz[g] * inv_len * flat_speed,     // vz
+                      10.0f,     // kinetic_energy
+                      AMMO_ROUNDSHOT, // ammo type
+                      true},     // active
+                     team.team);
         }
 
         // Consume ammo and start reload
-        if (ammo_type == AMMO_ROUNDSHOT)
-          bat.ammo_roundshot -= 1;
-        else
-          bat.ammo_canister -= 1;
+        bat.ammo_roundshot -= 1;
         bat.reload_timer = RELOAD_TIME;
 
         // Remove fire order (single volley per order)
@@ -666,123 +1468,89 @@ void register_artillery_systems(flecs::world &ecs) {
 
   // ── System 10: Artillery Kinematics (60Hz) ──────────────────
   // Gravity integration for in-flight cannonballs (CORE_MATH.md §3).
-  ecs.system<ArtilleryShot>("ArtilleryKinematicsSystem")
-      .each([](flecs::entity e, ArtilleryShot &shot) {
-        if (!shot.active)
-          return;
-
-        float dt = e.world().delta_time();
-        if (dt <= 0.0f)
-          return;
-
-        // Gravity
-        shot.vy -= 9.81f * dt;
-
-        // Position integration
-        shot.x += shot.vx * dt;
-        shot.y += shot.vy * dt;
-        shot.z += shot.vz * dt;
+  // Reaps shots spent last frame first, so every later artillery system
+  // walks only the live range of the pool.
+  ecs.system("ArtilleryKinematicsSystem").run([](flecs::iter &it) {
+    float dt = it.delta_time();
+    if (dt <= 0.0f)
+      return;
 
-        // Kill shot if KE depleted or way off map
-        if (shot.kinetic_energy <= 0.0f || shot.x < -500.0f ||
-            shot.x > 500.0f || shot.z < -500.0f || shot.z > 500.0f) {
-          shot.active = false;
-        }
-      });
+    ProjectilePool &pool = it.world().get_mut<ProjectilePool>();
+    pool.compact();
+    pool.integrate(dt, 500.0f); // Kill shot if KE depleted or way off map
+  });
 
   // ── System 11: Ground Collision & Ricochet (60Hz) ───────────
   // CORE_MATH.md §3: Hard earth = ricochet, mud = sink.
-  // Currently uses flat ground (y=0). Terrain height at M15+.
-  ecs.system<ArtilleryShot>("ArtilleryGroundCollisionSystem")
-      .each([](flecs::entity e, ArtilleryShot &shot) {
-        if (!shot.active)
-          return;
-
-        constexpr float GROUND_HEIGHT = 0.0f;
-        constexpr float WETNESS = 0.2f; // Dry day (0-1 scale)
-        constexpr float MUD_THRESHOLD = 0.8f;
-
-        if (shot.y <= GROUND_HEIGHT) {
-          if (WETNESS > MUD_THRESHOLD) {
-            // MUD: Ball sinks. Zero ricochet. (The Waterloo Effect)
-            shot.active = false;
-          } else {
-            // HARD EARTH: Ricochet! (CORE_MATH.md §3)
-            shot.y = GROUND_HEIGHT + 0.1f;
-            shot.vy = std::abs(shot.vy) * 0.4f; // Lose 60% vertical
-            shot.vx *= 0.7f;                    // Friction
-            shot.vz *= 0.7f;
-
-            // Ball stops if too slow
-            if (shot.vy < 1.0f && std::abs(shot.vx) < 1.0f &&
-                std::abs(shot.vz) < 1.0f) {
-              shot.active = false;
-            }
-          }
-        }
-      });
+  // Ground is the TerrainHeightmap column under the shot (M13.10);
+  // flat y=0 when no heightmap is present.
+  ecs.system("ArtilleryGroundCollisionSystem").run([](flecs::iter &it) {
+    flecs::world w = it.world();
+    ProjectilePool &pool = w.get_mut<ProjectilePool>();
+    const TerrainHeightmap *hm = w.try_get<TerrainHeightmap>();
+
+    for (int i = 0; i < pool.count; i++) {
+      if (!pool.active[i])
+        continue;
+      float ground = hm ? hm->surface(pool.x[i], pool.z[i]) : 0.0f;
+      if (pool.y[i] > ground)
+        continue;
+      if (!ground_ricochet(ground, pool.y[i], pool.vx[i], pool.vy[i],
+                           pool.vz[i]))
+        pool.active[i] = 0;
+    }
+  });
 
   // ── System 12: Artillery Hit Detection (60Hz) ───────────────
   // Roundshot: plows through formation, -1.0 KE per kill.
-  // Canister: cone shotgun at <100m.
+  // (Canister never enters the pool: see fire_canister.)
   // Queries all alive soldiers, checks proximity to active shots.
-  ecs.system<ArtilleryShot, const TeamId>("ArtilleryFormationHitSystem")
-      .each([](flecs::entity shot_e, ArtilleryShot &shot,
-               const TeamId &shot_team) {
-        if (!shot.active)
-          return;
-        if (shot.kinetic_energy <= 0.0f) {
-          shot.active = false;
-          return;
-        }
-
-        flecs::world w = shot_e.world();
-
-        // Trap 8 Fix: Use inline system query (no thread_local leak)
-
-        constexpr float HIT_RADIUS = 1.5f; // meters
-        constexpr float HIT_RADIUS_SQ = HIT_RADIUS * HIT_RADIUS;
-        constexpr float KE_PER_KILL = 1.0f;
-
-        // For canister: wider area, multiple hits
-        constexpr float CANISTER_RADIUS = 5.0f;
-        constexpr float CANISTER_RADIUS_SQ = CANISTER_RADIUS * CANISTER_RADIUS;
-        constexpr int CANISTER_MAX_HITS = 12;
-
-        float check_radius_sq =
-            (shot.ammo == AMMO_CANISTER) ? CANISTER_RADIUS_SQ : HIT_RADIUS_SQ;
+  ecs.system("ArtilleryFormationHitSystem").run([](flecs::iter &it) {
+    flecs::world w = it.world();
+    ProjectilePool &pool = w.get_mut<ProjectilePool>();
+
+    constexpr float HIT_RADIUS = 1.5f; // meters
+    constexpr float HIT_RADIUS_SQ = HIT_RADIUS * HIT_RADIUS;
+    constexpr float KE_PER_KILL = 1.0f;
+
+    for (int i = 0; i < pool.count; i++) {
+      if (!pool.active[i])
+        continue;
+      if (pool.kinetic_energy[i] <= 0.0f) {
+        pool.active[i] = 0;
+        continue;
+      }
 
-        int hits_this_frame = 0;
-        int max_hits = (shot.ammo == AMMO_CANISTER) ? CANISTER_MAX_HITS : 100;
+      const uint8_t shot_team = pool.team[i];
+      const float sx = pool.x[i];
+      const float sz = pool.z[i];
+      float &ke = pool.kinetic_energy[i];
 
-        w.each([&](flecs::entity te, const Position &tp, const TeamId &tt,
-                   const BattalionId &tb) {
-          if (!te.has<IsAlive>())
-            return;
-          // Only hit enemies
-          if (tt.team == shot_team.team)
-            return;
-          // Already spent
-          if (shot.kinetic_energy <= 0.0f)
-            return;
-          if (hits_this_frame >= max_hits)
-            return;
-
-          float dx = tp.x - shot.x;
-          float dz = tp.z - shot.z;
-          float d2 = dx * dx + dz * dz;
+      w.each([&](flecs::entity te, const Position &tp, const TeamId &tt,
+                 const BattalionId &tb) {
+        if (!te.has<IsAlive>())
+          return;
+        // Only hit enemies
+        if (tt.team == shot_team)
+          return;
+        // Already spent
+        if (ke <= 0.0f)
+          return;
 
-          if (d2 < check_radius_sq) {
-            te.remove<IsAlive>();
-            shot.kinetic_energy -= KE_PER_KILL;
-            hits_this_frame++;
+        float dx = tp.x - sx;
+        float dz = tp.z - sz;
+        float d2 = dx * dx + dz * dz;
 
-            if (shot.kinetic_energy <= 0.0f) {
-              shot.active = false;
-            }
-          }
-        });
+        if (d2 < HIT_RADIUS_SQ) {
+          te.remove<IsAlive>();
+          ke -= KE_PER_KILL;
+        }
       });
+
+      if (ke <= 0.0f)
+        pool.active[i] = 0;
+    }
+  });
 }
 
 // ═════════════════════════════════════════════════════════════
@@ -862,8 +1630,11 @@ void register_cavalry_systems(flecs::world &ecs) {
 
             // CRITICAL: Reset formation target to current position.
             // Prevents violent rubber-band back to charge origin.
-            tgt.target_x = p.x;
-            tgt.target_z = p.z;
+            const MacroBattalion &mb =
+                g_macro_battalions[e.get<BattalionId>().id % MAX_BATTALIONS];
+            world_to_battalion(p.x - (float)mb.anchor_x,
+                               p.z - (float)mb.anchor_z, mb.dir_x, mb.dir_z,
+                               tgt.offset_x, tgt.offset_z);
 
             e.remove<ChargeOrder>();
             e.remove<Disordered>();
@@ -939,6 +1710,9 @@ void register_cavalry_systems(flecs::world &ecs) {
 static std::vector<LogisticsJob> g_global_job_board;
 static int g_idle_citizen_count = 0; // Trap 41: early-out for matchmaker
 
+std::vector<LogisticsJob> &economy_job_board() { return g_global_job_board; }
+int &economy_idle_citizens() { return g_idle_citizen_count; }
+
 void register_economy_systems(flecs::world &ecs) {
 
   // ── System M9.1: Citizen Movement (60Hz) ─────────────────────
@@ -996,8 +1770,7 @@ void register_economy_systems(flecs::world &ecs) {
         // 5Hz amortization: only tick every ~0.2s using entity hash
         // Distributes load across frames instead of all citizens at once
         uint32_t frame_slot = (uint32_t)(e.id() % 12);
-        uint32_t current_slot =
-            (uint32_t)(e.world().get_info()->world_time_total * 60.0) % 12;
+        uint32_t current_slot = (uint32_t)(sim_tick(e.world()) % 12);
         if (frame_slot != current_slot)
           return;
 
@@ -1066,8 +1839,7 @@ void register_economy_systems(flecs::world &ecs) {
       .each([](flecs::entity e, Workplace &wp) {
         // 1Hz amortization
         uint32_t frame_slot = (uint32_t)(e.id() % 60);
-        uint32_t current_slot =
-            (uint32_t)(e.world().get_info()->world_time_total * 60.0) % 60;
+        uint32_t current_slot = (uint32_t)(sim_tick(e.world()) % 60);
         if (frame_slot != current_slot)
           return;
 
@@ -1235,8 +2007,7 @@ void register_economy_systems(flecs::world &ecs) {
 
         // 5Hz amortization
         uint32_t frame_slot = (uint32_t)(e.id() % 12);
-        uint32_t current_slot =
-            (uint32_t)(e.world().get_info()->world_time_total * 60.0) % 12;
+        uint32_t current_slot = (uint32_t)(sim_tick(e.world()) % 12);
         if (frame_slot != current_slot)
           return;
 
@@ -1249,12 +2020,12 @@ void register_economy_systems(flecs::world &ecs) {
         SpatialHashGrid::world_to_cell(pos.x, pos.z, cx, cz);
         int cell_range = (int)(IGNITION_RADIUS / SPATIAL_CELL_SIZE) + 1;
 
-        // Simple RNG humidity check (10% chance per tick per spark source)
-        uint32_t rng =
-            (uint32_t)(e.id() * 2654435761u +
-                       (uint32_t)(e.world().get_info()->world_time_total *
-                                  1000.0));
-        if ((rng % 100) > 10)
+        // Humidity check (10% chance per tick per spark source)
+        flecs::world w = e.world();
+        float roll =
+            sim_rand_unit(sim_rng_key(sim_seed(w), RNG_STREAM_HAZARD),
+                          sim_rng_counter(sim_tick(w), e.id()));
+        if (roll > 0.1f)
           return; // 90% humidity saves the day
 
         // Scan for volatile wagons in range
@@ -1340,48 +2111,37 @@ void register_economy_systems(flecs::world &ecs) {
         cargo.amount = 0;
       });
 
-  // ── System M9.4: Zeitgeist Aggregation (0.2Hz) ──────────────
-  // 5-second tick. Sums satisfaction by social_class.
+  // ── System M9.4: Zeitgeist Aggregation (economy group) ──────
+  // Sums satisfaction by social_class over every citizen in one pass,
+  // at the economy group's rate (1Hz by default).
   ecs.system<const Citizen>("ZeitgeistAggregationSystem")
       .with<IsAlive>()
-      .each([](flecs::entity e, const Citizen &c) {
-        // 0.2Hz: every ~300 frames using a global slot
-        uint32_t current_slot =
-            (uint32_t)(e.world().get_info()->world_time_total * 0.2) % 2;
-        static uint32_t last_slot = 999;
-        if (current_slot == last_slot)
-          return;
-
-        GlobalZeitgeist &z = e.world().get_mut<GlobalZeitgeist>();
-
-        // Only reset on first entity of new tick
-        static uint32_t reset_frame = 999;
-        uint32_t this_frame =
-            (uint32_t)(e.world().get_info()->world_time_total * 60.0);
-        if (reset_frame != this_frame) {
-          reset_frame = this_frame;
-          z.angry_peasants = 0;
-          z.angry_artisans = 0;
-          z.angry_merchants = 0;
-          z.total_citizens = 0;
-          z.avg_satisfaction = 0.0f;
-          g_idle_citizen_count = 0; // Also reset idle count
-        }
-
-        z.total_citizens++;
-        z.avg_satisfaction += c.satisfaction;
-
-        if (c.satisfaction < 0.4f) {
-          if (c.social_class == 0)
-            z.angry_peasants++;
-          else if (c.social_class == 1)
-            z.angry_artisans++;
-          else if (c.social_class == 2)
-            z.angry_merchants++;
+      .tick_source(sim_group_source(ecs, SIM_GROUP_ECONOMY))
+      .run([](flecs::iter &it) {
+        GlobalZeitgeist &z = it.world().get_mut<GlobalZeitgeist>();
+        z.angry_peasants = 0;
+        z.angry_artisans = 0;
+        z.angry_merchants = 0;
+        z.total_citizens = 0;
+        z.avg_satisfaction = 0.0f;
+        g_idle_citizen_count = 0; // Also reset idle count
+
+        while (it.next()) {
+          auto c = it.field<const Citizen>(0);
+          for (auto i : it) {
+            z.total_citizens++;
+            z.avg_satisfaction += c[i].satisfaction;
+
+            if (c[i].satisfaction < 0.4f) {
+              if (c[i].social_class == 0)
+                z.angry_peasants++;
+              else if (c[i].social_class == 1)
+                z.angry_artisans++;
+              else if (c[i].social_class == 2)
+                z.angry_merchants++;
+            }
+          }
         }
-
-        // Last entity updates the slot
-        last_slot = current_slot;
       });
 
   // ── M9.5: Conscription Bridge Observer ───────────────────────
@@ -1420,55 +2180,142 @@ void register_economy_systems(flecs::world &ecs) {
 // ── Helper: destroy_sphere (CORE_MATH §3) ──────────────────────
 // Carves a sphere of destruction into the voxel grid.
 // 30% of STONE voxels yield RUBBLE, which falls via gravity CA.
+//
+// M13.6: Chunk-coherent. edit_region() hands over each overlapping
+// chunk once; per (y, z) row the sphere's x-extent is solved
+// analytically (w = isqrt(r² − dy² − dz²)), so the inner loop is a
+// contiguous byte sweep with no distance test and no per-voxel
+// chunk_map lookup. solid_count and dirty flags are updated in bulk.
+
+// Rubble spawns stored relative to the blast centre (|d| <= 127).
+// Fixed stack buffer replaces the old thread_local vector so concurrent
+// mutation workers never share state. Overflow rubble is dropped —
+// 4096 covers a fully-stone r=14 blast, far above roundshot (r=3).
+struct RubbleSpawn {
+  int8_t dx, dy, dz, pad;
+};
+static constexpr int RUBBLE_MAX = 4096;
+
+// 30% of blasted STONE becomes rubble. An unseeded RNG stream keyed on
+// the voxel coordinate: the same in every world and for any chunk visit
+// order or worker (mutation workers have no world to ask for a seed).
+static inline bool yields_rubble(int vx, int vy, int vz) {
+  static const uint64_t key = sim_rng_key(0, RNG_STREAM_RUBBLE);
+  uint64_t voxel = ((uint64_t)(uint32_t)vx << 40) ^
+                   ((uint64_t)(uint32_t)vy << 20) ^ (uint32_t)vz;
+  return sim_rand_unit(key, sim_rng_counter(0, voxel)) < 0.3f;
+}
+
+// Largest w with w² <= v (v >= 0). sqrtf is exact to ±1 here.
+static inline int isqrt_floor(int v) {
+  int w = (int)std::sqrt((float)v);
+  while (w * w > v)
+    w--;
+  while ((w + 1) * (w + 1) <= v)
+    w++;
+  return w;
+}
+
+// Clears every non-air, non-bedrock voxel in row[x0..x1]. Returns the
+// number removed. Branch-free so MSVC/GCC vectorize it (16B per op).
+static inline int clear_row(uint8_t *row, int x0, int x1) {
+  int removed = 0;
+  for (int x = x0; x <= x1; x++) {
+    uint8_t m = row[x];
+    int keep = (m == VMAT_AIR) | (m == VMAT_BEDROCK);
+    removed += keep ^ 1;
+    row[x] = keep ? m : (uint8_t)VMAT_AIR;
+  }
+  return removed;
+}
+
+// Rubble whose landing chunk was not resident while a mutation worker
+// ran; settled on the main thread after the wave joins (M13.7).
+struct RubbleDrop {
+  int x, y, z;
+};
+
+// deferred == nullptr: main-thread mode (rubble placed via set_voxel).
+// deferred != nullptr: worker mode — only hot, pre-faulted chunks are
+// written; rubble landing anywhere else is queued on *deferred.
 static void destroy_sphere(VoxelGrid &grid, float wx, float wy, float wz,
-                           float radius) {
+                           float radius,
+                           std::vector<RubbleDrop> *deferred = nullptr) {
   int cx, cy, cz;
   VoxelGrid::world_to_voxel(wx, wy, wz, cx, cy, cz);
   int r = (int)(radius + 0.5f);
+  if (r > 127)
+    r = 127; // RubbleSpawn offsets are int8
+  const int r2 = r * r;
+
+  RubbleSpawn rubble[RUBBLE_MAX];
+  int rubble_count = 0;
+
+  grid.edit_region(
+      cx - r, cy - r, cz - r, cx + r, cy + r, cz + r, true,
+      [&](uint8_t *voxels, const VoxelEditSpan &s) -> VoxelEditResult {
+        int removed = 0;
+        for (int ly = s.ly0; ly <= s.ly1; ly++) {
+          int dy = s.oy + ly - cy;
+          for (int lz = s.lz0; lz <= s.lz1; lz++) {
+            int dz = s.oz + lz - cz;
+            int rem = r2 - dy * dy - dz * dz;
+            if (rem < 0)
+              continue;
+            int w = isqrt_floor(rem);
+            int x0 = cx - w - s.ox;
+            int x1 = cx + w - s.ox;
+            x0 = x0 < s.lx0 ? s.lx0 : x0;
+            x1 = x1 > s.lx1 ? s.lx1 : x1;
+            if (x0 > x1)
+              continue;
 
-  // Collect rubble placements for gravity pass
-  struct RubbleSpawn {
-    int x, y, z;
-  };
-  static thread_local std::vector<RubbleSpawn> rubble_queue;
-  rubble_queue.clear();
-
-  for (int dz = -r; dz <= r; dz++) {
-    for (int dy = -r; dy <= r; dy++) {
-      for (int dx = -r; dx <= r; dx++) {
-        if (dx * dx + dy * dy + dz * dz > r * r)
-          continue;
-
-        int vx = cx + dx;
-        int vy = cy + dy;
-        int vz = cz + dz;
-
-        uint8_t mat = grid.get_voxel(vx, vy, vz);
-        if (mat == VMAT_AIR || mat == VMAT_BEDROCK)
-          continue;
+            uint8_t *row = voxels + VoxelGrid::local_index(0, ly, lz);
 
-        // Destroy the voxel
-        grid.set_voxel(vx, vy, vz, VMAT_AIR);
+            // Rubble is keyed on the voxel coordinate (yields_rubble).
+            // Scanned before clearing.
+            int vy = s.oy + ly;
+            int vz = s.oz + lz;
+            for (int x = x0; x <= x1; x++) {
+              if (row[x] != VMAT_STONE)
+                continue;
+              int vx = s.ox + x;
+              if (yields_rubble(vx, vy, vz) && rubble_count < RUBBLE_MAX) {
+                rubble[rubble_count++] = {(int8_t)(vx - cx), (int8_t)dy,
+                                          (int8_t)dz, 0};
+              }
+            }
 
-        // 30% of STONE yields rubble
-        if (mat == VMAT_STONE) {
-          uint32_t rng =
-              (uint32_t)(vx * 73856093u ^ vy * 19349663u ^ vz * 83492791u);
-          if ((rng % 100) < 30) {
-            rubble_queue.push_back({vx, vy, vz});
+            removed += clear_row(row, x0, x1);
           }
         }
-      }
-    }
-  }
+        return {removed, -removed};
+      });
 
-  // Gravity CA: Drop rubble to lowest non-air voxel below
-  for (auto &rb : rubble_queue) {
-    int fall_y = rb.y;
-    while (fall_y > 0 && grid.get_voxel(rb.x, fall_y - 1, rb.z) == VMAT_AIR) {
-      fall_y--;
+  if (rubble_count == 0)
+    return;
+
+  // Gravity CA: Drop rubble to lowest non-air voxel below. Lower spawns
+  // land first so a column of rubble stacks exactly as the per-voxel
+  // scan did (insertion sort — counts are small and mostly ordered).
+  for (int i = 1; i < rubble_count; i++) {
+    RubbleSpawn key = rubble[i];
+    int j = i - 1;
+    while (j >= 0 && rubble[j].dy > key.dy) {
+      rubble[j + 1] = rubble[j];
+      j--;
     }
-    grid.set_voxel(rb.x, fall_y, rb.z, VMAT_RUBBLE);
+    rubble[j + 1] = key;
+  }
+  for (int i = 0; i < rubble_count; i++) {
+    int vx = cx + rubble[i].dx;
+    int vy = cy + rubble[i].dy;
+    int vz = cz + rubble[i].dz;
+    int fy = grid.column_floor(vx, vy, vz);
+    if (!deferred)
+      grid.set_voxel(vx, fy, vz, VMAT_RUBBLE);
+    else if (!grid.set_voxel_if_hot(vx, fy, vz, VMAT_RUBBLE))
+      deferred->push_back({vx, vy, vz});
   }
 }
 
@@ -1479,17 +2326,233 @@ static void destroy_box(VoxelGrid &grid, float wx, float wy, float wz,
   VoxelGrid::world_to_voxel(wx, wy, wz, cx, cy, cz);
   int r = (int)(radius + 0.5f);
 
-  for (int dz = -r; dz <= r; dz++) {
-    for (int dy = -r; dy <= r; dy++) {
-      for (int dx = -r; dx <= r; dx++) {
-        int vx = cx + dx;
-        int vy = cy + dy;
-        int vz = cz + dz;
-        uint8_t mat = grid.get_voxel(vx, vy, vz);
-        if (mat != VMAT_AIR && mat != VMAT_BEDROCK) {
-          grid.set_voxel(vx, vy, vz, VMAT_AIR);
+  grid.edit_region(
+      cx - r, cy - r, cz - r, cx + r, cy + r, cz + r, true,
+      [](uint8_t *voxels, const VoxelEditSpan &s) -> VoxelEditResult {
+        int removed = 0;
+        for (int ly = s.ly0; ly <= s.ly1; ly++) {
+          for (int lz = s.lz0; lz <= s.lz1; lz++) {
+            removed += clear_row(voxels + VoxelGrid::local_index(0, ly, lz),
+                                 s.lx0, s.lx1);
+          }
         }
+        return {removed, -removed};
+      });
+}
+
+// ── Parallel Destruction Batch (M13.7) ─────────────────────────
+// Drains a frame's destruction events across worker threads.
+//
+// 1. Group: events whose chunk-column footprints (x/z, all y — rubble
+//    falls straight down) overlap are unioned into one group. Groups
+//    never share a chunk, so they run concurrently without locks.
+// 2. Prepare (main thread): every chunk in each event's box is allocated
+//    and pinned in the hot cache, so workers never touch chunk_map, the
+//    pool counter or the eviction clock.
+// 3. Run: workers claim whole groups; inside a group events apply in
+//    queue order. Rubble that lands in a non-resident chunk is deferred,
+//    and its group stops after that event: later events must see it.
+// 4. Settle (main thread): group by group, the deferred rubble drops,
+//    then any events the group stopped short of apply serially.
+// Every event sees exactly what the serial drain would show it, so the
+// breach depends only on the event list — never on batch size, thread
+// count or scheduling.
+
+static constexpr int DESTRUCTION_PARALLEL_MIN = 8; // Below: not worth spawning
+static constexpr int DESTRUCTION_MAX_WORKERS = 8;
+// Chunks pinned per wave. Half the hot cache, so the clock always finds
+// an unpinned slot for the wave's own faults.
+static constexpr int DESTRUCTION_WAVE_CHUNKS = VOXEL_HOT_SLOTS / 2;
+
+// Chunk box an event can touch: [0..2] min cx/cy/cz, [3..5] max.
+static void destruction_chunk_box(const VoxelDestructionEvent &evt,
+                                  int box[6]) {
+  int cx, cy, cz;
+  VoxelGrid::world_to_voxel(evt.x, evt.y, evt.z, cx, cy, cz);
+  int r = (int)(evt.radius + 0.5f);
+  const int lo[3] = {cx - r, cy - r, cz - r};
+  const int hi[3] = {cx + r, cy + r, cz + r};
+  const int dims[3] = {MAP_CHUNKS_X, MAP_CHUNKS_Y, MAP_CHUNKS_Z};
+  for (int a = 0; a < 3; a++) {
+    int c0 = lo[a] < 0 ? 0 : lo[a] / CHUNK_SIZE;
+    int c1 = hi[a] < 0 ? -1 : hi[a] / CHUNK_SIZE;
+    box[a] = c0;
+    box[a + 3] = c1 >= dims[a] ? dims[a] - 1 : c1;
+  }
+}
+
+static int destruction_find(std::vector<int> &parent, int i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+static void apply_destruction_event(VoxelGrid &grid,
+                                    const VoxelDestructionEvent &evt,
+                                    std::vector<RubbleDrop> *deferred) {
+  if (evt.is_box)
+    destroy_box(grid, evt.x, evt.y, evt.z, evt.radius);
+  else
+    destroy_sphere(grid, evt.x, evt.y, evt.z, evt.radius, deferred);
+}
+
+static void resolve_destruction_events(
+    VoxelGrid &grid, const std::vector<VoxelDestructionEvent> &events,
+    int max_threads) {
+  const int n = (int)events.size();
+  if (n == 0)
+    return;
+
+  // Small batches: serial, identical to the old single-threaded drain.
+  // Larger ones always take the grouped path (even with one thread) so
+  // the outcome never depends on core count.
+  if (n < DESTRUCTION_PARALLEL_MIN) {
+    for (const auto &evt : events)
+      apply_destruction_event(grid, evt, nullptr);
+    return;
+  }
+
+  // ── 1. Group by overlapping chunk columns (union-find, O(n²) pairs —
+  //       n is one frame of impacts, a few hundred at most) ──
+  std::vector<int> boxes(n * 6);
+  std::vector<int> parent(n);
+  for (int i = 0; i < n; i++) {
+    destruction_chunk_box(events[i], &boxes[i * 6]);
+    parent[i] = i;
+  }
+  for (int i = 0; i < n; i++) {
+    const int *a = &boxes[i * 6];
+    for (int j = i + 1; j < n; j++) {
+      const int *b = &boxes[j * 6];
+      if (a[0] <= b[3] && b[0] <= a[3] && a[2] <= b[5] && b[2] <= a[5]) {
+        int ri = destruction_find(parent, i);
+        int rj = destruction_find(parent, j);
+        // Lowest event index is root → groups ordered by first event
+        if (ri != rj)
+          parent[ri > rj ? ri : rj] = ri < rj ? ri : rj;
+      }
+    }
+  }
+
+  // Flatten: group g owns order[start[g] .. start[g+1]), in queue order
+  std::vector<int> group_of(n, -1);
+  std::vector<int> group_size;
+  for (int i = 0; i < n; i++) {
+    int root = destruction_find(parent, i);
+    if (group_of[root] < 0) {
+      group_of[root] = (int)group_size.size();
+      group_size.push_back(0);
+    }
+    group_of[i] = group_of[root];
+    group_size[group_of[i]]++;
+  }
+  const int groups = (int)group_size.size();
+  std::vector<int> start(groups + 1, 0);
+  for (int g = 0; g < groups; g++)
+    start[g + 1] = start[g] + group_size[g];
+  std::vector<int> order(n);
+  std::vector<int> fill(start.begin(), start.end() - 1);
+  for (int i = 0; i < n; i++)
+    order[fill[group_of[i]]++] = i;
+
+  std::vector<std::vector<RubbleDrop>> deferred(groups);
+  std::vector<int> resume(groups); // First event a worker left unapplied
+  std::vector<uint32_t> pinned;
+  int threads = max_threads < 1                         ? 1
+                : max_threads < DESTRUCTION_MAX_WORKERS ? max_threads
+                                                        : DESTRUCTION_MAX_WORKERS;
+
+  // ── 2-4. Waves of groups sized to the hot-cache budget ──
+  int g = 0;
+  while (g < groups) {
+    int wave_begin = g;
+    int wave_chunks = 0;
+    while (g < groups) {
+      int cost = 0;
+      for (int k = start[g]; k < start[g + 1]; k++) {
+        const int *b = &boxes[order[k] * 6];
+        cost += (b[3] - b[0] + 1) * (b[4] - b[1] + 1) * (b[5] - b[2] + 1);
+      }
+      if (g > wave_begin && wave_chunks + cost > DESTRUCTION_WAVE_CHUNKS)
+        break;
+      wave_chunks += cost;
+      g++;
+    }
+
+    // A single group bigger than the budget runs on the main thread
+    if (wave_chunks > DESTRUCTION_WAVE_CHUNKS) {
+      for (int k = start[wave_begin]; k < start[wave_begin + 1]; k++)
+        apply_destruction_event(grid, events[order[k]], nullptr);
+      continue;
+    }
+
+    // Prepare: allocate + pin every non-air chunk the wave can carve.
+    // A chunk that was already hot must be pinned too, or later misses in
+    // this loop could wind the clock onto it. Workers must never grow the
+    // pool under each other, so a wave that cannot get all its chunks
+    // runs serially instead.
+    bool prepared = true;
+    pinned.clear();
+    for (int k = start[wave_begin]; k < start[g] && prepared; k++) {
+      const int *b = &boxes[order[k] * 6];
+      for (int cy = b[1]; cy <= b[4]; cy++)
+        for (int cz = b[2]; cz <= b[5]; cz++)
+          for (int cx = b[0]; cx <= b[3]; cx++) {
+            int map_idx = VoxelGrid::chunk_index(cx, cy, cz);
+            uint32_t pool_idx = grid.chunk_map[map_idx];
+            if (pool_idx == 0)
+              continue; // Air: carving skips it, rubble defers
+            if (pool_idx == 1)
+              pool_idx = grid.alloc_chunk(map_idx);
+            if (pool_idx == 0) {
+              prepared = false; // Pool exhausted
+            } else {
+              grid.pin_hot(pool_idx);
+              pinned.push_back(pool_idx);
+            }
+          }
+    }
+    if (!prepared) {
+      for (uint32_t pool_idx : pinned)
+        grid.unpin_hot(pool_idx);
+      for (int k = start[wave_begin]; k < start[g]; k++)
+        apply_destruction_event(grid, events[order[k]], nullptr);
+      continue;
+    }
+
+    // Run: workers claim whole groups; the main thread works too
+    std::atomic<int> next_group(wave_begin);
+    const int wave_end = g;
+    auto worker = [&]() {
+      for (;;) {
+        int wg = next_group.fetch_add(1);
+        if (wg >= wave_end)
+          return;
+        int k = start[wg];
+        while (k < start[wg + 1] && deferred[wg].empty())
+          apply_destruction_event(grid, events[order[k++]], &deferred[wg]);
+        resume[wg] = k;
       }
+    };
+    int wave_groups = wave_end - wave_begin;
+    grid.hot_frozen = 1;
+    shared_worker_pool().run(threads < wave_groups ? threads : wave_groups,
+                             [&](int) { worker(); });
+    grid.hot_frozen = 0;
+    for (uint32_t pool_idx : pinned)
+      grid.unpin_hot(pool_idx);
+
+    // Settle in deterministic (group, event) order: a stopped group's
+    // deferred rubble lands before the rest of its events carve
+    for (int wg = wave_begin; wg < wave_end; wg++) {
+      for (const RubbleDrop &rb : deferred[wg]) {
+        grid.set_voxel(rb.x, grid.column_floor(rb.x, rb.y, rb.z), rb.z,
+                       VMAT_RUBBLE);
+      }
+      for (int k = resume[wg]; k < start[wg + 1]; k++)
+        apply_destruction_event(grid, events[order[k]], nullptr);
     }
   }
 }
@@ -1502,7 +2565,7 @@ static void structural_integrity_bfs_tick(VoxelGrid &grid,
   // Static ring buffer for BFS — no heap allocations (Trap 30)
   static int32_t bfs_queue[CHUNK_VOLUME * 2]; // oversized for safety
 
-  for (uint16_t i = 2; i < grid.active_chunk_count; i++) {
+  for (uint32_t i = 2; i < grid.active_chunk_count; i++) {
     VoxelChunk &chunk = grid.chunk_pool[i];
     if (!chunk.needs_stability_bfs)
       continue;
@@ -1526,49 +2589,52 @@ void register_voxel_systems(flecs::world &ecs) {
   // ── System M13.1: ArtilleryVoxelCollisionSystem (60Hz) ───────
   // DDA raymarching: traces each shell's velocity vector through the grid.
   // CANISTER has zero structural KE. ROUNDSHOT absorbs KE per block.
-  ecs.system<ArtilleryShot>("ArtilleryVoxelCollisionSystem")
-      .each([](flecs::entity e, ArtilleryShot &shot) {
-        if (!shot.active)
-          return;
-
-        // CANISTER passes through structures (anti-personnel only)
-        if (shot.ammo == AMMO_CANISTER)
-          return;
-
-        const VoxelGrid &grid = e.world().get<VoxelGrid>();
-
-        // DDA: Step through the velocity vector one voxel at a time
-        // Convert world position to voxel coords (Trap 61)
-        int vx, vy, vz;
-        VoxelGrid::world_to_voxel(shot.x, shot.y, shot.z, vx, vy, vz);
-
-        uint8_t mat = grid.get_voxel(vx, vy, vz);
-        if (mat == VMAT_AIR || mat == VMAT_BEDROCK)
-          return;
-
-        // Hit a solid voxel — deduct KE based on material resistance
-        float ke_absorbed = (mat < 5) ? VOXEL_KE_RESISTANCE[mat] : 10000.0f;
-        shot.kinetic_energy -= ke_absorbed;
-
-        if (shot.kinetic_energy <= 0.0f) {
-          // Shell stopped — push destruction event
-          DestructionQueue &dq = e.world().get_mut<DestructionQueue>();
-          VoxelDestructionEvent evt;
-          evt.x = shot.x;
-          evt.y = shot.y;
-          evt.z = shot.z;
-          evt.radius = 3.0f; // 3-voxel blast radius for roundshot
-          evt.is_box = false;
-          dq.events.push_back(evt);
-
-          // Kill the shell
-          shot.active = false;
-          e.remove<IsAlive>();
-        }
-      });
+  ecs.system("ArtilleryVoxelCollisionSystem").run([](flecs::iter &it) {
+    flecs::world w = it.world();
+    ProjectilePool &pool = w.get_mut<ProjectilePool>();
+    const VoxelGrid &grid = w.get<VoxelGrid>();
+
+    for (int i = 0; i < pool.count; i++) {
+      if (!pool.active[i])
+        continue;
+
+      // CANISTER passes through structures (anti-personnel only)
+      if (pool.ammo[i] == AMMO_CANISTER)
+        continue;
+
+      // DDA: Step through the velocity vector one voxel at a time
+      // Convert world position to voxel coords (Trap 61)
+      int vx, vy, vz;
+      VoxelGrid::world_to_voxel(pool.x[i], pool.y[i], pool.z[i], vx, vy, vz);
+
+      uint8_t mat = grid.get_voxel(vx, vy, vz);
+      if (mat == VMAT_AIR || mat == VMAT_BEDROCK)
+        continue;
+
+      // Hit a solid voxel — deduct KE based on material resistance
+      float ke_absorbed = (mat < 5) ? VOXEL_KE_RESISTANCE[mat] : 10000.0f;
+      pool.kinetic_energy[i] -= ke_absorbed;
+
+      if (pool.kinetic_energy[i] <= 0.0f) {
+        // Shell stopped — push destruction event
+        DestructionQueue &dq = w.get_mut<DestructionQueue>();
+        VoxelDestructionEvent evt;
+        evt.x = pool.x[i];
+        evt.y = pool.y[i];
+        evt.z = pool.z[i];
+        evt.radius = 3.0f; // 3-voxel blast radius for roundshot
+        evt.is_box = false;
+        dq.events.push_back(evt);
+
+        // Kill the shell
+        pool.active[i] = 0;
+      }
+    }
+  });
 
   // ── System M13.2: VoxelMutationSystem (60Hz) ─────────────────
   // Pops DestructionQueue, runs destroy_sphere / destroy_box.
+  // Batches of >= 8 events run in parallel over disjoint chunk groups.
   // The Breach Pipeline: rubble CA creates traversable ramps.
   ecs.system("VoxelMutationSystem").run([](flecs::iter &it) {
     flecs::world w = it.world();
@@ -1578,11 +2644,17 @@ void register_voxel_systems(flecs::world &ecs) {
 
     VoxelGrid &grid = w.get_mut<VoxelGrid>();
 
-    for (auto &evt : dq.events) {
-      if (evt.is_box) {
-        destroy_box(grid, evt.x, evt.y, evt.z, evt.radius);
-      } else {
-        destroy_sphere(grid, evt.x, evt.y, evt.z, evt.radius);
+    // M13.7: disjoint chunk groups fan out across worker threads
+    int hw = (int)std::thread::hardware_concurrency();
+    resolve_destruction_events(grid, dq.events, hw > 0 ? hw : 1);
+
+    // M13.10: re-derive ground heights under the craters. Rubble falls
+    // straight down, so each event's chunk columns cover every edit.
+    if (TerrainHeightmap *hm = w.try_get_mut<TerrainHeightmap>()) {
+      for (const VoxelDestructionEvent &evt : dq.events) {
+        int box[6];
+        destruction_chunk_box(evt, box);
+        hm->refresh(grid, box[0], box[2], box[3], box[5]);
       }
     }
 
@@ -2,12 +2,55 @@
 #define MUSKET_SYSTEMS_H
 
 #include "../../flecs/flecs.h"
+#include "musket_components.h"
 
 namespace musket {
 
+// Fixed-step clock: SimClock singleton, tick counter, group rate sources.
+// Must be registered before any system that takes a group tick source.
+void register_sim_clock(flecs::world &ecs);
+
+// Rate-filter entity for a SimGroup (empty entity for the physics group)
+flecs::entity sim_group_source(flecs::world &ecs, int group);
+
+// Retunes a group's rate; hz is snapped to a divisor of SIM_TICK_HZ
+void set_sim_group_rate(flecs::world &ecs, int group, int hz);
+
+// Banks real_dt and runs whole SIM_TICK_DT ticks. Each tick drains the
+// sim command queue, then calls pre_tick, then progresses the world.
+// Returns the number of ticks run this frame.
+int advance_simulation(flecs::world &ecs, double real_dt,
+                       void (*pre_tick)(flecs::world &));
+
+// Exactly one tick, no banking: drain, pre_tick, progress. Replay
+// playback drives the world through this.
+void step_simulation(flecs::world &ecs, void (*pre_tick)(flecs::world &));
+
+// Bulk infantry spawn: per-soldier position/slot target, per-block
+// constants. RenderSlots are consecutive from first_slot.
+struct InfantryBlock {
+  int count;
+  uint32_t bat_id;
+  uint8_t team;
+  uint32_t first_slot;
+  const Position *pos;
+  const SoldierFormationTarget *target;
+  MovementStats stats;
+  MusketState musket;
+  FormationDefense defense;
+};
+
+// Creates the block in one archetype insert. Returns the new ids in
+// spawn order (valid until the next bulk operation on the world).
+const flecs::entity_t *spawn_infantry_block(flecs::world &ecs,
+                                            const InfantryBlock &b);
+
 // M2: Movement systems (spring-damper + march orders)
 void register_movement_systems(flecs::world &ecs);
 
+// Client: springs toward the interpolated VisualBattalions frame
+void register_visual_spring_system(flecs::world &ecs);
+
 // M3: Combat systems (reload tick + volley fire)
 void register_combat_systems(flecs::world &ecs);
 
@@ -23,6 +66,10 @@ void register_cavalry_systems(flecs::world &ecs);
 // M9: Economy (citizen movement, workplace logic, matchmaker, zeitgeist)
 void register_economy_systems(flecs::world &ecs);
 
+// M9 global job board and idle count (world snapshots save both)
+std::vector<LogisticsJob> &economy_job_board();
+int &economy_idle_citizens();
+
 // M13-M14: Voxel (DDA collision, mutation, structural integrity, fortification)
 void register_voxel_systems(flecs::world &ecs);
 
@@ -0,0 +1,28 @@
+#ifndef MUSKET_PLATFORM_H
+#define MUSKET_PLATFORM_H
+
+#include <string>
+
+// ═══════════════════════════════════════════════════════════════
+// PLATFORM (logging + data files)
+//
+// The little the shared ECS code needs from its host. The GDExtension
+// links platform_godot.cpp (Godot's console, FileAccess and res://);
+// the headless server and the tests link platform_stdio.cpp (stdout,
+// stderr and plain files, res:// resolved under MUSKET_DATA_ROOT).
+// Exactly one of the two is in any unity build.
+// ═══════════════════════════════════════════════════════════════
+
+namespace musket {
+
+// printf-style; one line each, no trailing newline needed
+void log_info(const char *fmt, ...);
+void log_error(const char *fmt, ...);
+
+// Whole file into `out`. False (and `out` untouched) when it cannot be
+// read. Paths may use res://.
+bool read_text_file(const char *path, std::string &out);
+
+} // namespace musket
+
+#endif // MUSKET_PLATFORM_H
@@ -0,0 +1,40 @@
+#include "platform.h"
+#include <cstdarg>
+#include <cstdio>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+namespace musket {
+
+// Long lines are cut at the buffer: these are status messages
+static godot::String format_line(const char *fmt, va_list args) {
+  char buf[1024];
+  std::vsnprintf(buf, sizeof(buf), fmt, args);
+  return godot::String::utf8(buf);
+}
+
+void log_info(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  godot::UtilityFunctions::print(format_line(fmt, args));
+  va_end(args);
+}
+
+void log_error(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  godot::UtilityFunctions::printerr(format_line(fmt, args));
+  va_end(args);
+}
+
+bool read_text_file(const char *path, std::string &out) {
+  const godot::String p = godot::String::utf8(path);
+  if (!godot::FileAccess::file_exists(p))
+    return false;
+  const godot::CharString text =
+      godot::FileAccess::get_file_as_string(p).utf8();
+  out = text.get_data();
+  return true;
+}
+
+} // namespace musket
@@ -0,0 +1,54 @@
+#include "platform.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace musket {
+
+void log_info(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  std::vfprintf(stdout, fmt, args);
+  va_end(args);
+  std::fputc('\n', stdout);
+}
+
+void log_error(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  std::vfprintf(stderr, fmt, args);
+  va_end(args);
+  std::fputc('\n', stderr);
+}
+
+// res:// is the Godot project root: MUSKET_DATA_ROOT, or the working
+// directory when unset
+static std::string resolve_path(const char *path) {
+  static const char RES[] = "res://";
+  if (std::strncmp(path, RES, sizeof(RES) - 1) != 0)
+    return path;
+  const char *root = std::getenv("MUSKET_DATA_ROOT");
+  std::string out = root && *root ? root : ".";
+  out += '/';
+  out += path + sizeof(RES) - 1;
+  return out;
+}
+
+bool read_text_file(const char *path, std::string &out) {
+  FILE *f = std::fopen(resolve_path(path).c_str(), "rb");
+  if (!f)
+    return false;
+  std::string text;
+  char buf[4096];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0)
+    text.append(buf, n);
+  const bool ok = !std::ferror(f);
+  std::fclose(f);
+  if (ok)
+    out.swap(text);
+  return ok;
+}
+
+} // namespace musket
@@ -1,39 +1,38 @@
 #include "prefab_loader.h"
 #include "../../thirdparty/json.hpp"
 #include "musket_components.h"
-#include <godot_cpp/classes/file_access.hpp>
-#include <godot_cpp/variant/utility_functions.hpp>
+#include "platform.h"
+#include <string>
 
 using json = nlohmann::json;
 
 namespace musket {
 
 void load_all_prefabs(flecs::world &ecs) {
+  std::string content;
+
   // 1. Load Units
-  godot::String units_path = "res://res/data/units.json";
-  if (godot::FileAccess::file_exists(units_path)) {
-    godot::String content = godot::FileAccess::get_file_as_string(units_path);
+  if (read_text_file("res://res/data/units.json", content)) {
     try {
-      json j = json::parse(content.utf8().get_data());
+      json j = json::parse(content);
 
       if (j.contains("units")) {
         for (auto &unit : j["units"]) {
           std::string unit_id = unit["unit_id"].get<std::string>();
           auto prefab = ecs.prefab(unit_id.c_str());
-          godot::UtilityFunctions::print("Created Unit Prefab: ",
-                                         godot::String(unit_id.c_str()));
+          log_info("Created Unit Prefab: %s", unit_id.c_str());
 
           if (unit.contains("components")) {
             auto &comps = unit["components"];
 
             if (comps.contains("FormationTarget")) {
               prefab.set<SoldierFormationTarget>(
-                  {0.0,
-                   0.0, // target_x, target_z (double)
+                  {0.0f,
+                   0.0f, // offset_x, offset_z (battalion-relative)
                    comps["FormationTarget"].value("base_stiffness", 50.0f),
                    comps["FormationTarget"].value("damping_multiplier", 2.0f),
-                   0.0f,
-                   -1.0f,
+                   face_snorm(0.0f),
+                   face_snorm(-1.0f),
                    true,
                    0,
                    {}});
@@ -58,27 +57,22 @@ void load_all_prefabs(flecs::world &ecs) {
         }
       }
     } catch (json::parse_error &e) {
-      godot::UtilityFunctions::printerr("Parse error in units.json: ",
-                                        e.what());
+      log_error("Parse error in units.json: %s", e.what());
     }
   } else {
-    godot::UtilityFunctions::printerr(
-        "Failed to find res://res/data/units.json");
+    log_error("Failed to find res://res/data/units.json");
   }
 
   // 2. Load Buildings
-  godot::String build_path = "res://res/data/buildings.json";
-  if (godot::FileAccess::file_exists(build_path)) {
-    godot::String content = godot::FileAccess::get_file_as_string(build_path);
+  if (read_text_file("res://res/data/buildings.json", content)) {
     try {
-      json j = json::parse(content.utf8().get_data());
+      json j = json::parse(content);
 
       if (j.contains("buildings")) {
         for (auto &bld : j["buildings"]) {
           std::string building_id = bld["building_id"].get<std::string>();
           auto prefab = ecs.prefab(building_id.c_str());
-          godot::UtilityFunctions::print("Created Building Prefab: ",
-                                         godot::String(building_id.c_str()));
+          log_info("Created Building Prefab: %s", building_id.c_str());
 
           if (bld.contains("components") &&
               bld["components"].contains("Workplace")) {
@@ -114,12 +108,10 @@ void load_all_prefabs(flecs::world &ecs) {
         }
       }
     } catch (json::parse_error &e) {
-      godot::UtilityFunctions::printerr("Parse error in buildings.json: ",
-                                        e.what());
+      log_error("Parse error in buildings.json: %s", e.what());
     }
   } else {
-    godot::UtilityFunctions::printerr(
-        "Failed to find res://res/data/buildings.json");
+    log_error("Failed to find res://res/data/buildings.json");
   }
 }
 
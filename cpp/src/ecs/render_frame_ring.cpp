@@ -0,0 +1,85 @@
+#include "render_frame_ring.h"
+#include <cstring>
+
+namespace musket {
+
+static inline void widen_range(int32_t &lo, int32_t &hi, int32_t a,
+                               int32_t b) {
+  if (b <= a)
+    return;
+  if (hi <= lo) {
+    lo = a;
+    hi = b;
+    return;
+  }
+  lo = a < lo ? a : lo;
+  hi = b > hi ? b : hi;
+}
+
+RenderFrameRing::RenderFrameRing(RenderFrameSlots *a, RenderFrameSlots *b,
+                                 RenderFrameSlots *c)
+    : slots{a, b, c}, ready(0), back(1), front(2) {
+  for (RenderFrameSlots *f : slots) {
+    f->active_count = 0;
+    std::memset(f->dirty_lo, 0, sizeof(f->dirty_lo));
+    std::memset(f->dirty_hi, 0, sizeof(f->dirty_hi));
+  }
+  std::memset(stale_lo, 0, sizeof(stale_lo));
+  std::memset(stale_hi, 0, sizeof(stale_hi));
+  std::memset(drained_lo, 0, sizeof(drained_lo));
+  std::memset(drained_hi, 0, sizeof(drained_hi));
+  std::memset(carry_lo, 0, sizeof(carry_lo));
+  std::memset(carry_hi, 0, sizeof(carry_hi));
+  std::memset(seen_lo, 0, sizeof(seen_lo));
+  std::memset(seen_hi, 0, sizeof(seen_hi));
+}
+
+void RenderFrameRing::begin_fill() { slots[back]->active_count = 0; }
+
+void RenderFrameRing::fill(int32_t id, int32_t lo, int32_t hi,
+                           int32_t &copy_lo, int32_t &copy_hi) {
+  RenderFrameSlots &f = *slots[back];
+  f.active[f.active_count++] = id;
+
+  // The drained range joins every frame's backlog
+  drained_lo[id] = lo < hi ? lo : 0;
+  drained_hi[id] = lo < hi ? hi : 0;
+  for (int s = 0; s < 3; s++)
+    widen_range(stale_lo[s][id], stale_hi[s][id], lo, hi);
+  copy_lo = stale_lo[back][id];
+  copy_hi = stale_hi[back][id];
+  stale_lo[back][id] = stale_hi[back][id] = 0;
+
+  f.dirty_lo[id] = drained_lo[id];
+  f.dirty_hi[id] = drained_hi[id];
+  widen_range(f.dirty_lo[id], f.dirty_hi[id], carry_lo[id], carry_hi[id]);
+}
+
+void RenderFrameRing::swap() {
+  const RenderFrameSlots &f = *slots[back];
+  const uint8_t prev =
+      ready.exchange((uint8_t)(back | FRESH), std::memory_order_acq_rel);
+  // The frame swapped out was taken: only this publish's ranges are
+  // still unseen. Otherwise it was dropped, and its ranges carry on.
+  const bool taken = !(prev & FRESH);
+  for (int k = 0; k < f.active_count; k++) {
+    const int id = f.active[k];
+    carry_lo[id] = taken ? drained_lo[id] : f.dirty_lo[id];
+    carry_hi[id] = taken ? drained_hi[id] : f.dirty_hi[id];
+  }
+  back = prev & 3;
+}
+
+bool RenderFrameRing::acquire() {
+  if (!(ready.load(std::memory_order_acquire) & FRESH))
+    return false;
+  front = ready.exchange(front, std::memory_order_acq_rel) & 3;
+  const RenderFrameSlots &f = *slots[front];
+  for (int k = 0; k < f.active_count; k++) {
+    const int id = f.active[k];
+    widen_range(seen_lo[id], seen_hi[id], f.dirty_lo[id], f.dirty_hi[id]);
+  }
+  return true;
+}
+
+} // namespace musket
@@ -0,0 +1,77 @@
+#ifndef MUSKET_RENDER_FRAME_RING_H
+#define MUSKET_RENDER_FRAME_RING_H
+
+#include "musket_components.h"
+#include <atomic>
+#include <cstdint>
+
+// ═══════════════════════════════════════════════════════════════
+// RENDER FRAME RING (the Godot-free half of RenderFrameExchange)
+//
+// Which of three frames each thread owns, and the per-battalion slot
+// ranges that decide what a publish copies and what the reader
+// uploads. RenderFrameExchange (rendering_bridge.h) adds the buffers.
+//
+// `ready` holds the index of the newest published frame; FRESH marks
+// it untaken. Each side swaps its own frame through it with a single
+// exchange, so the writer always has a frame to fill and the reader
+// always keeps the one it is drawing from.
+//
+// Copy cost: a frame is three publishes stale, so every shadow range
+// drained is remembered per frame (stale_*) and copied when that frame
+// next comes round — a standing army copies nothing. A frame the
+// reader never took is recycled, and its dirty ranges carry into the
+// next one.
+// ═══════════════════════════════════════════════════════════════
+
+namespace musket {
+
+// What one frame holds: active battalion ids (pool order) and the slots
+// each changed since the previous frame the reader took
+struct RenderFrameSlots {
+  int32_t active_count;
+  int32_t active[MAX_BATTALIONS];
+  int32_t dirty_lo[MAX_BATTALIONS];
+  int32_t dirty_hi[MAX_BATTALIONS];
+};
+
+struct RenderFrameRing {
+  static constexpr uint8_t FRESH = 4; // Ready frame not yet taken
+
+  RenderFrameSlots *slots[3];
+  std::atomic<uint8_t> ready; // Index | FRESH
+  uint8_t back;               // Sim thread's
+  uint8_t front;              // Main thread's
+
+  // Sim thread: shadow ranges each frame has missed, ranges drained by
+  // the current publish, and ranges published in a frame the reader
+  // may not have taken
+  int32_t stale_lo[3][MAX_BATTALIONS], stale_hi[3][MAX_BATTALIONS];
+  int32_t drained_lo[MAX_BATTALIONS], drained_hi[MAX_BATTALIONS];
+  int32_t carry_lo[MAX_BATTALIONS], carry_hi[MAX_BATTALIONS];
+
+  // Main thread: ranges taken but not yet fetched (the upload ack)
+  int32_t seen_lo[MAX_BATTALIONS], seen_hi[MAX_BATTALIONS];
+
+  // The three frames may still be under construction: they are only
+  // written to, never read, here
+  RenderFrameRing(RenderFrameSlots *a, RenderFrameSlots *b,
+                  RenderFrameSlots *c);
+
+  // Sim thread: empties the back frame's battalion list
+  void begin_fill();
+  // Sim thread, per active battalion: lists it in the back frame with
+  // the shadow slots [lo, hi) drained this publish. Returns in copy_*
+  // the slots the back frame is missing (its backlog, now cleared).
+  void fill(int32_t id, int32_t lo, int32_t hi, int32_t &copy_lo,
+            int32_t &copy_hi);
+  // Sim thread: swaps the filled back frame in as ready
+  void swap();
+
+  // Main thread: takes the newest published frame, if any
+  bool acquire();
+};
+
+} // namespace musket
+
+#endif // MUSKET_RENDER_FRAME_RING_H
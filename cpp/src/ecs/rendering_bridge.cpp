@@ -1,13 +1,20 @@
 #include "rendering_bridge.h"
 #include "musket_components.h"
+#include "sim_profiler.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <mutex>
 
 namespace musket {
 
 // ═══════════════════════════════════════════════════════════════
 // BUFFER FORMAT CONTRACT (SHARED BY LEGACY AND BATTALION PATHS)
 //
-// 16 floats per instance, row-major 3×4 + 4 custom:
+// INSTANCE_FULL — 16 floats per instance, row-major 3×4 + 4 custom:
 //
 //   [0]  right.x   [1]  up.x   [2]  fwd.x   [3]  origin.x
 //   [4]  right.y   [5]  up.y   [6]  fwd.y   [7]  origin.y
@@ -18,50 +25,124 @@ namespace musket {
 // Dead:   [12]=cause [13]=death_time [14]=impulse_x [15]=impulse_z
 //
 // multimesh_set_buffer() consumes this in one Vulkan upload.
+//
+// INSTANCE_COMPACT — 8 floats per instance, battalion buffers only:
+//
+//   [0] x  [1] z  [2] yaw  [3] speed  [4] team  [5] scale  [6] [7] 0
+//
+// yaw = atan2(fwd.x, fwd.z); scale 1 = alive, 0 = hidden. Half the
+// bytes of FULL, for a custom shader that rebuilds the basis itself
+// (e.g. uploaded as an RGBA32F data texture, 2 texels per instance,
+// fetched by INSTANCE_ID). The legacy repack is always FULL.
 // ═══════════════════════════════════════════════════════════════
 
 // ── Battalion Registry (LAZY INIT) ────────────────────────────
 // Cannot use static BattalionShadowBuffer[] — PackedFloat32Array
 // constructors fire before Godot runtime is initialized, crashing
-// the DLL on load. Use a pointer allocated on first access.
-static BattalionShadowBuffer *g_battalions = nullptr;
+// the DLL on load. Buffers are heap-allocated per battalion on first
+// access and freed when the pool reclaims the id, so memory tracks
+// live battalions; the pointer table grows to the highest id used.
+static std::vector<BattalionShadowBuffer *> g_battalions;
+static int g_instance_format = INSTANCE_FULL;
+static uint32_t g_battalion_serial = 0;
+
+static inline int format_stride(int format) {
+  return format == INSTANCE_COMPACT ? FLOATS_PER_COMPACT_INSTANCE
+                                    : FLOATS_PER_INSTANCE;
+}
 
-static void ensure_battalions() {
-  if (g_battalions == nullptr) {
-    g_battalions = new BattalionShadowBuffer[MAX_BATTALIONS];
+BattalionShadowBuffer &get_battalion(uint32_t battalion_id) {
+  if (battalion_id >= g_battalions.size())
+    g_battalions.resize(battalion_id + 1, nullptr);
+  if (g_battalions[battalion_id] == nullptr) {
+    g_battalions[battalion_id] = new BattalionShadowBuffer();
+    g_battalions[battalion_id]->stride = format_stride(g_instance_format);
+    g_battalions[battalion_id]->serial = ++g_battalion_serial;
   }
+  return *g_battalions[battalion_id];
 }
 
-BattalionShadowBuffer &get_battalion(uint32_t battalion_id) {
-  ensure_battalions();
-  return g_battalions[battalion_id % MAX_BATTALIONS];
+BattalionShadowBuffer *find_battalion(uint32_t battalion_id) {
+  return battalion_id < g_battalions.size() ? g_battalions[battalion_id]
+                                            : nullptr;
 }
 
+void release_battalion_buffer(uint32_t battalion_id) {
+  if (battalion_id >= g_battalions.size())
+    return;
+  delete g_battalions[battalion_id];
+  g_battalions[battalion_id] = nullptr;
+}
+
+// Both walk the pool's live list, not the id space
 int get_battalion_count() {
-  ensure_battalions();
   int count = 0;
-  for (int i = 0; i < MAX_BATTALIONS; i++) {
-    if (g_battalions[i].active)
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const BattalionShadowBuffer *bat =
+        find_battalion(g_battalion_pool.live[k]);
+    if (bat && bat->active)
       count++;
   }
   return count;
 }
 
+godot::PackedInt32Array get_dirty_battalion_ids() {
+  godot::PackedInt32Array ids;
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const int id = g_battalion_pool.live[k];
+    const BattalionShadowBuffer *bat = find_battalion(id);
+    if (bat && bat->active && bat->dirty())
+      ids.push_back(id);
+  }
+  return ids;
+}
+
 godot::PackedInt32Array get_active_battalion_ids() {
-  ensure_battalions();
   godot::PackedInt32Array ids;
-  for (int i = 0; i < MAX_BATTALIONS; i++) {
-    if (g_battalions[i].active) {
-      ids.push_back(i);
-    }
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const int id = g_battalion_pool.live[k];
+    const BattalionShadowBuffer *bat = find_battalion(id);
+    if (bat && bat->active)
+      ids.push_back(id);
   }
   return ids;
 }
 
+// Re-lays every existing buffer in the new stride. Contents are zeroed
+// and marked dirty: the next sync rewrites every live soldier (the
+// hidden scale never matches a live instance).
+void set_instance_format(int format) {
+  if (format != INSTANCE_FULL && format != INSTANCE_COMPACT)
+    return;
+  g_instance_format = format;
+  const int stride = format_stride(format);
+  for (BattalionShadowBuffer *bat : g_battalions) {
+    if (!bat || bat->stride == stride)
+      continue;
+    bat->stride = stride;
+    bat->buffer.resize((int64_t)bat->capacity * stride);
+    if (bat->capacity > 0)
+      std::memset(bat->buffer.ptrw(), 0,
+                  sizeof(float) * (size_t)bat->capacity * stride);
+    bat->mark_dirty(0, bat->capacity);
+  }
+}
+
+int get_instance_format() { return g_instance_format; }
+
+// ── Render lead: seconds of sim time not yet ticked ────────────
+// The fixed-step clock leaves alpha of a tick in the accumulator; the
+// origin is extrapolated along velocity by that much so motion stays
+// smooth when render and sim rates differ. 0 without a SimClock.
+static float render_lead(flecs::world &ecs) {
+  const SimClock *clock = ecs.try_get<SimClock>();
+  return clock ? (float)(clock->alpha * SIM_TICK_DT) : 0.0f;
+}
+
 // ── Helper: write transform into a dest buffer at offset ──────
 static void write_transform(float *dest, int offset, const Position &p,
-                            const Velocity &v, float custom_r, float custom_g,
-                            float custom_b, float custom_a) {
+                            const Velocity &v, float lead, float custom_r,
+                            float custom_g, float custom_b, float custom_a) {
   float speed_sq = (v.vx * v.vx) + (v.vz * v.vz);
 
   float fwd_x = 0.0f;
@@ -82,7 +163,7 @@ static void write_transform(float *dest, int offset, const Position &p,
   dest[offset + 0] = right_x;
   dest[offset + 1] = 0.0f;
   dest[offset + 2] = fwd_x;
-  dest[offset + 3] = p.x;
+  dest[offset + 3] = p.x + v.vx * lead;
 
   // Row 1: basis_col0.y, basis_col1.y, basis_col2.y, origin.y
   dest[offset + 4] = 0.0f;
@@ -94,7 +175,7 @@ static void write_transform(float *dest, int offset, const Position &p,
   dest[offset + 8] = right_z;
   dest[offset + 9] = 0.0f;
   dest[offset + 10] = fwd_z;
-  dest[offset + 11] = p.z;
+  dest[offset + 11] = p.z + v.vz * lead;
 
   // Custom data
   dest[offset + 12] = custom_r;
@@ -103,6 +184,60 @@ static void write_transform(float *dest, int offset, const Position &p,
   dest[offset + 15] = custom_a;
 }
 
+// ── Helper: compact 2D instance (same facing rule as above) ───
+static void write_compact(float *dest, int offset, const Position &p,
+                          const Velocity &v, float lead, float speed,
+                          float team) {
+  float speed_sq = (v.vx * v.vx) + (v.vz * v.vz);
+  dest[offset + 0] = p.x + v.vx * lead;
+  dest[offset + 1] = p.z + v.vz * lead;
+  dest[offset + 2] = speed_sq > 0.0001f ? std::atan2(v.vx, v.vz) : 0.0f;
+  dest[offset + 3] = speed;
+  dest[offset + 4] = team;
+  dest[offset + 5] = 1.0f;
+  dest[offset + 6] = 0.0f;
+  dest[offset + 7] = 0.0f;
+}
+
+static inline void write_instance(float *dest, int offset, int stride,
+                                  const Position &p, const Velocity &v,
+                                  float lead, float speed, float team) {
+  if (stride == FLOATS_PER_COMPACT_INSTANCE)
+    write_compact(dest, offset, p, v, lead, speed, team);
+  else
+    write_transform(dest, offset, p, v, lead, speed, team, 0.0f, 0.0f);
+}
+
+void write_spawn_instances(BattalionShadowBuffer &bat, uint32_t first_slot,
+                           const Position *pos, int n, float team) {
+  float *dest = bat.buffer.ptrw(); // One COW check for the whole block
+  const Velocity rest = {0.0f, 0.0f};
+  for (int i = 0; i < n; i++) {
+    write_instance(dest, (int)(first_slot + i) * bat.stride, bat.stride,
+                   pos[i], rest, 0.0f, 0.0f, team);
+  }
+  bat.mark_dirty((int)first_slot, (int)first_slot + n);
+}
+
+// ═══════════════════════════════════════════════════════════════
+// CACHED SYNC QUERIES
+// Built once per world (MusketServer::init_ecs) instead of on every
+// sync call.
+// ═══════════════════════════════════════════════════════════════
+RenderSyncQueries build_render_sync_queries(flecs::world &ecs) {
+  RenderSyncQueries q;
+  q.battalion = ecs.query_builder<const Position, const Velocity,
+                                  const TeamId, const RenderSlot>()
+                    .with<IsAlive>()
+                    .cached()
+                    .build();
+  q.legacy = ecs.query_builder<const Position, const Velocity, const TeamId>()
+                 .with<IsAlive>()
+                 .cached()
+                 .build();
+  return q;
+}
+
 // ═══════════════════════════════════════════════════════════════
 // M6: BATTALION-AWARE SYNC (Stable Slot Writes)
 //
@@ -110,24 +245,171 @@ static void write_transform(float *dest, int offset, const Position &p,
 // each battalion's shadow buffer at the entity's permanent slot.
 // Dead entities are SKIPPED (their ragdoll data was already
 // written by the OnRemove observer and stays frozen).
+//
+// Each instance is built in a scratch row and compared to what the
+// buffer already holds; it is written (and its slot marked dirty)
+// only when the origin moved more than SYNC_MOVE_EPS, the facing
+// turned, or speed/team changed. A spring at rest oscillates far
+// below a centimetre, so a standing line writes nothing.
+//
+// Parallel: the query's table chunks are gathered on the main thread,
+// then workers from the shared pool claim chunks (the main thread works
+// too). Every soldier owns its slot, so slot writes never collide; each
+// worker keeps its own dirty ranges, merged after the run. A
+// battalion's ptrw() (the only step that can copy its buffer) is taken
+// once, under a lock.
 // ═══════════════════════════════════════════════════════════════
-void sync_battalion_transforms(flecs::world &ecs) {
-  auto q = ecs.query_builder<const Position, const Velocity, const TeamId,
-                             const RenderSlot>()
-               .with<IsAlive>()
-               .build();
-
-  q.each([](const Position &p, const Velocity &v, const TeamId &team,
-            const RenderSlot &rs) {
-    auto &bat = g_battalions[rs.battalion_id % MAX_BATTALIONS];
-    float *dest = bat.buffer.ptrw();
-    int offset = rs.mm_slot * FLOATS_PER_INSTANCE;
+constexpr float SYNC_MOVE_EPS = 0.01f;  // m: origin change worth a write
+constexpr float SYNC_FACE_EPS = 0.01f;  // basis/yaw change (~0.6°)
+constexpr float SYNC_SPEED_EPS = 0.05f; // m/s: anim speed
+constexpr int SYNC_MAX_WORKERS = 16;
+constexpr int SYNC_PARALLEL_MIN = 16384; // Soldiers before threads pay off
+
+static inline bool instance_changed(const float *cur, const float *next) {
+  return std::fabs(cur[3] - next[3]) > SYNC_MOVE_EPS ||
+         std::fabs(cur[11] - next[11]) > SYNC_MOVE_EPS ||
+         std::fabs(cur[2] - next[2]) > SYNC_FACE_EPS ||
+         std::fabs(cur[10] - next[10]) > SYNC_FACE_EPS ||
+         std::fabs(cur[12] - next[12]) > SYNC_SPEED_EPS ||
+         cur[13] != next[13] || cur[5] != next[5]; // Team, or slot hidden
+}
 
-    float speed_sq = (v.vx * v.vx) + (v.vz * v.vz);
-    float speed = (speed_sq > 0.0001f) ? std::sqrt(speed_sq) : 0.0f;
+static inline bool compact_changed(const float *cur, const float *next) {
+  return std::fabs(cur[0] - next[0]) > SYNC_MOVE_EPS ||
+         std::fabs(cur[1] - next[1]) > SYNC_MOVE_EPS ||
+         std::fabs(cur[2] - next[2]) > SYNC_FACE_EPS ||
+         std::fabs(cur[3] - next[3]) > SYNC_SPEED_EPS ||
+         cur[4] != next[4] || cur[5] != next[5];
+}
+
+struct SyncChunk {
+  const Position *p;
+  const Velocity *v;
+  const TeamId *team;
+  const RenderSlot *rs;
+  int n;
+};
+
+// Per-battalion view for one sync, snapshotted on the main thread
+struct SyncTarget {
+  BattalionShadowBuffer *bat;
+  const float *read; // ptr() before any write this sync
+  int capacity;
+  int stride;
+};
+
+void sync_battalion_transforms(flecs::world &ecs,
+                               const RenderSyncQueries &queries) {
+  ProfileScope profile(ecs, PROFILE_SYNC_BATTALIONS);
+  profile.entities = (uint32_t)g_battalion_pool.live_count;
+  const float lead = render_lead(ecs);
+
+  static SyncTarget target[MAX_BATTALIONS];
+  static std::atomic<float *> write_ptr[MAX_BATTALIONS];
+  static int dirty_lo[SYNC_MAX_WORKERS][MAX_BATTALIONS];
+  static int dirty_hi[SYNC_MAX_WORKERS][MAX_BATTALIONS];
+  static std::vector<SyncChunk> chunks;
+  static std::mutex write_lock;
+
+  std::memset(target, 0, sizeof(target)); // Reclaimed ids → null
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const int b = g_battalion_pool.live[k];
+    BattalionShadowBuffer *bat = find_battalion((uint32_t)b);
+    if (!bat)
+      continue;
+    target[b] = {bat, bat->buffer.ptr(), bat->capacity, bat->stride};
+    write_ptr[b].store(nullptr, std::memory_order_relaxed);
+  }
 
-    write_transform(dest, offset, p, v, speed, (float)team.team, 0.0f, 0.0f);
+  chunks.clear();
+  int total = 0;
+  queries.battalion.run([&](flecs::iter &it) {
+    while (it.next()) {
+      const int n = (int)it.count();
+      chunks.push_back({&it.field<const Position>(0)[0],
+                        &it.field<const Velocity>(1)[0],
+                        &it.field<const TeamId>(2)[0],
+                        &it.field<const RenderSlot>(3)[0], n});
+      total += n;
+    }
   });
+  if (chunks.empty())
+    return;
+
+  WorkerPool &pool = shared_worker_pool();
+  int workers = total < SYNC_PARALLEL_MIN ? 1 : pool.size();
+  workers = std::max(1, std::min(workers, SYNC_MAX_WORKERS));
+  workers = std::min(workers, (int)chunks.size());
+
+  // Every range a worker might own starts empty, even if the pool ends
+  // up running fewer participants than asked for
+  for (int w = 0; w < workers; w++)
+    for (int k = 0; k < g_battalion_pool.live_count; k++) {
+      dirty_lo[w][g_battalion_pool.live[k]] = 0;
+      dirty_hi[w][g_battalion_pool.live[k]] = 0;
+    }
+
+  std::atomic<int> next_chunk(0);
+  auto worker = [&](int w) {
+    int *lo = dirty_lo[w], *hi = dirty_hi[w];
+    for (;;) {
+      int c = next_chunk.fetch_add(1);
+      if (c >= (int)chunks.size())
+        return;
+      const SyncChunk &ch = chunks[c];
+      for (int i = 0; i < ch.n; i++) {
+        const uint32_t b = ch.rs[i].battalion_id;
+        const int slot = (int)ch.rs[i].mm_slot;
+        if (b >= (uint32_t)MAX_BATTALIONS || !target[b].bat ||
+            slot >= target[b].capacity)
+          continue;
+        const SyncTarget &t = target[b];
+        const int offset = slot * t.stride;
+
+        const Velocity &v = ch.v[i];
+        float speed_sq = (v.vx * v.vx) + (v.vz * v.vz);
+        float speed = (speed_sq > 0.0001f) ? std::sqrt(speed_sq) : 0.0f;
+
+        float next[FLOATS_PER_INSTANCE];
+        write_instance(next, 0, t.stride, ch.p[i], v, lead, speed,
+                       (float)ch.team[i].team);
+        bool changed = t.stride == FLOATS_PER_COMPACT_INSTANCE
+                           ? compact_changed(t.read + offset, next)
+                           : instance_changed(t.read + offset, next);
+        if (!changed)
+          continue;
+
+        float *d = write_ptr[b].load(std::memory_order_acquire);
+        if (!d) {
+          std::lock_guard<std::mutex> guard(write_lock);
+          d = write_ptr[b].load(std::memory_order_relaxed);
+          if (!d) {
+            d = t.bat->buffer.ptrw();
+            write_ptr[b].store(d, std::memory_order_release);
+          }
+        }
+        std::memcpy(d + offset, next, sizeof(float) * t.stride);
+        if (hi[b] <= lo[b]) {
+          lo[b] = slot;
+          hi[b] = slot + 1;
+        } else {
+          lo[b] = slot < lo[b] ? slot : lo[b];
+          hi[b] = slot + 1 > hi[b] ? slot + 1 : hi[b];
+        }
+      }
+    }
+  };
+
+  pool.run(workers, worker);
+
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const int b = g_battalion_pool.live[k];
+    if (!target[b].bat)
+      continue;
+    for (int w = 0; w < workers; w++)
+      if (dirty_hi[w][b] > dirty_lo[w][b])
+        target[b].bat->mark_dirty(dirty_lo[w][b], dirty_hi[w][b]);
+  }
 }
 
 // ── Death Slot Clearer ─────────────────────────────────────────
@@ -138,30 +420,34 @@ void register_death_clear_observer(flecs::world &ecs) {
       .event(flecs::OnRemove)
       .with<IsAlive>()
       .each([](flecs::entity e, const RenderSlot &rs) {
-        ensure_battalions();
-        auto &bat = g_battalions[rs.battalion_id % MAX_BATTALIONS];
-        float *dest = bat.buffer.ptrw();
-        int offset = rs.mm_slot * FLOATS_PER_INSTANCE;
-
-        // Zero the entire slot — basis=0 means scale=0 → invisible
-        for (int i = 0; i < FLOATS_PER_INSTANCE; i++) {
+        BattalionShadowBuffer *bat = find_battalion(rs.battalion_id);
+        if (!bat || (int)rs.mm_slot >= bat->capacity)
+          return; // Battalion already reclaimed
+        float *dest = bat->buffer.ptrw();
+        int offset = rs.mm_slot * bat->stride;
+
+        // Zero the entire slot — basis=0 / scale=0 → invisible
+        for (int i = 0; i < bat->stride; i++) {
           dest[offset + i] = 0.0f;
         }
+        bat->mark_dirty((int)rs.mm_slot, (int)rs.mm_slot + 1);
       });
 }
 
 // ═══════════════════════════════════════════════════════════════
 // LEGACY: Sequential Repack (Strangler Fig — remove after M6)
+// Only runs while MusketServer's legacy sync switch is on.
 // ═══════════════════════════════════════════════════════════════
-void sync_transforms(flecs::world &ecs, godot::PackedFloat32Array &buffer_out,
+void sync_transforms(flecs::world &ecs, const RenderSyncQueries &queries,
+                     godot::PackedFloat32Array &buffer_out,
                      int &visible_count_out) {
-
-  auto q = ecs.query_builder<const Position, const Velocity, const TeamId>()
-               .with<IsAlive>()
-               .build();
+  ProfileScope profile(ecs, PROFILE_SYNC_TRANSFORMS);
+  const flecs::query<const Position, const Velocity, const TeamId> &q =
+      queries.legacy;
 
   int active_count = q.count();
   visible_count_out = active_count;
+  profile.entities = (uint32_t)active_count;
 
   if (active_count == 0) {
     if (buffer_out.size() != 0) {
@@ -177,59 +463,137 @@ void sync_transforms(flecs::world &ecs, godot::PackedFloat32Array &buffer_out,
 
   float *dest = buffer_out.ptrw();
   int idx = 0;
+  const float lead = render_lead(ecs);
 
   q.each([&](const Position &p, const Velocity &v, const TeamId &team) {
     float speed_sq = (v.vx * v.vx) + (v.vz * v.vz);
     float speed = (speed_sq > 0.0001f) ? std::sqrt(speed_sq) : 0.0f;
     int offset = idx * FLOATS_PER_INSTANCE;
-    write_transform(dest, offset, p, v, speed, (float)team.team, 0.0f, 0.0f);
+    write_transform(dest, offset, p, v, lead, speed, (float)team.team, 0.0f,
+                    0.0f);
     idx++;
   });
 }
 
 // ═══════════════════════════════════════════════════════════════
 // M5: PROJECTILE RENDERING BUFFER
+// One pass over the pool into static scratch, then one resize (only
+// when the live count changed) and one copy.
 // ═══════════════════════════════════════════════════════════════
 constexpr int FLOATS_PER_PROJECTILE = 4;
 
 void sync_projectiles(flecs::world &ecs, godot::PackedFloat32Array &buffer_out,
                       int &count_out) {
-  auto q = ecs.query_builder<const ArtilleryShot>().build();
-
-  int active_count = 0;
-  q.each([&](flecs::entity e, const ArtilleryShot &shot) {
-    if (shot.active)
-      active_count++;
-  });
+  ProfileScope profile(ecs, PROFILE_SYNC_PROJECTILES);
+  const ProjectilePool &pool = ecs.get<ProjectilePool>();
+  static float scratch[PROJECTILE_POOL_CAPACITY * FLOATS_PER_PROJECTILE];
 
-  count_out = active_count;
+  int idx = 0;
+  for (int i = 0; i < pool.count; i++) {
+    if (!pool.active[i])
+      continue;
 
-  if (active_count == 0) {
-    if (buffer_out.size() != 0) {
-      buffer_out.resize(0);
-    }
-    return;
+    int offset = idx * FLOATS_PER_PROJECTILE;
+    scratch[offset + 0] = pool.x[i];
+    scratch[offset + 1] = pool.y[i];
+    scratch[offset + 2] = pool.z[i];
+    scratch[offset + 3] = (float)pool.ammo[i];
+    idx++;
   }
 
-  int required_size = active_count * FLOATS_PER_PROJECTILE;
+  count_out = idx;
+  profile.entities = (uint32_t)idx;
+
+  int required_size = idx * FLOATS_PER_PROJECTILE;
   if (buffer_out.size() != required_size) {
     buffer_out.resize(required_size);
   }
+  if (idx > 0)
+    std::memcpy(buffer_out.ptrw(), scratch, sizeof(float) * required_size);
+}
 
-  float *dest = buffer_out.ptrw();
-  int idx = 0;
+// ═══════════════════════════════════════════════════════════════
+// THREADED SIMULATION: TRIPLE-BUFFERED RENDER FRAMES
+//
+// The ring decides which slots each publish copies; the frames only
+// add the buffers. A battalion whose buffer was swapped (new id
+// holder, growth, format) is copied whole.
+// ═══════════════════════════════════════════════════════════════
+static void copy_whole(godot::PackedFloat32Array &dst,
+                       const godot::PackedFloat32Array &src) {
+  if (dst.size() != src.size())
+    dst.resize(src.size());
+  if (src.size() > 0)
+    std::memcpy(dst.ptrw(), src.ptr(), sizeof(float) * (size_t)src.size());
+}
 
-  q.each([&](flecs::entity e, const ArtilleryShot &shot) {
-    if (!shot.active)
-      return;
+RenderFrameExchange::RenderFrameExchange()
+    : RenderFrameRing(&frames[0], &frames[1], &frames[2]) {
+  for (RenderFrame &f : frames) {
+    f.tick = 0;
+    f.publish_usec = 0;
+    f.projectile_count = 0;
+    f.visible_count = 0;
+    std::memset(f.serial, 0, sizeof(f.serial));
+    std::memset(f.instance_count, 0, sizeof(f.instance_count));
+  }
+}
 
-    int offset = idx * FLOATS_PER_PROJECTILE;
-    dest[offset + 0] = shot.x;
-    dest[offset + 1] = shot.y;
-    dest[offset + 2] = shot.z;
-    dest[offset + 3] = (float)shot.ammo;
-    idx++;
-  });
+void RenderFrameExchange::publish(int64_t tick,
+                                  const godot::PackedFloat32Array &projectiles,
+                                  int projectile_count,
+                                  const godot::PackedFloat32Array &transforms,
+                                  int visible_count) {
+  RenderFrame &f = frames[back];
+
+  // Free copies of battalions released since this frame was last filled
+  for (int k = 0; k < f.active_count; k++) {
+    const int id = f.active[k];
+    const BattalionShadowBuffer *bat = find_battalion(id);
+    if (!bat || !bat->active || bat->serial != f.serial[id]) {
+      f.buffer[id] = godot::PackedFloat32Array();
+      f.serial[id] = 0;
+    }
+  }
+
+  begin_fill();
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const int id = g_battalion_pool.live[k];
+    BattalionShadowBuffer *bat = find_battalion(id);
+    if (!bat || !bat->active)
+      continue;
+
+    // Drain the shadow's range into the ring
+    int32_t lo = 0, hi = 0, copy_lo, copy_hi;
+    if (bat->dirty()) {
+      lo = bat->dirty_lo;
+      hi = bat->dirty_hi;
+      bat->clear_dirty();
+    }
+    fill(id, lo, hi, copy_lo, copy_hi);
+
+    godot::PackedFloat32Array &dst = f.buffer[id];
+    if (f.serial[id] != bat->serial || dst.size() != bat->buffer.size()) {
+      copy_whole(dst, bat->buffer);
+      f.serial[id] = bat->serial;
+    } else if (copy_hi > copy_lo) {
+      const int64_t from = (int64_t)copy_lo * bat->stride;
+      const int64_t count = (int64_t)(copy_hi - copy_lo) * bat->stride;
+      std::memcpy(dst.ptrw() + from, bat->buffer.ptr() + from,
+                  sizeof(float) * (size_t)count);
+    }
+    f.instance_count[id] = bat->capacity;
+  }
+
+  copy_whole(f.projectiles, projectiles);
+  f.projectile_count = projectile_count;
+  copy_whole(f.transforms, transforms);
+  f.visible_count = visible_count;
+  f.tick = tick;
+  f.publish_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count();
+  swap();
 }
 
 } // namespace musket
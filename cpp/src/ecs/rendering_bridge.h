@@ -2,7 +2,11 @@
 #define MUSKET_RENDERING_BRIDGE_H
 
 #include "../../flecs/flecs.h"
+#include "musket_components.h"
+#include "render_frame_ring.h"
+#include <atomic>
 #include <cstdint>
+#include <cstring>
 #include <godot_cpp/variant/packed_float32_array.hpp>
 #include <godot_cpp/variant/packed_int32_array.hpp>
 #include <vector>
@@ -16,15 +20,65 @@ namespace musket {
 // shadow buffer. C++ writes directly via .ptrw() (L1 cache speed).
 // GDScript passes the buffer to RenderingServer.multimesh_set_buffer()
 // for a single O(1) Vulkan memory transfer per battalion.
+//
+// Dirty tracking: a slot is rewritten only when its instance changed
+// past epsilon, and every write widens the battalion's dirty range.
+// GDScript uploads only get_dirty_battalions(); fetching a buffer
+// acknowledges its range. Battalions at rest cost no writes and no
+// uploads (and no copy-on-write, since ptrw() is never taken).
 // ═══════════════════════════════════════════════════════════════
-constexpr int FLOATS_PER_INSTANCE = 16;
-constexpr int MAX_BATTALIONS = 64;
+constexpr int FLOATS_PER_INSTANCE = 16;        // INSTANCE_FULL
+constexpr int FLOATS_PER_COMPACT_INSTANCE = 8; // INSTANCE_COMPACT
+
+// Battalion buffer layout (see BUFFER FORMAT CONTRACT in the .cpp)
+enum InstanceFormat { INSTANCE_FULL = 0, INSTANCE_COMPACT = 1 };
 
 struct BattalionShadowBuffer {
   godot::PackedFloat32Array buffer; // Stable slots — zero-copy to RS
   std::vector<uint32_t> free_slots; // Recycling stack
-  int max_allocated = 0;
+  int max_allocated = 0;            // Slots ever handed out
+  int capacity = 0; // Slots backed by buffer (= MultiMesh instance count)
+  int stride = FLOATS_PER_INSTANCE; // Floats per slot (instance format)
+  uint32_t serial = 0; // Unique per buffer: a reused id is a new battalion
   bool active = false;
+  int dirty_lo = 0, dirty_hi = 0; // Slots written since last fetch [lo, hi)
+
+  bool dirty() const { return dirty_hi > dirty_lo; }
+  void mark_dirty(int lo, int hi) {
+    if (!dirty()) {
+      dirty_lo = lo;
+      dirty_hi = hi;
+      return;
+    }
+    dirty_lo = lo < dirty_lo ? lo : dirty_lo;
+    dirty_hi = hi > dirty_hi ? hi : dirty_hi;
+  }
+  void clear_dirty() { dirty_lo = dirty_hi = 0; }
+
+  // Grow the backing store to at least n slots. Capacity doubles (min
+  // 64), so N single allocs cost O(log N) reallocations instead of N.
+  // New slots are zeroed: basis=0 → scale=0 → GPU culls them.
+  void reserve_slots(int n) {
+    if (n <= capacity)
+      return;
+    int new_cap = capacity < 32 ? 64 : capacity * 2;
+    if (new_cap < n)
+      new_cap = n;
+    buffer.resize((int64_t)new_cap * stride);
+    float *dest = buffer.ptrw();
+    std::memset(dest + (int64_t)capacity * stride, 0,
+                sizeof(float) * (size_t)(new_cap - capacity) * stride);
+    capacity = new_cap;
+    mark_dirty(0, new_cap); // Instance count changed: full upload
+  }
+
+  // Allocate n fresh consecutive slots (bulk spawn), returns the first
+  uint32_t alloc_slots(int n) {
+    reserve_slots(max_allocated + n);
+    uint32_t first = (uint32_t)max_allocated;
+    max_allocated += n;
+    return first;
+  }
 
   // Allocate a slot, returns mm_slot index
   uint32_t alloc_slot() {
@@ -33,50 +87,115 @@ struct BattalionShadowBuffer {
       free_slots.pop_back();
       return slot;
     }
-    uint32_t slot = (uint32_t)max_allocated;
-    max_allocated++;
-    // Grow the buffer by 16 floats
-    buffer.resize(max_allocated * FLOATS_PER_INSTANCE);
-    // Zero-initialize the new slot
-    float *dest = buffer.ptrw();
-    int offset = slot * FLOATS_PER_INSTANCE;
-    for (int j = 0; j < FLOATS_PER_INSTANCE; j++) {
-      dest[offset + j] = 0.0f;
-    }
-    return slot;
+    return alloc_slots(1);
   }
 
   // Recycle a slot (hide it by zeroing scale)
   void free_slot(uint32_t slot) {
     float *dest = buffer.ptrw();
-    int offset = slot * FLOATS_PER_INSTANCE;
-    // Zero the scale columns to make GPU cull the instance
-    dest[offset + 0] = 0.0f;
+    int offset = slot * stride;
+    // Zero the scale (FULL: basis diagonal, COMPACT: [5]) so the GPU
+    // culls the instance
     dest[offset + 5] = 0.0f;
-    dest[offset + 10] = 0.0f;
+    if (stride == FLOATS_PER_INSTANCE) {
+      dest[offset + 0] = 0.0f;
+      dest[offset + 10] = 0.0f;
+    }
     free_slots.push_back(slot);
+    mark_dirty((int)slot, (int)slot + 1);
   }
 };
 
-// Global battalion registry (lives in rendering_bridge.cpp)
-BattalionShadowBuffer &get_battalion(uint32_t battalion_id);
+// Writes n resting instances (zero velocity, same basis sync would
+// write) at consecutive slots from first_slot in one pass, so a fresh
+// battalion is drawable before its first sync.
+void write_spawn_instances(BattalionShadowBuffer &bat, uint32_t first_slot,
+                           const Position *pos, int n, float team);
+
+// Global battalion registry (lives in rendering_bridge.cpp). Indexed by
+// the pool's battalion id; buffers exist only for live battalions.
+BattalionShadowBuffer &get_battalion(uint32_t battalion_id); // Creates
+BattalionShadowBuffer *find_battalion(uint32_t battalion_id); // Or null
+void release_battalion_buffer(uint32_t battalion_id);
 int get_battalion_count();
 godot::PackedInt32Array get_active_battalion_ids();
+godot::PackedInt32Array get_dirty_battalion_ids(); // Live + dirty()
+
+// Switches every battalion buffer between INSTANCE_FULL (16 floats,
+// stock MultiMesh TRANSFORM_3D + custom data) and INSTANCE_COMPACT
+// (8 floats for a custom shader). Existing buffers are re-laid and
+// fully dirtied; the next sync refills them.
+void set_instance_format(int format);
+int get_instance_format();
+
+// ── Cached sync queries (built once per world) ──────────────
+// Owned by MusketServer, declared after its world so they are
+// released before it.
+struct RenderSyncQueries {
+  flecs::query<const Position, const Velocity, const TeamId,
+               const RenderSlot>
+      battalion;
+  flecs::query<const Position, const Velocity, const TeamId> legacy;
+};
+RenderSyncQueries build_render_sync_queries(flecs::world &ecs);
 
 // ── Legacy sync (kept for Strangler Fig migration) ──────────
-void sync_transforms(flecs::world &ecs, godot::PackedFloat32Array &buffer_out,
+void sync_transforms(flecs::world &ecs, const RenderSyncQueries &queries,
+                     godot::PackedFloat32Array &buffer_out,
                      int &visible_count_out);
 
-// ── M6: Battalion-aware sync (stable slot writes) ───────────
-void sync_battalion_transforms(flecs::world &ecs);
+// ── M6: Battalion-aware sync (stable slot writes, parallel) ─
+void sync_battalion_transforms(flecs::world &ecs,
+                               const RenderSyncQueries &queries);
 
 // ── Death: Zero out shadow buffer slot when IsAlive removed ──
 void register_death_clear_observer(flecs::world &ecs);
 
-// M5: Packs active ArtilleryShot positions into a flat float array.
+// M5: Packs live ProjectilePool shots into a flat float array.
 void sync_projectiles(flecs::world &ecs, godot::PackedFloat32Array &buffer_out,
                       int &count_out);
 
+// ═══════════════════════════════════════════════════════════════
+// THREADED SIMULATION: TRIPLE-BUFFERED RENDER FRAMES
+//
+// With the sim on its own thread, the shadow buffers belong to it. After
+// each tick's sync it copies what changed into the back frame and
+// publishes it. The main thread takes the newest frame at the top of
+// _process and serves every render getter from it. Neither side waits:
+// a frame the reader never took is recycled, and its dirty ranges ride
+// along in the next one. Frame ownership and range bookkeeping live in
+// RenderFrameRing (render_frame_ring.h), which has no Godot types.
+// ═══════════════════════════════════════════════════════════════
+struct RenderFrame : RenderFrameSlots {
+  int64_t tick;          // SimClock.tick at publish
+  int64_t publish_usec;  // Steady clock, for the render blend
+  godot::PackedFloat32Array buffer[MAX_BATTALIONS]; // Copy of the shadow
+  uint32_t serial[MAX_BATTALIONS];                  // Buffer it copies
+  int32_t instance_count[MAX_BATTALIONS];
+  godot::PackedFloat32Array projectiles;
+  int32_t projectile_count;
+  godot::PackedFloat32Array transforms; // Legacy repack
+  int32_t visible_count;
+}; // ~96KB of metadata + the buffers
+
+// Heap-built once per threaded run (~350KB).
+struct RenderFrameExchange : RenderFrameRing {
+  RenderFrame frames[3];
+
+  RenderFrameExchange();
+
+  // Sim thread, after sync: copies every active shadow buffer's changes
+  // (and clears their dirty ranges), the projectile and legacy buffers,
+  // then swaps the back frame in as ready.
+  void publish(int64_t tick, const godot::PackedFloat32Array &projectiles,
+               int projectile_count,
+               const godot::PackedFloat32Array &transforms,
+               int visible_count);
+
+  // Main thread: the frame last taken by acquire()
+  const RenderFrame &current() const { return frames[front]; }
+};
+
 } // namespace musket
 
 #endif // MUSKET_RENDERING_BRIDGE_H
@@ -0,0 +1,251 @@
+#include "sim_commands.h"
+#include "sim_replay.h"
+#include <cmath>
+
+namespace musket {
+
+// ═══════════════════════════════════════════════════════════════
+// RING
+// ═══════════════════════════════════════════════════════════════
+SimCommandQueue::SimCommandQueue() : head(0), tail(0), dropped(0) {
+  for (uint32_t i = 0; i < SIM_COMMAND_CAPACITY; i++)
+    cells[i].seq.store(i, std::memory_order_relaxed);
+}
+
+bool SimCommandQueue::push(const SimCommand &c) {
+  uint32_t pos = head.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell &cell = cells[pos & (SIM_COMMAND_CAPACITY - 1)];
+    const uint32_t seq = cell.seq.load(std::memory_order_acquire);
+    const int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      // Free cell: claim it, then publish the record through seq
+      if (head.compare_exchange_weak(pos, pos + 1,
+                                     std::memory_order_relaxed)) {
+        cell.cmd = c;
+        cell.seq.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false; // Full: the sim is a whole ring behind
+    } else {
+      pos = head.load(std::memory_order_relaxed); // Lost the race
+    }
+  }
+}
+
+bool SimCommandQueue::pop(SimCommand &out) {
+  Cell &cell = cells[tail & (SIM_COMMAND_CAPACITY - 1)];
+  const uint32_t seq = cell.seq.load(std::memory_order_acquire);
+  if ((int32_t)(seq - (tail + 1)) < 0)
+    return false; // Empty, or its producer has not published yet
+  out = cell.cmd;
+  cell.seq.store(tail + SIM_COMMAND_CAPACITY, std::memory_order_release);
+  tail++;
+  return true;
+}
+
+SimCommandQueue *register_sim_commands(flecs::world &ecs) {
+  SimCommandInbox inbox = {new SimCommandQueue()};
+  ecs.set<SimCommandInbox>(inbox);
+  return inbox.queue;
+}
+
+void release_sim_commands(flecs::world &ecs) {
+  SimCommandInbox *inbox = ecs.try_get_mut<SimCommandInbox>();
+  if (!inbox)
+    return;
+  delete inbox->queue;
+  inbox->queue = nullptr;
+}
+
+int drain_sim_commands(flecs::world &ecs) {
+  const SimCommandInbox *inbox = ecs.try_get<SimCommandInbox>();
+  if (!inbox || !inbox->queue)
+    return 0;
+  record_replay_drain(ecs); // Checkpoint hash, before this tick's orders
+  SimCommand c;
+  int n = 0;
+  while (inbox->queue->pop(c)) {
+    record_replay_command(ecs, c);
+    apply_sim_command(ecs, c);
+    n++;
+  }
+  return n;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// APPLY (sim thread, between ticks)
+// ═══════════════════════════════════════════════════════════════
+
+// M7: orders wait out the drummer latency in g_pending_orders
+// (last-write-wins with penalty reset, Deep Think ruling #3)
+static void queue_pending_order(int i, OrderType type, float x, float z) {
+  g_pending_orders[i].type = type;
+  g_pending_orders[i].target_x = x;
+  g_pending_orders[i].target_z = z;
+  g_pending_orders[i].delay =
+      g_macro_battalions[i].drummer_alive ? 2.0f : 8.0f;
+}
+
+static bool live_battalion(int id) {
+  return id >= 0 && id < MAX_BATTALIONS && g_battalion_pool.is_live[id];
+}
+
+static void apply_charge(flecs::world &ecs, int team_id) {
+  // Cavalry centroid for this team
+  float cav_cx = 0, cav_cz = 0;
+  int cav_count = 0;
+  ecs.each([&](flecs::entity e, const Position &p, const CavalryState &,
+               const TeamId &t) {
+    if (!e.has<IsAlive>())
+      return;
+    if (t.team == (uint8_t)team_id) {
+      cav_cx += p.x;
+      cav_cz += p.z;
+      cav_count++;
+    }
+  });
+  if (cav_count == 0)
+    return;
+  cav_cx /= cav_count;
+  cav_cz /= cav_count;
+
+  // Nearest enemy battalion by the cached team id
+  float best_dist = 999999.0f;
+  int best_target = -1;
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const int i = g_battalion_pool.live[k];
+    auto &mb = g_macro_battalions[i];
+    if (mb.alive_count == 0 || mb.team_id == (uint32_t)team_id)
+      continue;
+    float dx = mb.cx - cav_cx;
+    float dz = mb.cz - cav_cz;
+    float d2 = (dx * dx) + (dz * dz);
+    if (d2 < best_dist) {
+      best_dist = d2;
+      best_target = i;
+    }
+  }
+  if (best_target == -1)
+    return;
+
+  const float target_cx = g_macro_battalions[best_target].cx;
+  const float target_cz = g_macro_battalions[best_target].cz;
+  ecs.each([&](flecs::entity e, const Position &p, CavalryState &cs,
+               const TeamId &t) {
+    if (!e.has<IsAlive>() || t.team != (uint8_t)team_id)
+      return;
+    if (cs.state_flags != 0)
+      return; // Already charging/disordered
+
+    // Parallel charge vector toward the enemy centroid
+    float dx = target_cx - p.x;
+    float dz = target_cz - p.z;
+    float dist = std::sqrt(dx * dx + dz * dz);
+    if (dist < 0.01f)
+      return;
+    cs.lock_dir_x = dx / dist;
+    cs.lock_dir_z = dz / dist;
+    cs.state_flags = 1; // → Charging
+    cs.state_timer = 0.0f;
+    cs.charge_momentum = 0.0f;
+
+    ChargeOrder order;
+    order.target_battalion_id = best_target;
+    order.is_committed = true;
+    e.set<ChargeOrder>(order);
+  });
+}
+
+void apply_sim_command(flecs::world &ecs, const SimCommand &c) {
+  switch (c.type) {
+  case CMD_MARCH:
+    for (int k = 0; k < g_battalion_pool.live_count; k++) {
+      const int i = g_battalion_pool.live[k];
+      if (g_macro_battalions[i].alive_count != 0)
+        queue_pending_order(i, ORDER_MARCH, c.x, c.z);
+    }
+    break;
+
+  case CMD_FIRE:
+    for (int k = 0; k < g_battalion_pool.live_count; k++) {
+      const int i = g_battalion_pool.live[k];
+      const MacroBattalion &mb = g_macro_battalions[i];
+      if (mb.alive_count != 0 && mb.team_id == (uint32_t)c.target)
+        queue_pending_order(i, ORDER_FIRE, c.x, c.z);
+    }
+    break;
+
+  case CMD_CHARGE:
+    apply_charge(ecs, c.target);
+    break;
+
+  case CMD_FIRE_DISCIPLINE:
+    if (!live_battalion(c.target) || c.arg < 0 || c.arg > 3)
+      break;
+    // Rides the M7 drummer latency pipeline
+    g_pending_orders[c.target].type = ORDER_DISCIPLINE;
+    g_pending_orders[c.target].requested_discipline = (uint8_t)c.arg;
+    g_pending_orders[c.target].delay =
+        g_macro_battalions[c.target].drummer_alive ? 2.0f : 8.0f;
+    break;
+
+  case CMD_FORMATION: {
+    if (!live_battalion(c.target) || c.arg < SHAPE_LINE ||
+        c.arg > SHAPE_SQUARE)
+      break;
+    // Queued: FormationSolveSystem lays out every re-forming battalion
+    // in one frame against its live members (M7.5 §12.1)
+    const MacroBattalion &mb = g_macro_battalions[c.target];
+    ecs.get_mut<FormationRoster>().request(c.target, (FormationShape)c.arg,
+                                           mb.dir_x, mb.dir_z);
+    break;
+  }
+
+  case CMD_WHEEL: {
+    if (!live_battalion(c.target))
+      break;
+    float len = std::sqrt(c.x * c.x + c.z * c.z);
+    if (len < 1e-4f)
+      break;
+    // Same shape, new facing; slot matching keeps files from crossing
+    FormationRoster &roster = ecs.get_mut<FormationRoster>();
+    int pending = roster.pending_shape[c.target];
+    FormationShape shape = pending >= 0
+                               ? (FormationShape)pending
+                               : g_macro_battalions[c.target].shape;
+    roster.request(c.target, shape, c.x / len, c.z / len);
+    break;
+  }
+
+  case CMD_ARTILLERY_FIRE:
+    ecs.each([&](flecs::entity e, const TeamId &t, const ArtilleryBattery &) {
+      if (t.team == (uint8_t)c.target)
+        e.set<FireOrder>({c.x, c.z});
+    });
+    break;
+
+  case CMD_LIMBER:
+    ecs.each([&](ArtilleryBattery &bat, const TeamId &t) {
+      if (t.team == (uint8_t)c.target) {
+        bat.is_limbered = true;
+        bat.unlimber_timer = 0.0f;
+      }
+    });
+    break;
+
+  case CMD_UNLIMBER:
+    ecs.each([&](ArtilleryBattery &bat, const TeamId &t) {
+      if (t.team == (uint8_t)c.target && bat.is_limbered)
+        bat.unlimber_timer = 60.0f;
+    });
+    break;
+
+  default:
+    break;
+  }
+}
+
+} // namespace musket
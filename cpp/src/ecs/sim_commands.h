@@ -0,0 +1,85 @@
+#ifndef MUSKET_SIM_COMMANDS_H
+#define MUSKET_SIM_COMMANDS_H
+
+#include "../../flecs/flecs.h"
+#include "musket_components.h"
+#include <atomic>
+#include <cstdint>
+
+// ═══════════════════════════════════════════════════════════════
+// SIM COMMAND QUEUE
+//
+// Orders reach the world only as POD SimCommands pushed into a bounded
+// MPSC ring (one sequence number per cell, Vyukov style). Any thread
+// (the Godot main thread, a network RPC handler) pushes without a
+// lock. advance_simulation drains the ring at the top of every fixed
+// tick, before the centroid pass. Because nothing else writes orders
+// into the world, the world can be stepped on a thread of its own.
+// ═══════════════════════════════════════════════════════════════
+
+namespace musket {
+
+enum SimCommandType : uint8_t {
+  CMD_NONE = 0,
+  CMD_MARCH,           // Every battalion → (x, z)
+  CMD_FIRE,            // Battalions of team `target` → (x, z)
+  CMD_CHARGE,          // Cavalry of team `target` → nearest enemy
+  CMD_FIRE_DISCIPLINE, // Battalion `target`, FireDiscipline `arg`
+  CMD_FORMATION,       // Battalion `target`, FormationShape `arg`
+  CMD_WHEEL,           // Battalion `target`, new facing (x, z)
+  CMD_ARTILLERY_FIRE,  // Batteries of team `target` → (x, z)
+  CMD_LIMBER,          // Batteries of team `target`
+  CMD_UNLIMBER,        // Batteries of team `target`
+  CMD_TYPE_COUNT
+};
+
+struct SimCommand {
+  uint8_t type; // SimCommandType
+  uint8_t pad[3];
+  int32_t target; // Team or battalion id, by type
+  int32_t arg;    // Enum argument (discipline, shape)
+  float x, z;     // Target point or facing
+}; // 20 bytes
+
+constexpr uint32_t SIM_COMMAND_CAPACITY = 4096; // Power of two
+
+// Heap-built once (~100KB). Producers and the consumer keep their
+// indices on separate cache lines.
+struct SimCommandQueue {
+  struct Cell {
+    std::atomic<uint32_t> seq; // == index: free, == index + 1: full
+    SimCommand cmd;
+  };
+
+  alignas(64) std::atomic<uint32_t> head; // Next index to claim (producers)
+  alignas(64) uint32_t tail;              // Next index to read (consumer)
+  std::atomic<uint32_t> dropped;          // Pushes refused while full
+  Cell cells[SIM_COMMAND_CAPACITY];
+
+  SimCommandQueue();
+  bool push(const SimCommand &c); // Any thread. False when full.
+  bool pop(SimCommand &out);      // Sim thread only. False when empty.
+};
+
+// Singleton: the queue's address. Copying it into Flecs copies the
+// pointer only, like VoxelGrid.
+struct SimCommandInbox {
+  SimCommandQueue *queue;
+};
+
+// Builds the queue and its singleton; the returned pointer is what
+// producers push into. release_sim_commands frees it.
+SimCommandQueue *register_sim_commands(flecs::world &ecs);
+void release_sim_commands(flecs::world &ecs);
+
+// Applies every queued command in push order. Returns the count. A
+// world without an inbox (a client) has nothing to drain.
+int drain_sim_commands(flecs::world &ecs);
+
+// One command against the live world (sim thread). Out-of-range ids
+// and enums are ignored, as the GDScript API always did.
+void apply_sim_command(flecs::world &ecs, const SimCommand &c);
+
+} // namespace musket
+
+#endif // MUSKET_SIM_COMMANDS_H
@@ -0,0 +1,258 @@
+#include "sim_profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace musket {
+
+static const char *const PROFILE_SECTION_NAMES[PROFILE_SECTION_COUNT] = {
+    "Tick",           "CommandDrain",   "CentroidPass",
+    "SyncTransforms", "SyncBattalions", "SyncProjectiles",
+    "MacroSyncEncode", "MacroSyncReceive"};
+
+int64_t profile_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Heap allocations through Flecs' OS API so far (sim thread only)
+static inline int64_t flecs_alloc_count() {
+  return ecs_os_api_malloc_count + ecs_os_api_calloc_count +
+         ecs_os_api_realloc_count;
+}
+
+void SimProfiler::record(ProfileEntry &e, int64_t begin_ns, int64_t dur_ns,
+                         uint32_t allocs, uint32_t entities) {
+  e.ms[e.next] = (float)((double)dur_ns * 1e-6);
+  e.allocs[e.next] = allocs;
+  e.next = (e.next + 1) % PROFILE_WINDOW;
+  if (e.filled < PROFILE_WINDOW)
+    e.filled++;
+  e.entities = entities;
+  e.runs++;
+
+  ProfileTraceEvent &ev = trace[trace_count++ % PROFILE_TRACE_EVENTS];
+  ev.entry = e.index;
+  ev.entities = entities;
+  ev.allocs = allocs;
+  ev.pad = 0;
+  ev.begin_ns = begin_ns - epoch_ns;
+  ev.dur_ns = dur_ns;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// SYSTEM WRAPPER
+// ═══════════════════════════════════════════════════════════════
+
+// What Flecs would have done without a run callback: the action per
+// result (once for a system with no terms)
+static inline void call_system(const ProfileEntry &e, ecs_iter_t *it) {
+  if (e.run) {
+    e.run(it);
+    return;
+  }
+  while (ecs_iter_next(it))
+    e.action(it);
+}
+
+static void profiled_run(ecs_iter_t *it) {
+  ProfileEntry &e = *static_cast<ProfileEntry *>(it->ctx);
+  SimProfiler &p = *e.owner;
+  if (!p.enabled) {
+    call_system(e, it);
+    return;
+  }
+  // Counted before the run: the cached query only walks its tables
+  const uint32_t entities = (uint32_t)ecs_query_count(it->query).entities;
+  const int64_t allocs = flecs_alloc_count();
+  const int64_t begin = profile_now_ns();
+  call_system(e, it);
+  const int64_t end = profile_now_ns();
+  p.record(e, begin, end - begin, (uint32_t)(flecs_alloc_count() - allocs),
+           entities);
+}
+
+// Same entity, same contexts: only the callbacks change. Passing the
+// contexts back unchanged keeps Flecs from freeing the C++ delegates.
+static void set_system_callbacks(flecs::world &ecs, flecs::entity_t system,
+                                 ecs_run_action_t run,
+                                 ecs_iter_action_t action, void *ctx) {
+  const ecs_system_t *s = ecs_system_get(ecs, system);
+  ecs_system_desc_t desc = {};
+  desc.entity = system;
+  desc.run = run;
+  desc.callback = action;
+  desc.ctx = ctx;
+  desc.callback_ctx = s->callback_ctx;
+  desc.run_ctx = s->run_ctx;
+  ecs_system_init(ecs, &desc);
+}
+
+// ═══════════════════════════════════════════════════════════════
+// REGISTRATION
+// ═══════════════════════════════════════════════════════════════
+
+static ProfileEntry &add_entry(SimProfiler &p, const char *name,
+                               flecs::entity_t system) {
+  p.entries.emplace_back();
+  ProfileEntry &e = p.entries.back();
+  e.name = name ? name : "";
+  e.system = system;
+  e.run = nullptr;
+  e.action = nullptr;
+  e.owner = &p;
+  e.index = (uint32_t)(p.entries.size() - 1);
+  e.next = e.filled = e.entities = 0;
+  e.runs = 0;
+  return e;
+}
+
+SimProfiler *register_sim_profiler(flecs::world &ecs) {
+  auto *p = new SimProfiler();
+  p->enabled = false;
+  p->epoch_ns = profile_now_ns();
+  p->trace_count = 0;
+  for (int i = 0; i < PROFILE_SECTION_COUNT; i++)
+    add_entry(*p, PROFILE_SECTION_NAMES[i], 0);
+
+  // Engine systems are top-level; Flecs' own live in module scopes.
+  // Sorted by id: registration order.
+  std::vector<flecs::entity_t> systems;
+  ecs.query_builder().with(flecs::System).build().each([&](flecs::entity e) {
+    if (!e.parent())
+      systems.push_back(e.id());
+  });
+  std::sort(systems.begin(), systems.end());
+
+  for (flecs::entity_t id : systems) {
+    const ecs_system_t *s = ecs_system_get(ecs, id);
+    if (!s || s->ctx || s->run == profiled_run)
+      continue; // A user context is the one slot the wrapper needs
+    ProfileEntry &e = add_entry(*p, ecs_get_name(ecs, id), id);
+    e.run = s->run;
+    e.action = s->action;
+    set_system_callbacks(ecs, id, profiled_run, e.action, &e);
+  }
+
+  ecs.set<SimProfile>({p});
+  return p;
+}
+
+void release_sim_profiler(flecs::world &ecs) {
+  SimProfile *sp = ecs.try_get_mut<SimProfile>();
+  if (!sp || !sp->profiler)
+    return;
+  for (const ProfileEntry &e : sp->profiler->entries) {
+    if (e.system && ecs_is_alive(ecs, e.system))
+      set_system_callbacks(ecs, e.system, e.run, e.action, nullptr);
+  }
+  delete sp->profiler;
+  sp->profiler = nullptr;
+}
+
+void set_profiling(flecs::world &ecs, bool enabled) {
+  const SimProfile *sp = ecs.try_get<SimProfile>();
+  if (!sp || !sp->profiler)
+    return;
+  SimProfiler &p = *sp->profiler;
+  if (enabled && !p.enabled) {
+    for (ProfileEntry &e : p.entries) {
+      e.next = e.filled = e.entities = 0;
+      e.runs = 0;
+    }
+    p.trace.resize(PROFILE_TRACE_EVENTS); // Once; kept while off
+    p.trace_count = 0;
+  }
+  p.enabled = enabled;
+}
+
+bool is_profiling(const flecs::world &ecs) {
+  const SimProfile *sp = ecs.try_get<SimProfile>();
+  return sp && sp->profiler && sp->profiler->enabled;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// SECTIONS
+// ═══════════════════════════════════════════════════════════════
+
+ProfileScope::ProfileScope(flecs::world &ecs, ProfileSection section)
+    : entry(nullptr), begin_ns(0), allocs(0) {
+  const SimProfile *sp = ecs.try_get<SimProfile>();
+  if (!sp || !sp->profiler || !sp->profiler->enabled)
+    return;
+  entry = &sp->profiler->entries[section];
+  allocs = flecs_alloc_count();
+  begin_ns = profile_now_ns();
+}
+
+ProfileScope::~ProfileScope() {
+  if (!entry)
+    return;
+  const int64_t end = profile_now_ns();
+  entry->owner->record(*entry, begin_ns, end - begin_ns,
+                       (uint32_t)(flecs_alloc_count() - allocs), entities);
+}
+
+// ═══════════════════════════════════════════════════════════════
+// REPORTS
+// ═══════════════════════════════════════════════════════════════
+
+void profile_stats(const SimProfiler &p, std::vector<ProfileStats> &out) {
+  out.clear();
+  std::vector<float> sorted;
+  for (const ProfileEntry &e : p.entries) {
+    ProfileStats s = {};
+    s.name = e.name.c_str();
+    s.system = e.system != 0;
+    s.runs = e.runs;
+    s.entities = e.entities;
+    s.samples = e.filled;
+    if (e.filled > 0) {
+      sorted.assign(e.ms, e.ms + e.filled);
+      float sum = 0.0f;
+      uint64_t alloc_sum = 0;
+      for (uint32_t i = 0; i < e.filled; i++) {
+        sum += e.ms[i];
+        alloc_sum += e.allocs[i];
+        s.allocs_max = std::max(s.allocs_max, e.allocs[i]);
+      }
+      // Nearest rank: the 6th slowest of 600
+      const size_t rank = (size_t)std::ceil(0.99 * (double)e.filled) - 1;
+      std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+      s.p99_ms = sorted[rank];
+      s.min_ms = *std::min_element(sorted.begin(), sorted.end());
+      s.max_ms = *std::max_element(sorted.begin(), sorted.end());
+      s.avg_ms = sum / (float)e.filled;
+      s.allocs_avg = (float)alloc_sum / (float)e.filled;
+    }
+    out.push_back(s);
+  }
+}
+
+bool write_profile_trace(const SimProfiler &p, const char *path) {
+  FILE *f = std::fopen(path, "wb");
+  if (!f)
+    return false;
+  std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                  "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                  "\"tid\":1,\"args\":{\"name\":\"sim\"}}");
+  const uint64_t n = std::min<uint64_t>(p.trace_count, PROFILE_TRACE_EVENTS);
+  for (uint64_t i = p.trace_count - n; i < p.trace_count; i++) {
+    const ProfileTraceEvent &ev = p.trace[i % PROFILE_TRACE_EVENTS];
+    const ProfileEntry &e = p.entries[ev.entry];
+    std::fprintf(f,
+                 ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                 "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1,"
+                 "\"args\":{\"entities\":%u,\"allocs\":%u}}",
+                 e.name.c_str(), e.system ? "system" : "section",
+                 (double)ev.begin_ns * 1e-3, (double)ev.dur_ns * 1e-3,
+                 ev.entities, ev.allocs);
+  }
+  std::fprintf(f, "\n]}\n");
+  const bool ok = !std::ferror(f);
+  return std::fclose(f) == 0 && ok;
+}
+
+} // namespace musket
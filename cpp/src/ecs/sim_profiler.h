@@ -0,0 +1,137 @@
+#ifndef MUSKET_SIM_PROFILER_H
+#define MUSKET_SIM_PROFILER_H
+
+#include "../../flecs/flecs.h"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// ═══════════════════════════════════════════════════════════════
+// SIM PROFILER (per-system frame-time telemetry)
+//
+// register_sim_profiler swaps every engine system's run callback for a
+// timing wrapper (through ecs_system_init on the existing entity, so
+// the system's own callbacks and contexts are kept). Each run records
+// wall time, the entities its query matched, and the heap allocations
+// made through Flecs' OS API while it ran (table growth, command
+// queues). Allocations a system makes through its own std containers
+// are not seen.
+//
+// Work outside the pipeline (the whole tick, the command drain, the
+// centroid pass, the sync functions) is timed by ProfileScope sections.
+//
+// Every entry keeps its last PROFILE_WINDOW runs for min/avg/p99. While
+// profiling is on, each run is also logged to a ring of trace events
+// that write_profile_trace dumps as Chrome trace JSON
+// (chrome://tracing, Perfetto). Off, the wrapper only calls through.
+// ═══════════════════════════════════════════════════════════════
+
+namespace musket {
+
+constexpr uint32_t PROFILE_WINDOW = 600;            // Runs: 10s at 60Hz
+constexpr uint32_t PROFILE_TRACE_EVENTS = 1u << 18; // ~80s of ticks, 8MB
+
+// Timed work outside the Flecs pipeline. Entries 0..COUNT-1.
+enum ProfileSection : uint8_t {
+  PROFILE_TICK = 0,         // One fixed tick: drain, pre-tick, pipeline
+  PROFILE_COMMAND_DRAIN,    // drain_sim_commands
+  PROFILE_CENTROIDS,        // The pre-tick centroid pass
+  PROFILE_SYNC_TRANSFORMS,  // Legacy sequential repack
+  PROFILE_SYNC_BATTALIONS,  // Stable slot writes to shadow buffers
+  PROFILE_SYNC_PROJECTILES, // Projectile buffer
+  PROFILE_MACRO_ENCODE,     // encode_macro_sync for one client
+  PROFILE_MACRO_RECEIVE,    // receive_macro_sync on a client
+  PROFILE_SECTION_COUNT
+};
+
+struct SimProfiler;
+
+struct ProfileEntry {
+  std::string name;
+  flecs::entity_t system; // 0 for a section
+  ecs_run_action_t run;   // The system's own callbacks
+  ecs_iter_action_t action;
+  SimProfiler *owner;
+  uint32_t index; // In SimProfiler::entries
+
+  float ms[PROFILE_WINDOW]; // Ring of the last runs
+  uint32_t allocs[PROFILE_WINDOW];
+  uint32_t next;     // Ring write index
+  uint32_t filled;   // Samples in the ring
+  uint32_t entities; // Matched entities (or items) on the last run
+  uint64_t runs;     // Since profiling was last enabled
+};
+
+// One run, for the trace. Times are ns since the profiler's epoch.
+struct ProfileTraceEvent {
+  uint32_t entry;
+  uint32_t entities;
+  uint32_t allocs;
+  uint32_t pad;
+  int64_t begin_ns;
+  int64_t dur_ns;
+}; // 32 bytes
+
+struct SimProfiler {
+  std::deque<ProfileEntry> entries; // Stable addresses: systems hold them
+  bool enabled;
+  int64_t epoch_ns;
+  std::vector<ProfileTraceEvent> trace; // Ring, sized on enable
+  uint64_t trace_count;                 // Events ever logged since enable
+
+  void record(ProfileEntry &e, int64_t begin_ns, int64_t dur_ns,
+              uint32_t allocs, uint32_t entities);
+};
+
+// Singleton: the profiler's address, like SimCommandInbox
+struct SimProfile {
+  SimProfiler *profiler;
+};
+
+// Summary of one entry's window, in pipeline order after the sections
+struct ProfileStats {
+  const char *name;
+  bool system;
+  uint64_t runs;
+  uint32_t entities;
+  uint32_t samples;
+  float min_ms, avg_ms, p99_ms, max_ms;
+  float allocs_avg; // Per run
+  uint32_t allocs_max;
+};
+
+// Wraps every top-level system registered so far (Flecs' own module
+// systems are left alone). Call after the last register_*. Starts off.
+SimProfiler *register_sim_profiler(flecs::world &ecs);
+// Restores the systems' callbacks and frees the profiler
+void release_sim_profiler(flecs::world &ecs);
+
+// Enabling clears every window and the trace
+void set_profiling(flecs::world &ecs, bool enabled);
+bool is_profiling(const flecs::world &ecs);
+
+void profile_stats(const SimProfiler &p, std::vector<ProfileStats> &out);
+
+// The trace ring, oldest first, as Chrome trace JSON ("X" events on one
+// thread; sections nest the systems they contain).
+bool write_profile_trace(const SimProfiler &p, const char *path);
+
+int64_t profile_now_ns();
+
+// Times one section when the world has a profiler that is on
+struct ProfileScope {
+  ProfileEntry *entry;
+  int64_t begin_ns;
+  int64_t allocs;
+  uint32_t entities = 0; // Set by the caller when it has a count
+
+  ProfileScope(flecs::world &ecs, ProfileSection section);
+  ~ProfileScope();
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+} // namespace musket
+
+#endif // MUSKET_SIM_PROFILER_H
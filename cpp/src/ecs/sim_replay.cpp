@@ -0,0 +1,431 @@
+#include "sim_replay.h"
+#include "musket_systems.h"
+#include <cstdio>
+#include <cstring>
+
+namespace musket {
+
+// ═══════════════════════════════════════════════════════════════
+// REPLAY LOG FORMAT (little-endian, version 1)
+//
+//   u8[4] magic "MRPL"  u16 version  u16 pad
+//   u64 seed  u64 start_tick  u32 checkpoint_ticks
+//   records: u8 type, varint tick delta from the previous record, then
+//     COMMAND     u8 SimCommandType, zigzag target, zigzag arg, f32 x, z
+//     SPAWN       u8 kind, u8 team, varint count, f32 x, z
+//     SEED        u64 seed
+//     CHECKPOINT  u64 world_state_hash
+//     END         (nothing; the delta gives the stop tick)
+//
+// An order costs 12-16 bytes, so an hour of heavy command traffic is a
+// few hundred KB.
+// ═══════════════════════════════════════════════════════════════
+
+static constexpr char REPLAY_MAGIC[4] = {'M', 'R', 'P', 'L'};
+static constexpr size_t REPLAY_HEADER_BYTES = 28;
+
+static inline void put_u8(std::vector<uint8_t> &out, uint8_t v) {
+  out.push_back(v);
+}
+static inline void put_u32(std::vector<uint8_t> &out, uint32_t v) {
+  for (int i = 0; i < 4; i++)
+    out.push_back((uint8_t)(v >> (8 * i)));
+}
+static inline void put_u64(std::vector<uint8_t> &out, uint64_t v) {
+  put_u32(out, (uint32_t)v);
+  put_u32(out, (uint32_t)(v >> 32));
+}
+static inline void put_f32(std::vector<uint8_t> &out, float v) {
+  uint32_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  put_u32(out, bits);
+}
+static inline void put_varint(std::vector<uint8_t> &out, uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t)v);
+}
+static inline void put_zigzag(std::vector<uint8_t> &out, int32_t v) {
+  put_varint(out, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+struct ReplayReader {
+  const uint8_t *p;
+  const uint8_t *end;
+  bool bad = false;
+
+  inline uint8_t u8() {
+    if (p >= end) {
+      bad = true;
+      return 0;
+    }
+    return *p++;
+  }
+  inline uint32_t u32() {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+      v |= (uint32_t)u8() << (8 * i);
+    return v;
+  }
+  inline uint64_t u64() {
+    uint64_t lo = u32();
+    return lo | ((uint64_t)u32() << 32);
+  }
+  inline float f32() {
+    uint32_t bits = u32();
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+  inline uint64_t varint() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 70; shift += 7) {
+      uint8_t b = u8();
+      v |= (uint64_t)(b & 0x7F) << shift;
+      if (!(b & 0x80))
+        return v;
+    }
+    bad = true;
+    return 0;
+  }
+  inline int32_t zigzag() {
+    uint32_t v = (uint32_t)varint();
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+  }
+};
+
+// Decodes one record after `prev_tick`. False on a malformed record.
+static bool read_event(ReplayReader &r, uint64_t prev_tick, ReplayEvent &ev) {
+  ev.type = r.u8();
+  ev.tick = prev_tick + r.varint();
+  switch (ev.type) {
+  case REPLAY_COMMAND:
+    ev.command = {};
+    ev.command.type = r.u8();
+    ev.command.target = r.zigzag();
+    ev.command.arg = r.zigzag();
+    ev.command.x = r.f32();
+    ev.command.z = r.f32();
+    if (ev.command.type == CMD_NONE || ev.command.type >= CMD_TYPE_COUNT)
+      return false;
+    break;
+  case REPLAY_SPAWN:
+    ev.spawn = {};
+    ev.spawn.kind = r.u8();
+    ev.spawn.team = r.u8();
+    ev.spawn.count = (int32_t)r.varint();
+    ev.spawn.x = r.f32();
+    ev.spawn.z = r.f32();
+    if (ev.spawn.kind > REPLAY_SPAWN_CAVALRY)
+      return false;
+    break;
+  case REPLAY_SEED:
+  case REPLAY_CHECKPOINT:
+    ev.value = r.u64();
+    break;
+  case REPLAY_END:
+    break;
+  default:
+    return false;
+  }
+  return !r.bad;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// STATE HASH
+// ═══════════════════════════════════════════════════════════════
+static inline uint64_t hash_in(uint64_t h, uint64_t v) {
+  return sim_mix64(h ^ v);
+}
+static inline uint64_t hash_in(uint64_t h, float v) {
+  uint32_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  return sim_mix64(h ^ bits);
+}
+static inline uint64_t hash_in(uint64_t h, double v) {
+  uint64_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  return sim_mix64(h ^ bits);
+}
+
+uint64_t world_state_hash(flecs::world &ecs) {
+  uint64_t h = hash_in(0x9E3779B97F4A7C15ULL, ecs.get<SimClock>().tick);
+
+  ecs.each([&](flecs::entity e, const Position &p, const Velocity &v) {
+    h = hash_in(h, p.x);
+    h = hash_in(h, p.z);
+    h = hash_in(h, v.vx);
+    h = hash_in(h, v.vz);
+    h = hash_in(h, (uint64_t)e.has<IsAlive>());
+  });
+
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const int i = g_battalion_pool.live[k];
+    const MacroBattalion &mb = g_macro_battalions[i];
+    h = hash_in(h, (uint64_t)i << 32 | (uint32_t)mb.alive_count);
+    h = hash_in(h, mb.cx);
+    h = hash_in(h, mb.cz);
+    h = hash_in(h, mb.flag_cohesion);
+    h = hash_in(h, (uint64_t)mb.fire_discipline << 8 | mb.shape);
+    h = hash_in(h, (uint64_t)(int64_t)mb.target_bat_id);
+    h = hash_in(h, mb.anchor_x);
+    h = hash_in(h, mb.anchor_z);
+  }
+
+  if (const ProjectilePool *pool = ecs.try_get<ProjectilePool>()) {
+    h = hash_in(h, (uint64_t)pool->count);
+    for (int i = 0; i < pool->count; i++) {
+      h = hash_in(h, pool->x[i]);
+      h = hash_in(h, pool->y[i]);
+      h = hash_in(h, pool->z[i]);
+      h = hash_in(h, (uint64_t)pool->active[i]);
+    }
+  }
+  return h;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// RECORDING
+// ═══════════════════════════════════════════════════════════════
+void ReplayRecorder::begin(uint64_t seed, uint64_t tick, uint32_t every) {
+  bytes.clear();
+  bytes.reserve(64 * 1024);
+  bytes.insert(bytes.end(), REPLAY_MAGIC, REPLAY_MAGIC + 4);
+  put_u32(bytes, REPLAY_VERSION); // u16 version + u16 pad
+  put_u64(bytes, seed);
+  put_u64(bytes, tick);
+  put_u32(bytes, every);
+  last_tick = tick;
+  next_checkpoint = tick; // First drain: the world as spawned
+  checkpoint_ticks = every > 0 ? every : REPLAY_CHECKPOINT_TICKS;
+}
+
+void ReplayRecorder::record(uint8_t type, uint64_t tick) {
+  put_u8(bytes, type);
+  put_varint(bytes, tick - last_tick);
+  last_tick = tick;
+}
+
+void ReplayRecorder::command(uint64_t tick, const SimCommand &c) {
+  record(REPLAY_COMMAND, tick);
+  put_u8(bytes, c.type);
+  put_zigzag(bytes, c.target);
+  put_zigzag(bytes, c.arg);
+  put_f32(bytes, c.x);
+  put_f32(bytes, c.z);
+}
+
+void ReplayRecorder::spawn(uint64_t tick, const ReplaySpawn &s) {
+  record(REPLAY_SPAWN, tick);
+  put_u8(bytes, s.kind);
+  put_u8(bytes, s.team);
+  put_varint(bytes, (uint32_t)s.count);
+  put_f32(bytes, s.x);
+  put_f32(bytes, s.z);
+}
+
+void ReplayRecorder::seed(uint64_t tick, uint64_t value) {
+  record(REPLAY_SEED, tick);
+  put_u64(bytes, value);
+}
+
+void ReplayRecorder::checkpoint(uint64_t tick, uint64_t hash) {
+  record(REPLAY_CHECKPOINT, tick);
+  put_u64(bytes, hash);
+  next_checkpoint = tick + checkpoint_ticks;
+}
+
+void ReplayRecorder::finish(uint64_t tick) { record(REPLAY_END, tick); }
+
+static ReplayRecorder *active_recorder(flecs::world &ecs) {
+  SimReplay *replay = ecs.try_get_mut<SimReplay>();
+  return replay ? replay->recorder : nullptr;
+}
+
+bool begin_replay_recording(flecs::world &ecs, uint32_t checkpoint_ticks) {
+  if (active_recorder(ecs) || g_battalion_pool.live_count != 0)
+    return false;
+  const SimRng *rng = ecs.try_get<SimRng>();
+  auto *rec = new ReplayRecorder();
+  rec->begin(rng ? rng->seed : 0, ecs.get<SimClock>().tick, checkpoint_ticks);
+  ecs.set<SimReplay>({rec});
+  return true;
+}
+
+bool end_replay_recording(flecs::world &ecs, std::vector<uint8_t> &out) {
+  ReplayRecorder *rec = active_recorder(ecs);
+  if (!rec)
+    return false;
+  rec->finish(ecs.get<SimClock>().tick);
+  out.swap(rec->bytes);
+  delete rec;
+  ecs.get_mut<SimReplay>().recorder = nullptr;
+  return true;
+}
+
+bool is_replay_recording(flecs::world &ecs) {
+  return active_recorder(ecs) != nullptr;
+}
+
+bool save_replay_file(const char *path, const std::vector<uint8_t> &bytes) {
+  FILE *f = std::fopen(path, "wb");
+  if (!f)
+    return false;
+  const bool ok =
+      std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+  return std::fclose(f) == 0 && ok;
+}
+
+void record_replay_spawn(flecs::world &ecs, const ReplaySpawn &s) {
+  if (ReplayRecorder *rec = active_recorder(ecs))
+    rec->spawn(ecs.get<SimClock>().tick, s);
+}
+
+void record_replay_seed(flecs::world &ecs, uint64_t seed) {
+  if (ReplayRecorder *rec = active_recorder(ecs))
+    rec->seed(ecs.get<SimClock>().tick, seed);
+}
+
+void record_replay_drain(flecs::world &ecs) {
+  ReplayRecorder *rec = active_recorder(ecs);
+  if (!rec)
+    return;
+  const uint64_t tick = ecs.get<SimClock>().tick;
+  if (tick >= rec->next_checkpoint)
+    rec->checkpoint(tick, world_state_hash(ecs));
+}
+
+void record_replay_command(flecs::world &ecs, const SimCommand &c) {
+  if (ReplayRecorder *rec = active_recorder(ecs))
+    rec->command(ecs.get<SimClock>().tick, c);
+}
+
+// ═══════════════════════════════════════════════════════════════
+// PLAYBACK
+// ═══════════════════════════════════════════════════════════════
+bool ReplayPlayer::load(const uint8_t *data, size_t size) {
+  bytes.clear();
+  has_next = false;
+  if (size < REPLAY_HEADER_BYTES || std::memcmp(data, REPLAY_MAGIC, 4) != 0)
+    return false;
+  ReplayReader r = {data + 4, data + size};
+  if ((r.u32() & 0xFFFF) != REPLAY_VERSION)
+    return false;
+  seed = r.u64();
+  start_tick = r.u64();
+  checkpoint_ticks = r.u32();
+
+  // Walk every record once: a truncated or corrupt log fails here, not
+  // halfway through a playback
+  uint64_t tick = start_tick;
+  record_count = 0;
+  ReplayEvent ev;
+  for (;;) {
+    if (!read_event(r, tick, ev))
+      return false;
+    tick = ev.tick;
+    if (ev.type == REPLAY_END)
+      break;
+    record_count++;
+  }
+  if (r.p != r.end)
+    return false; // Bytes after END
+  end_tick = tick;
+
+  bytes.assign(data, data + size);
+  rewind();
+  return true;
+}
+
+bool ReplayPlayer::load_file(const char *path) {
+  FILE *f = std::fopen(path, "rb");
+  if (!f)
+    return false;
+  std::fseek(f, 0, SEEK_END);
+  const long size = std::ftell(f);
+  std::fseek(f, 0, SEEK_SET);
+  std::vector<uint8_t> data(size > 0 ? (size_t)size : 0);
+  const bool read =
+      size > 0 && std::fread(data.data(), 1, data.size(), f) == data.size();
+  std::fclose(f);
+  return read && load(data.data(), data.size());
+}
+
+static void next_event(ReplayPlayer &p) {
+  ReplayReader r = {p.bytes.data() + p.pos, p.bytes.data() + p.bytes.size()};
+  const uint64_t prev = p.next.tick;
+  p.has_next = read_event(r, prev, p.next) && p.next.type != REPLAY_END;
+  p.pos = (size_t)(r.p - p.bytes.data());
+}
+
+void ReplayPlayer::rewind() {
+  pos = REPLAY_HEADER_BYTES;
+  next.tick = start_tick;
+  checkpoints_ok = 0;
+  diverged_tick = REPLAY_NO_DIVERGENCE;
+  next_event(*this);
+}
+
+bool begin_replay_playback(flecs::world &ecs, ReplayPlayer &p,
+                           void (*pre_tick)(flecs::world &)) {
+  if (p.bytes.empty() || g_battalion_pool.live_count != 0 ||
+      ecs.get<SimClock>().tick > p.start_tick)
+    return false;
+  p.rewind();
+  ecs.get_mut<SimRng>().seed = p.seed;
+  while (ecs.get<SimClock>().tick < p.start_tick)
+    step_simulation(ecs, pre_tick);
+  return true;
+}
+
+bool step_replay(flecs::world &ecs, ReplayPlayer &p,
+                 void (*pre_tick)(flecs::world &), ReplaySpawnFn spawn,
+                 void *user) {
+  // Inputs stamped with this tick, in the order they first landed
+  const uint64_t tick = ecs.get<SimClock>().tick;
+  while (p.has_next && p.next.tick <= tick) {
+    const ReplayEvent &ev = p.next;
+    switch (ev.type) {
+    case REPLAY_SPAWN:
+      if (spawn)
+        spawn(ecs, ev.spawn, user);
+      break;
+    case REPLAY_SEED:
+      ecs.get_mut<SimRng>().seed = ev.value;
+      break;
+    case REPLAY_CHECKPOINT:
+      if (world_state_hash(ecs) == ev.value)
+        p.checkpoints_ok++;
+      else if (!p.diverged())
+        p.diverged_tick = tick;
+      break;
+    case REPLAY_COMMAND:
+      // Where drain_sim_commands applied it: after the checkpoint,
+      // before the centroid pass
+      apply_sim_command(ecs, ev.command);
+      break;
+    default:
+      break;
+    }
+    next_event(p);
+  }
+  if (p.finished(tick))
+    return false;
+  step_simulation(ecs, pre_tick);
+  return true;
+}
+
+uint64_t fast_forward_replay(flecs::world &ecs, ReplayPlayer &p,
+                             uint64_t until_tick,
+                             void (*pre_tick)(flecs::world &),
+                             ReplaySpawnFn spawn, void *user) {
+  uint64_t ran = 0;
+  while (ecs.get<SimClock>().tick < until_tick &&
+         step_replay(ecs, p, pre_tick, spawn, user))
+    ran++;
+  return ran;
+}
+
+} // namespace musket
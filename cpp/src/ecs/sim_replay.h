@@ -0,0 +1,163 @@
+#ifndef MUSKET_SIM_REPLAY_H
+#define MUSKET_SIM_REPLAY_H
+
+#include "../../flecs/flecs.h"
+#include "musket_components.h"
+#include "sim_commands.h"
+#include <cstdint>
+#include <vector>
+
+// ═══════════════════════════════════════════════════════════════
+// DETERMINISTIC REPLAY
+//
+// A replay holds the world seed, the tick that recording began at, and
+// every input in the order the sim applied it. Spawns and seed changes
+// land between ticks. Commands are logged as drain_sim_commands applies
+// them. Each input is stamped with the SimClock.tick it landed before.
+// The sim RNG is keyed on (seed, tick, entity), so the same inputs at
+// the same ticks replay the same battle, tick for tick.
+//
+// Every checkpoint_ticks the recorder logs world_state_hash. Playback
+// compares its own hash at that tick and reports the first tick that
+// diverged. Playback never reads the wall clock: fast-forward runs
+// ticks back to back, as fast as the CPU allows.
+//
+// Terrain, voxel edits and group rates are not inputs: play a replay
+// back on the map it was recorded on.
+// ═══════════════════════════════════════════════════════════════
+
+namespace musket {
+
+constexpr uint16_t REPLAY_VERSION = 1;
+constexpr uint32_t REPLAY_CHECKPOINT_TICKS = 600; // 10s of sim
+constexpr uint64_t REPLAY_NO_DIVERGENCE = ~0ULL;
+
+enum ReplayRecordType : uint8_t {
+  REPLAY_COMMAND = 1,    // SimCommand, drained at the top of the tick
+  REPLAY_SPAWN = 2,      // ReplaySpawn, before the tick
+  REPLAY_SEED = 3,       // SimRng.seed changed, before the tick
+  REPLAY_CHECKPOINT = 4, // world_state_hash before the tick's commands
+  REPLAY_END = 5         // Recording stopped; no records follow
+};
+
+enum ReplaySpawnKind : uint8_t {
+  REPLAY_SPAWN_INFANTRY = 0, // spawn_test_battalion
+  REPLAY_SPAWN_BATTERY = 1,  // spawn_test_battery (count = guns)
+  REPLAY_SPAWN_CAVALRY = 2   // spawn_test_cavalry
+};
+
+// The parameters of one GDScript spawn call: the spawn itself is
+// deterministic in them and the seed
+struct ReplaySpawn {
+  uint8_t kind; // ReplaySpawnKind
+  uint8_t team;
+  uint8_t pad[2];
+  int32_t count;
+  float x, z;
+}; // 16 bytes
+
+// One decoded record
+struct ReplayEvent {
+  uint64_t tick;
+  uint8_t type; // ReplayRecordType
+  SimCommand command;
+  ReplaySpawn spawn;
+  uint64_t value; // REPLAY_SEED: seed, REPLAY_CHECKPOINT: hash
+};
+
+// ── Recording (heap object, owned by the SimReplay singleton) ──
+// Records go straight into a growing byte log (~16B per order, ~12B
+// per checkpoint); nothing is encoded at stop.
+struct ReplayRecorder {
+  std::vector<uint8_t> bytes;
+  uint64_t last_tick;       // Tick of the newest record
+  uint64_t next_checkpoint; // Next tick to hash
+  uint32_t checkpoint_ticks;
+
+  void begin(uint64_t seed, uint64_t tick, uint32_t checkpoint_ticks);
+  void command(uint64_t tick, const SimCommand &c);
+  void spawn(uint64_t tick, const ReplaySpawn &s);
+  void seed(uint64_t tick, uint64_t seed);
+  void checkpoint(uint64_t tick, uint64_t hash);
+  void finish(uint64_t tick);
+
+private:
+  void record(uint8_t type, uint64_t tick);
+};
+
+// ── Playback ────────────────────────────────────────────────
+struct ReplayPlayer {
+  std::vector<uint8_t> bytes;
+  uint64_t seed;       // Seed when recording began
+  uint64_t start_tick; // Tick when recording began
+  uint64_t end_tick;   // Tick when it stopped
+  uint32_t checkpoint_ticks;
+  uint32_t record_count;
+
+  size_t pos; // Next record's byte offset
+  ReplayEvent next;
+  bool has_next;
+  uint32_t checkpoints_ok;
+  uint64_t diverged_tick; // First checkpoint that missed, or NO_DIVERGENCE
+
+  // Validates the whole log; false on a bad magic, version or record
+  bool load(const uint8_t *data, size_t size);
+  bool load_file(const char *path);
+  void rewind();
+  bool finished(uint64_t tick) const { return tick >= end_tick; }
+  bool diverged() const { return diverged_tick != REPLAY_NO_DIVERGENCE; }
+};
+
+// Singleton: the active recorder, when there is one
+struct SimReplay {
+  ReplayRecorder *recorder;
+};
+
+// Hash of the state inputs act on: soldier positions, velocities and
+// life, the macro battalion table and the projectile pool. Order
+// dependent: two worlds built by the same inputs iterate alike.
+uint64_t world_state_hash(flecs::world &ecs);
+
+// Recording starts on a world with no live battalion (the seed and the
+// tick are the whole initial state). False if one already exists.
+bool begin_replay_recording(
+    flecs::world &ecs, uint32_t checkpoint_ticks = REPLAY_CHECKPOINT_TICKS);
+// Appends END at the current tick and moves the log into `out`. False
+// if nothing was recording.
+bool end_replay_recording(flecs::world &ecs, std::vector<uint8_t> &out);
+bool is_replay_recording(flecs::world &ecs);
+bool save_replay_file(const char *path, const std::vector<uint8_t> &bytes);
+
+// Input hooks; no-ops while not recording. drain_sim_commands calls
+// record_replay_drain once per tick and record_replay_command per order.
+void record_replay_spawn(flecs::world &ecs, const ReplaySpawn &s);
+void record_replay_seed(flecs::world &ecs, uint64_t seed);
+void record_replay_drain(flecs::world &ecs);
+void record_replay_command(flecs::world &ecs, const SimCommand &c);
+
+// Rebuilds a GDScript spawn call. Returns false if it was refused.
+typedef bool (*ReplaySpawnFn)(flecs::world &ecs, const ReplaySpawn &s,
+                              void *user);
+
+// On a fresh world: applies the recorded seed and idles to the start
+// tick (so every group rate filter has the same phase). False if the
+// world is already past the start tick or has live battalions.
+bool begin_replay_playback(flecs::world &ecs, ReplayPlayer &p,
+                           void (*pre_tick)(flecs::world &));
+
+// One tick: the inputs recorded before it, then the tick itself.
+// Returns false (running nothing) once the log has ended.
+bool step_replay(flecs::world &ecs, ReplayPlayer &p,
+                 void (*pre_tick)(flecs::world &), ReplaySpawnFn spawn,
+                 void *user);
+
+// Headless fast-forward: steps to `until_tick` or the end of the log,
+// whichever comes first. Returns the ticks run.
+uint64_t fast_forward_replay(flecs::world &ecs, ReplayPlayer &p,
+                             uint64_t until_tick,
+                             void (*pre_tick)(flecs::world &),
+                             ReplaySpawnFn spawn, void *user);
+
+} // namespace musket
+
+#endif // MUSKET_SIM_REPLAY_H
@@ -0,0 +1,653 @@
+#include "sim_snapshot.h"
+#include "musket_systems.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+namespace musket {
+
+// ═══════════════════════════════════════════════════════════════
+// SNAPSHOT FORMAT (version 1, host byte order like voxel files)
+//
+//   u8[4] magic "MSNP"  u16 version  u16 pad
+//   u32 component count, per component: u8 name length, name, u32 size
+//   u32 table count, per table:
+//     u8 id count, u8 component index per id (table type order)
+//     u32 rows (0: an empty table, kept for its place in the order),
+//     u64 entity id per row
+//     per non-tag id: rows * size bytes, the column as Flecs holds it
+//   u32 block count, per block: u8 name length, name, u32 size, bytes
+//
+// Column bytes go in and out with one memcpy each; a 200K-soldier
+// world is ~16MB and nothing in it is encoded per entity.
+// ═══════════════════════════════════════════════════════════════
+
+static constexpr char SNAPSHOT_MAGIC[4] = {'M', 'S', 'N', 'P'};
+
+// ── Schema: every component a sim entity may carry ──────────
+struct SnapshotComponent {
+  const char *name;
+  uint32_t size; // 0 = tag
+  flecs::id_t (*id)(flecs::world &);
+};
+
+template <typename T> static flecs::id_t snapshot_component_id(flecs::world &ecs) {
+  return ecs.id<T>();
+}
+
+#define SNAPSHOT_COMPONENT(T)                                                  \
+  {#T, std::is_empty<T>::value ? 0u : (uint32_t)sizeof(T),                     \
+   snapshot_component_id<T>}
+
+static const SnapshotComponent SNAPSHOT_SCHEMA[] = {
+    // Spatial + combat state
+    SNAPSHOT_COMPONENT(Position), SNAPSHOT_COMPONENT(Velocity),
+    SNAPSHOT_COMPONENT(Height), SNAPSHOT_COMPONENT(IsAlive),
+    SNAPSHOT_COMPONENT(Routing), SNAPSHOT_COMPONENT(TeamId),
+    SNAPSHOT_COMPONENT(BattalionId), SNAPSHOT_COMPONENT(SoldierFormationTarget),
+    SNAPSHOT_COMPONENT(MovementStats), SNAPSHOT_COMPONENT(MusketState),
+    SNAPSHOT_COMPONENT(HaltOrder), SNAPSHOT_COMPONENT(FireOrder),
+    SNAPSHOT_COMPONENT(ArtilleryBattery), SNAPSHOT_COMPONENT(CavalryState),
+    SNAPSHOT_COMPONENT(FormationDefense), SNAPSHOT_COMPONENT(ChargeOrder),
+    SNAPSHOT_COMPONENT(Disordered), SNAPSHOT_COMPONENT(RenderSlot),
+    // Command network
+    SNAPSHOT_COMPONENT(FormationAnchor), SNAPSHOT_COMPONENT(Drummer),
+    SNAPSHOT_COMPONENT(OrderLatency), SNAPSHOT_COMPONENT(ElevatedLOS),
+    // Medical + S-LOD
+    SNAPSHOT_COMPONENT(Downed), SNAPSHOT_COMPONENT(Veteran),
+    SNAPSHOT_COMPONENT(Amputee), SNAPSHOT_COMPONENT(MacroSimulated),
+    // Economy
+    SNAPSHOT_COMPONENT(Citizen), SNAPSHOT_COMPONENT(Workplace),
+    SNAPSHOT_COMPONENT(CargoManifest), SNAPSHOT_COMPONENT(Household)};
+
+#undef SNAPSHOT_COMPONENT
+
+static constexpr int SNAPSHOT_COMPONENT_COUNT =
+    (int)(sizeof(SNAPSHOT_SCHEMA) / sizeof(SNAPSHOT_SCHEMA[0]));
+
+// ── Blocks: fixed-size state saved byte for byte ────────────
+// `get` returns nullptr when the world has no such singleton (a test
+// world without the economy); its block is then skipped both ways.
+struct SnapshotBlock {
+  const char *name;
+  uint32_t size;
+  void *(*get)(flecs::world &);
+};
+
+template <typename T> static void *snapshot_singleton(flecs::world &ecs) {
+  return ecs.try_get_mut<T>();
+}
+static void *snapshot_macro_battalions(flecs::world &) {
+  return g_macro_battalions;
+}
+static void *snapshot_pending_orders(flecs::world &) {
+  return g_pending_orders;
+}
+static void *snapshot_battalion_pool(flecs::world &) {
+  return &g_battalion_pool;
+}
+
+static const SnapshotBlock SNAPSHOT_BLOCKS[] = {
+    {"SimClock", sizeof(SimClock), snapshot_singleton<SimClock>},
+    {"SimRng", sizeof(SimRng), snapshot_singleton<SimRng>},
+    {"MacroBattalions", sizeof(g_macro_battalions), snapshot_macro_battalions},
+    {"PendingOrders", sizeof(g_pending_orders), snapshot_pending_orders},
+    {"BattalionPool", sizeof(BattalionPool), snapshot_battalion_pool},
+    {"PanicGrid", sizeof(PanicGrid), snapshot_singleton<PanicGrid>},
+    {"FleeField", sizeof(FleeField), snapshot_singleton<FleeField>},
+    {"CivicGrid", sizeof(CivicGrid), snapshot_singleton<CivicGrid>},
+    {"GlobalZeitgeist", sizeof(GlobalZeitgeist),
+     snapshot_singleton<GlobalZeitgeist>},
+    {"ProjectilePool", sizeof(ProjectilePool),
+     snapshot_singleton<ProjectilePool>}};
+
+static constexpr int SNAPSHOT_BLOCK_COUNT =
+    (int)(sizeof(SNAPSHOT_BLOCKS) / sizeof(SNAPSHOT_BLOCKS[0]));
+
+// ── Blocks with a layout of their own ───────────────────────
+// Group rate phases: rate, tick_count, time_elapsed per slow group
+static constexpr const char *BLOCK_GROUP_RATES = "SimGroupRates";
+static constexpr uint32_t GROUP_RATE_BYTES = 12;
+// Queued re-forms only; the rest of FormationRoster is solver scratch
+static constexpr const char *BLOCK_FORMATION = "FormationRequests";
+static constexpr uint32_t FORMATION_REQUEST_BYTES =
+    MAX_BATTALIONS * (1 + 4 + 4) + 4;
+// u32 idle citizen count, u32 job count, LogisticsJob[count]
+static constexpr const char *BLOCK_JOB_BOARD = "JobBoard";
+
+// ═══════════════════════════════════════════════════════════════
+// BYTE HELPERS
+// ═══════════════════════════════════════════════════════════════
+static inline void snap_put(std::vector<uint8_t> &out, const void *p,
+                            size_t n) {
+  const uint8_t *b = static_cast<const uint8_t *>(p);
+  out.insert(out.end(), b, b + n);
+}
+static inline void snap_put_u8(std::vector<uint8_t> &out, uint8_t v) {
+  out.push_back(v);
+}
+static inline void snap_put_u32(std::vector<uint8_t> &out, uint32_t v) {
+  snap_put(out, &v, sizeof(v));
+}
+static inline void snap_put_name(std::vector<uint8_t> &out,
+                                 const char *name) {
+  const size_t n = std::strlen(name);
+  snap_put_u8(out, (uint8_t)n);
+  snap_put(out, name, n);
+}
+static void snap_put_block(std::vector<uint8_t> &out, const char *name,
+                           const void *p, uint32_t size) {
+  snap_put_name(out, name);
+  snap_put_u32(out, size);
+  snap_put(out, p, size);
+}
+
+struct SnapshotReader {
+  const uint8_t *p;
+  const uint8_t *end;
+  bool bad = false;
+
+  // Advances past n bytes; nullptr (and bad) if the snapshot is short
+  inline const uint8_t *take(size_t n) {
+    if ((size_t)(end - p) < n) {
+      bad = true;
+      p = end;
+      return nullptr;
+    }
+    const uint8_t *at = p;
+    p += n;
+    return at;
+  }
+  inline uint8_t u8() {
+    const uint8_t *b = take(1);
+    return b ? *b : 0;
+  }
+  inline uint32_t u32() {
+    uint32_t v = 0;
+    if (const uint8_t *b = take(4))
+      std::memcpy(&v, b, 4);
+    return v;
+  }
+  inline bool name_is(const char *name, uint8_t len, const uint8_t *at) const {
+    return at && std::strlen(name) == len && std::memcmp(name, at, len) == 0;
+  }
+};
+
+// ═══════════════════════════════════════════════════════════════
+// JOB BOARD + GROUP RATES
+// ═══════════════════════════════════════════════════════════════
+static void put_group_rates(flecs::world &ecs, std::vector<uint8_t> &out) {
+  snap_put_name(out, BLOCK_GROUP_RATES);
+  snap_put_u32(out, (SIM_GROUP_COUNT - 1) * GROUP_RATE_BYTES);
+  for (int g = SIM_GROUP_PHYSICS + 1; g < SIM_GROUP_COUNT; g++) {
+    EcsRateFilter rf = {};
+    flecs::entity src = sim_group_source(ecs, g);
+    if (src && src.has<flecs::RateFilter>())
+      rf = src.get<flecs::RateFilter>();
+    const float elapsed = (float)rf.time_elapsed;
+    snap_put(out, &rf.rate, 4);
+    snap_put(out, &rf.tick_count, 4);
+    snap_put(out, &elapsed, 4);
+  }
+}
+
+static void apply_group_rates(flecs::world &ecs, const uint8_t *p) {
+  for (int g = SIM_GROUP_PHYSICS + 1; g < SIM_GROUP_COUNT; g++, p += 12) {
+    flecs::entity src = sim_group_source(ecs, g);
+    if (!src || !src.has<flecs::RateFilter>())
+      continue;
+    int32_t rate, ticks;
+    float elapsed;
+    std::memcpy(&rate, p, 4);
+    std::memcpy(&ticks, p + 4, 4);
+    std::memcpy(&elapsed, p + 8, 4);
+    EcsRateFilter &rf = src.get_mut<flecs::RateFilter>();
+    rf.rate = rate;
+    rf.tick_count = ticks;
+    rf.time_elapsed = (ecs_ftime_t)elapsed;
+  }
+}
+
+static void put_formation_requests(flecs::world &ecs,
+                                   std::vector<uint8_t> &out) {
+  const FormationRoster *roster = ecs.try_get<FormationRoster>();
+  if (!roster)
+    return;
+  snap_put_name(out, BLOCK_FORMATION);
+  snap_put_u32(out, FORMATION_REQUEST_BYTES);
+  snap_put(out, roster->pending_shape, sizeof(roster->pending_shape));
+  snap_put(out, roster->pending_dir_x, sizeof(roster->pending_dir_x));
+  snap_put(out, roster->pending_dir_z, sizeof(roster->pending_dir_z));
+  snap_put(out, &roster->pending_count, 4);
+}
+
+static void apply_formation_requests(flecs::world &ecs, const uint8_t *p) {
+  FormationRoster *roster = ecs.try_get_mut<FormationRoster>();
+  if (!roster)
+    return;
+  std::memcpy(roster->pending_shape, p, sizeof(roster->pending_shape));
+  p += sizeof(roster->pending_shape);
+  std::memcpy(roster->pending_dir_x, p, sizeof(roster->pending_dir_x));
+  p += sizeof(roster->pending_dir_x);
+  std::memcpy(roster->pending_dir_z, p, sizeof(roster->pending_dir_z));
+  p += sizeof(roster->pending_dir_z);
+  std::memcpy(&roster->pending_count, p, 4);
+}
+
+static void put_job_board(std::vector<uint8_t> &out) {
+  const std::vector<LogisticsJob> &jobs = economy_job_board();
+  snap_put_name(out, BLOCK_JOB_BOARD);
+  snap_put_u32(out, 8 + (uint32_t)(jobs.size() * sizeof(LogisticsJob)));
+  snap_put_u32(out, (uint32_t)economy_idle_citizens());
+  snap_put_u32(out, (uint32_t)jobs.size());
+  snap_put(out, jobs.data(), jobs.size() * sizeof(LogisticsJob));
+}
+
+static bool job_board_fits(const uint8_t *p, uint32_t size) {
+  if (size < 8)
+    return false;
+  uint32_t count;
+  std::memcpy(&count, p + 4, 4);
+  return (uint64_t)size == 8 + (uint64_t)count * sizeof(LogisticsJob);
+}
+
+static void apply_job_board(const uint8_t *p) {
+  uint32_t idle, count;
+  std::memcpy(&idle, p, 4);
+  std::memcpy(&count, p + 4, 4);
+  economy_idle_citizens() = (int)idle;
+  std::vector<LogisticsJob> &jobs = economy_job_board();
+  jobs.resize(count);
+  std::memcpy(jobs.data(), p + 8, (size_t)count * sizeof(LogisticsJob));
+}
+
+// ═══════════════════════════════════════════════════════════════
+// CAPTURE
+// ═══════════════════════════════════════════════════════════════
+bool capture_world_snapshot(flecs::world &ecs, std::vector<uint8_t> &out) {
+  out.clear();
+  snap_put(out, SNAPSHOT_MAGIC, 4);
+  snap_put_u32(out, SNAPSHOT_VERSION); // u16 version + u16 pad
+
+  flecs::id_t schema_id[SNAPSHOT_COMPONENT_COUNT];
+  snap_put_u32(out, SNAPSHOT_COMPONENT_COUNT);
+  for (int c = 0; c < SNAPSHOT_COMPONENT_COUNT; c++) {
+    snap_put_name(out, SNAPSHOT_SCHEMA[c].name);
+    snap_put_u32(out, SNAPSHOT_SCHEMA[c].size);
+    schema_id[c] = SNAPSHOT_SCHEMA[c].id(ecs);
+  }
+
+  // Table count is patched in once the walk is done
+  const size_t table_count_at = out.size();
+  snap_put_u32(out, 0);
+  uint32_t tables = 0;
+  bool ok = true;
+
+  // Empty tables too, in the order this world created them: tables are
+  // rebuilt in file order, so systems walk them in the same order.
+  // Prefabs and disabled entities are matched so that anything restore
+  // would delete fails the schema check here instead.
+  flecs::query<> q = ecs.query_builder()
+                         .with<Position>()
+                         .query_flags(EcsQueryMatchEmptyTables |
+                                      EcsQueryMatchPrefab |
+                                      EcsQueryMatchDisabled)
+                         .build();
+  q.run([&](flecs::iter &it) {
+    while (it.next()) {
+      ecs_table_t *table = it.table().get_table();
+      const ecs_type_t *type = ecs_table_get_type(table);
+      const int32_t rows = ecs_table_count(table);
+      if (!ok)
+        continue;
+
+      uint8_t index[FLECS_ID_DESC_MAX];
+      if (type->count > FLECS_ID_DESC_MAX) {
+        ok = false;
+        continue;
+      }
+      for (int32_t i = 0; i < type->count; i++) {
+        int c = 0;
+        while (c < SNAPSHOT_COMPONENT_COUNT && schema_id[c] != type->array[i])
+          c++;
+        if (c == SNAPSHOT_COMPONENT_COUNT)
+          ok = false; // Unlisted component, pair or name
+        index[i] = (uint8_t)c;
+      }
+      if (!ok)
+        continue;
+
+      snap_put_u8(out, (uint8_t)type->count);
+      snap_put(out, index, (size_t)type->count);
+      snap_put_u32(out, (uint32_t)rows);
+      snap_put(out, ecs_table_entities(table), sizeof(ecs_entity_t) * rows);
+      for (int32_t i = 0; i < type->count; i++) {
+        const uint32_t size = SNAPSHOT_SCHEMA[index[i]].size;
+        if (size == 0)
+          continue;
+        const int32_t col = ecs_table_type_to_column_index(table, i);
+        snap_put(out, ecs_table_get_column(table, col, 0),
+                 (size_t)size * rows);
+      }
+      tables++;
+    }
+  });
+  if (!ok) {
+    out.clear();
+    return false;
+  }
+  std::memcpy(out.data() + table_count_at, &tables, 4);
+
+  // Singletons and globals
+  const size_t block_count_at = out.size();
+  snap_put_u32(out, 0);
+  uint32_t blocks = 0;
+  for (int b = 0; b < SNAPSHOT_BLOCK_COUNT; b++) {
+    if (const void *p = SNAPSHOT_BLOCKS[b].get(ecs)) {
+      snap_put_block(out, SNAPSHOT_BLOCKS[b].name, p, SNAPSHOT_BLOCKS[b].size);
+      blocks++;
+    }
+  }
+  put_group_rates(ecs, out);
+  blocks++;
+  if (ecs.has<FormationRoster>()) {
+    put_formation_requests(ecs, out);
+    blocks++;
+  }
+  put_job_board(out);
+  blocks++;
+  std::memcpy(out.data() + block_count_at, &blocks, 4);
+  return true;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// RESTORE
+// ═══════════════════════════════════════════════════════════════
+
+// One table as it sits in the snapshot bytes
+struct SnapshotTable {
+  uint8_t id_count;
+  uint8_t schema[FLECS_ID_DESC_MAX]; // Index into SNAPSHOT_SCHEMA
+  uint32_t rows;
+  const uint8_t *entities;                // rows * u64, maybe unaligned
+  const uint8_t *column[FLECS_ID_DESC_MAX]; // nullptr for tags
+};
+
+struct SnapshotBlockView {
+  int known; // SNAPSHOT_BLOCKS index, or -1 for the custom blocks
+  const uint8_t *name;
+  uint8_t name_len;
+  const uint8_t *data;
+  uint32_t size;
+};
+
+// Parses and checks the whole snapshot without touching the world
+static bool parse_snapshot(const uint8_t *data, size_t size,
+                           std::vector<SnapshotTable> &tables,
+                           std::vector<SnapshotBlockView> &blocks,
+                           std::vector<uint32_t> &indices) {
+  if (size < 8 || std::memcmp(data, SNAPSHOT_MAGIC, 4) != 0)
+    return false;
+  SnapshotReader r = {data + 4, data + size};
+  if ((r.u32() & 0xFFFF) != SNAPSHOT_VERSION)
+    return false;
+
+  // File component → schema index, by name and size
+  const uint32_t component_count = r.u32();
+  if (component_count > 255)
+    return false;
+  uint8_t file_to_schema[256];
+  for (uint32_t f = 0; f < component_count; f++) {
+    const uint8_t len = r.u8();
+    const uint8_t *name = r.take(len);
+    const uint32_t csize = r.u32();
+    if (r.bad)
+      return false;
+    int c = 0;
+    while (c < SNAPSHOT_COMPONENT_COUNT &&
+           !r.name_is(SNAPSHOT_SCHEMA[c].name, len, name))
+      c++;
+    if (c == SNAPSHOT_COMPONENT_COUNT || SNAPSHOT_SCHEMA[c].size != csize)
+      return false; // Unknown component or changed layout
+    file_to_schema[f] = (uint8_t)c;
+  }
+
+  const uint32_t table_count = r.u32();
+  tables.clear();
+  indices.clear();
+  for (uint32_t t = 0; t < table_count && !r.bad; t++) {
+    SnapshotTable st;
+    st.id_count = r.u8();
+    if (st.id_count == 0 || st.id_count > FLECS_ID_DESC_MAX)
+      return false;
+    for (int i = 0; i < st.id_count; i++) {
+      const uint8_t f = r.u8();
+      if (f >= component_count)
+        return false;
+      st.schema[i] = file_to_schema[f];
+    }
+    st.rows = r.u32();
+    st.entities = r.take((size_t)st.rows * sizeof(uint64_t));
+    for (int i = 0; i < st.id_count; i++) {
+      const uint32_t csize = SNAPSHOT_SCHEMA[st.schema[i]].size;
+      st.column[i] = csize ? r.take((size_t)csize * st.rows) : nullptr;
+    }
+    if (r.bad)
+      return false;
+    for (uint32_t e = 0; e < st.rows; e++) {
+      uint64_t id;
+      std::memcpy(&id, st.entities + e * sizeof(uint64_t), sizeof(id));
+      if ((uint32_t)id == 0)
+        return false;
+      indices.push_back((uint32_t)id);
+    }
+    tables.push_back(st);
+  }
+
+  // A repeated entity would be created twice
+  std::sort(indices.begin(), indices.end());
+  if (std::adjacent_find(indices.begin(), indices.end()) != indices.end())
+    return false;
+
+  const uint32_t block_count = r.u32();
+  blocks.clear();
+  for (uint32_t b = 0; b < block_count && !r.bad; b++) {
+    SnapshotBlockView v;
+    v.name_len = r.u8();
+    v.name = r.take(v.name_len);
+    v.size = r.u32();
+    v.data = r.take(v.size);
+    if (r.bad)
+      return false;
+    v.known = -1;
+    for (int k = 0; k < SNAPSHOT_BLOCK_COUNT; k++)
+      if (r.name_is(SNAPSHOT_BLOCKS[k].name, v.name_len, v.name))
+        v.known = k;
+    bool fits;
+    if (v.known >= 0)
+      fits = v.size == SNAPSHOT_BLOCKS[v.known].size;
+    else if (r.name_is(BLOCK_GROUP_RATES, v.name_len, v.name))
+      fits = v.size == (SIM_GROUP_COUNT - 1) * GROUP_RATE_BYTES;
+    else if (r.name_is(BLOCK_FORMATION, v.name_len, v.name))
+      fits = v.size == FORMATION_REQUEST_BYTES;
+    else if (r.name_is(BLOCK_JOB_BOARD, v.name_len, v.name))
+      fits = job_board_fits(v.data, v.size);
+    else
+      fits = false; // A block this build does not know
+    if (!fits)
+      return false;
+    blocks.push_back(v);
+  }
+  return !r.bad && r.p == r.end;
+}
+
+// Deletes every entity with a Position, a whole table at a time, with
+// the gameplay OnRemove observers muted: the snapshot replaces the state
+// they would update (panic fear, death log, wagon explosions, workplace
+// head counts)
+static void clear_sim_entities(flecs::world &ecs) {
+  std::vector<flecs::entity> muted;
+  ecs.query_builder().with(flecs::Observer).build().each([&](flecs::entity o) {
+    if (!o.parent().is_valid() && o.enabled()) // Engine observers are
+      muted.push_back(o);                      // top level, Flecs' in modules
+  });
+  for (flecs::entity o : muted)
+    o.disable();
+
+  ecs.delete_with<Position>();
+
+  for (flecs::entity o : muted)
+    o.enable();
+}
+
+static inline void remap_ref(uint64_t &ref,
+                             const std::unordered_map<uint64_t, uint64_t> &m) {
+  if (ref == 0)
+    return;
+  auto it = m.find(ref);
+  if (it != m.end())
+    ref = it->second;
+}
+
+bool restore_world_snapshot(flecs::world &ecs, const uint8_t *data,
+                            size_t size, uint32_t *remapped) {
+  std::vector<SnapshotTable> tables;
+  std::vector<SnapshotBlockView> blocks;
+  std::vector<uint32_t> indices;
+  if (!parse_snapshot(data, size, tables, blocks, indices))
+    return false;
+
+  clear_sim_entities(ecs);
+
+  // Saved ids are kept unless the index is alive here (a world that
+  // registered more systems before its first spawn); those get fresh
+  // indices above everything either side has issued
+  flecs::id_t schema_id[SNAPSHOT_COMPONENT_COUNT];
+  for (int c = 0; c < SNAPSHOT_COMPONENT_COUNT; c++)
+    schema_id[c] = SNAPSHOT_SCHEMA[c].id(ecs);
+  uint64_t next_index = ecs_get_max_id(ecs);
+  if (!indices.empty() && indices.back() > next_index)
+    next_index = indices.back();
+  std::unordered_map<uint64_t, uint64_t> remap;
+
+  std::vector<ecs_entity_t> entities;
+  for (const SnapshotTable &st : tables) {
+    entities.resize(st.rows);
+    std::memcpy(entities.data(), st.entities, sizeof(uint64_t) * st.rows);
+    for (uint32_t e = 0; e < st.rows; e++) {
+      if (ecs_get_alive(ecs, (uint32_t)entities[e]) == 0)
+        continue;
+      const uint64_t fresh = ++next_index;
+      remap[entities[e]] = fresh;
+      entities[e] = fresh;
+    }
+
+    ecs_bulk_desc_t desc = {};
+    void *columns[FLECS_ID_DESC_MAX];
+    for (int i = 0; i < st.id_count; i++) {
+      desc.ids[i] = schema_id[st.schema[i]];
+      columns[i] = const_cast<uint8_t *>(st.column[i]);
+    }
+    if (st.rows == 0) {
+      std::sort(desc.ids, desc.ids + st.id_count); // Table type order
+      ecs_table_find(ecs, desc.ids, st.id_count);
+      continue;
+    }
+    desc.entities = entities.data();
+    desc.count = (int32_t)st.rows;
+    desc.data = columns;
+    ecs_bulk_init(ecs, &desc);
+  }
+
+  // References to renumbered entities
+  if (!remap.empty()) {
+    ecs.each([&](Citizen &c) {
+      remap_ref(c.home_id, remap);
+      remap_ref(c.workplace_id, remap);
+      remap_ref(c.current_target, remap);
+    });
+    ecs.each([&](CargoManifest &cargo) {
+      remap_ref(cargo.source_building, remap);
+      remap_ref(cargo.dest_building, remap);
+    });
+  }
+
+  for (const SnapshotBlockView &v : blocks) {
+    if (v.known >= 0) {
+      if (void *dst = SNAPSHOT_BLOCKS[v.known].get(ecs))
+        std::memcpy(dst, v.data, v.size);
+    } else if (v.name_len == std::strlen(BLOCK_GROUP_RATES) &&
+               std::memcmp(v.name, BLOCK_GROUP_RATES, v.name_len) == 0) {
+      apply_group_rates(ecs, v.data);
+    } else if (v.name_len == std::strlen(BLOCK_FORMATION) &&
+               std::memcmp(v.name, BLOCK_FORMATION, v.name_len) == 0) {
+      apply_formation_requests(ecs, v.data);
+    } else {
+      apply_job_board(v.data);
+      if (!remap.empty())
+        for (LogisticsJob &job : economy_job_board()) {
+          remap_ref(job.source_building, remap);
+          remap_ref(job.dest_building, remap);
+        }
+    }
+  }
+
+  if (remapped)
+    *remapped = (uint32_t)remap.size();
+  return true;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// FILES
+// ═══════════════════════════════════════════════════════════════
+bool write_snapshot_file(const char *path, const std::vector<uint8_t> &bytes) {
+  FILE *f = std::fopen(path, "wb");
+  if (!f)
+    return false;
+  const bool ok =
+      std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+  return std::fclose(f) == 0 && ok;
+}
+
+bool read_snapshot_file(const char *path, std::vector<uint8_t> &out) {
+  FILE *f = std::fopen(path, "rb");
+  if (!f)
+    return false;
+  std::fseek(f, 0, SEEK_END);
+  const long size = std::ftell(f);
+  std::fseek(f, 0, SEEK_SET);
+  out.resize(size > 0 ? (size_t)size : 0);
+  const bool ok =
+      size > 0 && std::fread(out.data(), 1, out.size(), f) == out.size();
+  std::fclose(f);
+  return ok;
+}
+
+bool SnapshotWriter::start(std::vector<uint8_t> &&snapshot,
+                           const char *file_path) {
+  if (busy())
+    return false;
+  finish(); // Join the previous worker
+  bytes = std::move(snapshot);
+  path = file_path;
+  state.store(WRITING, std::memory_order_release);
+  thread = std::thread([this] {
+    const bool ok = write_snapshot_file(path.c_str(), bytes);
+    state.store(ok ? DONE : FAILED, std::memory_order_release);
+  });
+  return true;
+}
+
+int SnapshotWriter::finish() {
+  if (thread.joinable())
+    thread.join();
+  const int result = state.load(std::memory_order_acquire);
+  state.store(IDLE, std::memory_order_release);
+  bytes.clear();
+  bytes.shrink_to_fit();
+  return result;
+}
+
+} // namespace musket
@@ -0,0 +1,74 @@
+#ifndef MUSKET_SIM_SNAPSHOT_H
+#define MUSKET_SIM_SNAPSHOT_H
+
+#include "../../flecs/flecs.h"
+#include "musket_components.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ═══════════════════════════════════════════════════════════════
+// WORLD SNAPSHOTS (save games, checkpoints)
+//
+// A snapshot is the sim state dumped the way Flecs stores it: one
+// block per archetype table holding its entity ids and every component
+// column as raw bytes, then one named block per sim singleton and
+// global (SimClock, SimRng, group rate phases, g_macro_battalions,
+// g_pending_orders, the battalion pool, queued re-forms, PanicGrid,
+// FleeField, CivicGrid, GlobalZeitgeist, ProjectilePool, the job
+// board). Components are listed by name and size up front, so a file
+// from a build whose layouts differ is refused instead of misread.
+//
+// Restore rebuilds each table with one ecs_bulk_init. Entity ids are
+// kept where the index is free (the RNG is keyed on them); an id that
+// is taken gets a fresh one and every stored reference to it (Citizen,
+// CargoManifest, job board) is rewritten.
+//
+// VoxelGrid has its own file format (voxel_file.cpp) and is saved
+// beside the snapshot, not inside it. Derived state (SpatialHashGrid,
+// FormationRoster scratch, shadow buffers) is rebuilt by its owners.
+// ═══════════════════════════════════════════════════════════════
+
+namespace musket {
+
+constexpr uint16_t SNAPSHOT_VERSION = 1;
+
+// Dumps every entity with a Position and the sim singletons into `out`
+// (cleared first). False if an entity carries a component or pair the
+// snapshot schema does not list: that state would be lost on load.
+bool capture_world_snapshot(flecs::world &ecs, std::vector<uint8_t> &out);
+
+// Replaces every entity with a Position and the sim singletons with
+// the snapshot's. The whole snapshot is validated first: on false the
+// world is untouched. `remapped` (optional) receives how many entity
+// ids had to change.
+bool restore_world_snapshot(flecs::world &ecs, const uint8_t *data,
+                            size_t size, uint32_t *remapped = nullptr);
+
+bool write_snapshot_file(const char *path, const std::vector<uint8_t> &bytes);
+bool read_snapshot_file(const char *path, std::vector<uint8_t> &out);
+
+// ── Background save ─────────────────────────────────────────
+// The capture is the copy: once it is taken the sim runs on and the
+// file is written from the captured bytes on a worker thread.
+struct SnapshotWriter {
+  enum State : int { IDLE = 0, WRITING = 1, DONE = 2, FAILED = 3 };
+
+  std::thread thread;
+  std::vector<uint8_t> bytes;
+  std::string path;
+  std::atomic<int> state{IDLE};
+
+  // Takes ownership of the bytes. False while a write is in flight.
+  bool start(std::vector<uint8_t> &&snapshot, const char *file_path);
+  bool busy() const { return state.load(std::memory_order_acquire) == WRITING; }
+  // Joins the worker; returns DONE, FAILED, or IDLE if none ran
+  int finish();
+  ~SnapshotWriter() { finish(); }
+};
+
+} // namespace musket
+
+#endif // MUSKET_SIM_SNAPSHOT_H
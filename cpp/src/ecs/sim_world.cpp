@@ -0,0 +1,451 @@
+#include "sim_world.h"
+#include "macro_sync.h"
+#include "musket_systems.h"
+#include "platform.h"
+#include "prefab_loader.h"
+#include "sim_commands.h"
+#include "sim_profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace musket {
+
+// ═══════════════════════════════════════════════════════════════
+// WORLD SETUP
+// ═══════════════════════════════════════════════════════════════
+
+void register_sim_components(flecs::world &ecs) {
+  // Core components
+  ecs.component<Position>("Position");
+  ecs.component<Velocity>("Velocity");
+  ecs.component<Height>("Height");
+  ecs.component<IsAlive>("IsAlive");
+  ecs.component<Routing>("Routing");
+  ecs.component<TeamId>("TeamId");
+  ecs.component<BattalionId>("BattalionId");
+  ecs.component<SoldierFormationTarget>("SoldierFormationTarget");
+  ecs.component<MovementStats>("MovementStats");
+  ecs.component<MusketState>("MusketState");
+  ecs.component<FireOrder>("FireOrder");
+  ecs.component<CavalryState>("CavalryState");
+  ecs.component<Workplace>("Workplace");
+
+  // M5: Artillery components
+  ecs.component<ArtilleryBattery>("ArtilleryBattery");
+
+  // M6: Rendering + Cavalry components
+  ecs.component<RenderSlot>("RenderSlot");
+  ecs.component<FormationDefense>("FormationDefense");
+  ecs.component<ChargeOrder>("ChargeOrder");
+  ecs.component<Disordered>("Disordered");
+
+  // M7: Command Network components
+  ecs.component<FormationAnchor>("FormationAnchor");
+  ecs.component<Drummer>("Drummer");
+  ecs.component<ElevatedLOS>("ElevatedLOS");
+}
+
+SimCommandQueue *init_sim_world(flecs::world &ecs) {
+  register_sim_components(ecs);
+
+  // Fixed-step simulation clock. Must come before any system that runs
+  // on a group tick source (panic CA, economy aggregation).
+  register_sim_clock(ecs);
+
+  // Order queue, drained by advance_simulation at the top of each tick
+  SimCommandQueue *commands = register_sim_commands(ecs);
+
+  // Initialize M7.5 formation roster singleton (heap-built: ~5MB)
+  // Must come before register_movement_systems (FormationSolveSystem).
+  {
+    auto *roster = new FormationRoster();
+    std::memset(roster, 0, sizeof(FormationRoster));
+    std::memset(roster->pending_shape, -1, sizeof(roster->pending_shape));
+    ecs.set<FormationRoster>(*roster);
+    delete roster;
+  }
+
+  // Register M2 movement systems
+  register_movement_systems(ecs);
+
+  // Initialize M8 spatial hash grid singleton (heap-allocated: 4.2MB)
+  // Must come before register_combat_systems which registers the rebuild
+  // system.
+  {
+    auto *shg = new SpatialHashGrid();
+    std::memset(shg, 0, sizeof(SpatialHashGrid));
+    std::memset(shg->cell_head, -1, sizeof(shg->cell_head));
+    std::memset(shg->bat_head, -1, sizeof(shg->bat_head));
+    ecs.set<SpatialHashGrid>(*shg);
+    delete shg;
+  }
+
+  // Register M3+M8 combat systems
+  register_combat_systems(ecs);
+
+  // Initialize M4 panic grid singleton (zero-initialized)
+  ecs.set<PanicGrid>({});
+
+  // Simulation RNG seed (set_world_seed overrides)
+  ecs.set<SimRng>({1805});
+
+  // Initialize M4 flee field singleton (-1 = no enemy until first build)
+  {
+    FleeField ff;
+    std::memset(ff.nearest, -1, sizeof(ff.nearest));
+    ecs.set<FleeField>(ff);
+  }
+
+  // Register M4 panic systems (must come after PanicGrid singleton)
+  register_panic_systems(ecs);
+
+  // Initialize M5 projectile pool singleton (heap-built: ~124KB)
+  {
+    auto *pool = new ProjectilePool();
+    std::memset(pool, 0, sizeof(ProjectilePool));
+    ecs.set<ProjectilePool>(*pool);
+    delete pool;
+  }
+
+  // Register M5 artillery systems (must come after ProjectilePool)
+  register_artillery_systems(ecs);
+
+  // Register M6 cavalry systems
+  register_cavalry_systems(ecs);
+
+  // Initialize M9 economy singletons
+  ecs.set<CivicGrid>({});
+  ecs.set<GlobalZeitgeist>({});
+
+  // Register M9 economy systems
+  register_economy_systems(ecs);
+
+  // 10Hz macro-state snapshots (GDD §4.3). After every grid singleton.
+  register_macro_sync(ecs);
+
+  // Initialize M13-M14 voxel singletons
+  // chunk_map (1MB), chunk headers (4MB) and the hot cache (4MB) are
+  // heap-allocated. VoxelGrid struct itself is ~40 bytes — safe for Flecs copy.
+  VoxelGrid vg = {};
+  vg.allocate();
+  ecs.set<VoxelGrid>(vg);
+  ecs.set<DestructionQueue>({});
+
+  // M13.10 terrain heightmap (16MB heap array; pointer-only singleton)
+  TerrainHeightmap hm = {};
+  hm.allocate();
+  ecs.set<TerrainHeightmap>(hm);
+
+  // Register M13-M14 voxel systems
+  register_voxel_systems(ecs);
+
+  // Load JSON prefabs
+  load_all_prefabs(ecs);
+
+  // Per-system timing wrappers (off until set_profiling). After the
+  // last register_*: it wraps the systems that exist now.
+  register_sim_profiler(ecs);
+
+  return commands;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// CENTROID PASS (pre-tick)
+// ═══════════════════════════════════════════════════════════════
+
+void run_centroid_pass(flecs::world &ecs,
+                       void (*on_release)(uint32_t battalion_id)) {
+  // Runs once per fixed tick. Not the world's last delta: that is 0 on
+  // a fresh or just-restored world.
+  const float dt = (float)SIM_TICK_DT;
+
+  // Every per-battalion pass walks the pool's live ids (ascending)
+  const BattalionPool &pool = g_battalion_pool;
+
+  // 1. Zero TRANSIENT data only (Trap 23: preserve flag_cohesion)
+  for (int k = 0; k < pool.live_count; k++) {
+    const int i = pool.live[k];
+    g_macro_battalions[i].cx = 0.0f;
+    g_macro_battalions[i].cz = 0.0f;
+    g_macro_battalions[i].alive_count = 0;
+    g_macro_battalions[i].team_id = 999;
+    g_macro_battalions[i].flag_alive = false;
+    g_macro_battalions[i].drummer_alive = false;
+    g_macro_battalions[i].officer_alive = false;
+  }
+
+  // 2. Accumulate + detect M7 command network tags
+  ecs.each([](flecs::entity e, const Position &p, const BattalionId &b,
+              const TeamId &t) {
+    if (!e.has<IsAlive>())
+      return;
+    uint32_t id = b.id % MAX_BATTALIONS;
+    g_macro_battalions[id].cx += p.x;
+    g_macro_battalions[id].cz += p.z;
+    g_macro_battalions[id].alive_count++;
+    g_macro_battalions[id].team_id = t.team;
+
+    // M7: Tag detection
+    if (e.has<FormationAnchor>())
+      g_macro_battalions[id].flag_alive = true;
+    if (e.has<Drummer>())
+      g_macro_battalions[id].drummer_alive = true;
+    if (e.has<ElevatedLOS>())
+      g_macro_battalions[id].officer_alive = true;
+  });
+
+  // 3. Finalize centroids + M7 pipelines + M7.5 targeting + fire discipline
+  for (int k = 0; k < pool.live_count; k++) {
+    const int i = pool.live[k];
+    auto &mb = g_macro_battalions[i];
+
+    // Trap 24: Shatter command if almost wiped out
+    if (mb.alive_count > 0 && mb.alive_count < 10) {
+      mb.flag_alive = mb.drummer_alive = mb.officer_alive = false;
+    }
+
+    if (mb.alive_count > 0) {
+      mb.cx /= (float)mb.alive_count;
+      mb.cz /= (float)mb.alive_count;
+
+      // Phase A: Flag cohesion decay (16s to 0.2 floor)
+      if (mb.flag_alive) {
+        mb.flag_cohesion = std::min(1.0f, mb.flag_cohesion + dt * 0.1f);
+      } else {
+        mb.flag_cohesion = std::max(0.2f, mb.flag_cohesion - dt * 0.05f);
+      }
+
+      // M7.5 §12.7: Dead officer = loss of fire discipline!
+      if (!mb.officer_alive && mb.fire_discipline != DISCIPLINE_AT_WILL) {
+        mb.fire_discipline = DISCIPLINE_AT_WILL;
+      }
+
+      // M7.5 §12.7: Officer's Metronome — tick the fire discipline timer
+      if (mb.fire_discipline == DISCIPLINE_BY_RANK) {
+        mb.volley_timer -= dt;
+        if (mb.volley_timer <= 0.0f) {
+          mb.active_firing_rank = (mb.active_firing_rank + 1) % 3;
+          mb.volley_timer = 3.0f; // 3s between rank volleys
+        }
+      } else if (mb.fire_discipline == DISCIPLINE_MASS_VOLLEY) {
+        mb.volley_timer -= dt;
+        if (mb.volley_timer <= 0.0f) {
+          mb.fire_discipline = DISCIPLINE_HOLD; // Window closed
+        }
+      }
+
+      // ── M7.5 §12.8 Trap 26: Hoisted Macro Targeting ──
+      // O(B²) total: find nearest unblocked enemy battalion for each battalion
+      mb.target_bat_id = -1;
+      float best_dist = 1e18f;
+
+      for (int kj = 0; kj < pool.live_count; kj++) {
+        const int j = pool.live[kj];
+        auto &enemy = g_macro_battalions[j];
+        if (enemy.alive_count == 0 || enemy.team_id == mb.team_id)
+          continue;
+
+        float edx = enemy.cx - mb.cx;
+        float edz = enemy.cz - mb.cz;
+        float ed2 = edx * edx + edz * edz;
+        if (ed2 >= best_dist)
+          continue;
+
+        // Check if a FRIENDLY battalion's OBB blocks this shot path
+        bool blocked = false;
+        for (int kf = 0; kf < pool.live_count; kf++) {
+          const int fb = pool.live[kf];
+          if (fb == i || fb == j)
+            continue;
+          auto &f = g_macro_battalions[fb];
+          if (f.alive_count == 0 || f.team_id != mb.team_id)
+            continue;
+
+          // OBB diagonals
+          float rx = -f.dir_z * f.ext_w, rz = f.dir_x * f.ext_w;
+          float fx = f.dir_x * f.ext_d, fz = f.dir_z * f.ext_d;
+          // Diagonal 1: (cx-rx-fx) to (cx+rx+fx)
+          float d1ax = f.cx - rx - fx, d1az = f.cz - rz - fz;
+          float d1bx = f.cx + rx + fx, d1bz = f.cz + rz + fz;
+          // Diagonal 2: (cx+rx-fx) to (cx-rx+fx)
+          float d2ax = f.cx + rx - fx, d2az = f.cz + rz - fz;
+          float d2bx = f.cx - rx + fx, d2bz = f.cz - rz + fz;
+
+          // CCW segment intersection test (zero sqrt)
+          auto ccw = [](float ax, float az, float bx, float bz, float cx,
+                        float cz) {
+            return (cz - az) * (bx - ax) > (bz - az) * (cx - ax);
+          };
+          auto seg_hit = [&](float ax, float az, float bx, float bz, float cx,
+                             float cz, float dx, float dz) {
+            return ccw(ax, az, cx, cz, dx, dz) != ccw(bx, bz, cx, cz, dx, dz) &&
+                   ccw(ax, az, bx, bz, cx, cz) != ccw(ax, az, bx, bz, dx, dz);
+          };
+
+          if (seg_hit(mb.cx, mb.cz, enemy.cx, enemy.cz, d1ax, d1az, d1bx,
+                      d1bz) ||
+              seg_hit(mb.cx, mb.cz, enemy.cx, enemy.cz, d2ax, d2az, d2bx,
+                      d2bz)) {
+            blocked = true;
+            break;
+          }
+        }
+
+        if (!blocked && ed2 < best_dist) {
+          best_dist = ed2;
+          mb.target_bat_id = j;
+        }
+      }
+    }
+
+    // Phase D: Order Delay Pipeline
+    auto &order = g_pending_orders[i];
+    if (order.type != ORDER_NONE) {
+      order.delay -= dt;
+      if (order.delay <= 0.0f) {
+        OrderType otype = order.type;
+        float tx = order.target_x;
+        float tz = order.target_z;
+
+        if (otype == ORDER_DISCIPLINE) {
+          // M7.5 §12.7: Fire discipline change
+          mb.fire_discipline = (FireDiscipline)order.requested_discipline;
+          if (mb.fire_discipline == DISCIPLINE_BY_RANK) {
+            mb.active_firing_rank = 0;
+            mb.volley_timer = 3.0f;
+          } else if (mb.fire_discipline == DISCIPLINE_MASS_VOLLEY) {
+            mb.volley_timer = 0.5f; // 0.5s execution window
+          }
+        } else if (otype == ORDER_MARCH) {
+          // O(1): retarget the anchor; BattalionMarchSystem moves it and
+          // the soldiers' slots follow at integration time.
+          mb.march_x = mb.anchor_x + tx;
+          mb.march_z = mb.anchor_z + tz;
+          mb.marching = true;
+        } else {
+          // Dispatch to ECS entities in this battalion
+          ecs.each([&](flecs::entity e, const BattalionId &b) {
+            if ((int)b.id != i || !e.has<IsAlive>())
+              return;
+            if (e.has<CavalryState>()) {
+              const auto &cs = e.get<CavalryState>();
+              if (cs.state_flags != 0)
+                return;
+            }
+
+            if (otype == ORDER_FIRE) {
+              e.set<FireOrder>({tx, tz});
+            }
+          });
+        }
+        order.type = ORDER_NONE;
+      }
+    }
+  }
+
+  // 4. Reclaim emptied battalions: id, macro state and whatever the
+  // host keeps per battalion. Walk backwards — release() closes the gap
+  // behind k.
+  for (int k = pool.live_count - 1; k >= 0; k--) {
+    const int i = pool.live[k];
+    if (g_macro_battalions[i].alive_count == 0) {
+      release_battalion(i);
+      if (on_release)
+        on_release((uint32_t)i);
+    }
+  }
+
+  // Diagnostic (every 2s at 60Hz)
+  static int tick = 0;
+  if (tick++ % 120 == 0) {
+    log_info("[CENTROIDS] Bat0: alive=%d flag=%s drum=%s cohesion=%g | "
+             "Bat1: alive=%d",
+             g_macro_battalions[0].alive_count,
+             g_macro_battalions[0].flag_alive ? "true" : "false",
+             g_macro_battalions[0].drummer_alive ? "true" : "false",
+             (double)g_macro_battalions[0].flag_cohesion,
+             g_macro_battalions[1].alive_count);
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════
+// SPAWNING
+// ═══════════════════════════════════════════════════════════════
+
+void spawn_line_battalion(flecs::world &ecs, uint32_t bat_id, int count,
+                          float center_x, float center_z, int team_id,
+                          uint32_t first_slot, std::vector<Position> &pos) {
+  // M7.5: True Napoleonic Line — 3 ranks deep (§12.1)
+  constexpr int RANKS = 3;
+  constexpr float SP_X = 0.8f; // 0.8m shoulder-to-shoulder
+  constexpr float SP_Z = 1.2f; // 1.2m depth between ranks
+  int cols = (int)std::ceil((float)count / RANKS);
+
+  // M7.5: Set initial OBB geometry for this battalion
+  auto &mb = g_macro_battalions[bat_id];
+  mb.dir_x = 0.0f;
+  mb.dir_z = -1.0f;                        // Facing -Z (Godot forward)
+  mb.ext_w = (cols * SP_X) / 2.0f + 2.0f;  // Half-width + 2m buffer
+  mb.ext_d = (RANKS * SP_Z) / 2.0f + 2.0f; // Half-depth + 2m buffer
+  mb.anchor_x = center_x;                  // Slot offsets are relative to this
+  mb.anchor_z = center_z;
+  mb.marching = false;
+
+  // Center offsets for perfectly centering the formation
+  float start_x = center_x - ((cols - 1) * SP_X) / 2.0f;
+  float start_z = center_z - ((RANKS - 1) * SP_Z) / 2.0f;
+
+  int center_col = cols / 2;
+  const uint64_t jitter_key =
+      sim_rng_key(ecs.get<SimRng>().seed, RNG_STREAM_SPAWN);
+
+  pos.resize(count);
+  std::vector<SoldierFormationTarget> target(count);
+  for (int i = 0; i < count; i++) {
+    int row = i % RANKS; // 0=Front, 1=Middle, 2=Rear
+    int col = i / RANKS; // 0..166
+
+    float x = start_x + col * SP_X;
+    float z = start_z + row * SP_Z;
+
+    // Micro-jitter to avoid robotic grid (seeded: same world, same lines)
+    uint64_t who = ((uint64_t)bat_id << 32) | (uint32_t)i;
+    float jx = (sim_rand_unit(jitter_key, sim_rng_counter(0, who, 0)) - 0.5f) *
+               0.15f;
+    float jz = (sim_rand_unit(jitter_key, sim_rng_counter(0, who, 1)) - 0.5f) *
+               0.15f;
+
+    pos[i] = {x + jx, z + jz};
+    target[i] = {x - center_x, z - center_z, 50.0f, 2.0f,
+                 face_snorm(0.0f), face_snorm(-1.0f), // Face forward (-Z)
+                 true, (uint8_t)row, {}};
+  }
+
+  // The whole battalion in one ECS insert
+  InfantryBlock block = {};
+  block.count = count;
+  block.bat_id = bat_id;
+  block.team = (uint8_t)team_id;
+  block.first_slot = first_slot;
+  block.pos = pos.data();
+  block.target = target.data();
+  block.stats = {4.0f, 8.0f};
+  block.musket = {0.0f, 30, 13}; // Trap 28: no stagger, all start loaded
+  block.defense = {0.2f};        // Line formation by default
+  const flecs::entity_t *ids = spawn_infantry_block(ecs, block);
+
+  // M7.5: Embed command staff in center file (§12.2)
+  if (ids) {
+    int staff = center_col * RANKS;
+    if (staff + 0 < count)
+      ecs.entity(ids[staff + 0]).add<ElevatedLOS>(); // Officer: Front rank
+    if (staff + 1 < count)
+      ecs.entity(ids[staff + 1])
+          .add<FormationAnchor>(); // Flag: Middle rank (protected)
+    if (staff + 2 < count)
+      ecs.entity(ids[staff + 2]).add<Drummer>(); // Drummer: Rear rank
+  }
+}
+
+} // namespace musket
@@ -0,0 +1,49 @@
+#ifndef MUSKET_SIM_WORLD_H
+#define MUSKET_SIM_WORLD_H
+
+#include "../../flecs/flecs.h"
+#include "musket_components.h"
+#include <cstdint>
+#include <vector>
+
+// ═══════════════════════════════════════════════════════════════
+// SIM WORLD (the authoritative world, host-agnostic)
+//
+// Everything MusketServer::init_ecs builds that the simulation needs:
+// components, clock, order queue, every system and singleton, prefabs
+// and the profiler. The GDExtension adds the rendering bridge on top;
+// the headless server (src/server/) runs it as is.
+//
+// The render observer and queries are created after this, so entity
+// ids in a headless world differ from the GDExtension's from the first
+// spawn on: replays recorded in one do not check out in the other.
+// ═══════════════════════════════════════════════════════════════
+
+namespace musket {
+
+struct SimCommandQueue;
+
+// Named components, shared by the server and client worlds
+void register_sim_components(flecs::world &ecs);
+
+// The server world, built in dependency order. Returns the order queue
+// (register_sim_commands).
+SimCommandQueue *init_sim_world(flecs::world &ecs);
+
+// Pre-tick pass: battalion centroids, command network, fire discipline,
+// macro targeting, delayed orders, then emptied battalions back to the
+// pool. on_release (may be null) drops what the host keeps per id.
+void run_centroid_pass(flecs::world &ecs,
+                       void (*on_release)(uint32_t battalion_id));
+
+// A 3-rank line of `count` soldiers around (center_x, center_z) facing
+// -Z, command staff in the centre file, into battalion bat_id (already
+// taken from the pool). RenderSlots run from first_slot. The spawn
+// positions are left in `pos` for the host's instance buffers.
+void spawn_line_battalion(flecs::world &ecs, uint32_t bat_id, int count,
+                          float center_x, float center_z, int team_id,
+                          uint32_t first_slot, std::vector<Position> &pos);
+
+} // namespace musket
+
+#endif // MUSKET_SIM_WORLD_H
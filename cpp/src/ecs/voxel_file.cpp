@@ -0,0 +1,497 @@
+#include "musket_components.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ═══════════════════════════════════════════════════════════════
+// M13.8: VOXEL SAVE FILE (.mvox)
+//
+//   [VoxelFileHeader 64B]
+//   [VoxelFileRun × earth_run_count]     chunk_map runs == 1 (full only)
+//   [VoxelFileChunk × chunk_count]       sparse index, ascending map_idx
+//   [payloads]                           4B-aligned, packed as in memory
+//
+// Payloads are the in-memory palette/RLE/RAW bytes verbatim, so load
+// does no decoding: the file is memory-mapped and each chunk header
+// points straight into the mapping. The OS pages payloads in the first
+// time a region is read; stream_in() detaches a region to the heap up
+// front when it activates. Little-endian only (x64 targets).
+//
+// Delta files hold only chunks with edit_gen > base generation and no
+// earth runs (sentinels never change — edits promote them to chunks).
+// ═══════════════════════════════════════════════════════════════
+
+static constexpr char VOXEL_FILE_MAGIC[4] = {'M', 'V', 'O', 'X'};
+static constexpr uint16_t VOXEL_FILE_VERSION = 1;
+static constexpr uint16_t VOXEL_FILE_DELTA = 1 << 0;
+
+struct VoxelFileHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t flags; // VOXEL_FILE_DELTA
+  uint16_t chunk_size;
+  uint16_t map_x, map_y, map_z;
+  uint32_t generation;      // edit_generation at save time
+  uint32_t base_generation; // Delta: generation it applies on top of
+  uint32_t earth_run_count;
+  uint32_t earth_run_offset;
+  uint32_t chunk_count;
+  uint32_t index_offset;
+  uint32_t file_bytes; // Truncation check
+  uint8_t pad[20];
+}; // 64 bytes
+
+struct VoxelFileRun {
+  uint32_t start; // First map_idx of the run
+  uint32_t count;
+}; // 8 bytes
+
+struct VoxelFileChunk {
+  uint32_t map_idx;
+  uint32_t offset; // Payload byte offset from file start (0 if none)
+  uint16_t payload_bytes;
+  uint16_t solid_count;
+  uint8_t storage, bits, palette_count, pad;
+  uint8_t palette[VOXEL_PALETTE_MAX];
+}; // 32 bytes
+
+static_assert(sizeof(VoxelFileHeader) == 64, "VoxelFileHeader must be 64B");
+static_assert(sizeof(VoxelFileChunk) == 32, "VoxelFileChunk must be 32B");
+
+// ── Platform: read-only file mapping ───────────────────────────
+
+struct VoxelFileMap {
+  const uint8_t *data;
+  size_t size;
+#ifdef _WIN32
+  HANDLE file;
+  HANDLE mapping;
+#else
+  int fd;
+#endif
+};
+
+static VoxelFileMap *map_file(const char *path) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return nullptr;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return nullptr;
+  }
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    return nullptr;
+  }
+  void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return nullptr;
+  }
+  VoxelFileMap *m = new VoxelFileMap;
+  m->data = static_cast<const uint8_t *>(view);
+  m->size = (size_t)size.QuadPart;
+  m->file = file;
+  m->mapping = mapping;
+  return m;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+  void *view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (view == MAP_FAILED) {
+    close(fd);
+    return nullptr;
+  }
+  VoxelFileMap *m = new VoxelFileMap;
+  m->data = static_cast<const uint8_t *>(view);
+  m->size = (size_t)st.st_size;
+  m->fd = fd;
+  return m;
+#endif
+}
+
+static void unmap_file(VoxelFileMap *m) {
+#ifdef _WIN32
+  UnmapViewOfFile(m->data);
+  CloseHandle(m->mapping);
+  CloseHandle(m->file);
+#else
+  munmap(const_cast<uint8_t *>(m->data), m->size);
+  close(m->fd);
+#endif
+  delete m;
+}
+
+void VoxelGrid::close_file_map() {
+  if (!file_map)
+    return;
+  // Detach anything still pointing into the mapping
+  if (chunk_pool) {
+    for (uint32_t i = 2; i < active_chunk_count; i++) {
+      VoxelChunk &chunk = chunk_pool[i];
+      if (!chunk.payload_mapped)
+        continue;
+      uint8_t *owned = new uint8_t[chunk.payload_bytes];
+      std::memcpy(owned, chunk.payload, chunk.payload_bytes);
+      chunk.payload = owned;
+      chunk.payload_mapped = 0;
+    }
+  }
+  unmap_file(file_map);
+  file_map = nullptr;
+}
+
+// ── Save ───────────────────────────────────────────────────────
+
+static bool write_voxel_file(VoxelGrid &grid, const char *path,
+                             bool delta) {
+  grid.repack_stale(); // Payloads must match the hot copies
+
+  VoxelFileHeader hdr;
+  std::memset(&hdr, 0, sizeof(hdr));
+  std::memcpy(hdr.magic, VOXEL_FILE_MAGIC, 4);
+  hdr.version = VOXEL_FILE_VERSION;
+  hdr.flags = delta ? VOXEL_FILE_DELTA : 0;
+  hdr.chunk_size = CHUNK_SIZE;
+  hdr.map_x = MAP_CHUNKS_X;
+  hdr.map_y = MAP_CHUNKS_Y;
+  hdr.map_z = MAP_CHUNKS_Z;
+  hdr.generation = grid.edit_generation;
+  hdr.base_generation = delta ? grid.saved_generation : 0;
+
+  // One pass over chunk_map: earth runs + sparse index (map order)
+  std::vector<VoxelFileRun> runs;
+  std::vector<VoxelFileChunk> index;
+  for (int m = 0; m < TOTAL_MAP_CHUNKS; m++) {
+    uint32_t pool_idx = grid.chunk_map[m];
+    if (pool_idx == 1) {
+      if (delta)
+        continue;
+      if (!runs.empty() && runs.back().start + runs.back().count == (uint32_t)m)
+        runs.back().count++;
+      else
+        runs.push_back({(uint32_t)m, 1});
+      continue;
+    }
+    if (pool_idx < 2)
+      continue;
+    const VoxelChunk &chunk = grid.chunk_pool[pool_idx];
+    if (delta && chunk.edit_gen <= grid.saved_generation)
+      continue;
+
+    VoxelFileChunk e;
+    std::memset(&e, 0, sizeof(e));
+    e.map_idx = (uint32_t)m;
+    e.payload_bytes = chunk.payload_bytes;
+    e.solid_count = chunk.solid_count;
+    e.storage = chunk.storage;
+    e.bits = chunk.bits;
+    e.palette_count = chunk.palette_count;
+    std::memcpy(e.palette, chunk.palette, VOXEL_PALETTE_MAX);
+    index.push_back(e);
+  }
+
+  hdr.earth_run_count = (uint32_t)runs.size();
+  hdr.earth_run_offset = sizeof(VoxelFileHeader);
+  hdr.chunk_count = (uint32_t)index.size();
+  hdr.index_offset =
+      hdr.earth_run_offset + hdr.earth_run_count * sizeof(VoxelFileRun);
+
+  uint32_t cursor = hdr.index_offset + hdr.chunk_count * sizeof(VoxelFileChunk);
+  for (auto &e : index) {
+    if (e.payload_bytes == 0)
+      continue;
+    e.offset = cursor;
+    cursor += (e.payload_bytes + 3u) & ~3u;
+  }
+  hdr.file_bytes = cursor;
+
+  FILE *f = std::fopen(path, "wb");
+  if (!f)
+    return false;
+  bool ok = std::fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+  if (ok && !runs.empty())
+    ok = std::fwrite(runs.data(), sizeof(VoxelFileRun), runs.size(), f) ==
+         runs.size();
+  if (ok && !index.empty())
+    ok = std::fwrite(index.data(), sizeof(VoxelFileChunk), index.size(), f) ==
+         index.size();
+  static const uint8_t zeros[4] = {};
+  for (size_t i = 0; ok && i < index.size(); i++) {
+    const VoxelFileChunk &e = index[i];
+    if (e.payload_bytes == 0)
+      continue;
+    const VoxelChunk &chunk = grid.chunk_pool[grid.chunk_map[e.map_idx]];
+    ok = std::fwrite(chunk.payload, 1, e.payload_bytes, f) == e.payload_bytes;
+    uint32_t padding = ((e.payload_bytes + 3u) & ~3u) - e.payload_bytes;
+    if (ok && padding)
+      ok = std::fwrite(zeros, 1, padding, f) == padding;
+  }
+  ok = (std::fclose(f) == 0) && ok;
+  if (!ok)
+    return false;
+
+  // Edits from here on are newer than this save
+  grid.saved_generation = grid.edit_generation;
+  grid.edit_generation++;
+  return true;
+}
+
+bool VoxelGrid::save_file(const char *path) {
+  return write_voxel_file(*this, path, false);
+}
+
+bool VoxelGrid::save_delta(const char *path) {
+  return write_voxel_file(*this, path, true);
+}
+
+// ── Load ───────────────────────────────────────────────────────
+
+static bool validate_header(const VoxelFileHeader &hdr, size_t size) {
+  if (std::memcmp(hdr.magic, VOXEL_FILE_MAGIC, 4) != 0 ||
+      hdr.version != VOXEL_FILE_VERSION || hdr.chunk_size != CHUNK_SIZE ||
+      hdr.map_x != MAP_CHUNKS_X || hdr.map_y != MAP_CHUNKS_Y ||
+      hdr.map_z != MAP_CHUNKS_Z || hdr.file_bytes != size)
+    return false;
+  if (hdr.chunk_count > (uint32_t)MAX_ACTIVE_CHUNKS - 2)
+    return false;
+  uint64_t index_end = (uint64_t)hdr.index_offset +
+                       (uint64_t)hdr.chunk_count * sizeof(VoxelFileChunk);
+  uint64_t runs_end = (uint64_t)hdr.earth_run_offset +
+                      (uint64_t)hdr.earth_run_count * sizeof(VoxelFileRun);
+  return index_end <= size && runs_end <= size;
+}
+
+// Every entry must decode to exactly CHUNK_VOLUME voxels without
+// reading past its payload: unpack_chunk trusts the header. map_idx
+// ascends strictly, as written, so no chunk appears twice.
+static bool validate_entry(const VoxelFileChunk &e, const uint8_t *data,
+                           size_t size, int64_t prev_map_idx) {
+  if (e.map_idx >= (uint32_t)TOTAL_MAP_CHUNKS ||
+      (int64_t)e.map_idx <= prev_map_idx)
+    return false;
+  if (e.payload_bytes > 0 &&
+      ((uint64_t)e.offset + e.payload_bytes > size || (e.offset & 3u)))
+    return false;
+  if (e.palette_count > VOXEL_PALETTE_MAX)
+    return false;
+
+  if (e.storage == VSTORE_PALETTE) {
+    if (e.bits != 0 && e.bits != 1 && e.bits != 2 && e.bits != 4)
+      return false;
+    return e.palette_count >= 1 &&
+           e.payload_bytes == (uint32_t)(CHUNK_VOLUME * e.bits) / 8;
+  }
+  if (e.storage == VSTORE_RAW)
+    return e.payload_bytes == CHUNK_VOLUME;
+  if (e.storage != VSTORE_RLE || e.payload_bytes == 0 ||
+      e.payload_bytes % sizeof(VoxelRun) != 0)
+    return false;
+
+  // Runs cover the chunk: ends strictly increase and the last is 4096
+  const uint32_t run_count = e.payload_bytes / sizeof(VoxelRun);
+  uint32_t end = 0;
+  for (uint32_t r = 0; r < run_count; r++) {
+    VoxelRun run;
+    std::memcpy(&run, data + e.offset + r * sizeof(VoxelRun), sizeof(run));
+    if (run.end <= end || run.end > CHUNK_VOLUME)
+      return false;
+    end = run.end;
+  }
+  return end == CHUNK_VOLUME;
+}
+
+static bool validate_index(const VoxelFileChunk *index, uint32_t count,
+                           const uint8_t *data, size_t size) {
+  int64_t prev = -1;
+  for (uint32_t i = 0; i < count; i++) {
+    if (!validate_entry(index[i], data, size, prev))
+      return false;
+    prev = index[i].map_idx;
+  }
+  return true;
+}
+
+bool VoxelGrid::load_file(const char *path) {
+  VoxelFileMap *m = map_file(path);
+  if (!m)
+    return false;
+  VoxelFileHeader hdr;
+  if (m->size < sizeof(hdr)) {
+    unmap_file(m);
+    return false;
+  }
+  std::memcpy(&hdr, m->data, sizeof(hdr));
+  if (!validate_header(hdr, m->size) || (hdr.flags & VOXEL_FILE_DELTA)) {
+    unmap_file(m);
+    return false;
+  }
+  const VoxelFileChunk *index =
+      reinterpret_cast<const VoxelFileChunk *>(m->data + hdr.index_offset);
+  if (!validate_index(index, hdr.chunk_count, m->data, m->size)) {
+    unmap_file(m);
+    return false;
+  }
+
+  // Fresh grid, then sentinels + headers straight from the index
+  release();
+  allocate();
+  reserve_chunks(hdr.chunk_count + 2);
+  file_map = m;
+
+  const VoxelFileRun *runs =
+      reinterpret_cast<const VoxelFileRun *>(m->data + hdr.earth_run_offset);
+  for (uint32_t r = 0; r < hdr.earth_run_count; r++) {
+    uint32_t end = runs[r].start + runs[r].count;
+    if (end > (uint32_t)TOTAL_MAP_CHUNKS)
+      end = TOTAL_MAP_CHUNKS;
+    for (uint32_t i = runs[r].start; i < end; i++)
+      chunk_map[i] = 1;
+  }
+
+  for (uint32_t i = 0; i < hdr.chunk_count; i++) {
+    const VoxelFileChunk &e = index[i];
+    uint32_t pool_idx = active_chunk_count++;
+    chunk_map[e.map_idx] = pool_idx;
+
+    VoxelChunk &chunk = chunk_pool[pool_idx];
+    std::memset(&chunk, 0, sizeof(VoxelChunk));
+    chunk.payload =
+        e.payload_bytes ? const_cast<uint8_t *>(m->data + e.offset) : nullptr;
+    chunk.payload_mapped = e.payload_bytes ? 1 : 0;
+    chunk.payload_bytes = e.payload_bytes;
+    chunk.solid_count = e.solid_count;
+    chunk.storage = e.storage;
+    chunk.bits = e.bits;
+    chunk.palette_count = e.palette_count;
+    std::memcpy(chunk.palette, e.palette, VOXEL_PALETTE_MAX);
+    chunk.hot_slot = VOXEL_NO_HOT_SLOT;
+    chunk.edit_gen = hdr.generation;
+    chunk.dirty_mesh = 1; // Fresh world: everything needs a mesh
+    chunk.dirty_flow = 1;
+    chunk.dirty_height = 1;
+  }
+
+  saved_generation = hdr.generation;
+  edit_generation = hdr.generation + 1;
+  return true;
+}
+
+bool VoxelGrid::apply_delta(const char *path) {
+  FILE *f = std::fopen(path, "rb");
+  if (!f)
+    return false;
+  std::fseek(f, 0, SEEK_END);
+  long size = std::ftell(f);
+  std::fseek(f, 0, SEEK_SET);
+  std::vector<uint8_t> data(size > 0 ? (size_t)size : 0);
+  bool ok = size >= (long)sizeof(VoxelFileHeader) &&
+            std::fread(data.data(), 1, data.size(), f) == data.size();
+  std::fclose(f);
+  if (!ok)
+    return false;
+
+  VoxelFileHeader hdr;
+  std::memcpy(&hdr, data.data(), sizeof(hdr));
+  if (!validate_header(hdr, data.size()) || !(hdr.flags & VOXEL_FILE_DELTA) ||
+      hdr.base_generation != saved_generation)
+    return false;
+  const VoxelFileChunk *index =
+      reinterpret_cast<const VoxelFileChunk *>(data.data() + hdr.index_offset);
+  if (!validate_index(index, hdr.chunk_count, data.data(), data.size()))
+    return false;
+
+  for (uint32_t i = 0; i < hdr.chunk_count; i++) {
+    const VoxelFileChunk &e = index[i];
+    uint32_t pool_idx = chunk_map[e.map_idx];
+    if (pool_idx < 2) {
+      pool_idx = alloc_chunk((int)e.map_idx);
+      if (pool_idx == 0)
+        return false; // Pool exhausted
+    }
+
+    VoxelChunk &chunk = chunk_pool[pool_idx];
+    // Drop the hot copy: the delta replaces the whole chunk
+    if (chunk.hot_slot != VOXEL_NO_HOT_SLOT) {
+      hot_pool[chunk.hot_slot].chunk_idx = 0;
+      chunk.hot_slot = VOXEL_NO_HOT_SLOT;
+    }
+    if (!chunk.payload_mapped)
+      delete[] chunk.payload;
+    chunk.payload = nullptr;
+    if (e.payload_bytes) {
+      chunk.payload = new uint8_t[e.payload_bytes];
+      std::memcpy(chunk.payload, data.data() + e.offset, e.payload_bytes);
+    }
+    chunk.payload_mapped = 0;
+    chunk.payload_stale = 0;
+    chunk.payload_bytes = e.payload_bytes;
+    chunk.solid_count = e.solid_count;
+    chunk.storage = e.storage;
+    chunk.bits = e.bits;
+    chunk.palette_count = e.palette_count;
+    std::memcpy(chunk.palette, e.palette, VOXEL_PALETTE_MAX);
+    chunk.edit_gen = hdr.generation;
+    chunk.dirty_mesh = 1;
+    chunk.dirty_flow = 1;
+    chunk.dirty_height = 1;
+    chunk.needs_stability_bfs = 1;
+  }
+
+  saved_generation = hdr.generation;
+  if (edit_generation <= hdr.generation)
+    edit_generation = hdr.generation + 1;
+  return true;
+}
+
+// ── Streaming ──────────────────────────────────────────────────
+
+void VoxelGrid::stream_in(int cx0, int cz0, int cx1, int cz1) {
+  if (!file_map)
+    return;
+  cx0 = cx0 < 0 ? 0 : cx0;
+  cz0 = cz0 < 0 ? 0 : cz0;
+  cx1 = cx1 >= MAP_CHUNKS_X ? MAP_CHUNKS_X - 1 : cx1;
+  cz1 = cz1 >= MAP_CHUNKS_Z ? MAP_CHUNKS_Z - 1 : cz1;
+  for (int cy = 0; cy < MAP_CHUNKS_Y; cy++)
+    for (int cz = cz0; cz <= cz1; cz++)
+      for (int cx = cx0; cx <= cx1; cx++) {
+        uint32_t pool_idx = chunk_map[chunk_index(cx, cy, cz)];
+        if (pool_idx < 2)
+          continue;
+        VoxelChunk &chunk = chunk_pool[pool_idx];
+        if (!chunk.payload_mapped)
+          continue;
+        uint8_t *owned = new uint8_t[chunk.payload_bytes];
+        std::memcpy(owned, chunk.payload, chunk.payload_bytes);
+        chunk.payload = owned;
+        chunk.payload_mapped = 0;
+      }
+}
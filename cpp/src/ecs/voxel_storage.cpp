@@ -0,0 +1,419 @@
+#include "musket_components.h"
+#include <cassert>
+#include <cstring>
+
+// ═══════════════════════════════════════════════════════════════
+// M13.5: VOXEL CHUNK STORAGE (Palette + RLE + Hot Cache)
+//
+// Cold chunks live as a 64B header plus a compressed payload:
+//   - PALETTE: up to 16 materials, 1/2/4-bit indices (512B-2KB)
+//   - RLE:     (end, material) runs — wins on layered terrain and
+//              on the rubble-and-air chunks left after a siege
+//   - RAW:     >16 materials (never hit with the current 6)
+// get_voxel() decodes cold chunks in place. set_voxel() faults the
+// chunk into a 4KB hot slot so repeated edits stay raw-speed; the
+// payload is patched in-place when the palette already holds the
+// material, and repacked on eviction only when it went stale.
+// ═══════════════════════════════════════════════════════════════
+
+void VoxelGrid::allocate() {
+  chunk_map = new uint32_t[TOTAL_MAP_CHUNKS](); // 2MB, zero-init = all air
+  chunk_pool = new VoxelChunk[VOXEL_POOL_INITIAL]();    // Grows on demand
+  hot_pool = new VoxelHotChunk[VOXEL_HOT_SLOTS]();      // 4MB edit cache
+  chunk_capacity = VOXEL_POOL_INITIAL;
+  active_chunk_count = 2; // 0=Air sentinel, 1=Earth sentinel (reserved)
+  hot_cursor = 0;
+  hot_frozen = 0;
+  edit_generation = 1;
+  saved_generation = 0;
+  file_map = nullptr;
+}
+
+void VoxelGrid::release() {
+  if (chunk_pool) {
+    for (uint32_t i = 2; i < active_chunk_count; i++) {
+      if (!chunk_pool[i].payload_mapped)
+        delete[] chunk_pool[i].payload;
+    }
+  }
+  delete[] chunk_map;
+  delete[] chunk_pool;
+  delete[] hot_pool;
+  chunk_map = nullptr;
+  chunk_pool = nullptr;
+  hot_pool = nullptr;
+  close_file_map(); // Pool gone: unmaps without detaching payloads
+  active_chunk_count = 0;
+  chunk_capacity = 0;
+  hot_cursor = 0;
+}
+
+bool VoxelGrid::reserve_chunks(uint32_t count) {
+  if (count <= chunk_capacity)
+    return true;
+  if (count > (uint32_t)MAX_ACTIVE_CHUNKS)
+    return false;
+  uint32_t cap = chunk_capacity ? chunk_capacity : VOXEL_POOL_INITIAL;
+  while (cap < count)
+    cap *= 2;
+  if (cap > (uint32_t)MAX_ACTIVE_CHUNKS)
+    cap = MAX_ACTIVE_CHUNKS;
+
+  VoxelChunk *grown = new VoxelChunk[cap]();
+  std::memcpy(grown, chunk_pool, sizeof(VoxelChunk) * active_chunk_count);
+  delete[] chunk_pool;
+  chunk_pool = grown;
+  chunk_capacity = cap;
+  return true;
+}
+
+uint32_t VoxelGrid::alloc_chunk(int map_idx) {
+  if (!reserve_chunks(active_chunk_count + 1))
+    return 0; // Pool exhausted
+
+  uint8_t implicit = (chunk_map[map_idx] == 1) ? VMAT_EARTH : VMAT_AIR;
+  uint32_t new_idx = active_chunk_count++;
+  chunk_map[map_idx] = new_idx;
+
+  // A fresh chunk is uniform: 1-entry palette, 0 bits, no payload
+  VoxelChunk &chunk = chunk_pool[new_idx];
+  std::memset(&chunk, 0, sizeof(VoxelChunk));
+  chunk.storage = VSTORE_PALETTE;
+  chunk.palette_count = 1;
+  chunk.palette[0] = implicit;
+  chunk.solid_count = (implicit == VMAT_AIR) ? 0 : CHUNK_VOLUME;
+  chunk.hot_slot = VOXEL_NO_HOT_SLOT;
+  return new_idx;
+}
+
+// ── Codec ──────────────────────────────────────────────────────
+
+static void unpack_chunk(const VoxelChunk &chunk, uint8_t *out) {
+  if (chunk.storage == VSTORE_RAW) {
+    std::memcpy(out, chunk.payload, CHUNK_VOLUME);
+  } else if (chunk.storage == VSTORE_RLE) {
+    const VoxelRun *runs = reinterpret_cast<const VoxelRun *>(chunk.payload);
+    int run_count = chunk.payload_bytes / (int)sizeof(VoxelRun);
+    int start = 0;
+    for (int r = 0; r < run_count; r++) {
+      std::memset(out + start, runs[r].mat, runs[r].end - start);
+      start = runs[r].end;
+    }
+  } else if (chunk.bits == 0) {
+    std::memset(out, chunk.palette[0], CHUNK_VOLUME);
+  } else {
+    const int bits = chunk.bits;
+    const int mask = (1 << bits) - 1;
+    const int per_byte = 8 / bits;
+    for (int b = 0; b < CHUNK_VOLUME / per_byte; b++) {
+      uint8_t packed = chunk.payload[b];
+      for (int k = 0; k < per_byte; k++) {
+        out[b * per_byte + k] = chunk.palette[(packed >> (k * bits)) & mask];
+      }
+    }
+  }
+}
+
+void VoxelGrid::read_voxels(uint32_t pool_idx, uint8_t *out) const {
+  const VoxelChunk &chunk = chunk_pool[pool_idx];
+  if (chunk.hot_slot != VOXEL_NO_HOT_SLOT)
+    std::memcpy(out, hot_pool[chunk.hot_slot].voxels, CHUNK_VOLUME);
+  else
+    unpack_chunk(chunk, out);
+}
+
+// Bit-packs palette indices with a compile-time width so the inner
+// loop fully unrolls (repack cost dominates terrain generation).
+template <int BITS>
+static void pack_indices(const uint8_t *voxels, const uint8_t *lut,
+                         uint8_t *out) {
+  constexpr int PER_BYTE = 8 / BITS;
+  for (int b = 0; b < CHUNK_VOLUME / PER_BYTE; b++) {
+    const uint8_t *v = voxels + b * PER_BYTE;
+    uint8_t packed = 0;
+    for (int k = 0; k < PER_BYTE; k++)
+      packed |= (uint8_t)(lut[v[k]] << (k * BITS));
+    out[b] = packed;
+  }
+}
+
+// Rewrites every packed index in place through lut (old → new index)
+template <int BITS>
+static void remap_indices(uint8_t *payload, const uint8_t *lut) {
+  constexpr int PER_BYTE = 8 / BITS;
+  constexpr int MASK = (1 << BITS) - 1;
+  for (int b = 0; b < CHUNK_VOLUME / PER_BYTE; b++) {
+    const uint8_t packed = payload[b];
+    uint8_t out = 0;
+    for (int k = 0; k < PER_BYTE; k++)
+      out |= (uint8_t)(lut[(packed >> (k * BITS)) & MASK] << (k * BITS));
+    payload[b] = out;
+  }
+}
+
+// Picks the smallest encoding for a raw 4KB chunk and rewrites the
+// header + payload. Palette entries are sorted ascending so the same
+// voxels always produce the same bytes (save-file stability).
+static void repack_chunk(VoxelChunk &chunk, const uint8_t *voxels) {
+  // Run count and material set as separate passes: the first is a
+  // branch-free compare the compiler vectorizes, the second a store-only
+  // scatter
+  int run_count = 1;
+  for (int i = 1; i < CHUNK_VOLUME; i++)
+    run_count += (voxels[i] != voxels[i - 1]);
+  bool seen[256] = {};
+  for (int i = 0; i < CHUNK_VOLUME; i++)
+    seen[voxels[i]] = true;
+
+  uint8_t palette[VOXEL_PALETTE_MAX];
+  uint8_t lut[256];
+  int palette_count = 0;
+  for (int m = 0; m < 256; m++) {
+    if (!seen[m])
+      continue;
+    if (palette_count < VOXEL_PALETTE_MAX)
+      palette[palette_count] = (uint8_t)m;
+    lut[m] = (uint8_t)palette_count;
+    palette_count++;
+  }
+
+  int bits = (palette_count <= 1)   ? 0
+             : (palette_count <= 2) ? 1
+             : (palette_count <= 4) ? 2
+                                    : 4;
+  int palette_bytes = (palette_count <= VOXEL_PALETTE_MAX)
+                          ? (CHUNK_VOLUME * bits) / 8
+                          : CHUNK_VOLUME;
+  int rle_bytes = run_count * (int)sizeof(VoxelRun);
+
+  uint8_t storage;
+  int bytes;
+  if (palette_count <= VOXEL_PALETTE_MAX && palette_bytes <= rle_bytes) {
+    storage = VSTORE_PALETTE;
+    bytes = palette_bytes;
+  } else if (rle_bytes < palette_bytes) {
+    storage = VSTORE_RLE;
+    bytes = rle_bytes;
+  } else {
+    storage = VSTORE_RAW;
+    bytes = CHUNK_VOLUME;
+  }
+
+  // Reuse the allocation when the size class is unchanged. Mapped
+  // payloads are read-only file memory: always copy-on-write.
+  if (bytes != chunk.payload_bytes || chunk.payload_mapped) {
+    if (!chunk.payload_mapped)
+      delete[] chunk.payload;
+    chunk.payload = (bytes > 0) ? new uint8_t[bytes] : nullptr;
+    chunk.payload_bytes = (uint16_t)bytes;
+    chunk.payload_mapped = 0;
+  }
+
+  chunk.storage = storage;
+  chunk.payload_stale = 0;
+  if (storage == VSTORE_PALETTE) {
+    chunk.bits = (uint8_t)bits;
+    chunk.palette_count = (uint8_t)palette_count;
+    std::memcpy(chunk.palette, palette, palette_count);
+    if (bits == 1)
+      pack_indices<1>(voxels, lut, chunk.payload);
+    else if (bits == 2)
+      pack_indices<2>(voxels, lut, chunk.payload);
+    else if (bits == 4)
+      pack_indices<4>(voxels, lut, chunk.payload);
+  } else if (storage == VSTORE_RLE) {
+    chunk.bits = 0;
+    chunk.palette_count = 0;
+    VoxelRun *runs = reinterpret_cast<VoxelRun *>(chunk.payload);
+    int r = 0;
+    for (int i = 1; i <= CHUNK_VOLUME; i++) {
+      if (i == CHUNK_VOLUME || voxels[i] != voxels[i - 1]) {
+        runs[r].end = (uint16_t)i;
+        runs[r].mat = voxels[i - 1];
+        runs[r].pad = 0;
+        r++;
+      }
+    }
+  } else {
+    chunk.bits = 8;
+    chunk.palette_count = 0;
+    std::memcpy(chunk.payload, voxels, CHUNK_VOLUME);
+  }
+}
+
+void VoxelGrid::pack_voxels(VoxelChunk &chunk, const uint8_t *voxels) {
+  repack_chunk(chunk, voxels);
+  chunk.hot_slot = VOXEL_NO_HOT_SLOT;
+}
+
+// ── Hot Cache ──────────────────────────────────────────────────
+
+uint8_t *VoxelGrid::hot_voxels(uint32_t pool_idx) {
+  VoxelChunk &chunk = chunk_pool[pool_idx];
+  if (chunk.hot_slot != VOXEL_NO_HOT_SLOT)
+    return hot_pool[chunk.hot_slot].voxels;
+
+  // A miss moves the clock, which destruction workers share unlocked
+  assert(!hot_frozen && "hot-cache miss while destruction workers run");
+
+  // Clock eviction: slots are claimed round-robin, skipping pinned ones.
+  // A destruction event touches at most a few dozen chunks, far below
+  // VOXEL_HOT_SLOTS, so a chunk is never evicted while the same edit
+  // still holds its pointer.
+  uint16_t slot = hot_cursor;
+  while (hot_pool[slot].pinned)
+    slot = (uint16_t)((slot + 1) % VOXEL_HOT_SLOTS);
+  hot_cursor = (uint16_t)((slot + 1) % VOXEL_HOT_SLOTS);
+
+  VoxelHotChunk &hot = hot_pool[slot];
+  if (hot.chunk_idx != 0) {
+    VoxelChunk &owner = chunk_pool[hot.chunk_idx];
+    if (owner.payload_stale)
+      repack_chunk(owner, hot.voxels);
+    owner.hot_slot = VOXEL_NO_HOT_SLOT;
+  }
+
+  unpack_chunk(chunk, hot.voxels);
+  hot.chunk_idx = pool_idx;
+  chunk.hot_slot = slot;
+  return hot.voxels;
+}
+
+void VoxelGrid::pin_hot(uint32_t pool_idx) {
+  hot_voxels(pool_idx);
+  hot_pool[chunk_pool[pool_idx].hot_slot].pinned = 1;
+}
+
+void VoxelGrid::unpin_hot(uint32_t pool_idx) {
+  uint16_t slot = chunk_pool[pool_idx].hot_slot;
+  if (slot != VOXEL_NO_HOT_SLOT)
+    hot_pool[slot].pinned = 0;
+}
+
+void VoxelGrid::write_through(VoxelChunk &chunk, int local, uint8_t mat) {
+  if (chunk.payload_stale)
+    return; // Already diverged — eviction repacks from the hot copy
+  if (chunk.payload_mapped) {
+    chunk.payload_stale = 1; // File memory is read-only
+    return;
+  }
+
+  if (chunk.storage == VSTORE_RAW) {
+    chunk.payload[local] = mat;
+    return;
+  }
+
+  if (chunk.storage == VSTORE_PALETTE && chunk.bits > 0) {
+    int idx = 0;
+    while (idx < chunk.palette_count && chunk.palette[idx] < mat)
+      idx++;
+    bool found = idx < chunk.palette_count && chunk.palette[idx] == mat;
+    // Insert into spare palette capacity at the current bit width. The
+    // palette stays sorted, as repack_chunk leaves it: indices past the
+    // insertion point shift up one.
+    if (!found && chunk.palette_count < (1 << chunk.bits)) {
+      if (idx < chunk.palette_count) {
+        uint8_t lut[VOXEL_PALETTE_MAX];
+        for (int i = 0; i < VOXEL_PALETTE_MAX; i++)
+          lut[i] = (uint8_t)(i < idx ? i : i + 1);
+        if (chunk.bits == 1)
+          remap_indices<1>(chunk.payload, lut);
+        else if (chunk.bits == 2)
+          remap_indices<2>(chunk.payload, lut);
+        else
+          remap_indices<4>(chunk.payload, lut);
+        std::memmove(chunk.palette + idx + 1, chunk.palette + idx,
+                     chunk.palette_count - idx);
+      }
+      chunk.palette[idx] = mat;
+      chunk.palette_count++;
+      found = true;
+    }
+    if (found) {
+      int bit = local * chunk.bits;
+      uint8_t mask = (uint8_t)(((1 << chunk.bits) - 1) << (bit & 7));
+      uint8_t &packed = chunk.payload[bit >> 3];
+      packed = (uint8_t)((packed & ~mask) | ((idx << (bit & 7)) & mask));
+      return;
+    }
+  }
+
+  // Uniform chunk, RLE, or palette overflow: repack on eviction
+  chunk.payload_stale = 1;
+}
+
+void VoxelGrid::flush_hot_cache() {
+  for (int slot = 0; slot < VOXEL_HOT_SLOTS; slot++) {
+    VoxelHotChunk &hot = hot_pool[slot];
+    if (hot.chunk_idx == 0)
+      continue;
+    VoxelChunk &owner = chunk_pool[hot.chunk_idx];
+    if (owner.payload_stale)
+      repack_chunk(owner, hot.voxels);
+    owner.hot_slot = VOXEL_NO_HOT_SLOT;
+    hot.chunk_idx = 0;
+    hot.pinned = 0;
+  }
+  hot_cursor = 0;
+}
+
+void VoxelGrid::repack_stale() {
+  for (int slot = 0; slot < VOXEL_HOT_SLOTS; slot++) {
+    VoxelHotChunk &hot = hot_pool[slot];
+    if (hot.chunk_idx == 0)
+      continue;
+    VoxelChunk &owner = chunk_pool[hot.chunk_idx];
+    if (owner.payload_stale)
+      repack_chunk(owner, hot.voxels);
+  }
+}
+
+size_t VoxelGrid::storage_bytes() const {
+  size_t total = 0;
+  for (uint32_t i = 2; i < active_chunk_count; i++) {
+    const VoxelChunk &chunk = chunk_pool[i];
+    total += sizeof(VoxelChunk) + chunk.payload_bytes;
+    if (chunk.hot_slot != VOXEL_NO_HOT_SLOT)
+      total += sizeof(VoxelHotChunk);
+  }
+  return total;
+}
+
+// ── Rubble Gravity ─────────────────────────────────────────────
+
+int VoxelGrid::column_floor(int x, int y, int z) const {
+  if (x < 0 || x >= MAP_CHUNKS_X * CHUNK_SIZE || z < 0 ||
+      z >= MAP_CHUNKS_Z * CHUNK_SIZE)
+    return y;
+  if (y > MAP_CHUNKS_Y * CHUNK_SIZE)
+    y = MAP_CHUNKS_Y * CHUNK_SIZE;
+
+  const int cx = x / CHUNK_SIZE;
+  const int cz = z / CHUNK_SIZE;
+  int fy = y;
+  while (fy > 0) {
+    int cy = (fy - 1) / CHUNK_SIZE;
+    uint32_t pool_idx = chunk_map[chunk_index(cx, cy, cz)];
+    if (pool_idx == 0) {
+      fy = cy * CHUNK_SIZE; // Whole air chunk below: fall through it
+      continue;
+    }
+    if (pool_idx == 1)
+      break; // Solid earth sentinel
+
+    const VoxelChunk &chunk = chunk_pool[pool_idx];
+    const uint8_t *hot = (chunk.hot_slot != VOXEL_NO_HOT_SLOT)
+                             ? hot_pool[chunk.hot_slot].voxels
+                             : nullptr;
+    int column = local_index(x, 0, z);
+    int bottom = cy * CHUNK_SIZE;
+    while (fy > bottom) {
+      int local = column + ((fy - 1) - bottom) * (CHUNK_SIZE * CHUNK_SIZE);
+      uint8_t mat = hot ? hot[local] : chunk.read_packed(local);
+      if (mat != VMAT_AIR)
+        return fy;
+      fy--;
+    }
+  }
+  return fy;
+}
@@ -0,0 +1,382 @@
+#include "musket_components.h"
+#include "worker_pool.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// ═══════════════════════════════════════════════════════════════
+// M13.9: PROCEDURAL TERRAIN (256×8×256 chunk map)
+//
+// Shared-pool workers claim rows of chunk columns. Per column: evaluate
+// the 16×16 heightmap, then classify each of the 8 chunks:
+//   - entirely above the surface       → chunk_map 0 (air sentinel)
+//   - entirely inside plain earth      → chunk_map 1 (earth sentinel)
+//   - crosses the surface / rock cap   → packed into worker staging
+// Sentinels are written by the worker (its columns are disjoint). Pool
+// indices are assigned afterwards on the calling thread in column order,
+// so the grid is byte-identical for a given seed at any thread count.
+//
+// Noise is integer-hashed value noise — no libm beyond floor/fabs, no
+// shared state, identical on every thread.
+// ═══════════════════════════════════════════════════════════════
+
+static inline uint32_t terrain_hash(int x, int z, uint32_t seed) {
+  uint32_t h = (uint32_t)x * 0x8da6b343u ^ (uint32_t)z * 0xd8163841u ^
+               seed * 0xcb1ab31fu;
+  h ^= h >> 16;
+  h *= 0x7feb352du;
+  h ^= h >> 15;
+  h *= 0x846ca68bu;
+  h ^= h >> 16;
+  return h;
+}
+
+// Smoothed value noise in [0, 1)
+static inline float terrain_noise(float x, float z, uint32_t seed) {
+  float fx0 = std::floor(x), fz0 = std::floor(z);
+  int ix = (int)fx0, iz = (int)fz0;
+  float fx = x - fx0, fz = z - fz0;
+  fx = fx * fx * (3.0f - 2.0f * fx);
+  fz = fz * fz * (3.0f - 2.0f * fz);
+  const float inv = 1.0f / 16777216.0f; // 24-bit mantissa
+  float a = (float)(terrain_hash(ix, iz, seed) >> 8) * inv;
+  float b = (float)(terrain_hash(ix + 1, iz, seed) >> 8) * inv;
+  float c = (float)(terrain_hash(ix, iz + 1, seed) >> 8) * inv;
+  float d = (float)(terrain_hash(ix + 1, iz + 1, seed) >> 8) * inv;
+  float ab = a + fx * (b - a);
+  float cd = c + fx * (d - c);
+  return ab + fz * (cd - ab);
+}
+
+// Three-octave fbm, normalized to [0, 1)
+static inline float terrain_fbm(float x, float z, uint32_t seed) {
+  return (terrain_noise(x, z, seed) * 0.5f +
+          terrain_noise(x * 2.0f, z * 2.0f, seed + 1) * 0.25f +
+          terrain_noise(x * 4.0f, z * 4.0f, seed + 2) * 0.125f) *
+         (1.0f / 0.875f);
+}
+
+// Continuous fields, sampled on a TERRAIN_LATTICE-voxel lattice and
+// bilinearly interpolated (the shortest noise wavelength is ~96 voxels,
+// so this is visually lossless and cuts noise evaluations 10×).
+static constexpr int TERRAIN_LATTICE = 4;
+
+struct TerrainFields {
+  float height; // Hills + ridges, before river carving
+  float ridge;  // 0..1 ridge strength
+  float river;  // |river field − 0.5| (0 = channel centre)
+};
+
+static inline TerrainFields terrain_fields(const TerrainParams &p, int x,
+                                           int z) {
+  const float fx = (float)x, fz = (float)z;
+  float hills = terrain_fbm(fx * p.hill_frequency, fz * p.hill_frequency,
+                            p.seed);
+
+  // Ridges: creased noise (1 − |2n − 1|)³, masked to part of the map
+  float rn = terrain_noise(fx * p.ridge_frequency, fz * p.ridge_frequency,
+                           p.seed + 17);
+  float crease = 1.0f - std::fabs(2.0f * rn - 1.0f);
+  float mask = terrain_noise(fx * p.ridge_frequency * 0.5f,
+                             fz * p.ridge_frequency * 0.5f, p.seed + 23);
+  mask = mask < 0.45f ? 0.0f : (mask - 0.45f) * (1.0f / 0.55f);
+  float ridge = crease * crease * crease * mask;
+
+  // Rivers: channels along the 0.5 contour of a low-frequency field
+  float rv = terrain_noise(fx * p.river_frequency, fz * p.river_frequency,
+                           p.seed + 31);
+
+  TerrainFields f;
+  f.height = (float)p.base_height + hills * (float)p.hill_amplitude +
+             ridge * (float)p.ridge_amplitude;
+  f.ridge = ridge;
+  f.river = std::fabs(rv - 0.5f);
+  return f;
+}
+
+// Surface height + top material for one voxel column
+struct TerrainColumn {
+  int height;  // Voxels y < height are solid
+  uint8_t top; // Material of the cap layer
+  uint8_t cap; // Cap thickness (0 → plain earth to the surface)
+};
+
+static inline TerrainColumn terrain_finish(const TerrainParams &p,
+                                           const TerrainFields &f) {
+  float h = f.height;
+  uint8_t top = VMAT_EARTH;
+  uint8_t cap = 0;
+  if (f.river < p.river_width * 2.0f) {
+    float t = f.river / (p.river_width * 2.0f); // 0 centre → 1 bank
+    t = t * t * (3.0f - 2.0f * t);
+    float bed = (float)(p.base_height - p.river_depth);
+    h = bed + t * (h - bed);
+    if (f.river < p.river_width) {
+      top = VMAT_RUBBLE; // Gravel bed
+      cap = 1;
+    }
+  } else if (f.ridge > 0.25f) {
+    top = VMAT_STONE; // Exposed escarpment
+    cap = (uint8_t)p.stone_cap_depth;
+  }
+
+  int height = (int)h;
+  const int max_h = MAP_CHUNKS_Y * CHUNK_SIZE;
+  height = height < 1 ? 1 : (height > max_h ? max_h : height);
+  return {height, top, cap};
+}
+
+// Evaluates one chunk column's 16×16 surface from its lattice corners
+static void terrain_chunk_columns(const TerrainParams &p, int cx, int cz,
+                                  TerrainColumn *out) {
+  constexpr int L = TERRAIN_LATTICE;
+  constexpr int N = CHUNK_SIZE / L + 1; // 5×5 lattice per chunk column
+  TerrainFields lat[N * N];
+  for (int j = 0; j < N; j++)
+    for (int i = 0; i < N; i++)
+      lat[j * N + i] =
+          terrain_fields(p, cx * CHUNK_SIZE + i * L, cz * CHUNK_SIZE + j * L);
+
+  const float inv = 1.0f / (float)L;
+  for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+    int j = lz / L;
+    float tz = (float)(lz % L) * inv;
+    for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+      int i = lx / L;
+      float tx = (float)(lx % L) * inv;
+      const TerrainFields &a = lat[j * N + i];
+      const TerrainFields &b = lat[j * N + i + 1];
+      const TerrainFields &c = lat[(j + 1) * N + i];
+      const TerrainFields &d = lat[(j + 1) * N + i + 1];
+      float w00 = (1.0f - tx) * (1.0f - tz), w10 = tx * (1.0f - tz);
+      float w01 = (1.0f - tx) * tz, w11 = tx * tz;
+      TerrainFields f;
+      f.height = a.height * w00 + b.height * w10 + c.height * w01 +
+                 d.height * w11;
+      f.ridge = a.ridge * w00 + b.ridge * w10 + c.ridge * w01 + d.ridge * w11;
+      f.river = a.river * w00 + b.river * w10 + c.river * w01 + d.river * w11;
+      out[lz * CHUNK_SIZE + lx] = terrain_finish(p, f);
+    }
+  }
+}
+
+// One materialized chunk awaiting a pool index
+struct TerrainStaged {
+  VoxelChunk chunk;
+  uint32_t map_idx;
+};
+
+struct TerrainColumnOut {
+  uint32_t start; // First entry in the worker's staging vector
+  uint16_t worker;
+  uint16_t count;
+};
+
+bool VoxelGrid::generate_terrain(const TerrainParams &params,
+                                 int max_threads) {
+  release();
+  allocate();
+
+  const int columns = MAP_CHUNKS_X * MAP_CHUNKS_Z;
+  std::vector<TerrainColumnOut> out(columns);
+  int threads = max_threads < 1 ? 1 : max_threads;
+  std::vector<std::vector<TerrainStaged>> staging(threads);
+  std::atomic<int> next_row(0);
+  uint32_t *map = chunk_map;
+
+  auto worker = [&](int wid) {
+    std::vector<TerrainStaged> &stage = staging[wid];
+    TerrainColumn col[CHUNK_SIZE * CHUNK_SIZE];
+    // SoA byte copies of the column (heights <= 128) so the layer fill
+    // below is a pure byte compare/select the compiler vectorizes
+    uint8_t col_height[CHUNK_SIZE * CHUNK_SIZE];
+    uint8_t col_earth[CHUNK_SIZE * CHUNK_SIZE];
+    uint8_t col_top[CHUNK_SIZE * CHUNK_SIZE];
+    uint8_t voxels[CHUNK_VOLUME];
+
+    for (;;) {
+      int cz = next_row.fetch_add(1);
+      if (cz >= MAP_CHUNKS_Z)
+        return;
+      for (int cx = 0; cx < MAP_CHUNKS_X; cx++) {
+        terrain_chunk_columns(params, cx, cz, col);
+        int lo_earth = 1 << 30; // Lowest voxel not plain earth
+        int hi_solid = 0;
+        for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++) {
+          int earth_top = col[i].height - col[i].cap;
+          earth_top = earth_top < 0 ? 0 : earth_top;
+          lo_earth = earth_top < lo_earth ? earth_top : lo_earth;
+          hi_solid = col[i].height > hi_solid ? col[i].height : hi_solid;
+          col_height[i] = (uint8_t)col[i].height;
+          col_earth[i] = (uint8_t)earth_top;
+          col_top[i] = col[i].top;
+        }
+
+        TerrainColumnOut &o = out[cz * MAP_CHUNKS_X + cx];
+        o.worker = (uint16_t)wid;
+        o.start = (uint32_t)stage.size();
+        o.count = 0;
+
+        for (int cy = 0; cy < MAP_CHUNKS_Y; cy++) {
+          const int y0 = cy * CHUNK_SIZE;
+          const int map_idx = chunk_index(cx, cy, cz);
+          if (y0 >= hi_solid)
+            break; // Air sentinel (map is zero-initialized)
+          if (y0 + CHUNK_SIZE <= lo_earth) {
+            map[map_idx] = 1; // Earth sentinel
+            continue;
+          }
+
+          int solids = 0;
+          for (int ly = 0; ly < CHUNK_SIZE; ly++) {
+            const uint8_t y = (uint8_t)(y0 + ly);
+            uint8_t *layer = voxels + ly * CHUNK_SIZE * CHUNK_SIZE;
+            for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++) {
+              uint8_t solid = y < col_height[i];
+              uint8_t m = (y < col_earth[i]) ? (uint8_t)VMAT_EARTH : col_top[i];
+              layer[i] = solid ? m : (uint8_t)VMAT_AIR;
+              solids += solid;
+            }
+          }
+
+          stage.emplace_back();
+          TerrainStaged &st = stage.back();
+          std::memset(&st.chunk, 0, sizeof(VoxelChunk));
+          pack_voxels(st.chunk, voxels);
+          st.chunk.solid_count = (uint16_t)solids;
+          st.chunk.dirty_mesh = 1;
+          st.chunk.dirty_flow = 1;
+          st.chunk.dirty_height = 1;
+          st.map_idx = (uint32_t)map_idx;
+          o.count++;
+        }
+      }
+    }
+  };
+
+  musket::shared_worker_pool().run(threads, worker);
+
+  // Deterministic pool assignment: column order, then height
+  uint32_t total = 0;
+  for (int i = 0; i < columns; i++)
+    total += out[i].count;
+  if (!reserve_chunks(2 + total)) {
+    // Cannot fit (never at 4km): an empty grid, not one with holes
+    // where the surface chunks should be
+    for (auto &stage : staging)
+      for (auto &st : stage)
+        delete[] st.chunk.payload;
+    release();
+    allocate();
+    return false;
+  }
+
+  for (int i = 0; i < columns; i++) {
+    const TerrainColumnOut &o = out[i];
+    const TerrainStaged *st = staging[o.worker].data() + o.start;
+    for (int k = 0; k < o.count; k++) {
+      uint32_t pool_idx = active_chunk_count++;
+      chunk_pool[pool_idx] = st[k].chunk;
+      chunk_pool[pool_idx].edit_gen = edit_generation;
+      chunk_map[st[k].map_idx] = pool_idx;
+    }
+  }
+  return true;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// M13.10: TERRAIN HEIGHTMAP (per-column surface cache)
+//
+// One chunk column at a time: walk its 8 chunks top-down. Air sentinels
+// are skipped, an earth sentinel resolves every open column at its top
+// face, and a pool chunk is decoded once and scanned per column from
+// the top. Stops as soon as all 256 columns are resolved.
+// ═══════════════════════════════════════════════════════════════
+
+void TerrainHeightmap::allocate() {
+  height = new uint8_t[HEIGHTMAP_WIDTH * HEIGHTMAP_DEPTH];
+  std::memset(height, 0, HEIGHTMAP_WIDTH * HEIGHTMAP_DEPTH);
+}
+
+void TerrainHeightmap::release() {
+  delete[] height;
+  height = nullptr;
+}
+
+static void heightmap_chunk_column(const VoxelGrid &grid, uint8_t *height,
+                                   int cx, int cz) {
+  constexpr int COLUMNS = CHUNK_SIZE * CHUNK_SIZE;
+  uint8_t top[COLUMNS];
+  bool open[COLUMNS];
+  int remaining = COLUMNS;
+  for (int i = 0; i < COLUMNS; i++) {
+    top[i] = 0;
+    open[i] = true;
+  }
+
+  uint8_t voxels[CHUNK_VOLUME];
+  for (int cy = MAP_CHUNKS_Y - 1; cy >= 0 && remaining > 0; cy--) {
+    uint32_t pool_idx = grid.chunk_map[VoxelGrid::chunk_index(cx, cy, cz)];
+    if (pool_idx == 0)
+      continue;
+    if (pool_idx == 1) {
+      for (int i = 0; i < COLUMNS; i++)
+        if (open[i])
+          top[i] = (uint8_t)((cy + 1) * CHUNK_SIZE);
+      break;
+    }
+    if (grid.chunk_pool[pool_idx].solid_count == 0)
+      continue;
+
+    grid.read_voxels(pool_idx, voxels);
+    for (int i = 0; i < COLUMNS; i++) {
+      if (!open[i])
+        continue;
+      for (int ly = CHUNK_SIZE - 1; ly >= 0; ly--) {
+        if (voxels[ly * COLUMNS + i] != VMAT_AIR) {
+          top[i] = (uint8_t)(cy * CHUNK_SIZE + ly + 1);
+          open[i] = false;
+          remaining--;
+          break;
+        }
+      }
+    }
+  }
+
+  const int x0 = cx * CHUNK_SIZE;
+  const int z0 = cz * CHUNK_SIZE;
+  for (int lz = 0; lz < CHUNK_SIZE; lz++)
+    std::memcpy(height + (z0 + lz) * HEIGHTMAP_WIDTH + x0,
+                top + lz * CHUNK_SIZE, CHUNK_SIZE);
+}
+
+void TerrainHeightmap::rebuild(VoxelGrid &grid) {
+  for (int cz = 0; cz < MAP_CHUNKS_Z; cz++)
+    for (int cx = 0; cx < MAP_CHUNKS_X; cx++)
+      heightmap_chunk_column(grid, height, cx, cz);
+  for (uint32_t i = 2; i < grid.active_chunk_count; i++)
+    grid.chunk_pool[i].dirty_height = 0;
+}
+
+void TerrainHeightmap::refresh(VoxelGrid &grid, int cx0, int cz0, int cx1,
+                               int cz1) {
+  cx0 = cx0 < 0 ? 0 : cx0;
+  cz0 = cz0 < 0 ? 0 : cz0;
+  cx1 = cx1 >= MAP_CHUNKS_X ? MAP_CHUNKS_X - 1 : cx1;
+  cz1 = cz1 >= MAP_CHUNKS_Z ? MAP_CHUNKS_Z - 1 : cz1;
+  for (int cz = cz0; cz <= cz1; cz++) {
+    for (int cx = cx0; cx <= cx1; cx++) {
+      bool dirty = false;
+      for (int cy = 0; cy < MAP_CHUNKS_Y; cy++) {
+        uint32_t pool_idx = grid.chunk_map[VoxelGrid::chunk_index(cx, cy, cz)];
+        if (pool_idx > 1 && grid.chunk_pool[pool_idx].dirty_height) {
+          grid.chunk_pool[pool_idx].dirty_height = 0;
+          dirty = true;
+        }
+      }
+      if (dirty)
+        heightmap_chunk_column(grid, height, cx, cz);
+    }
+  }
+}
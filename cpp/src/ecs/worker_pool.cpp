@@ -0,0 +1,74 @@
+#include "worker_pool.h"
+
+namespace musket {
+
+WorkerPool::WorkerPool(int threads) {
+  helpers.reserve(threads > 0 ? threads : 0);
+  for (int t = 0; t < threads; t++)
+    helpers.emplace_back(&WorkerPool::helper_main, this, t + 1);
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(state);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread &t : helpers)
+    t.join();
+}
+
+void WorkerPool::helper_main(int worker) {
+  uint64_t seen = 0;
+  std::unique_lock<std::mutex> lock(state);
+  for (;;) {
+    wake.wait(lock, [&] { return stopping || generation != seen; });
+    if (stopping)
+      return;
+    seen = generation;
+    if (worker > job_helpers)
+      continue; // Not needed for this job
+    const JobFn fn = job_fn;
+    void *ctx = job_ctx;
+    lock.unlock();
+    fn(ctx, worker);
+    lock.lock();
+    if (--pending == 0)
+      done.notify_one();
+  }
+}
+
+void WorkerPool::run_raw(int workers, JobFn fn, void *ctx) {
+  const int n = workers < size() ? workers : size();
+  // Another thread's job is running (or this is a nested fan-out): the
+  // claim loop finishes on the caller alone
+  std::unique_lock<std::mutex> owner(busy, std::try_to_lock);
+  if (n <= 1 || !owner.owns_lock()) {
+    fn(ctx, 0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(state);
+    job_fn = fn;
+    job_ctx = ctx;
+    job_helpers = n - 1;
+    pending = n - 1;
+    generation++;
+  }
+  wake.notify_all();
+  fn(ctx, 0);
+
+  std::unique_lock<std::mutex> lock(state);
+  done.wait(lock, [&] { return pending == 0; });
+}
+
+WorkerPool &shared_worker_pool() {
+  static WorkerPool pool([] {
+    const int hw = (int)std::thread::hardware_concurrency();
+    return hw > 1 ? hw - 1 : 0;
+  }());
+  return pool;
+}
+
+} // namespace musket
@@ -0,0 +1,74 @@
+#ifndef MUSKET_WORKER_POOL_H
+#define MUSKET_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// ═══════════════════════════════════════════════════════════════
+// SHARED WORKER POOL
+//
+// One set of parked threads for every fan-out in the engine
+// (destruction waves, formation solves, render-sync repacks), started
+// once instead of spawned and joined per call. run() wakes up to
+// `workers - 1` of them, runs the job on the calling thread as worker
+// 0, and returns once every participant has finished.
+//
+// Jobs are claim loops: each participant pulls work items from a
+// shared atomic counter until none are left, so any number of
+// participants, one included, finishes the whole job. That is what
+// lets run() fall back to the caller alone when the pool is already
+// busy with another thread's fan-out (or a nested one) instead of
+// blocking on it.
+// ═══════════════════════════════════════════════════════════════
+
+namespace musket {
+
+class WorkerPool {
+public:
+  // `threads` parked helpers (the caller makes one more participant)
+  explicit WorkerPool(int threads);
+  ~WorkerPool();
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  // Participants available to run(), the caller included
+  int size() const { return (int)helpers.size() + 1; }
+
+  // Calls job(worker) on min(workers, size()) participants, worker ids
+  // 0..n-1 with 0 on the calling thread. No heap allocation.
+  template <typename F> void run(int workers, F &&job) {
+    using Job = typename std::remove_reference<F>::type;
+    run_raw(
+        workers,
+        [](void *ctx, int worker) { (*static_cast<Job *>(ctx))(worker); },
+        const_cast<void *>(static_cast<const void *>(&job)));
+  }
+
+private:
+  typedef void (*JobFn)(void *ctx, int worker);
+  void run_raw(int workers, JobFn fn, void *ctx);
+  void helper_main(int worker);
+
+  std::vector<std::thread> helpers;
+  std::mutex busy;  // Held by the thread whose job is running
+  std::mutex state; // Guards everything below
+  std::condition_variable wake, done;
+  JobFn job_fn = nullptr;
+  void *job_ctx = nullptr;
+  uint64_t generation = 0; // Bumped per job: wakes the helpers
+  int job_helpers = 0;     // Helpers taking part in this job
+  int pending = 0;         // Of those, still running
+  bool stopping = false;
+};
+
+// The process-wide pool: hardware_concurrency() - 1 helpers, started
+// on first use
+WorkerPool &shared_worker_pool();
+
+} // namespace musket
+
+#endif // MUSKET_WORKER_POOL_H
@@ -1,223 +1,60 @@
 #include "world_manager.h"
+#include "macro_sync.h"
 #include "musket_components.h"
 #include "musket_systems.h"
-#include "prefab_loader.h"
 #include "rendering_bridge.h"
+#include "sim_commands.h"
+#include "sim_profiler.h"
+#include "sim_replay.h"
+#include "sim_snapshot.h"
+#include "sim_world.h"
+#include "worker_pool.h"
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
 #include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 
 // ═══════════════════════════════════════════════════════════════
-// GOLDEN TU: Array and centroid function MUST live here.
+// GOLDEN TU: Arrays MUST live here, and the centroid pass
+// (sim_world.cpp) in the same unity build.
 // ecs.each<> resolves Flecs component IDs from TU-local static
 // template variables. These must share the TU where components
 // are registered to get the correct IDs (MSVC TU mismatch rule).
 // ═══════════════════════════════════════════════════════════════
 MacroBattalion g_macro_battalions[MAX_BATTALIONS];
 PendingOrder g_pending_orders[MAX_BATTALIONS];
+BattalionPool g_battalion_pool;
 
+// Centroid pre-pass; an emptied battalion also drops its shadow buffer
 static void compute_battalion_centroids(flecs::world &ecs) {
-  float dt = ecs.get_info()->delta_time;
-
-  // 1. Zero TRANSIENT data only (Trap 23: preserve flag_cohesion)
-  for (int i = 0; i < MAX_BATTALIONS; i++) {
-    g_macro_battalions[i].cx = 0.0f;
-    g_macro_battalions[i].cz = 0.0f;
-    g_macro_battalions[i].alive_count = 0;
-    g_macro_battalions[i].team_id = 999;
-    g_macro_battalions[i].flag_alive = false;
-    g_macro_battalions[i].drummer_alive = false;
-    g_macro_battalions[i].officer_alive = false;
-  }
-
-  // 2. Accumulate + detect M7 command network tags
-  ecs.each([](flecs::entity e, const Position &p, const BattalionId &b,
-              const TeamId &t) {
-    if (!e.has<IsAlive>())
-      return;
-    uint32_t id = b.id % MAX_BATTALIONS;
-    g_macro_battalions[id].cx += p.x;
-    g_macro_battalions[id].cz += p.z;
-    g_macro_battalions[id].alive_count++;
-    g_macro_battalions[id].team_id = t.team;
-
-    // M7: Tag detection
-    if (e.has<FormationAnchor>())
-      g_macro_battalions[id].flag_alive = true;
-    if (e.has<Drummer>())
-      g_macro_battalions[id].drummer_alive = true;
-    if (e.has<ElevatedLOS>())
-      g_macro_battalions[id].officer_alive = true;
-  });
-
-  // 3. Finalize centroids + M7 pipelines + M7.5 targeting + fire discipline
-  for (int i = 0; i < MAX_BATTALIONS; i++) {
-    auto &mb = g_macro_battalions[i];
-
-    // Trap 24: Shatter command if almost wiped out
-    if (mb.alive_count > 0 && mb.alive_count < 10) {
-      mb.flag_alive = mb.drummer_alive = mb.officer_alive = false;
-    }
-
-    if (mb.alive_count > 0) {
-      mb.cx /= (float)mb.alive_count;
-      mb.cz /= (float)mb.alive_count;
-
-      // Phase A: Flag cohesion decay (16s to 0.2 floor)
-      if (mb.flag_alive) {
-        mb.flag_cohesion = std::min(1.0f, mb.flag_cohesion + dt * 0.1f);
-      } else {
-        mb.flag_cohesion = std::max(0.2f, mb.flag_cohesion - dt * 0.05f);
-      }
-
-      // M7.5 §12.7: Dead officer = loss of fire discipline!
-      if (!mb.officer_alive && mb.fire_discipline != DISCIPLINE_AT_WILL) {
-        mb.fire_discipline = DISCIPLINE_AT_WILL;
-      }
-
-      // M7.5 §12.7: Officer's Metronome — tick the fire discipline timer
-      if (mb.fire_discipline == DISCIPLINE_BY_RANK) {
-        mb.volley_timer -= dt;
-        if (mb.volley_timer <= 0.0f) {
-          mb.active_firing_rank = (mb.active_firing_rank + 1) % 3;
-          mb.volley_timer = 3.0f; // 3s between rank volleys
-        }
-      } else if (mb.fire_discipline == DISCIPLINE_MASS_VOLLEY) {
-        mb.volley_timer -= dt;
-        if (mb.volley_timer <= 0.0f) {
-          mb.fire_discipline = DISCIPLINE_HOLD; // Window closed
-        }
-      }
-
-      // ── M7.5 §12.8 Trap 26: Hoisted Macro Targeting ──
-      // O(B²) total: find nearest unblocked enemy battalion for each battalion
-      mb.target_bat_id = -1;
-      float best_dist = 1e18f;
-
-      for (int j = 0; j < MAX_BATTALIONS; j++) {
-        auto &enemy = g_macro_battalions[j];
-        if (enemy.alive_count == 0 || enemy.team_id == mb.team_id)
-          continue;
-
-        float edx = enemy.cx - mb.cx;
-        float edz = enemy.cz - mb.cz;
-        float ed2 = edx * edx + edz * edz;
-        if (ed2 >= best_dist)
-          continue;
-
-        // Check if a FRIENDLY battalion's OBB blocks this shot path
-        bool blocked = false;
-        for (int fb = 0; fb < MAX_BATTALIONS; fb++) {
-          if (fb == i || fb == j)
-            continue;
-          auto &f = g_macro_battalions[fb];
-          if (f.alive_count == 0 || f.team_id != mb.team_id)
-            continue;
-
-          // OBB diagonals
-          float rx = -f.dir_z * f.ext_w, rz = f.dir_x * f.ext_w;
-          float fx = f.dir_x * f.ext_d, fz = f.dir_z * f.ext_d;
-          // Diagonal 1: (cx-rx-fx) to (cx+rx+fx)
-          float d1ax = f.cx - rx - fx, d1az = f.cz - rz - fz;
-          float d1bx = f.cx + rx + fx, d1bz = f.cz + rz + fz;
-          // Diagonal 2: (cx+rx-fx) to (cx-rx+fx)
-          float d2ax = f.cx + rx - fx, d2az = f.cz + rz - fz;
-          float d2bx = f.cx - rx + fx, d2bz = f.cz - rz + fz;
-
-          // CCW segment intersection test (zero sqrt)
-          auto ccw = [](float ax, float az, float bx, float bz, float cx,
-                        float cz) {
-            return (cz - az) * (bx - ax) > (bz - az) * (cx - ax);
-          };
-          auto seg_hit = [&](float ax, float az, float bx, float bz, float cx,
-                             float cz, float dx, float dz) {
-            return ccw(ax, az, cx, cz, dx, dz) != ccw(bx, bz, cx, cz, dx, dz) &&
-                   ccw(ax, az, bx, bz, cx, cz) != ccw(ax, az, bx, bz, dx, dz);
-          };
-
-          if (seg_hit(mb.cx, mb.cz, enemy.cx, enemy.cz, d1ax, d1az, d1bx,
-                      d1bz) ||
-              seg_hit(mb.cx, mb.cz, enemy.cx, enemy.cz, d2ax, d2az, d2bx,
-                      d2bz)) {
-            blocked = true;
-            break;
-          }
-        }
-
-        if (!blocked && ed2 < best_dist) {
-          best_dist = ed2;
-          mb.target_bat_id = j;
-        }
-      }
-    }
-
-    // Phase D: Order Delay Pipeline
-    auto &order = g_pending_orders[i];
-    if (order.type != ORDER_NONE) {
-      order.delay -= dt;
-      if (order.delay <= 0.0f) {
-        OrderType otype = order.type;
-        float tx = order.target_x;
-        float tz = order.target_z;
-
-        if (otype == ORDER_DISCIPLINE) {
-          // M7.5 §12.7: Fire discipline change
-          mb.fire_discipline = (FireDiscipline)order.requested_discipline;
-          if (mb.fire_discipline == DISCIPLINE_BY_RANK) {
-            mb.active_firing_rank = 0;
-            mb.volley_timer = 3.0f;
-          } else if (mb.fire_discipline == DISCIPLINE_MASS_VOLLEY) {
-            mb.volley_timer = 0.5f; // 0.5s execution window
-          }
-        } else {
-          // Dispatch to ECS entities in this battalion
-          ecs.each([&](flecs::entity e, const BattalionId &b) {
-            if ((int)(b.id % MAX_BATTALIONS) != i || !e.has<IsAlive>())
-              return;
-            if (e.has<CavalryState>()) {
-              const auto &cs = e.get<CavalryState>();
-              if (cs.state_flags != 0)
-                return;
-            }
-
-            if (otype == ORDER_MARCH && e.has<SoldierFormationTarget>()) {
-              const auto &st = e.get<SoldierFormationTarget>();
-              e.set<MovementOrder>({(float)(tx + st.target_x),
-                                    (float)(tz + st.target_z), false});
-            } else if (otype == ORDER_FIRE) {
-              e.set<FireOrder>({tx, tz});
-            }
-          });
-        }
-        order.type = ORDER_NONE;
-      }
-    }
-  }
-
-  // Diagnostic (every 2s at 60Hz)
-  static int tick = 0;
-  if (tick++ % 120 == 0) {
-    godot::UtilityFunctions::print(
-        "[CENTROIDS] Bat0: alive=", g_macro_battalions[0].alive_count,
-        " flag=", g_macro_battalions[0].flag_alive,
-        " drum=", g_macro_battalions[0].drummer_alive,
-        " cohesion=", g_macro_battalions[0].flag_cohesion,
-        " | Bat1: alive=", g_macro_battalions[1].alive_count);
-  }
+  musket::run_centroid_pass(ecs, musket::release_battalion_buffer);
 }
 
 namespace godot {
 
 MusketServer::MusketServer() {}
 
-MusketServer::~MusketServer() {}
+MusketServer::~MusketServer() {
+  stop_sim_thread();
+  musket::release_sim_profiler(ecs);
+  musket::release_sim_commands(ecs);
+  commands = nullptr;
+  delete replay;
+  delete world_writer; // Joins a save still writing
+}
 
 void MusketServer::_bind_methods() {
   // M1: Core
   ClassDB::bind_method(D_METHOD("spawn_test_battalion", "count", "center_x",
                                 "center_z", "team_id"),
                        &MusketServer::spawn_test_battalion);
+  ClassDB::bind_method(D_METHOD("set_legacy_sync", "enabled"),
+                       &MusketServer::set_legacy_sync);
   ClassDB::bind_method(D_METHOD("get_transform_buffer"),
                        &MusketServer::get_transform_buffer);
   ClassDB::bind_method(D_METHOD("get_visible_count"),
@@ -253,6 +90,14 @@ void MusketServer::_bind_methods() {
                        &MusketServer::get_battalion_buffer);
   ClassDB::bind_method(D_METHOD("get_battalion_instance_count", "battalion_id"),
                        &MusketServer::get_battalion_instance_count);
+  ClassDB::bind_method(D_METHOD("get_dirty_battalions"),
+                       &MusketServer::get_dirty_battalions);
+  ClassDB::bind_method(D_METHOD("get_battalion_dirty_range", "battalion_id"),
+                       &MusketServer::get_battalion_dirty_range);
+  ClassDB::bind_method(D_METHOD("set_instance_format", "format"),
+                       &MusketServer::set_instance_format);
+  ClassDB::bind_method(D_METHOD("get_instance_format"),
+                       &MusketServer::get_instance_format);
 
   // M6: Cavalry
   ClassDB::bind_method(
@@ -269,223 +114,175 @@ void MusketServer::_bind_methods() {
   ClassDB::bind_method(
       D_METHOD("order_formation", "battalion_id", "shape_enum"),
       &MusketServer::order_formation);
+  ClassDB::bind_method(
+      D_METHOD("order_wheel", "battalion_id", "dir_x", "dir_z"),
+      &MusketServer::order_wheel);
+
+  // M13.8: Voxel Save Files
+  ClassDB::bind_method(D_METHOD("save_voxels", "path"),
+                       &MusketServer::save_voxels);
+  ClassDB::bind_method(D_METHOD("save_voxels_delta", "path"),
+                       &MusketServer::save_voxels_delta);
+  ClassDB::bind_method(D_METHOD("load_voxels", "path"),
+                       &MusketServer::load_voxels);
+  ClassDB::bind_method(D_METHOD("apply_voxels_delta", "path"),
+                       &MusketServer::apply_voxels_delta);
+  ClassDB::bind_method(
+      D_METHOD("stream_voxel_region", "min_x", "min_z", "max_x", "max_z"),
+      &MusketServer::stream_voxel_region);
+
+  // M13.9: Procedural Terrain
+  ClassDB::bind_method(D_METHOD("generate_terrain", "seed"),
+                       &MusketServer::generate_terrain);
+
+  // Deterministic simulation RNG
+  ClassDB::bind_method(D_METHOD("set_world_seed", "seed"),
+                       &MusketServer::set_world_seed);
+
+  // Fixed-step simulation clock
+  ClassDB::bind_method(D_METHOD("get_sim_tick"), &MusketServer::get_sim_tick);
+  ClassDB::bind_method(D_METHOD("get_interpolation_alpha"),
+                       &MusketServer::get_interpolation_alpha);
+  ClassDB::bind_method(D_METHOD("set_sim_group_rate", "group", "hz"),
+                       &MusketServer::set_sim_group_rate);
+  ClassDB::bind_method(D_METHOD("set_threaded_simulation", "enabled"),
+                       &MusketServer::set_threaded_simulation);
+  ClassDB::bind_method(D_METHOD("is_threaded_simulation"),
+                       &MusketServer::is_threaded_simulation);
+
+  // Deterministic replay
+  ClassDB::bind_method(D_METHOD("start_replay_recording"),
+                       &MusketServer::start_replay_recording);
+  ClassDB::bind_method(D_METHOD("stop_replay_recording", "path"),
+                       &MusketServer::stop_replay_recording);
+  ClassDB::bind_method(D_METHOD("play_replay", "path"),
+                       &MusketServer::play_replay);
+  ClassDB::bind_method(D_METHOD("fast_forward_replay", "tick"),
+                       &MusketServer::fast_forward_replay);
+  ClassDB::bind_method(D_METHOD("is_replay_playing"),
+                       &MusketServer::is_replay_playing);
+
+  // World snapshots
+  ClassDB::bind_method(D_METHOD("save_world", "path"),
+                       &MusketServer::save_world);
+  ClassDB::bind_method(D_METHOD("load_world", "path"),
+                       &MusketServer::load_world);
+  ClassDB::bind_method(D_METHOD("is_world_saving"),
+                       &MusketServer::is_world_saving);
+
+  // Per-system profiler
+  ClassDB::bind_method(D_METHOD("set_profiling", "enabled"),
+                       &MusketServer::set_profiling);
+  ClassDB::bind_method(D_METHOD("is_profiling"), &MusketServer::is_profiling);
+  ClassDB::bind_method(D_METHOD("get_profile"), &MusketServer::get_profile);
+  ClassDB::bind_method(D_METHOD("save_profile_trace", "path"),
+                       &MusketServer::save_profile_trace);
+
+  // Macro-state sync
+  ClassDB::bind_method(D_METHOD("get_macro_sync_seq"),
+                       &MusketServer::get_macro_sync_seq);
+  ClassDB::bind_method(D_METHOD("encode_macro_sync", "baseline_seq"),
+                       &MusketServer::encode_macro_sync);
+  ClassDB::bind_method(D_METHOD("set_client_mode", "enabled"),
+                       &MusketServer::set_client_mode);
+  ClassDB::bind_method(D_METHOD("is_client_mode"),
+                       &MusketServer::is_client_mode);
+  ClassDB::bind_method(D_METHOD("receive_macro_sync", "packet"),
+                       &MusketServer::receive_macro_sync);
 }
 
 void MusketServer::_ready() {
   if (Engine::get_singleton()->is_editor_hint()) {
     return;
   }
-  init_ecs();
+  if (client_mode)
+    init_client_ecs();
+  else
+    init_ecs();
+  if (threaded_sim)
+    start_sim_thread();
 }
 
+void MusketServer::_exit_tree() { stop_sim_thread(); }
+
 void MusketServer::init_ecs() {
   UtilityFunctions::print("[MusketEngine] Initializing ECS...");
 
-  // Register core components
-  ecs.component<Position>("Position");
-  ecs.component<Velocity>("Velocity");
-  ecs.component<Height>("Height");
-  ecs.component<IsAlive>("IsAlive");
-  ecs.component<Routing>("Routing");
-  ecs.component<TeamId>("TeamId");
-  ecs.component<BattalionId>("BattalionId");
-  ecs.component<SoldierFormationTarget>("SoldierFormationTarget");
-  ecs.component<MovementStats>("MovementStats");
-  ecs.component<MovementOrder>("MovementOrder");
-  ecs.component<MusketState>("MusketState");
-  ecs.component<FireOrder>("FireOrder");
-  ecs.component<CavalryState>("CavalryState");
-  ecs.component<Workplace>("Workplace");
-
-  // M5: Artillery components
-  ecs.component<ArtilleryShot>("ArtilleryShot");
-  ecs.component<ArtilleryBattery>("ArtilleryBattery");
-
-  // M6: Rendering + Cavalry components
-  ecs.component<RenderSlot>("RenderSlot");
-  ecs.component<FormationDefense>("FormationDefense");
-  ecs.component<ChargeOrder>("ChargeOrder");
-  ecs.component<Disordered>("Disordered");
-
-  // M7: Command Network components
-  ecs.component<FormationAnchor>("FormationAnchor");
-  ecs.component<Drummer>("Drummer");
-  ecs.component<ElevatedLOS>("ElevatedLOS");
-
-  // Register M2 movement systems
-  musket::register_movement_systems(ecs);
-
-  // Initialize M8 spatial hash grid singleton (heap-allocated: 4.2MB)
-  // Must come before register_combat_systems which registers the rebuild
-  // system.
-  {
-    auto *shg = new SpatialHashGrid();
-    memset(shg, 0, sizeof(SpatialHashGrid));
-    memset(shg->cell_head, -1, sizeof(shg->cell_head));
-    ecs.set<SpatialHashGrid>(*shg);
-    delete shg;
-  }
-
-  // Register M3+M8 combat systems
-  musket::register_combat_systems(ecs);
+  commands = musket::init_sim_world(ecs);
 
-  // Initialize M4 panic grid singleton (zero-initialized)
-  ecs.set<PanicGrid>({});
-
-  // Register M4 panic systems (must come after PanicGrid singleton)
-  musket::register_panic_systems(ecs);
-
-  // Register M5 artillery systems
-  musket::register_artillery_systems(ecs);
-
-  // Register M6 cavalry systems
-  musket::register_cavalry_systems(ecs);
+  // Rendering bridge on top: slot clearing on death, and the render
+  // sync queries (cached once, iterated every frame)
   musket::register_death_clear_observer(ecs);
-
-  // Initialize M9 economy singletons
-  ecs.set<CivicGrid>({});
-  ecs.set<GlobalZeitgeist>({});
-
-  // Register M9 economy systems
-  musket::register_economy_systems(ecs);
-
-  // Initialize M13-M14 voxel singletons
-  // Both chunk_map (1MB) and chunk_pool (~272MB) are heap-allocated.
-  // VoxelGrid struct itself is only ~24 bytes — safe for Flecs copy.
-  VoxelGrid vg = {};
-  vg.chunk_map = new uint16_t[TOTAL_MAP_CHUNKS](); // 1MB, zero-init = all air
-  vg.chunk_pool = new VoxelChunk[MAX_ACTIVE_CHUNKS]();
-  vg.active_chunk_count = 2; // 0=Air sentinel, 1=Earth sentinel (reserved)
-  ecs.set<VoxelGrid>(vg);
-  ecs.set<DestructionQueue>({});
-
-  // Register M13-M14 voxel systems
-  musket::register_voxel_systems(ecs);
-
-  // Load JSON prefabs
-  musket::load_all_prefabs(ecs);
+  sync_queries = musket::build_render_sync_queries(ecs);
 
   UtilityFunctions::print("[MusketEngine] ECS ready — systems registered.");
 }
 
 void MusketServer::spawn_test_battalion(int count, float center_x,
                                         float center_z, int team_id) {
-  uint32_t bat_id = next_battalion_id++;
+  auto lock = lock_world();
+  if (count <= 0)
+    return;
+  int pooled = g_battalion_pool.acquire();
+  if (pooled < 0) {
+    UtilityFunctions::printerr("[MusketEngine] Battalion pool full (",
+                               MAX_BATTALIONS, " live battalions)");
+    return;
+  }
+  uint32_t bat_id = (uint32_t)pooled;
 
   UtilityFunctions::print("[MusketEngine] Spawning battalion #", bat_id, " (",
                           count, " soldiers, team ", team_id, ") at (",
                           center_x, ", ", center_z, ")");
 
-  // Activate the battalion shadow buffer
+  // Activate the battalion shadow buffer: stable rendering slots for the
+  // whole battalion, one buffer grow, one pass over the shadow buffer
   auto &bat = musket::get_battalion(bat_id);
   bat.active = true;
+  uint32_t first_slot = bat.alloc_slots(count);
+  std::vector<Position> pos;
+  musket::spawn_line_battalion(ecs, bat_id, count, center_x, center_z, team_id,
+                               first_slot, pos);
+  musket::write_spawn_instances(bat, first_slot, pos.data(), count,
+                                (float)team_id);
+
+  musket::record_replay_spawn(ecs, {musket::REPLAY_SPAWN_INFANTRY,
+                                    (uint8_t)team_id, {}, count, center_x,
+                                    center_z});
+  UtilityFunctions::print("[MusketEngine] Battalion #", bat_id,
+                          " spawned: ", count, " soldiers (3-rank line, ",
+                          (count + 2) / 3, " files wide).");
+}
 
-  // M7.5: True Napoleonic Line — 3 ranks deep (§12.1)
-  constexpr int RANKS = 3;
-  constexpr float SP_X = 0.8f; // 0.8m shoulder-to-shoulder
-  constexpr float SP_Z = 1.2f; // 1.2m depth between ranks
-  int cols = (int)std::ceil((float)count / RANKS);
-
-  // M7.5: Set initial OBB geometry for this battalion
-  auto &mb = g_macro_battalions[bat_id % MAX_BATTALIONS];
-  mb.dir_x = 0.0f;
-  mb.dir_z = -1.0f;                        // Facing -Z (Godot forward)
-  mb.ext_w = (cols * SP_X) / 2.0f + 2.0f;  // Half-width + 2m buffer
-  mb.ext_d = (RANKS * SP_Z) / 2.0f + 2.0f; // Half-depth + 2m buffer
-
-  // Center offsets for perfectly centering the formation
-  float start_x = center_x - ((cols - 1) * SP_X) / 2.0f;
-  float start_z = center_z - ((RANKS - 1) * SP_Z) / 2.0f;
-
-  int center_col = cols / 2;
-
-  for (int i = 0; i < count; i++) {
-    int row = i % RANKS; // 0=Front, 1=Middle, 2=Rear
-    int col = i / RANKS; // 0..166
-
-    float x = start_x + col * SP_X;
-    float z = start_z + row * SP_Z;
-
-    // Micro-jitter to avoid robotic grid
-    float jx = ((float)(std::rand() % 100) / 100.0f - 0.5f) * 0.15f;
-    float jz = ((float)(std::rand() % 100) / 100.0f - 0.5f) * 0.15f;
-
-    // Allocate a stable rendering slot
-    uint32_t mm_slot = bat.alloc_slot();
-
-    auto e = ecs.entity()
-                 .set<Position>({x + jx, z + jz})
-                 .set<Velocity>({0.0f, 0.0f})
-                 .set<SoldierFormationTarget>({(double)x,
-                                               (double)z,
-                                               50.0f,
-                                               2.0f,
-                                               0.0f,
-                                               -1.0f, // Face forward (-Z)
-                                               true,
-                                               (uint8_t)row,
-                                               {}})
-                 .set<MovementStats>({4.0f, 8.0f})
-                 .set<TeamId>({(uint8_t)team_id})
-                 .set<BattalionId>({bat_id})
-                 .set<MusketState>(
-                     {0.0f, 30, 13}) // Trap 28: no stagger, all start loaded
-                 .set<FormationDefense>({0.2f}) // Line formation by default
-                 .set<RenderSlot>({bat_id, mm_slot})
-                 .add<IsAlive>();
-
-    // M7.5: Embed command staff in center file (§12.2)
-    if (col == center_col) {
-      if (row == 0)
-        e.add<ElevatedLOS>(); // Officer: Front rank
-      if (row == 1)
-        e.add<FormationAnchor>(); // Flag: Middle rank (protected)
-      if (row == 2)
-        e.add<Drummer>(); // Drummer: Rear rank
-    }
+// Orders never touch the world here: the sim applies them at the top of
+// its next tick (musket::drain_sim_commands)
+void MusketServer::submit(const musket::SimCommand &c) {
+  if (!commands) {
+    UtilityFunctions::printerr("[MusketEngine] No command queue (client?)");
+    return;
   }
-
-  UtilityFunctions::print("[MusketEngine] Battalion #", bat_id,
-                          " spawned: ", count, " soldiers (3-rank line, ", cols,
-                          " files wide).");
+  if (replay) {
+    UtilityFunctions::printerr("[MusketEngine] Replay playing: order ignored");
+    return;
+  }
+  if (!commands->push(c))
+    UtilityFunctions::printerr("[MusketEngine] Command queue full, dropped");
 }
 
 void MusketServer::order_march(float target_x, float target_z) {
   UtilityFunctions::print("[MusketEngine] March order → (", target_x, ", ",
                           target_z, ")");
-
-  // M7: Route through pending order pipeline for ALL battalions
-  for (int i = 0; i < MAX_BATTALIONS; i++) {
-    if (g_macro_battalions[i].alive_count == 0)
-      continue;
-    g_pending_orders[i].type = ORDER_MARCH;
-    g_pending_orders[i].target_x = target_x;
-    g_pending_orders[i].target_z = target_z;
-    // Last-write-wins with penalty reset (Deep Think ruling #3)
-    g_pending_orders[i].delay =
-        g_macro_battalions[i].drummer_alive ? 2.0f : 8.0f;
-  }
+  submit({musket::CMD_MARCH, {}, 0, 0, target_x, target_z});
 }
 
 void MusketServer::order_fire(int team_id, float target_x, float target_z) {
   UtilityFunctions::print("[MusketEngine] Fire order (team ", team_id, ") → (",
                           target_x, ", ", target_z, ")");
-
-  // M7: Route through pending order pipeline for matching team
-  for (int i = 0; i < MAX_BATTALIONS; i++) {
-    if (g_macro_battalions[i].alive_count == 0)
-      continue;
-    if (g_macro_battalions[i].team_id != (uint32_t)team_id)
-      continue;
-    g_pending_orders[i].type = ORDER_FIRE;
-    g_pending_orders[i].target_x = target_x;
-    g_pending_orders[i].target_z = target_z;
-    g_pending_orders[i].delay =
-        g_macro_battalions[i].drummer_alive ? 2.0f : 8.0f;
-  }
+  submit({musket::CMD_FIRE, {}, team_id, 0, target_x, target_z});
 }
 
 int MusketServer::get_alive_count(int team_id) const {
+  auto lock = lock_world();
   int count = 0;
   flecs::world &w = const_cast<flecs::world &>(ecs);
   auto q = w.query_builder<const TeamId>().with<IsAlive>().build();
@@ -498,30 +295,60 @@ int MusketServer::get_alive_count(int team_id) const {
   return count;
 }
 
+void MusketServer::set_legacy_sync(bool enabled) {
+  auto lock = lock_world();
+  legacy_sync = enabled;
+  if (!enabled) {
+    transform_buffer.resize(0);
+    visible_count = 0;
+  }
+}
+
 PackedFloat32Array MusketServer::get_transform_buffer() const {
-  return transform_buffer;
+  return frames ? frames->current().transforms : transform_buffer;
 }
 
-int MusketServer::get_visible_count() const { return visible_count; }
+int MusketServer::get_visible_count() const {
+  return frames ? frames->current().visible_count : visible_count;
+}
 
 void MusketServer::_process(double delta) {
   if (Engine::get_singleton()->is_editor_hint()) {
     return;
   }
+  if (world_writer)
+    poll_world_save();
 
-  // Pre-pass: battalion centroids (GOLDEN TU — same TU as component
-  // registration)
-  compute_battalion_centroids(ecs);
+  // Threaded: the sim thread ticks and syncs; take its newest frame
+  if (frames) {
+    frames->acquire();
+    return;
+  }
 
-  // Tick the ECS world
-  ecs.progress(delta);
+  // Client: interpolate snapshots, springs, slot writes. Nothing else.
+  if (client_mode) {
+    musket::advance_simulation(ecs, delta, nullptr);
+    musket::sync_battalion_transforms(ecs, sync_queries);
+    return;
+  }
+
+  // Tick the ECS world in fixed SIM_TICK_DT steps (0..max_catchup per
+  // frame). Pre-pass per tick: battalion centroids (GOLDEN TU — same TU
+  // as component registration)
+  if (replay)
+    advance_replay(delta);
+  else
+    musket::advance_simulation(ecs, delta, compute_battalion_centroids);
 
   // ── DUAL WRITE (Strangler Fig Migration) ──
-  // Legacy path: sequential repack for old GDScript code
-  musket::sync_transforms(ecs, transform_buffer, visible_count);
+  // Legacy path: sequential repack for old GDScript code. Opt-in — it
+  // rewrites every soldier every frame.
+  if (legacy_sync)
+    musket::sync_transforms(ecs, sync_queries, transform_buffer,
+                            visible_count);
 
   // New path: stable slot writes to battalion shadow buffers
-  musket::sync_battalion_transforms(ecs);
+  musket::sync_battalion_transforms(ecs, sync_queries);
 
   // M5: Projectile sync
   musket::sync_projectiles(ecs, projectile_buffer, projectile_count);
@@ -533,6 +360,7 @@ void MusketServer::_process(double delta) {
 
 void MusketServer::spawn_test_battery(int num_guns, float x, float z,
                                       int team_id) {
+  auto lock = lock_world();
   UtilityFunctions::print("[MusketEngine] Spawning battery (", num_guns,
                           " guns, team ", team_id, ") at (", x, ", ", z, ")");
 
@@ -541,69 +369,117 @@ void MusketServer::spawn_test_battery(int num_guns, float x, float z,
       .set<Velocity>({0.0f, 0.0f})
       .set<TeamId>({(uint8_t)team_id})
       .set<ArtilleryBattery>({num_guns, 0.0f, 0.0f, 50, 20, false, 0.0f});
+  musket::record_replay_spawn(
+      ecs, {musket::REPLAY_SPAWN_BATTERY, (uint8_t)team_id, {}, num_guns, x, z});
 }
 
 void MusketServer::order_artillery_fire(int team_id, float target_x,
                                         float target_z) {
   UtilityFunctions::print("[MusketEngine] Artillery fire (team ", team_id,
                           ") → (", target_x, ", ", target_z, ")");
-
-  auto q = ecs.query_builder<const TeamId, const ArtilleryBattery>().build();
-
-  q.each([&](flecs::entity e, const TeamId &t, const ArtilleryBattery &bat) {
-    if (t.team == (uint8_t)team_id) {
-      e.set<FireOrder>({target_x, target_z});
-    }
-  });
+  submit({musket::CMD_ARTILLERY_FIRE, {}, team_id, 0, target_x, target_z});
 }
 
 void MusketServer::order_limber(int team_id) {
   UtilityFunctions::print("[MusketEngine] Limber order (team ", team_id, ")");
-
-  auto q = ecs.query_builder<ArtilleryBattery, const TeamId>().build();
-
-  q.each([&](flecs::entity e, ArtilleryBattery &bat, const TeamId &t) {
-    if (t.team == (uint8_t)team_id) {
-      bat.is_limbered = true;
-      bat.unlimber_timer = 0.0f;
-    }
-  });
+  submit({musket::CMD_LIMBER, {}, team_id, 0, 0.0f, 0.0f});
 }
 
 void MusketServer::order_unlimber(int team_id) {
   UtilityFunctions::print("[MusketEngine] Unlimber order (team ", team_id, ")");
-
-  auto q = ecs.query_builder<ArtilleryBattery, const TeamId>().build();
-
-  q.each([&](flecs::entity e, ArtilleryBattery &bat, const TeamId &t) {
-    if (t.team == (uint8_t)team_id && bat.is_limbered) {
-      bat.unlimber_timer = 60.0f;
-    }
-  });
+  submit({musket::CMD_UNLIMBER, {}, team_id, 0, 0.0f, 0.0f});
 }
 
 PackedFloat32Array MusketServer::get_projectile_buffer() const {
-  return projectile_buffer;
+  return frames ? frames->current().projectiles : projectile_buffer;
 }
 
-int MusketServer::get_projectile_count() const { return projectile_count; }
+int MusketServer::get_projectile_count() const {
+  return frames ? frames->current().projectile_count : projectile_count;
+}
 
 // ═══════════════════════════════════════════════════════════════
 // M6: Battalion Rendering API
 // ═══════════════════════════════════════════════════════════════
 
+// Threaded, every getter below reads the frame taken in _process and
+// the dirty ranges it has accumulated since each battalion's last fetch
+
 PackedInt32Array MusketServer::get_active_battalions() const {
-  return musket::get_active_battalion_ids();
+  if (!frames)
+    return musket::get_active_battalion_ids();
+  const musket::RenderFrame &f = frames->current();
+  PackedInt32Array ids;
+  ids.resize(f.active_count);
+  if (f.active_count > 0)
+    memcpy(ids.ptrw(), f.active, sizeof(int32_t) * f.active_count);
+  return ids;
+}
+
+// Battalions with slots written since their buffer was last fetched
+PackedInt32Array MusketServer::get_dirty_battalions() const {
+  if (!frames)
+    return musket::get_dirty_battalion_ids();
+  const musket::RenderFrame &f = frames->current();
+  PackedInt32Array ids;
+  for (int k = 0; k < f.active_count; k++) {
+    const int id = f.active[k];
+    if (frames->seen_hi[id] > frames->seen_lo[id])
+      ids.push_back(id);
+  }
+  return ids;
+}
+
+// [first_slot, end_slot) written since the last fetch; [0, 0] if clean
+PackedInt32Array MusketServer::get_battalion_dirty_range(
+    int battalion_id) const {
+  PackedInt32Array range;
+  if (frames) {
+    const bool valid = battalion_id >= 0 && battalion_id < MAX_BATTALIONS;
+    range.push_back(valid ? frames->seen_lo[battalion_id] : 0);
+    range.push_back(valid ? frames->seen_hi[battalion_id] : 0);
+    return range;
+  }
+  const auto *bat = musket::find_battalion((uint32_t)battalion_id);
+  range.push_back(bat ? bat->dirty_lo : 0);
+  range.push_back(bat ? bat->dirty_hi : 0);
+  return range;
 }
 
+// Fetching is the upload acknowledgment: the dirty range resets
 PackedFloat32Array MusketServer::get_battalion_buffer(int battalion_id) const {
-  const auto &bat = musket::get_battalion((uint32_t)battalion_id);
-  return bat.buffer;
+  if (frames) {
+    if (battalion_id < 0 || battalion_id >= MAX_BATTALIONS)
+      return PackedFloat32Array();
+    frames->seen_lo[battalion_id] = frames->seen_hi[battalion_id] = 0;
+    return frames->current().buffer[battalion_id];
+  }
+  auto *bat = musket::find_battalion((uint32_t)battalion_id);
+  if (!bat)
+    return PackedFloat32Array();
+  bat->clear_dirty();
+  return bat->buffer;
+}
+
+// 0 = FULL (16 floats, stock MultiMesh), 1 = COMPACT (8 floats)
+void MusketServer::set_instance_format(int format) {
+  auto lock = lock_world();
+  musket::set_instance_format(format);
+}
+
+int MusketServer::get_instance_format() const {
+  return musket::get_instance_format();
 }
 
 int MusketServer::get_battalion_instance_count(int battalion_id) const {
-  const auto &bat = musket::get_battalion((uint32_t)battalion_id);
-  return bat.max_allocated;
+  // Whole buffer: multimesh_set_buffer needs size == count * 16, and
+  // slots past max_allocated are zeroed (invisible)
+  if (frames)
+    return battalion_id >= 0 && battalion_id < MAX_BATTALIONS
+               ? frames->current().instance_count[battalion_id]
+               : 0;
+  const auto *bat = musket::find_battalion((uint32_t)battalion_id);
+  return bat ? bat->capacity : 0;
 }
 
 // ═══════════════════════════════════════════════════════════════
@@ -612,7 +488,16 @@ int MusketServer::get_battalion_instance_count(int battalion_id) const {
 
 void MusketServer::spawn_test_cavalry(int count, float x, float z,
                                       int team_id) {
-  uint32_t bat_id = next_battalion_id++;
+  auto lock = lock_world();
+  if (count <= 0)
+    return;
+  int pooled = g_battalion_pool.acquire();
+  if (pooled < 0) {
+    UtilityFunctions::printerr("[MusketEngine] Battalion pool full (",
+                               MAX_BATTALIONS, " live battalions)");
+    return;
+  }
+  uint32_t bat_id = (uint32_t)pooled;
 
   UtilityFunctions::print("[MusketEngine] Spawning cavalry battalion #", bat_id,
                           " (", count, " riders, team ", team_id, ") at (", x,
@@ -621,8 +506,20 @@ void MusketServer::spawn_test_cavalry(int count, float x, float z,
   auto &bat = musket::get_battalion(bat_id);
   bat.active = true;
 
+  auto &mb = g_macro_battalions[bat_id];
+  mb.dir_x = 0.0f;
+  mb.dir_z = -1.0f; // Identity frame: offsets below are world offsets
+  mb.anchor_x = x;
+  mb.anchor_z = z;
+  mb.marching = false;
+
   int cols = 10;
   float spacing = 2.0f; // Wider spacing for cavalry
+  const uint64_t jitter_key =
+      sim_rng_key(ecs.get<SimRng>().seed, RNG_STREAM_SPAWN);
+
+  uint32_t first_slot = bat.alloc_slots(count);
+  std::vector<Position> pos(count);
 
   for (int i = 0; i < count; i++) {
     int row = i / cols;
@@ -631,16 +528,21 @@ void MusketServer::spawn_test_cavalry(int count, float x, float z,
     float cx = x + (col - cols / 2) * spacing;
     float cz = z + row * spacing;
 
-    float jx = ((float)(std::rand() % 100) / 100.0f - 0.5f) * 0.5f;
-    float jz = ((float)(std::rand() % 100) / 100.0f - 0.5f) * 0.5f;
+    uint64_t who = ((uint64_t)bat_id << 32) | (uint32_t)i;
+    float jx =
+        (sim_rand_unit(jitter_key, sim_rng_counter(0, who, 0)) - 0.5f) * 0.5f;
+    float jz =
+        (sim_rand_unit(jitter_key, sim_rng_counter(0, who, 1)) - 0.5f) * 0.5f;
 
-    uint32_t mm_slot = bat.alloc_slot();
+    uint32_t mm_slot = first_slot + (uint32_t)i;
+    pos[i] = {cx + jx, cz + jz};
 
     ecs.entity()
-        .set<Position>({cx + jx, cz + jz})
+        .set<Position>(pos[i])
         .set<Velocity>({0.0f, 0.0f})
-        .set<SoldierFormationTarget>(
-            {(double)cx, (double)cz, 30.0f, 1.5f, 0.0f, -1.0f, false, 0, {}})
+        .set<SoldierFormationTarget>({cx - x, cz - z, 30.0f, 1.5f,
+                                      face_snorm(0.0f), face_snorm(-1.0f),
+                                      false, 0, {}})
         .set<MovementStats>({4.0f, 12.0f}) // Walk 4, Charge 12
         .set<TeamId>({(uint8_t)team_id})
         .set<BattalionId>({bat_id})
@@ -648,252 +550,656 @@ void MusketServer::spawn_test_cavalry(int count, float x, float z,
         .set<RenderSlot>({bat_id, mm_slot})
         .add<IsAlive>();
   }
+  musket::write_spawn_instances(bat, first_slot, pos.data(), count,
+                                (float)team_id);
+  musket::record_replay_spawn(
+      ecs, {musket::REPLAY_SPAWN_CAVALRY, (uint8_t)team_id, {}, count, x, z});
 
   UtilityFunctions::print("[MusketEngine] Cavalry battalion #", bat_id,
                           " spawned: ", count, " riders.");
 }
 
+// Target: the enemy battalion nearest this team's cavalry, picked when
+// the sim drains the order
 void MusketServer::order_charge(int team_id, float target_x, float target_z) {
-  // Find cavalry centroid for this team
-  float cav_cx = 0, cav_cz = 0;
-  int cav_count = 0;
-
-  // EPHEMERAL EACH: Searches instantly, leaves zero memory footprint!
-  ecs.each([&](flecs::entity e, const Position &p, CavalryState &cs,
-               const TeamId &t) {
-    if (!e.has<IsAlive>())
-      return;
-    if (t.team == (uint8_t)team_id) {
-      cav_cx += p.x;
-      cav_cz += p.z;
-      cav_count++;
-    }
-  });
+  UtilityFunctions::print("[MusketEngine] Charge order (team ", team_id, ")");
+  submit({musket::CMD_CHARGE, {}, team_id, 0, target_x, target_z});
+}
+
+// ═══════════════════════════════════════════════════════════
+// M7.5: FIRE DISCIPLINE + FORMATION API
+// ═══════════════════════════════════════════════════════════
+
+void MusketServer::order_fire_discipline(int battalion_id,
+                                         int discipline_enum) {
+  UtilityFunctions::print("[MusketEngine] Fire discipline → bat ", battalion_id,
+                          " discipline=", discipline_enum);
+  submit({musket::CMD_FIRE_DISCIPLINE, {}, battalion_id, discipline_enum, 0.0f,
+          0.0f});
+}
+
+void MusketServer::order_formation(int battalion_id, int shape_enum) {
+  UtilityFunctions::print("[MusketEngine] Formation → bat ", battalion_id,
+                          " shape=", shape_enum);
+  submit({musket::CMD_FORMATION, {}, battalion_id, shape_enum, 0.0f, 0.0f});
+}
+
+void MusketServer::order_wheel(int battalion_id, float dir_x, float dir_z) {
+  UtilityFunctions::print("[MusketEngine] Wheel → bat ", battalion_id,
+                          " facing (", dir_x, ", ", dir_z, ")");
+  submit({musket::CMD_WHEEL, {}, battalion_id, 0, dir_x, dir_z});
+}
+
+// ═══════════════════════════════════════════════════════════
+// M13.8: VOXEL SAVE FILES
+// ═══════════════════════════════════════════════════════════
+// Paths may be res:// or user:// — globalized for the C file API.
+
+static std::string voxel_os_path(const String &path) {
+  return std::string(
+      ProjectSettings::get_singleton()->globalize_path(path).utf8().get_data());
+}
+
+bool MusketServer::save_voxels(const String &path) {
+  auto lock = lock_world();
+  bool ok = ecs.get_mut<VoxelGrid>().save_file(voxel_os_path(path).c_str());
+  UtilityFunctions::print("[MusketEngine] Voxel save → ", path,
+                          ok ? " OK" : " FAILED");
+  return ok;
+}
 
-  if (cav_count == 0) {
-    UtilityFunctions::print("[MusketEngine] No cavalry alive on team ",
-                            team_id);
+bool MusketServer::save_voxels_delta(const String &path) {
+  auto lock = lock_world();
+  return ecs.get_mut<VoxelGrid>().save_delta(voxel_os_path(path).c_str());
+}
+
+bool MusketServer::load_voxels(const String &path) {
+  auto lock = lock_world();
+  VoxelGrid &grid = ecs.get_mut<VoxelGrid>();
+  bool ok = grid.load_file(voxel_os_path(path).c_str());
+  if (ok)
+    ecs.get_mut<TerrainHeightmap>().rebuild(grid);
+  UtilityFunctions::print("[MusketEngine] Voxel load ← ", path,
+                          ok ? " OK" : " FAILED");
+  return ok;
+}
+
+bool MusketServer::apply_voxels_delta(const String &path) {
+  auto lock = lock_world();
+  VoxelGrid &grid = ecs.get_mut<VoxelGrid>();
+  bool ok = grid.apply_delta(voxel_os_path(path).c_str());
+  if (ok)
+    ecs.get_mut<TerrainHeightmap>().refresh(grid, 0, 0, MAP_CHUNKS_X - 1,
+                                            MAP_CHUNKS_Z - 1);
+  return ok;
+}
+
+void MusketServer::stream_voxel_region(float min_x, float min_z, float max_x,
+                                       float max_z) {
+  auto lock = lock_world();
+  int x0, y0, z0, x1, y1, z1;
+  VoxelGrid::world_to_voxel(min_x, 0.0f, min_z, x0, y0, z0);
+  VoxelGrid::world_to_voxel(max_x, 0.0f, max_z, x1, y1, z1);
+  VoxelGrid &grid = ecs.get_mut<VoxelGrid>();
+  grid.stream_in(x0 / CHUNK_SIZE, z0 / CHUNK_SIZE, x1 / CHUNK_SIZE,
+                 z1 / CHUNK_SIZE);
+  ecs.get_mut<TerrainHeightmap>().refresh(grid, x0 / CHUNK_SIZE,
+                                          z0 / CHUNK_SIZE, x1 / CHUNK_SIZE,
+                                          z1 / CHUNK_SIZE);
+}
+
+// ═══════════════════════════════════════════════════════════
+// M13.9: PROCEDURAL TERRAIN
+// ═══════════════════════════════════════════════════════════
+
+void MusketServer::generate_terrain(int seed) {
+  auto lock = lock_world();
+  TerrainParams params;
+  params.seed = (uint32_t)seed;
+  VoxelGrid &grid = ecs.get_mut<VoxelGrid>();
+  const bool ok =
+      grid.generate_terrain(params, musket::shared_worker_pool().size());
+  ecs.get_mut<TerrainHeightmap>().rebuild(grid);
+  if (!ok) {
+    UtilityFunctions::printerr("[MusketEngine] Terrain seed ", seed,
+                               ": chunk pool full, grid left empty");
     return;
   }
-  cav_cx /= cav_count;
-  cav_cz /= cav_count;
+  UtilityFunctions::print("[MusketEngine] Terrain seed ", seed, ": ",
+                          (int)grid.active_chunk_count - 2,
+                          " surface chunks");
+}
+
+// ═══════════════════════════════════════════════════════════
+// DETERMINISTIC SIMULATION RNG
+// ═══════════════════════════════════════════════════════════
+
+// Every roll is keyed on (seed, stream, tick, entity), so two servers
+// with the same seed and orders replay the same battle.
+void MusketServer::set_world_seed(int seed) {
+  auto lock = lock_world();
+  ecs.get_mut<SimRng>().seed = (uint64_t)(uint32_t)seed;
+  musket::record_replay_seed(ecs, (uint64_t)(uint32_t)seed);
+  UtilityFunctions::print("[MusketEngine] World seed ", seed);
+}
 
-  // Find Nearest Enemy Battalion safely using the cached Team ID
-  float best_dist = 999999.0f;
-  int best_target = -1;
+// ═══════════════════════════════════════════════════════════
+// FIXED-STEP SIMULATION CLOCK
+// ═══════════════════════════════════════════════════════════
 
-  for (int i = 0; i < MAX_BATTALIONS; i++) {
-    auto &mb = g_macro_battalions[i];
-    if (mb.alive_count == 0)
-      continue;
-    if (mb.team_id == (uint32_t)team_id)
-      continue; // Safely skip allies!
+int64_t MusketServer::get_sim_tick() const {
+  if (frames)
+    return frames->current().tick;
+  return (int64_t)ecs.get<SimClock>().tick;
+}
 
-    float dx = mb.cx - cav_cx;
-    float dz = mb.cz - cav_cz;
-    float d2 = (dx * dx) + (dz * dz);
+// Threaded: how far the render frame is past the last publish, the same
+// blend the main-thread clock would report
+double MusketServer::get_interpolation_alpha() const {
+  if (!frames)
+    return ecs.get<SimClock>().alpha;
+  const int64_t now_usec =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  const double alpha =
+      (now_usec - frames->current().publish_usec) * 1e-6 / SIM_TICK_DT;
+  return alpha < 0.0 ? 0.0 : (alpha > 1.0 ? 1.0 : alpha);
+}
 
-    if (d2 < best_dist) {
-      best_dist = d2;
-      best_target = i;
-    }
+// ═══════════════════════════════════════════════════════════════
+// Macro-state sync (GDD §4.3)
+// ═══════════════════════════════════════════════════════════════
+
+int64_t MusketServer::get_macro_sync_seq() const {
+  auto lock = lock_world();
+  return ecs.get<musket::MacroSyncHistory>().latest_seq;
+}
+
+// Latest snapshot as a delta from the client's last acknowledged seq
+// (0 = full). The scratch vector keeps its capacity between calls.
+PackedByteArray MusketServer::encode_macro_sync(int64_t baseline_seq) {
+  auto lock = lock_world();
+  musket::ProfileScope profile(ecs, musket::PROFILE_MACRO_ENCODE);
+  const auto &h = ecs.get<musket::MacroSyncHistory>();
+  const size_t n = musket::encode_macro_sync(
+      h, h.latest_seq, (uint32_t)baseline_seq, macro_sync_scratch);
+  profile.entities = (uint32_t)g_battalion_pool.live_count;
+  PackedByteArray out;
+  out.resize((int64_t)n);
+  if (n > 0)
+    memcpy(out.ptrw(), macro_sync_scratch.data(), n);
+  return out;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// Client Visual ECS (GDD §4.3)
+// ═══════════════════════════════════════════════════════════════
+
+// A client world registers no simulation: no combat, panic, economy or
+// voxels. Soldiers exist only as springs chasing interpolated anchors.
+void MusketServer::init_client_ecs() {
+  UtilityFunctions::print("[MusketEngine] Initializing client ECS...");
+
+  musket::register_sim_components(ecs);
+  musket::register_sim_clock(ecs);
+  musket::register_visual_client(ecs);
+  musket::register_death_clear_observer(ecs);
+  sync_queries = musket::build_render_sync_queries(ecs);
+  musket::register_sim_profiler(ecs);
+
+  UtilityFunctions::print("[MusketEngine] Client ECS ready.");
+}
+
+void MusketServer::set_client_mode(bool enabled) {
+  if (is_inside_tree()) {
+    UtilityFunctions::printerr(
+        "[MusketEngine] set_client_mode must be called before _ready");
+    return;
   }
+  client_mode = enabled;
+}
+
+bool MusketServer::is_client_mode() const { return client_mode; }
 
-  if (best_target != -1) {
-    UtilityFunctions::print("[MusketEngine] Charge → bat ", best_target);
-
-    float target_cx = g_macro_battalions[best_target].cx;
-    float target_cz = g_macro_battalions[best_target].cz;
-
-    int committed = 0;
-    ecs.each([&](flecs::entity e, const Position &p, CavalryState &cs,
-                 const TeamId &t) {
-      if (!e.has<IsAlive>())
-        return;
-      if (t.team != (uint8_t)team_id)
-        return;
-      if (cs.state_flags != 0)
-        return; // Skip already charging/disordered
-
-      // Compute parallel charge vector toward enemy centroid
-      float dx = target_cx - p.x;
-      float dz = target_cz - p.z;
-      float dist = std::sqrt(dx * dx + dz * dz);
-      if (dist < 0.01f)
-        return;
-
-      cs.lock_dir_x = dx / dist;
-      cs.lock_dir_z = dz / dist;
-      cs.state_flags = 1; // → Charging
-      cs.state_timer = 0.0f;
-      cs.charge_momentum = 0.0f;
-
-      ChargeOrder order;
-      order.target_battalion_id = best_target;
-      order.is_committed = true;
-      e.set<ChargeOrder>(order);
-      committed++;
-    });
-    UtilityFunctions::print("[MusketEngine] ", committed,
-                            " cavalry committed to charge");
-  } else {
-    UtilityFunctions::print(
-        "[MusketEngine] Charge -> fallback coords (No enemies found)");
+// Applies one snapshot; returns the seq to send back as the ack.
+int64_t MusketServer::receive_macro_sync(const PackedByteArray &packet) {
+  if (!client_mode) {
+    UtilityFunctions::printerr(
+        "[MusketEngine] receive_macro_sync needs client mode");
+    return 0;
   }
+  const uint32_t ack =
+      musket::receive_macro_sync(ecs, packet.ptr(), (size_t)packet.size());
+  mirror_visual_battalions();
+  return ack;
 }
 
-// ═══════════════════════════════════════════════════════════
-// M7.5: FIRE DISCIPLINE + FORMATION API
-// ═══════════════════════════════════════════════════════════
+// The client process runs no server, so its battalion pool and shadow
+// buffers mirror the snapshot's ids and slot tables: the rendering API
+// serves visual battalions unchanged.
+void MusketServer::mirror_visual_battalions() {
+  const auto &c = ecs.get<musket::MacroSyncClient>();
+  const int end = std::max<int>(c.id_end, mirrored_end);
+  for (int id = 0; id < end; id++) {
+    const int n = (int)c.bat[id].entity.size();
+    musket::BattalionShadowBuffer *buf = musket::find_battalion(id);
+    if (n == 0 || (buf && buf->max_allocated > n)) {
+      // Gone, or respawned under the same id: start from a fresh buffer
+      release_battalion(id);
+      musket::release_battalion_buffer((uint32_t)id);
+      if (n == 0)
+        continue;
+    }
+    g_battalion_pool.claim(id);
+    auto &bat = musket::get_battalion((uint32_t)id);
+    bat.active = true;
+    if (bat.max_allocated < n)
+      bat.alloc_slots(n - bat.max_allocated);
+  }
+  mirrored_end = c.id_end;
+}
 
-void MusketServer::order_fire_discipline(int battalion_id,
-                                         int discipline_enum) {
-  if (battalion_id < 0 || battalion_id >= MAX_BATTALIONS)
+// group: 1 = panic CA, 2 = economy, 3 = net snapshots. Physics is fixed
+// at 60Hz.
+void MusketServer::set_sim_group_rate(int group, int hz) {
+  auto lock = lock_world();
+  musket::set_sim_group_rate(ecs, group, hz);
+}
+
+// ═══════════════════════════════════════════════════════════════
+// THREADED SIMULATION
+//
+// The sim thread owns the world: it drains orders, ticks, syncs the
+// shadow buffers and publishes a render frame, all under world_mutex.
+// Orders never take the lock (the command queue); the rarer API calls
+// that reach into the world (spawns, voxels, seed, snapshots) take it
+// through lock_world and wait out at most one tick.
+// ═══════════════════════════════════════════════════════════════
+
+std::unique_lock<std::mutex> MusketServer::lock_world() const {
+  if (!frames)
+    return std::unique_lock<std::mutex>(); // Single-threaded: no-op
+  return std::unique_lock<std::mutex>(world_mutex);
+}
+
+// Takes effect at _ready when set earlier. Not for client worlds: they
+// only interpolate snapshots.
+void MusketServer::set_threaded_simulation(bool enabled) {
+  if (client_mode) {
+    UtilityFunctions::printerr(
+        "[MusketEngine] Threaded simulation is server-only");
+    return;
+  }
+  if (replay && enabled) {
+    UtilityFunctions::printerr(
+        "[MusketEngine] Replay playing: simulation stays on the main thread");
     return;
-  if (discipline_enum < 0 || discipline_enum > 3)
+  }
+  threaded_sim = enabled;
+  if (!is_inside_tree() || Engine::get_singleton()->is_editor_hint())
     return;
+  if (enabled)
+    start_sim_thread();
+  else
+    stop_sim_thread();
+}
 
-  // Feed into M7 Drummer Latency Pipeline
-  g_pending_orders[battalion_id].type = ORDER_DISCIPLINE;
-  g_pending_orders[battalion_id].requested_discipline =
-      (uint8_t)discipline_enum;
-  g_pending_orders[battalion_id].delay =
-      g_macro_battalions[battalion_id].drummer_alive ? 2.0f : 8.0f;
+bool MusketServer::is_threaded_simulation() const { return frames != nullptr; }
 
-  UtilityFunctions::print("[MusketEngine] Fire discipline → bat ", battalion_id,
-                          " discipline=", discipline_enum);
+void MusketServer::start_sim_thread() {
+  if (frames)
+    return;
+  // Shadow ranges not yet fetched drain into the first frame
+  frames = new musket::RenderFrameExchange();
+  sim_running.store(true, std::memory_order_release);
+  sim_thread = std::thread(&MusketServer::sim_thread_main, this);
+  UtilityFunctions::print("[MusketEngine] Simulation thread started");
 }
 
-void MusketServer::order_formation(int battalion_id, int shape_enum) {
-  if (battalion_id < 0 || battalion_id >= MAX_BATTALIONS)
+void MusketServer::stop_sim_thread() {
+  if (!frames)
     return;
+  sim_running.store(false, std::memory_order_release);
+  sim_thread.join();
+  // Ranges published but never fetched are lost with the frames: the
+  // main-thread getters start from a full upload
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    auto *bat = musket::find_battalion(g_battalion_pool.live[k]);
+    if (bat && bat->active)
+      bat->mark_dirty(0, bat->capacity);
+  }
+  delete frames;
+  frames = nullptr;
+}
 
-  auto &mb = g_macro_battalions[battalion_id];
-  if (mb.alive_count == 0)
-    return;
+void MusketServer::sim_thread_main() {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point last = Clock::now();
+  while (sim_running.load(std::memory_order_acquire)) {
+    const Clock::time_point now = Clock::now();
+    const double dt = std::chrono::duration<double>(now - last).count();
+    last = now;
+
+    double wait;
+    {
+      std::lock_guard<std::mutex> lock(world_mutex);
+      // Same pipeline as _process, published once per batch of ticks
+      if (musket::advance_simulation(ecs, dt, compute_battalion_centroids) >
+          0) {
+        if (legacy_sync)
+          musket::sync_transforms(ecs, sync_queries, transform_buffer,
+                                  visible_count);
+        musket::sync_battalion_transforms(ecs, sync_queries);
+        musket::sync_projectiles(ecs, projectile_buffer, projectile_count);
+        frames->publish((int64_t)ecs.get<SimClock>().tick, projectile_buffer,
+                        projectile_count, transform_buffer, visible_count);
+      }
+      wait = SIM_TICK_DT - ecs.get<SimClock>().accumulator;
+    }
+    if (wait > 0.0)
+      std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════
+// DETERMINISTIC REPLAY
+// ═══════════════════════════════════════════════════════════════
+
+// Playback rebuilds each recorded spawn through the same API call
+static bool replay_spawn(flecs::world &, const musket::ReplaySpawn &s,
+                         void *user) {
+  auto *server = static_cast<MusketServer *>(user);
+  switch (s.kind) {
+  case musket::REPLAY_SPAWN_INFANTRY:
+    server->spawn_test_battalion(s.count, s.x, s.z, s.team);
+    return true;
+  case musket::REPLAY_SPAWN_BATTERY:
+    server->spawn_test_battery(s.count, s.x, s.z, s.team);
+    return true;
+  case musket::REPLAY_SPAWN_CAVALRY:
+    server->spawn_test_cavalry(s.count, s.x, s.z, s.team);
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Before the first spawn: the log holds the seed, the tick and every
+// input from here on
+bool MusketServer::start_replay_recording() {
+  auto lock = lock_world();
+  if (client_mode || !musket::begin_replay_recording(ecs)) {
+    UtilityFunctions::printerr("[MusketEngine] Replay recording needs a "
+                               "server world with no battalions yet");
+    return false;
+  }
+  UtilityFunctions::print("[MusketEngine] Replay recording from tick ",
+                          (int64_t)ecs.get<SimClock>().tick);
+  return true;
+}
+
+bool MusketServer::stop_replay_recording(const String &path) {
+  std::vector<uint8_t> log;
+  {
+    auto lock = lock_world();
+    if (!musket::end_replay_recording(ecs, log))
+      return false;
+  }
+  bool ok = musket::save_replay_file(voxel_os_path(path).c_str(), log);
+  UtilityFunctions::print("[MusketEngine] Replay save → ", path, " (",
+                          (int64_t)log.size(), " bytes)",
+                          ok ? " OK" : " FAILED");
+  return ok;
+}
+
+// On a fresh scene (no battalions). Live orders are refused until the
+// log ends; the world then carries on live.
+bool MusketServer::play_replay(const String &path) {
+  if (client_mode || frames || replay) {
+    UtilityFunctions::printerr("[MusketEngine] Replay needs an idle "
+                               "single-threaded server world");
+    return false;
+  }
+  auto *player = new musket::ReplayPlayer();
+  if (!player->load_file(voxel_os_path(path).c_str()) ||
+      !musket::begin_replay_playback(ecs, *player,
+                                     compute_battalion_centroids)) {
+    UtilityFunctions::printerr("[MusketEngine] Replay load failed: ", path);
+    delete player;
+    return false;
+  }
+  replay = player;
+  UtilityFunctions::print("[MusketEngine] Replay ← ", path, ": ticks ",
+                          (int64_t)player->start_tick, "-",
+                          (int64_t)player->end_tick);
+  return true;
+}
+
+// Headless catch-up: runs ticks back to back up to `tick`, then the
+// next frame syncs the result. Returns the ticks run.
+int64_t MusketServer::fast_forward_replay(int64_t tick) {
+  if (!replay)
+    return 0;
+  const uint64_t ran = musket::fast_forward_replay(
+      ecs, *replay, (uint64_t)tick, compute_battalion_centroids, replay_spawn,
+      this);
+  if (replay->finished(ecs.get<SimClock>().tick))
+    end_replay();
+  return (int64_t)ran;
+}
+
+bool MusketServer::is_replay_playing() const { return replay != nullptr; }
 
-  FormationShape shape = (FormationShape)shape_enum;
-
-  // M7.5 §12.1: Formation geometry constants
-  constexpr float SP_X = 0.8f;
-  constexpr float SP_Z = 1.2f;
-  constexpr int RANKS = 3;
-
-  int N = mb.alive_count; // Includes command staff
-  float cx = mb.cx;
-  float cz = mb.cz;
-  float dir_x = mb.dir_x;
-  float dir_z = mb.dir_z;
-
-  // Calculate formation dimensions
-  int cols, ranks;
-  float defense, speed;
-  bool front_only_shoot = false;
-
-  if (shape == SHAPE_LINE) {
-    ranks = RANKS;
-    cols = (int)std::ceil((float)N / ranks);
-    defense = 0.2f;
-    speed = 4.0f;
-  } else if (shape == SHAPE_COLUMN) {
-    cols = 16; // 16-wide column
-    ranks = (int)std::ceil((float)N / cols);
-    defense = 0.5f;
-    speed = 6.0f;
-    front_only_shoot = true;
-  } else { // SHAPE_SQUARE
-    int per_side = (int)std::ceil((float)N / 4.0f);
-    cols = per_side;
-    ranks = per_side;
-    defense = 0.9f;
-    speed = 2.0f;
-    front_only_shoot = true;
-  }
-
-  // Update OBB extents (persistent)
-  mb.ext_w = (cols * SP_X) / 2.0f + 2.0f;
-  mb.ext_d = (ranks * SP_Z) / 2.0f + 2.0f;
-
-  // Universal rotation helper: local offset → global coordinates
-  auto rotate = [&](float lx, float lz, float &gx, float &gz) {
-    gx = -lx * dir_z - lz * dir_x;
-    gz = lx * dir_x - lz * dir_z;
-  };
-
-  // Trap 29: Running index inside ecs.each() — zero heap allocation
-  int slot = 0;
-  ecs.each([&](flecs::entity e, const BattalionId &b,
-               SoldierFormationTarget &tgt, FormationDefense &fd) {
-    if ((int)(b.id % MAX_BATTALIONS) != battalion_id || !e.has<IsAlive>())
+// Real-time playback: the clock banks the frame, the log drives each tick
+void MusketServer::advance_replay(double delta) {
+  const int steps = ecs.get_mut<SimClock>().bank(delta);
+  for (int s = 0; s < steps; s++) {
+    if (!musket::step_replay(ecs, *replay, compute_battalion_centroids,
+                             replay_spawn, this)) {
+      end_replay();
       return;
+    }
+  }
+}
 
-    // Determine local offset based on shape
-    float ox = 0.0f, oz = 0.0f;
-    float local_aim_x = 0.0f, local_aim_z = -1.0f;
-    int r = 0;
-    bool can_shoot = true;
-
-    if (shape == SHAPE_LINE) {
-      r = slot % RANKS;
-      int c = slot / RANKS;
-      ox = (c - cols / 2) * SP_X;
-      oz = r * SP_Z;
-    } else if (shape == SHAPE_COLUMN) {
-      r = slot / cols;
-      int c = slot % cols;
-      ox = (c - cols / 2) * SP_X;
-      oz = r * SP_Z;
-      can_shoot = (r == 0); // Only front rank fires
-    } else {                // SHAPE_SQUARE
-      int side = slot % 4;
-      int pos_on_side = slot / 4;
-      int per_side = (int)std::ceil((float)N / 4.0f);
-      r = pos_on_side % RANKS;
-
-      float half = (per_side * SP_X) / 2.0f;
-      float depth = r * SP_Z;
-      if (side == 0) {
-        ox = (pos_on_side - per_side / 2) * SP_X;
-        oz = -half - depth;
-        local_aim_x = 0.0f;
-        local_aim_z = -1.0f;
-      } else if (side == 1) {
-        ox = half + depth;
-        oz = (pos_on_side - per_side / 2) * SP_X;
-        local_aim_x = 1.0f;
-        local_aim_z = 0.0f;
-      } else if (side == 2) {
-        ox = (pos_on_side - per_side / 2) * SP_X;
-        oz = half + depth;
-        local_aim_x = 0.0f;
-        local_aim_z = 1.0f;
-      } else {
-        ox = -half - depth;
-        oz = (pos_on_side - per_side / 2) * SP_X;
-        local_aim_x = -1.0f;
-        local_aim_z = 0.0f;
-      }
-      can_shoot = (r == 0); // Only outermost rank fires per face
+void MusketServer::end_replay() {
+  if (replay->diverged())
+    UtilityFunctions::printerr("[MusketEngine] Replay diverged at tick ",
+                               (int64_t)replay->diverged_tick);
+  else
+    UtilityFunctions::print("[MusketEngine] Replay finished: ",
+                            (int64_t)replay->checkpoints_ok,
+                            " checkpoints matched");
+  delete replay;
+  replay = nullptr;
+}
+
+// ═══════════════════════════════════════════════════════════════
+// WORLD SNAPSHOTS
+// ═══════════════════════════════════════════════════════════════
+// The snapshot goes to `path`, the voxel grid to `path` + ".mvox" in
+// its own format.
+
+// Captures between ticks (~15ms at 200K soldiers) and returns; the
+// snapshot file is written on a worker thread while play goes on. The
+// voxel file is written here.
+bool MusketServer::save_world(const String &path) {
+  if (client_mode) {
+    UtilityFunctions::printerr("[MusketEngine] World saves are server-only");
+    return false;
+  }
+  if (!world_writer)
+    world_writer = new musket::SnapshotWriter();
+  if (world_writer->busy()) {
+    UtilityFunctions::printerr("[MusketEngine] World save still writing");
+    return false;
+  }
+  const std::string os_path = voxel_os_path(path);
+  std::vector<uint8_t> bytes;
+  {
+    auto lock = lock_world();
+    if (!musket::capture_world_snapshot(ecs, bytes)) {
+      UtilityFunctions::printerr(
+          "[MusketEngine] World save: an entity carries a component the "
+          "snapshot schema does not list");
+      return false;
+    }
+    if (!ecs.get_mut<VoxelGrid>().save_file((os_path + ".mvox").c_str())) {
+      UtilityFunctions::printerr("[MusketEngine] World save: voxel file "
+                                 "failed: ",
+                                 path, ".mvox");
+      return false;
     }
+  }
+  const int64_t size = (int64_t)bytes.size();
+  world_writer->start(std::move(bytes), os_path.c_str());
+  UtilityFunctions::print("[MusketEngine] World save → ", path, " (", size,
+                          " bytes, writing)");
+  return true;
+}
 
-    // Rotate to global
-    float gx, gz, gax, gaz;
-    rotate(ox, oz, gx, gz);
-    rotate(local_aim_x, local_aim_z, gax, gaz);
+bool MusketServer::is_world_saving() const {
+  return world_writer && world_writer->busy();
+}
+
+// Reports a finished background write
+void MusketServer::poll_world_save() {
+  if (world_writer->busy() ||
+      world_writer->state.load() == musket::SnapshotWriter::IDLE)
+    return;
+  const std::string path = world_writer->path;
+  if (world_writer->finish() == musket::SnapshotWriter::DONE)
+    UtilityFunctions::print("[MusketEngine] World save written: ",
+                            path.c_str());
+  else
+    UtilityFunctions::printerr("[MusketEngine] World save FAILED: ",
+                               path.c_str());
+}
 
-    tgt.target_x = (double)(cx + gx);
-    tgt.target_z = (double)(cz + gz);
-    tgt.face_dir_x = gax;
-    tgt.face_dir_z = gaz;
-    tgt.can_shoot = can_shoot;
-    tgt.rank_index = (uint8_t)r;
-    fd.defense = defense;
+// Replaces the battle in place. The sim thread, if running, is stopped
+// for the restore and started again after it.
+bool MusketServer::load_world(const String &path) {
+  if (client_mode || replay) {
+    UtilityFunctions::printerr("[MusketEngine] World load needs a server "
+                               "world with no replay playing");
+    return false;
+  }
+  const std::string os_path = voxel_os_path(path);
+  std::vector<uint8_t> bytes;
+  if (!musket::read_snapshot_file(os_path.c_str(), bytes)) {
+    UtilityFunctions::printerr("[MusketEngine] World load failed: ", path);
+    return false;
+  }
 
-    slot++;
+  const bool threaded = frames != nullptr;
+  stop_sim_thread();
+  bool ok = false;
+  uint32_t remapped = 0;
+  if (musket::is_replay_recording(ecs))
+    UtilityFunctions::printerr(
+        "[MusketEngine] World load refused: a replay is recording");
+  else
+    ok = musket::restore_world_snapshot(ecs, bytes.data(), bytes.size(),
+                                        &remapped);
+  if (ok) {
+    VoxelGrid &grid = ecs.get_mut<VoxelGrid>();
+    if (grid.load_file((os_path + ".mvox").c_str()))
+      ecs.get_mut<TerrainHeightmap>().rebuild(grid);
+    else
+      UtilityFunctions::printerr("[MusketEngine] World load: no voxel file, "
+                                 "terrain unchanged");
+    rebuild_shadow_buffers();
+  }
+  if (threaded)
+    start_sim_thread();
+
+  if (ok)
+    UtilityFunctions::print("[MusketEngine] World load ← ", path, ": tick ",
+                            (int64_t)ecs.get<SimClock>().tick, ", ",
+                            (int64_t)g_battalion_pool.live_count,
+                            " battalions, ", (int64_t)remapped,
+                            " ids renumbered");
+  else
+    UtilityFunctions::printerr("[MusketEngine] World load failed: ", path,
+                               " is not a snapshot this build can read");
+  return ok;
+}
+
+// Fresh buffers (new serials) for every live battalion, sized to its
+// highest RenderSlot: the next sync fills them from the restored soldiers
+void MusketServer::rebuild_shadow_buffers() {
+  for (int id = 0; id < MAX_BATTALIONS; id++)
+    musket::release_battalion_buffer((uint32_t)id);
+  std::vector<int> slots(MAX_BATTALIONS, 0);
+  ecs.each([&](const RenderSlot &rs) {
+    if (rs.battalion_id < (uint32_t)MAX_BATTALIONS &&
+        (int)rs.mm_slot >= slots[rs.battalion_id])
+      slots[rs.battalion_id] = (int)rs.mm_slot + 1;
   });
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const int id = g_battalion_pool.live[k];
+    auto &bat = musket::get_battalion((uint32_t)id);
+    bat.active = true;
+    if (slots[id] > 0)
+      bat.alloc_slots(slots[id]);
+  }
+}
 
-  UtilityFunctions::print("[MusketEngine] Formation → bat ", battalion_id,
-                          " shape=", shape_enum, " (", slot, " soldiers)");
+// ═══════════════════════════════════════════════════════════════
+// PER-SYSTEM PROFILER
+// ═══════════════════════════════════════════════════════════════
+
+void MusketServer::set_profiling(bool enabled) {
+  auto lock = lock_world();
+  musket::set_profiling(ecs, enabled);
+}
+
+bool MusketServer::is_profiling() const {
+  auto lock = lock_world();
+  return musket::is_profiling(ecs);
+}
+
+// { name: { kind, runs, entities, samples, min_ms, avg_ms, p99_ms,
+// max_ms, allocs_avg, allocs_max } }: sections first, then systems in
+// registration order. Windows are the last PROFILE_WINDOW runs.
+Dictionary MusketServer::get_profile() const {
+  Dictionary out;
+  auto lock = lock_world();
+  const auto *sp = ecs.try_get<musket::SimProfile>();
+  if (!sp || !sp->profiler)
+    return out;
+  std::vector<musket::ProfileStats> stats;
+  musket::profile_stats(*sp->profiler, stats);
+  for (const musket::ProfileStats &s : stats) {
+    Dictionary e;
+    e["kind"] = String(s.system ? "system" : "section");
+    e["runs"] = (int64_t)s.runs;
+    e["entities"] = (int64_t)s.entities;
+    e["samples"] = (int64_t)s.samples;
+    e["min_ms"] = (double)s.min_ms;
+    e["avg_ms"] = (double)s.avg_ms;
+    e["p99_ms"] = (double)s.p99_ms;
+    e["max_ms"] = (double)s.max_ms;
+    e["allocs_avg"] = (double)s.allocs_avg;
+    e["allocs_max"] = (int64_t)s.allocs_max;
+    out[String(s.name)] = e;
+  }
+  return out;
+}
+
+// Chrome trace JSON of the runs logged since profiling was enabled
+// (the newest PROFILE_TRACE_EVENTS). Open in chrome://tracing.
+bool MusketServer::save_profile_trace(const String &path) {
+  auto lock = lock_world();
+  const auto *sp = ecs.try_get<musket::SimProfile>();
+  if (!sp || !sp->profiler || sp->profiler->trace_count == 0) {
+    UtilityFunctions::printerr("[MusketEngine] No profile trace: call "
+                               "set_profiling(true) first");
+    return false;
+  }
+  return musket::write_profile_trace(*sp->profiler,
+                                     voxel_os_path(path).c_str());
 }
 
 } // namespace godot
@@ -2,10 +2,24 @@
 #define MUSKET_WORLD_MANAGER_H
 
 #include "../../flecs/flecs.h"
+#include "rendering_bridge.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <godot_cpp/classes/node.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
 #include <godot_cpp/variant/packed_float32_array.hpp>
 #include <godot_cpp/variant/packed_int32_array.hpp>
 
+namespace musket {
+struct SimCommand;
+struct SimCommandQueue;
+struct ReplayPlayer;
+struct SnapshotWriter;
+} // namespace musket
+
 namespace godot {
 
 class MusketServer : public Node {
@@ -13,17 +27,52 @@ class MusketServer : public Node {
 
 private:
   flecs::world ecs;
+  musket::RenderSyncQueries sync_queries; // After ecs: destroyed first
 
   // Legacy rendering (Strangler Fig — remove after M6 verified)
   PackedFloat32Array transform_buffer;
   int visible_count = 0;
+  bool legacy_sync = false; // Repack only while something reads it
 
   // M5: Projectile rendering
   PackedFloat32Array projectile_buffer;
   int projectile_count = 0;
 
-  // M6: Battalion counter for assigning battalion IDs
-  uint32_t next_battalion_id = 0;
+  // Macro-sync encode output (reused: no per-snapshot allocation)
+  std::vector<uint8_t> macro_sync_scratch;
+
+  // Orders: pushed here, drained by the sim at the top of each tick
+  musket::SimCommandQueue *commands = nullptr;
+  void submit(const musket::SimCommand &c);
+
+  // Client mode: the world only rebuilds soldiers from snapshots
+  bool client_mode = false;
+  int mirrored_end = 0; // Battalion ids mirrored into the render bridge
+
+  // Threaded simulation: the sim steps on sim_thread and publishes
+  // render frames; the main thread reads only the frames. frames is
+  // non-null exactly while the thread runs.
+  bool threaded_sim = false; // Requested (applied from _ready on)
+  std::thread sim_thread;
+  std::atomic<bool> sim_running{false};
+  mutable std::mutex world_mutex; // Held by the sim for a whole tick
+  musket::RenderFrameExchange *frames = nullptr;
+  std::unique_lock<std::mutex> lock_world() const;
+  void start_sim_thread();
+  void stop_sim_thread();
+  void sim_thread_main();
+
+  // Replay playback: replaces live ticking until the log ends
+  musket::ReplayPlayer *replay = nullptr;
+  void advance_replay(double delta);
+  void end_replay();
+
+  // World saves: captured between ticks, written on a worker thread
+  musket::SnapshotWriter *world_writer = nullptr;
+  void poll_world_save();
+  void rebuild_shadow_buffers();
+
+  void mirror_visual_battalions();
 
 protected:
   static void _bind_methods();
@@ -33,9 +82,11 @@ public:
   ~MusketServer();
 
   void _ready() override;
+  void _exit_tree() override;
   void _process(double delta) override;
 
   void init_ecs();
+  void init_client_ecs();
 
   // --- GDScript API ---
   void spawn_test_battalion(int count, float center_x, float center_z,
@@ -45,6 +96,7 @@ public:
   int get_alive_count(int team_id) const;
 
   // Legacy rendering (kept for dual-write migration)
+  void set_legacy_sync(bool enabled);
   PackedFloat32Array get_transform_buffer() const;
   int get_visible_count() const;
 
@@ -60,6 +112,10 @@ public:
   PackedInt32Array get_active_battalions() const;
   PackedFloat32Array get_battalion_buffer(int battalion_id) const;
   int get_battalion_instance_count(int battalion_id) const;
+  PackedInt32Array get_dirty_battalions() const;
+  PackedInt32Array get_battalion_dirty_range(int battalion_id) const;
+  void set_instance_format(int format);
+  int get_instance_format() const;
 
   // --- M6: Cavalry API ---
   void spawn_test_cavalry(int count, float x, float z, int team_id);
@@ -68,6 +124,55 @@ public:
   // --- M7.5: Fire Discipline + Formation API ---
   void order_fire_discipline(int battalion_id, int discipline_enum);
   void order_formation(int battalion_id, int shape_enum);
+  void order_wheel(int battalion_id, float dir_x, float dir_z);
+
+  // --- M13.8: Voxel Save Files ---
+  bool save_voxels(const String &path);
+  bool save_voxels_delta(const String &path);
+  bool load_voxels(const String &path);
+  bool apply_voxels_delta(const String &path);
+  void stream_voxel_region(float min_x, float min_z, float max_x,
+                           float max_z);
+
+  // --- M13.9: Procedural Terrain ---
+  void generate_terrain(int seed);
+
+  // --- Deterministic simulation RNG ---
+  void set_world_seed(int seed);
+
+  // --- Fixed-step simulation clock ---
+  int64_t get_sim_tick() const;
+  double get_interpolation_alpha() const;
+  void set_sim_group_rate(int group, int hz);
+  void set_threaded_simulation(bool enabled);
+  bool is_threaded_simulation() const;
+
+  // --- Deterministic replay ---
+  bool start_replay_recording();
+  bool stop_replay_recording(const String &path);
+  bool play_replay(const String &path);
+  int64_t fast_forward_replay(int64_t tick);
+  bool is_replay_playing() const;
+
+  // --- World snapshots (save games) ---
+  bool save_world(const String &path);
+  bool load_world(const String &path);
+  bool is_world_saving() const;
+
+  // --- Per-system profiler ---
+  void set_profiling(bool enabled);
+  bool is_profiling() const;
+  Dictionary get_profile() const;
+  bool save_profile_trace(const String &path);
+
+  // --- Macro-state sync (10Hz snapshots, GDD §4.3) ---
+  int64_t get_macro_sync_seq() const;
+  PackedByteArray encode_macro_sync(int64_t baseline_seq);
+
+  // --- Client Visual ECS (set before the node enters the tree) ---
+  void set_client_mode(bool enabled);
+  bool is_client_mode() const;
+  int64_t receive_macro_sync(const PackedByteArray &packet);
 };
 
 } // namespace godot
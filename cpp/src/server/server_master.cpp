@@ -0,0 +1,222 @@
+// ═════════════════════════════════════════════════════════════
+// MUSKET ENGINE: HEADLESS SERVER UNITY BUILD (SERVER_MODE, M0.8)
+// ═════════════════════════════════════════════════════════════
+// Dedicated battle server: Flecs + the ECS systems, no Godot, no
+// rendering bridge. Same unity rule as musket_master.cpp: compile
+// ONLY this file (plus flecs.c).
+// Build: scons server=yes
+// Run:   bin/musket_server [--ticks N] [--seed S] [--terrain SEED]
+//                          [--battalions N] [--soldiers N] [--bench]
+// Prefabs load from $MUSKET_DATA_ROOT/res/data (res:// = that root,
+// the working directory when unset).
+// ═════════════════════════════════════════════════════════════
+
+// ── Flecs ───────────────────────────────────────────────────
+#include "../../flecs/flecs.h"
+
+// ── Pure C++ engine code (Godot-free) ───────────────────────
+#include "../ecs/musket_components.h"
+#include "../ecs/musket_systems.h"
+#include "../ecs/macro_sync.h"
+#include "../ecs/platform.h"
+#include "../ecs/sim_commands.h"
+#include "../ecs/sim_replay.h"
+#include "../ecs/sim_world.h"
+#include "../ecs/worker_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Define the globals that normally live in world_manager.cpp
+MacroBattalion g_macro_battalions[MAX_BATTALIONS];
+PendingOrder g_pending_orders[MAX_BATTALIONS];
+BattalionPool g_battalion_pool;
+
+// Include the systems implementation (Godot-free) + stdio platform
+#include "../ecs/platform_stdio.cpp"
+#include "../ecs/worker_pool.cpp"
+#include "../ecs/voxel_storage.cpp"
+#include "../ecs/voxel_terrain.cpp"
+#include "../ecs/formation_layout.cpp"
+#include "../ecs/musket_systems.cpp"
+#include "../ecs/sim_commands.cpp"
+#include "../ecs/sim_replay.cpp"
+#include "../ecs/sim_snapshot.cpp"
+#include "../ecs/sim_profiler.cpp"
+#include "../ecs/macro_sync.cpp"
+#include "../ecs/prefab_loader.cpp"
+#include "../ecs/sim_world.cpp"
+#include "../ecs/voxel_file.cpp"
+
+using namespace musket;
+
+struct ServerOptions {
+  int64_t ticks = 0;     // 0 = until SIGINT/SIGTERM
+  uint32_t seed = 1805;  // SimRng seed
+  int64_t terrain = -1;  // Terrain seed (-1 = flat, no voxels)
+  int battalions = 4;    // Per side
+  int soldiers = 600;    // Per battalion
+  bool bench = false;    // Back-to-back ticks instead of real time
+};
+
+static std::atomic<bool> g_stop(false);
+static void on_signal(int) { g_stop.store(true); }
+
+static bool parse_options(int argc, char **argv, ServerOptions &o) {
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!std::strcmp(a, "--bench")) {
+      o.bench = true;
+      continue;
+    }
+    if (!v) {
+      log_error("Unknown or incomplete option: %s", a);
+      return false;
+    }
+    if (!std::strcmp(a, "--ticks"))
+      o.ticks = std::atoll(v);
+    else if (!std::strcmp(a, "--seed"))
+      o.seed = (uint32_t)std::strtoul(v, nullptr, 10);
+    else if (!std::strcmp(a, "--terrain"))
+      o.terrain = std::atoll(v);
+    else if (!std::strcmp(a, "--battalions"))
+      o.battalions = std::atoi(v);
+    else if (!std::strcmp(a, "--soldiers"))
+      o.soldiers = std::atoi(v);
+    else {
+      log_error("Unknown option: %s", a);
+      return false;
+    }
+    i++;
+  }
+  return o.battalions > 0 && o.soldiers > 0;
+}
+
+// Two armies of line battalions 80m apart, facing each other, ordered
+// to fire. Orders go through the queue like any client's would.
+static void deploy_armies(flecs::world &ecs, SimCommandQueue &commands,
+                          const ServerOptions &o) {
+  std::vector<Position> pos;
+  const float frontage = (float)((o.soldiers + 2) / 3) * 0.8f + 10.0f;
+  for (int team = 0; team < 2; team++) {
+    const float z = team == 0 ? 40.0f : -40.0f;
+    for (int b = 0; b < o.battalions; b++) {
+      const int id = g_battalion_pool.acquire();
+      if (id < 0) {
+        log_error("[MusketServer] Battalion pool full (%d live battalions)",
+                  MAX_BATTALIONS);
+        return;
+      }
+      const float x =
+          ((float)b - 0.5f * (float)(o.battalions - 1)) * frontage;
+      // No shadow buffers headless: every battalion's slots start at 0
+      spawn_line_battalion(ecs, (uint32_t)id, o.soldiers, x, z, team, 0,
+                           pos);
+      if (team == 1)
+        commands.push({CMD_WHEEL, {}, id, 0, 0.0f, 1.0f}); // Face +Z
+    }
+    commands.push({CMD_FIRE, {}, team, 0, 0.0f, -z});
+  }
+}
+
+static int alive_in_team(int team) {
+  int alive = 0;
+  for (int k = 0; k < g_battalion_pool.live_count; k++) {
+    const MacroBattalion &mb = g_macro_battalions[g_battalion_pool.live[k]];
+    if (mb.team_id == (uint32_t)team)
+      alive += mb.alive_count;
+  }
+  return alive;
+}
+
+static void pre_tick(flecs::world &ecs) { run_centroid_pass(ecs, nullptr); }
+
+int main(int argc, char **argv) {
+  ServerOptions o;
+  if (!parse_options(argc, argv, o)) {
+    log_error("Usage: musket_server [--ticks N] [--seed S] [--terrain SEED] "
+              "[--battalions N] [--soldiers N] [--bench]");
+    return 2;
+  }
+  std::signal(SIGINT, on_signal);
+  std::signal(SIGTERM, on_signal);
+
+  flecs::world ecs;
+  log_info("[MusketServer] Initializing ECS (%d workers)...",
+           shared_worker_pool().size());
+  SimCommandQueue *commands = init_sim_world(ecs);
+  ecs.get_mut<SimRng>().seed = o.seed;
+
+  if (o.terrain >= 0) {
+    TerrainParams params;
+    params.seed = (uint32_t)o.terrain;
+    VoxelGrid &grid = ecs.get_mut<VoxelGrid>();
+    const bool ok =
+        grid.generate_terrain(params, shared_worker_pool().size());
+    ecs.get_mut<TerrainHeightmap>().rebuild(grid);
+    if (!ok) {
+      log_error("[MusketServer] Terrain seed %u: chunk pool full",
+                params.seed);
+      return 1;
+    }
+  }
+
+  deploy_armies(ecs, *commands, o);
+  log_info("[MusketServer] Seed %u, %d battalions x %d soldiers per side, "
+           "%d Hz%s",
+           o.seed, o.battalions, o.soldiers, SIM_TICK_HZ,
+           o.bench ? " (bench)" : "");
+
+  // Fixed tick: advance_simulation banks real time and runs whole
+  // SIM_TICK_DT ticks (catching up when late); bench mode steps back to
+  // back. The sim sleeps between ticks, like the GDExtension's thread.
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point start = Clock::now();
+  Clock::time_point last = start, report = start;
+  int64_t ticks = 0, busy_ns = 0;
+  while (!g_stop.load() && (o.ticks <= 0 || ticks < o.ticks)) {
+    const Clock::time_point now = Clock::now();
+    if (o.bench) {
+      step_simulation(ecs, pre_tick);
+      ticks++;
+    } else {
+      const double dt = std::chrono::duration<double>(now - last).count();
+      ticks += advance_simulation(ecs, dt, pre_tick);
+    }
+    last = now;
+    busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   Clock::now() - now)
+                   .count();
+
+    if (Clock::now() - report >= std::chrono::seconds(10)) {
+      report = Clock::now();
+      log_info("[MusketServer] Tick %lld: alive %d vs %d, %.3f ms/tick",
+               (long long)ecs.get<SimClock>().tick, alive_in_team(0),
+               alive_in_team(1),
+               ticks > 0 ? (double)busy_ns * 1e-6 / (double)ticks : 0.0);
+    }
+    if (!o.bench) {
+      const double wait = SIM_TICK_DT - ecs.get<SimClock>().accumulator;
+      if (wait > 0.0)
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+    }
+  }
+
+  const double wall =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  log_info("[MusketServer] %lld ticks in %.2fs (%.3f ms/tick), alive %d vs "
+           "%d, world hash %016llx",
+           (long long)ticks, wall,
+           ticks > 0 ? (double)busy_ns * 1e-6 / (double)ticks : 0.0,
+           alive_in_team(0), alive_in_team(1),
+           (unsigned long long)world_state_hash(ecs));
+  release_sim_profiler(ecs);
+  release_sim_commands(ecs);
+  return 0;
+}
@@ -110,3 +110,230 @@ TEST_CASE_FIXTURE(EngineTestHarness, "Cat3: can_shoot=false prevents firing") {
 
   CHECK(get_ammo(shooter) == 60);
 }
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat3: Routing soldiers flee the nearest enemy battalion") {
+  auto router = spawn_soldier(0, 0.0f, 0.0f, 0);
+  router.add<Routing>();
+  // Keep panic above the recovery threshold so the rout holds
+  ecs.get_mut<PanicGrid>().read_buf[0][PanicGrid::world_to_idx(0, 0)] = 1.0f;
+
+  for (int i = 0; i < 10; i++) {
+    spawn_soldier(1, 100.0f + (float)i, 0.0f, 1);  // Near enemy, east
+    spawn_soldier(3, -400.0f - (float)i, 0.0f, 1); // Far enemy, west
+    spawn_soldier(2, 0.0f, 50.0f + (float)i, 0);   // Friends don't count
+  }
+  step(1);
+
+  const Velocity &v = router.get<Velocity>();
+  CHECK(v.vx < -4.9f); // Sprints west, away from battalion 1
+  CHECK(std::abs(v.vz) < 0.1f);
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat3: Flee field matches a brute-force nearest search") {
+  uint32_t rng = 12345u;
+  auto next = [&rng]() {
+    rng = rng * 1664525u + 1013904223u;
+    return (float)(rng >> 8) / 16777216.0f;
+  };
+  for (int b = 0; b < 60; b++) {
+    g_battalion_pool.claim(b);
+    g_macro_battalions[b].alive_count = 100;
+    g_macro_battalions[b].team_id = (uint32_t)(b % 2);
+    g_macro_battalions[b].cx = next() * 4000.0f - 2000.0f;
+    g_macro_battalions[b].cz = next() * 4000.0f - 2000.0f;
+  }
+  FleeField ff;
+  musket::build_flee_field(ff);
+
+  int wrong = 0;
+  float worst = 0.0f;
+  for (int t = 0; t < FleeField::TEAMS; t++) {
+    for (int c = 0; c < FleeField::CELLS; c++) {
+      float x = ((float)(c % FleeField::WIDTH) + 0.5f) * FleeField::CELL_SIZE -
+                2048.0f;
+      float z = ((float)(c / FleeField::WIDTH) + 0.5f) * FleeField::CELL_SIZE -
+                2048.0f;
+      float best = 1e30f;
+      for (int b = 0; b < 60; b++) {
+        if ((int)g_macro_battalions[b].team_id == t)
+          continue;
+        float dx = g_macro_battalions[b].cx - x;
+        float dz = g_macro_battalions[b].cz - z;
+        best = std::min(best, std::sqrt(dx * dx + dz * dz));
+      }
+      int got = ff.nearest[t][c];
+      if (got < 0 || (int)g_macro_battalions[got].team_id == t) {
+        wrong++; // Empty cell or a friendly battalion
+        continue;
+      }
+      float dx = g_macro_battalions[got].cx - x;
+      float dz = g_macro_battalions[got].cz - z;
+      float err = std::sqrt(dx * dx + dz * dz) - best;
+      if (err > 0.01f)
+        wrong++;
+      worst = std::max(worst, err);
+    }
+  }
+  MESSAGE("Flee field: ", wrong, " cells off, worst by ", worst, "m");
+  CHECK(wrong < FleeField::CELLS / 100); // JFA+1: well under 1% of cells
+  CHECK(worst < FleeField::CELL_SIZE);
+}
+
+// ═════════════════════════════════════════════════════════════
+// Category 3: COMBAT — Artillery Ballistics over Terrain
+// ═════════════════════════════════════════════════════════════
+
+// Artillery systems over a hand-shaped heightmap (no VoxelGrid needed:
+// ballistics only read the heightmap cache).
+struct ArtilleryTestWorld {
+  flecs::world ecs;
+
+  ArtilleryTestWorld() {
+    auto *pool = new ProjectilePool();
+    std::memset(pool, 0, sizeof(ProjectilePool));
+    ecs.set<ProjectilePool>(*pool);
+    delete pool;
+    TerrainHeightmap hm = {};
+    hm.allocate();
+    ecs.set<TerrainHeightmap>(hm);
+    musket::register_artillery_systems(ecs);
+  }
+  ~ArtilleryTestWorld() { ecs.get_mut<TerrainHeightmap>().release(); }
+
+  // Sets every column with world z <= wz_edge to height h
+  void raise_beyond(float wz_edge, uint8_t h) {
+    TerrainHeightmap &hm = ecs.get_mut<TerrainHeightmap>();
+    int edge = (int)(wz_edge + VOXEL_WORLD_OFFSET);
+    for (int z = 0; z <= edge; z++)
+      std::memset(hm.height + z * HEIGHTMAP_WIDTH, h, HEIGHTMAP_WIDTH);
+  }
+
+  // Uniform slope toward -z: 0 at wz_foot, rising `grade` per metre
+  void slope_from(float wz_foot, float grade) {
+    TerrainHeightmap &hm = ecs.get_mut<TerrainHeightmap>();
+    int foot = (int)(wz_foot + VOXEL_WORLD_OFFSET);
+    for (int z = 0; z < foot; z++) {
+      float h = (float)(foot - z) * grade;
+      std::memset(hm.height + z * HEIGHTMAP_WIDTH,
+                  (int)(h > 128.0f ? 128.0f : h), HEIGHTMAP_WIDTH);
+    }
+  }
+};
+
+TEST_CASE("Cat3: Battery solves elevation up a slope to a raised target") {
+  ArtilleryTestWorld tw;
+  // Ground rises 1:8 from 100m out; the target sits 25m up at 300m.
+  // A flat-ground solver would bury every ball in the slope near 130m.
+  tw.slope_from(-100.0f, 0.125f);
+  tw.ecs.entity()
+      .set<Position>({0.0f, 0.0f})
+      .set<ArtilleryBattery>({4, 0.0f, 0.0f, 10, 0, false, 0.0f})
+      .set<FireOrder>({0.0f, -300.0f})
+      .set<TeamId>({0});
+
+  tw.ecs.progress(1.0f / 60.0f);
+  const ProjectilePool &pool = tw.ecs.get<ProjectilePool>();
+  REQUIRE(pool.count == 4);
+
+  // Each ball's first graze is on the slope near the target
+  const TerrainHeightmap &hm = tw.ecs.get<TerrainHeightmap>();
+  for (int i = 0; i < pool.count; i++) {
+    ArtilleryShot shot = {pool.x[i],  pool.y[i],  pool.z[i],
+                          pool.vx[i], pool.vy[i], pool.vz[i],
+                          pool.kinetic_energy[i], AMMO_ROUNDSHOT, true};
+    musket::BallisticGraze graze[4];
+    int n = musket::predict_grazes(&hm, shot, 1.0f / 60.0f, graze, 4);
+    REQUIRE(n >= 1);
+    CHECK(graze[0].z < -290.0f);
+    CHECK(graze[0].z > -320.0f);
+  }
+}
+
+TEST_CASE("Cat3: Predicted ricochet grazes match the simulated ball") {
+  ArtilleryTestWorld tw;
+  tw.raise_beyond(-120.0f, 6);
+  ProjectilePool &pool = tw.ecs.get_mut<ProjectilePool>();
+  ArtilleryShot shot = {0.0f, 1.0f, 0.0f, 0.0f, 12.0f, -180.0f,
+                        10.0f, AMMO_ROUNDSHOT, true};
+  pool.spawn(shot, 0);
+
+  constexpr float DT = 1.0f / 60.0f;
+  musket::BallisticGraze predicted[8];
+  int n = musket::predict_grazes(&tw.ecs.get<TerrainHeightmap>(), shot, DT,
+                                 predicted, 8);
+  REQUIRE(n >= 2);
+
+  // Simulate: a graze is a frame where the ball's vertical velocity
+  // flips upward (the ground system bounced it)
+  int seen = 0;
+  for (int f = 0; f < 60 * 30 && seen < n; f++) {
+    const ProjectilePool &p = tw.ecs.get<ProjectilePool>();
+    if (p.count == 0)
+      break;
+    float vy_before = p.vy[0];
+    tw.ecs.progress(DT);
+    const ProjectilePool &after = tw.ecs.get<ProjectilePool>();
+    if (after.count == 0 || !after.active[0] ||
+        (vy_before < 0.0f && after.vy[0] > 0.0f)) {
+      if (after.count == 0)
+        break;
+      CHECK(after.x[0] == doctest::Approx(predicted[seen].x).epsilon(1e-3));
+      CHECK(after.z[0] == doctest::Approx(predicted[seen].z).epsilon(1e-3));
+      seen++;
+    }
+  }
+  CHECK(seen == n);
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat3: Canister cone strikes front ranks first, repeatably") {
+  // Enemy line 3 ranks deep, 40m north; a second line past the cone's
+  // range; one friendly file inside the cone
+  for (int f = 0; f < 40; f++) {
+    for (int r = 0; r < 3; r++)
+      spawn_soldier(1, (float)(f - 20) * 0.8f, -40.0f - (float)r * 1.2f, 1);
+    spawn_soldier(3, (float)(f - 20) * 0.8f, -200.0f, 1);
+  }
+  for (int k = 0; k < 10; k++)
+    spawn_soldier(2, 0.0f, -10.0f - (float)k, 0);
+  step(1); // Build the spatial hash
+
+  const SpatialHashGrid &grid = ecs.get<SpatialHashGrid>();
+  uint64_t hits[256], again[256];
+  // Two guns: a budget of 20 lethal balls, fewer than the men in the cone
+  const uint64_t key = sim_rng_key(1805, RNG_STREAM_CANISTER);
+  int n = musket::fire_canister(grid, 0.0f, 0.0f, 0.0f, -1.0f, 0, 2, 7, key,
+                                42, hits, 256);
+  int m = musket::fire_canister(grid, 0.0f, 0.0f, 0.0f, -1.0f, 0, 2, 7, key,
+                                42, again, 256);
+  REQUIRE(n > 0);
+  CHECK(n <= 20);
+  REQUIRE(m == n);
+
+  // A second battery on the same tick rolls its own dice
+  uint64_t other[256];
+  int o = musket::fire_canister(grid, 0.0f, 0.0f, 0.0f, -1.0f, 0, 2, 8, key,
+                                42, other, 256);
+  bool differs = o != n;
+  for (int h = 0; h < n && h < o && !differs; h++)
+    differs = other[h] != hits[h];
+  CHECK(differs);
+
+  int per_rank[3] = {0, 0, 0};
+  for (int h = 0; h < n; h++) {
+    CHECK(hits[h] == again[h]);
+    flecs::entity te = ecs.entity(hits[h]);
+    CHECK(te.get<TeamId>().team == 1);
+    const Position &p = te.get<Position>();
+    CHECK(p.z > -100.0f); // Nothing past the cone's range
+    CHECK(std::abs(p.x) <= -p.z * 0.1f + 0.5f);
+    per_rank[(int)((-40.0f - p.z) / 1.2f + 0.5f)]++;
+  }
+  MESSAGE("Canister hits per rank: ", per_rank[0], " ", per_rank[1], " ",
+          per_rank[2]);
+  CHECK(per_rank[0] > per_rank[2]); // Front ranks soak the balls
+  CHECK(per_rank[0] >= per_rank[1]);
+  CHECK(per_rank[1] >= per_rank[2]);
+}
@@ -0,0 +1,117 @@
+// ═════════════════════════════════════════════════════════════
+// Category 2: FORMATION GEOMETRY — layout + slot matching
+// ═════════════════════════════════════════════════════════════
+#include <set>
+#include <utility>
+
+// Queue a re-form and service it, as order_formation/order_wheel would
+static void reform(flecs::world &ecs, int bat, FormationShape shape,
+                   float dir_x = 0.0f, float dir_z = -1.0f) {
+  ecs.get_mut<FormationRoster>().request(bat, shape, dir_x, dir_z);
+  ecs.system(ecs.lookup("FormationSolveSystem")).run(1.0f / 60.0f);
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat2: Line re-forms into ceil(N/3) files on unique slots") {
+  // 100 soldiers in a 10×10 blob
+  for (int i = 0; i < 100; i++)
+    spawn_armed_soldier(0, (float)(i % 10) * 1.5f, (float)(i / 10) * 1.5f);
+  reform(ecs, 0, SHAPE_COLUMN); // Something other than the spawn line
+  reform(ecs, 0, SHAPE_LINE);
+
+  const auto &mb = g_macro_battalions[0];
+  CHECK(mb.shape == SHAPE_LINE);
+  CHECK(mb.anchor_x == doctest::Approx(6.75)); // Live centroid
+  CHECK(mb.anchor_z == doctest::Approx(6.75));
+  CHECK(mb.ext_w == doctest::Approx(34 * 0.8f / 2.0f + 2.0f));
+  CHECK(mb.ext_d == doctest::Approx(3 * 1.2f / 2.0f + 2.0f));
+
+  std::set<std::pair<int, int>> slots;
+  std::set<int> files;
+  ecs.each([&](const SoldierFormationTarget &t, const FormationDefense &fd) {
+    int sx = (int)std::lround(t.offset_x * 10.0f);
+    int sz = (int)std::lround(t.offset_z * 10.0f);
+    slots.insert({sx, sz});
+    files.insert(sx);
+    CHECK(t.rank_index < 3);
+    CHECK(t.can_shoot);
+    CHECK(fd.defense == doctest::Approx(0.2f));
+  });
+  CHECK(slots.size() == 100);
+  CHECK(files.size() == 34);
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat2: Column and square fire only from the outer rank") {
+  for (int i = 0; i < 96; i++)
+    spawn_armed_soldier(0, (float)(i / 3) * 0.8f, (float)(i % 3) * 1.2f,
+                        (uint8_t)(i % 3));
+
+  SUBCASE("Column: 16 wide, front rank only") {
+    reform(ecs, 0, SHAPE_COLUMN);
+    int shooters = 0;
+    ecs.each([&](const SoldierFormationTarget &t) {
+      CHECK(t.can_shoot == (t.rank_index == 0));
+      shooters += t.can_shoot ? 1 : 0;
+    });
+    CHECK(shooters == 16);
+  }
+
+  SUBCASE("Square: four faces, outermost rank, unit facings") {
+    reform(ecs, 0, SHAPE_SQUARE, 1.0f, 0.0f); // Square facing +X
+    const auto &mb = g_macro_battalions[0];
+    int per_face[4] = {};
+    ecs.each([&](const SoldierFormationTarget &t, const FormationDefense &fd) {
+      CHECK(fd.defense == doctest::Approx(0.9f));
+      float fx, fz;
+      battalion_to_world(t.face_dir_x(), t.face_dir_z(), mb.dir_x, mb.dir_z,
+                         fx, fz);
+      CHECK(fx * fx + fz * fz == doctest::Approx(1.0f).epsilon(1e-3));
+      // Every face points away from the square's centre
+      float ox, oz;
+      battalion_to_world(t.offset_x, t.offset_z, mb.dir_x, mb.dir_z, ox, oz);
+      CHECK(ox * fx + oz * fz > 0.0f);
+      if (t.can_shoot) {
+        CHECK(t.rank_index == 0);
+        int face = t.face_dir_z() < -0.5f  ? 0
+                   : t.face_dir_x() > 0.5f ? 1
+                   : t.face_dir_z() > 0.5f ? 2
+                                           : 3;
+        per_face[face]++;
+      }
+    });
+    for (int f = 0; f < 4; f++)
+      CHECK(per_face[f] == 8); // 24 per side, every 3rd in the outer rank
+  }
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat2: About-face matches nearest slots instead of crossing "
+                  "files") {
+  // 30 files × 3 ranks, exactly on their line slots
+  for (int i = 0; i < 90; i++)
+    spawn_armed_soldier(0, (float)(i / 3 - 15) * 0.8f, (float)(i % 3) * 1.2f,
+                        (uint8_t)(i % 3));
+
+  reform(ecs, 0, SHAPE_LINE, 0.0f, 1.0f); // Face +Z: the frame flips
+
+  // Index-order assignment (the old running index) sends each file to
+  // the opposite flank; nearest-slot matching barely moves anyone.
+  const auto &roster = ecs.get<FormationRoster>();
+  int base = roster.bat_start[0];
+  float greedy = 0.0f, index_order = 0.0f, worst = 0.0f;
+  std::set<int> taken;
+  for (int m = base; m < base + 90; m++) {
+    int s = roster.assigned[m];
+    taken.insert(s);
+    float d = std::hypot(roster.slot_x[s] - roster.member_x[m],
+                         roster.slot_z[s] - roster.member_z[m]);
+    greedy += d;
+    worst = std::max(worst, d);
+    index_order += std::hypot(roster.slot_x[m] - roster.member_x[m],
+                              roster.slot_z[m] - roster.member_z[m]);
+  }
+  CHECK(taken.size() == 90);
+  CHECK(worst < 2.5f); // At most a rank-depth shuffle
+  CHECK(greedy * 10.0f < index_order);
+}
@@ -13,16 +13,21 @@
 // Forward-declare the extern globals (defined in test_master.cpp)
 extern MacroBattalion g_macro_battalions[MAX_BATTALIONS];
 extern PendingOrder g_pending_orders[MAX_BATTALIONS];
+extern BattalionPool g_battalion_pool;
 
 // ── Minimal centroid pass (pure ECS, no Godot print) ────────
 // This is the test-only version of compute_battalion_centroids.
 // It replicates the production logic from world_manager.cpp
 // without any UtilityFunctions::print calls.
 static void test_compute_centroids(flecs::world &ecs) {
-  float dt = ecs.get_info()->delta_time;
+  // Runs once per fixed tick. Not the world's last delta: that is 0 on
+  // a fresh or just-restored world.
+  const float dt = (float)SIM_TICK_DT;
+  const BattalionPool &pool = g_battalion_pool;
 
   // 1. Zero transients (Trap 23: preserve persistent fields)
-  for (int i = 0; i < MAX_BATTALIONS; i++) {
+  for (int k = 0; k < pool.live_count; k++) {
+    const int i = pool.live[k];
     g_macro_battalions[i].cx = 0.0f;
     g_macro_battalions[i].cz = 0.0f;
     g_macro_battalions[i].alive_count = 0;
@@ -51,7 +56,8 @@ static void test_compute_centroids(flecs::world &ecs) {
   });
 
   // 3. Finalize
-  for (int i = 0; i < MAX_BATTALIONS; i++) {
+  for (int k = 0; k < pool.live_count; k++) {
+    const int i = pool.live[k];
     auto &mb = g_macro_battalions[i];
     if (mb.alive_count > 0 && mb.alive_count < 10) {
       mb.flag_alive = mb.drummer_alive = mb.officer_alive = false;
@@ -86,7 +92,8 @@ static void test_compute_centroids(flecs::world &ecs) {
       // Hoisted targeting
       mb.target_bat_id = -1;
       float best_dist = 1e18f;
-      for (int j = 0; j < MAX_BATTALIONS; j++) {
+      for (int kj = 0; kj < pool.live_count; kj++) {
+        const int j = pool.live[kj];
         auto &enemy = g_macro_battalions[j];
         if (enemy.alive_count == 0 || enemy.team_id == mb.team_id)
           continue;
@@ -118,6 +125,13 @@ static void test_compute_centroids(flecs::world &ecs) {
       }
     }
   }
+
+  // 4. Reclaim emptied battalions (no shadow buffers headless)
+  for (int k = pool.live_count - 1; k >= 0; k--) {
+    const int i = pool.live[k];
+    if (g_macro_battalions[i].alive_count == 0)
+      release_battalion(i);
+  }
 }
 
 // ── RAII Test Fixture ───────────────────────────────────────
@@ -128,6 +142,7 @@ struct EngineTestHarness {
     // 1. NUKE all global state
     std::memset(g_macro_battalions, 0, sizeof(g_macro_battalions));
     std::memset(g_pending_orders, 0, sizeof(g_pending_orders));
+    g_battalion_pool.reset();
 
     // 2. Restore persistent invariants
     for (int i = 0; i < MAX_BATTALIONS; ++i) {
@@ -138,7 +153,27 @@ struct EngineTestHarness {
     }
 
     // 3. Register all ECS systems
+    // Fixed-step clock + group rate sources (same as init_ecs)
+    musket::register_sim_clock(ecs);
+    // M7.5 formation roster (heap-built: ~5MB, same as init_ecs)
+    {
+      auto *roster = new FormationRoster();
+      std::memset(roster, 0, sizeof(FormationRoster));
+      std::memset(roster->pending_shape, -1, sizeof(roster->pending_shape));
+      ecs.set<FormationRoster>(*roster);
+      delete roster;
+    }
     musket::register_movement_systems(ecs);
+
+    // M8 spatial hash singleton (heap-allocated: 4.2MB, same as init_ecs)
+    {
+      auto *shg = new SpatialHashGrid();
+      std::memset(shg, 0, sizeof(SpatialHashGrid));
+      std::memset(shg->cell_head, -1, sizeof(shg->cell_head));
+      std::memset(shg->bat_head, -1, sizeof(shg->bat_head));
+      ecs.set<SpatialHashGrid>(*shg);
+      delete shg;
+    }
     musket::register_combat_systems(ecs);
     musket::register_panic_systems(ecs);
 
@@ -146,6 +181,10 @@ struct EngineTestHarness {
     PanicGrid pg = {};
     std::memset(&pg, 0, sizeof(pg));
     ecs.set<PanicGrid>(pg);
+    FleeField ff;
+    std::memset(ff.nearest, -1, sizeof(ff.nearest));
+    ecs.set<FleeField>(ff);
+    ecs.set<SimRng>({1805});
   }
 
   // Deterministic frame stepping
@@ -161,6 +200,7 @@ struct EngineTestHarness {
                               uint8_t team = 255) {
     if (team == 255)
       team = (uint8_t)(bat_id % 2);
+    g_battalion_pool.claim((int)bat_id);
     return ecs.entity()
         .set<Position>({x, z})
         .set<Velocity>({0.0f, 0.0f})
@@ -175,11 +215,13 @@ struct EngineTestHarness {
   flecs::entity spawn_armed_soldier(uint32_t bat_id, float x, float z,
                                     uint8_t rank = 0) {
     uint8_t team = (uint8_t)(bat_id % 2);
+    g_battalion_pool.claim((int)bat_id);
     return ecs.entity()
         .set<Position>({x, z})
         .set<Velocity>({0.0f, 0.0f})
         .set<SoldierFormationTarget>(
-            {(double)x, (double)z, 50.0f, 2.0f, 0.0f, -1.0f, true, rank, {}})
+            {x, z, 50.0f, 2.0f, face_snorm(0.0f), face_snorm(-1.0f), true,
+             rank, {}})
         .set<MusketState>({0.0f, 60, 0}) // Loaded, 60 ammo
         .set<BattalionId>({bat_id})
         .set<TeamId>({team})
@@ -3,9 +3,9 @@
 // ═════════════════════════════════════════════════════════════
 
 TEST_CASE("Cat1: Component Memory Layout") {
-  SUBCASE("SoldierFormationTarget is exactly 1 cache line") {
-    CHECK(sizeof(SoldierFormationTarget) == 64);
-    CHECK(alignof(SoldierFormationTarget) == 64);
+  SUBCASE("SoldierFormationTarget packs 8 soldiers per 3 cache lines") {
+    CHECK(sizeof(SoldierFormationTarget) == 24);
+    CHECK(alignof(SoldierFormationTarget) == 4);
   }
 
   SUBCASE("MacroBattalion fits in 2 cache lines") {
@@ -13,6 +13,133 @@ TEST_CASE("Cat1: Component Memory Layout") {
   }
 }
 
+TEST_CASE("Cat1: Sim RNG is a pure function of its counter") {
+  const uint64_t key = sim_rng_key(1805, RNG_STREAM_VOLLEY);
+  uint64_t ids[64];
+  for (int i = 0; i < 64; i++)
+    ids[i] = 600 + (uint64_t)i * 3;
+
+  float batch[64], reversed[64];
+  sim_rand_batch(key, 9, ids, 64, batch);
+  std::reverse(ids, ids + 64);
+  sim_rand_batch(key, 9, ids, 64, reversed);
+
+  double mean = 0.0;
+  for (int i = 0; i < 64; i++) {
+    // Visit order doesn't matter: entity i gets the same roll either way
+    CHECK(batch[i] == reversed[63 - i]);
+    CHECK(batch[i] == sim_rand_unit(key, sim_rng_counter(9, ids[63 - i])));
+    CHECK(batch[i] >= 0.0f);
+    CHECK(batch[i] < 1.0f);
+    mean += batch[i];
+  }
+  CHECK(mean / 64.0 == doctest::Approx(0.5).epsilon(0.2));
+
+  // Another tick, stream or seed gives another roll
+  const uint64_t e = 600;
+  float r = sim_rand_unit(key, sim_rng_counter(9, e));
+  CHECK(r != sim_rand_unit(key, sim_rng_counter(10, e)));
+  CHECK(r != sim_rand_unit(sim_rng_key(1805, RNG_STREAM_CANISTER),
+                           sim_rng_counter(9, e)));
+  CHECK(r != sim_rand_unit(sim_rng_key(1806, RNG_STREAM_VOLLEY),
+                           sim_rng_counter(9, e)));
+}
+
+TEST_CASE("Cat1: SimClock banks real time into whole ticks") {
+  SimClock clock = {};
+  clock.max_catchup = 4;
+
+  SUBCASE("Sixty 60Hz frames are sixty ticks") {
+    int steps = 0;
+    for (int f = 0; f < 60; f++)
+      steps += clock.bank(1.0 / 60.0);
+    CHECK(steps == 60);
+    CHECK(clock.alpha < 1e-6);
+  }
+
+  SUBCASE("A 144Hz render rate leaves a fractional alpha") {
+    int steps = 0;
+    for (int f = 0; f < 144; f++)
+      steps += clock.bank(1.0 / 144.0);
+    CHECK(steps == 60);
+    CHECK(clock.bank(1.0 / 144.0) == 0);
+    CHECK(clock.alpha == doctest::Approx(60.0 / 144.0));
+  }
+
+  SUBCASE("A hitch runs max_catchup ticks and drops the rest") {
+    CHECK(clock.bank(1.0) == 4);
+    CHECK(clock.dropped_ticks == 56);
+    CHECK(clock.bank(1.0 / 60.0) == 1); // No spiral: debt was discarded
+  }
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat1: Fixed-step clock ticks once per progress") {
+  CHECK(musket::advance_simulation(ecs, 1.0 / 30.0, nullptr) == 2);
+  CHECK(ecs.get<SimClock>().tick == 2);
+  CHECK(musket::advance_simulation(ecs, 1.0 / 120.0, nullptr) == 0);
+  CHECK(ecs.get<SimClock>().tick == 2);
+  CHECK(musket::advance_simulation(ecs, 1.0 / 120.0, nullptr) == 1);
+  CHECK(ecs.get<SimClock>().tick == 3);
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat1: Panic CA runs on its group rate, not every tick") {
+  constexpr int IDX = 32 * PanicGrid::WIDTH + 32;
+  ecs.get_mut<PanicGrid>().read_buf[0][IDX] = 1.0f;
+
+  // 5Hz of 60Hz: one diffusion pass per 12 ticks, 2 passes in 24
+  int passes = 0;
+  float last = 1.0f;
+  for (int t = 0; t < 24; t++) {
+    musket::advance_simulation(ecs, SIM_TICK_DT, nullptr);
+    float now = ecs.get<PanicGrid>().read_buf[0][IDX];
+    if (now != last)
+      passes++;
+    last = now;
+  }
+  CHECK(passes == 2);
+  CHECK(last == doctest::Approx(0.95f * 0.95f).epsilon(1e-3));
+
+  SUBCASE("Retuning the group rate changes the pass count") {
+    musket::set_sim_group_rate(ecs, SIM_GROUP_CA, 10);
+    CHECK(ecs.get<SimClock>().group_hz[SIM_GROUP_CA] == 10);
+    passes = 0;
+    for (int t = 0; t < 24; t++) {
+      musket::advance_simulation(ecs, SIM_TICK_DT, nullptr);
+      float now = ecs.get<PanicGrid>().read_buf[0][IDX];
+      if (now != last)
+        passes++;
+      last = now;
+    }
+    CHECK(passes == 4);
+  }
+}
+
+TEST_CASE("Cat1: Same seed replays the same volley casualties") {
+  auto battle = [](uint64_t seed) {
+    EngineTestHarness h;
+    h.ecs.get_mut<SimRng>().seed = seed;
+    std::vector<flecs::entity> men;
+    for (int i = 0; i < 20; i++) {
+      men.push_back(h.spawn_armed_soldier(0, (float)i * 0.8f, 0.0f, 0));
+      men.push_back(h.spawn_armed_soldier(1, (float)i * 0.8f, -50.0f, 0));
+    }
+    // Officers keep full range and accuracy
+    h.spawn_soldier(0, 8.0f, 2.0f, 0).add<ElevatedLOS>();
+    h.spawn_soldier(1, 8.0f, -52.0f, 1).add<ElevatedLOS>();
+    h.step(600);
+    std::vector<int> alive;
+    for (flecs::entity e : men)
+      alive.push_back(e.has<IsAlive>() ? 1 : 0);
+    return alive;
+  };
+  std::vector<int> a = battle(7), b = battle(7), c = battle(8);
+  REQUIRE(std::count(a.begin(), a.end(), 0) > 0); // Someone was hit
+  CHECK(a == b);
+  CHECK(a != c);
+}
+
 TEST_CASE_FIXTURE(EngineTestHarness,
                   "Cat1: Trap 23 - Centroid preserves persistent data") {
   // Set persistent fields to non-default values
@@ -98,3 +225,766 @@ TEST_CASE_FIXTURE(EngineTestHarness,
   // Centroid should shift toward 0.0 (remaining soldiers mostly at 0 and 50)
   CHECK(g_macro_battalions[0].cx < 100.0f);
 }
+
+TEST_CASE("Cat1: Battalion pool hands out ids lowest-first") {
+  BattalionPool &pool = g_battalion_pool;
+  pool.reset();
+  CHECK(pool.acquire() == 0);
+  CHECK(pool.acquire() == 1);
+  CHECK(pool.acquire() == 2);
+  CHECK(pool.claim(3000));
+  pool.release(1);
+  CHECK(pool.live_count == 3);
+  CHECK(pool.live[0] == 0);
+  CHECK(pool.live[1] == 2);
+  CHECK(pool.live[2] == 3000); // Ascending: stable iteration order
+  CHECK(pool.acquire() == 1);  // Recycled
+  CHECK(pool.live[1] == 1);
+  CHECK_FALSE(pool.claim(MAX_BATTALIONS));
+  pool.reset();
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat1: Battalions past 255 keep their own state") {
+  // 7 and 263 aliased under the old 256-slot modulo
+  for (int i = 0; i < 12; i++) {
+    spawn_soldier(7, (float)i, 0.0f, 0);
+    spawn_soldier(263, (float)i, 500.0f, 1);
+  }
+  step(1);
+  CHECK(g_macro_battalions[7].alive_count == 12);
+  CHECK(g_macro_battalions[263].alive_count == 12);
+  CHECK(g_macro_battalions[7].cz == doctest::Approx(0.0f));
+  CHECK(g_macro_battalions[263].cz == doctest::Approx(500.0f));
+  CHECK(g_macro_battalions[7].target_bat_id == 263);
+  CHECK(g_battalion_pool.live_count == 2);
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat1: Emptied battalions are reclaimed") {
+  std::vector<flecs::entity> men;
+  for (int i = 0; i < 12; i++) {
+    men.push_back(spawn_soldier(2, (float)i, 0.0f, 0));
+    spawn_soldier(5, (float)i, 50.0f, 1);
+  }
+  g_macro_battalions[2].flag_cohesion = 0.5f;
+  g_pending_orders[2].type = ORDER_FIRE;
+  g_pending_orders[2].delay = 10.0f;
+  step(1);
+  REQUIRE(g_battalion_pool.is_live[2]);
+
+  ecs.defer_begin();
+  for (flecs::entity e : men)
+    e.remove<IsAlive>();
+  ecs.defer_end();
+  step(1);
+
+  CHECK_FALSE(g_battalion_pool.is_live[2]);
+  CHECK(g_battalion_pool.live_count == 1);
+  CHECK(g_battalion_pool.live[0] == 5);
+  // The id comes back clean: no stale cohesion or queued order
+  CHECK(g_macro_battalions[2].flag_cohesion == 1.0f);
+  CHECK(g_pending_orders[2].type == ORDER_NONE);
+  CHECK(g_battalion_pool.acquire() == 0);
+  CHECK(g_battalion_pool.acquire() == 1);
+  CHECK(g_battalion_pool.acquire() == 2);
+}
+
+// Per-entity spring-damper exactly as written before the archetype split
+// (std::exp decay, per-soldier component probes).
+static void reference_spring_step(Position &p, Velocity &v,
+                                  const SoldierFormationTarget &t,
+                                  uint32_t bat_id, bool routing, float dt) {
+  float stiffness =
+      t.base_stiffness * g_macro_battalions[bat_id].flag_cohesion;
+  if (routing)
+    stiffness = 0.0f;
+  float damping = t.damping_multiplier * std::sqrt(stiffness);
+  const MacroBattalion &mb = g_macro_battalions[bat_id];
+  float gx, gz;
+  battalion_to_world(t.offset_x, t.offset_z, mb.dir_x, mb.dir_z, gx, gz);
+  v.vx += (stiffness * (((float)mb.anchor_x + gx) - p.x)) * dt;
+  v.vz += (stiffness * (((float)mb.anchor_z + gz) - p.z)) * dt;
+  float decay = std::exp(-damping * dt);
+  v.vx *= decay;
+  v.vz *= decay;
+  float speed_sq = v.vx * v.vx + v.vz * v.vz;
+  if (speed_sq > 16.0f) {
+    float inv = 4.0f / std::sqrt(speed_sq);
+    v.vx *= inv;
+    v.vz *= inv;
+  }
+  p.x += v.vx * dt;
+  p.z += v.vz * dt;
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat1: Archetype-split spring-damper matches per-entity "
+                  "integrator") {
+  g_macro_battalions[0].flag_cohesion = 0.6f;
+  g_macro_battalions[2].flag_cohesion = 0.9f;
+  g_macro_battalions[0].anchor_x = 4.0;
+  g_macro_battalions[2].anchor_z = -1.5;
+  g_macro_battalions[0].dir_x = 0.6f; // Wheeled line
+  g_macro_battalions[0].dir_z = -0.8f;
+
+  struct Probe {
+    flecs::entity e;
+    Position p;
+    Velocity v;
+    SoldierFormationTarget t;
+    uint32_t bat;
+    bool routing, frozen;
+  };
+  std::vector<Probe> probes;
+  auto add = [&](uint32_t bat, float x, float stiff, float vx, bool routing,
+                 int cav_state) {
+    const MacroBattalion &mb = g_macro_battalions[bat];
+    SoldierFormationTarget t = {x + 3.0f - (float)mb.anchor_x,
+                                -2.0f - (float)mb.anchor_z,
+                                stiff,
+                                2.0f,
+                                face_snorm(0.0f),
+                                face_snorm(-1.0f),
+                                true,
+                                0,
+                                {}};
+    auto e = spawn_soldier(bat, x, 0.0f).set<SoldierFormationTarget>(t);
+    e.set<Velocity>({vx, 0.0f});
+    if (routing)
+      e.add<Routing>();
+    if (cav_state >= 0)
+      e.set<CavalryState>({0.0f, 0.0f, 0.0f, 0.0f, (uint32_t)cav_state, 0});
+    probes.push_back({e, {x, 0.0f}, {vx, 0.0f}, t, bat, routing,
+                      cav_state > 0});
+  };
+  for (int i = 0; i < 30; i++) // Line, panic-scaled stiffness
+    add(0, (float)i, 50.0f - (float)(i % 3) * 20.0f, 0.0f, false, -1);
+  for (int i = 0; i < 10; i++) // Routing infantry, over the speed clamp
+    add(1, (float)i, 0.0f, 5.0f + (float)i, true, -1);
+  for (int i = 0; i < 5; i++) // Cavalry at the walk
+    add(2, (float)i, 50.0f, 0.0f, false, 0);
+  for (int i = 0; i < 5; i++) // Charging cavalry: not the spring's job
+    add(2, (float)i, 50.0f, 9.0f, false, 1);
+  for (int i = 0; i < 3; i++) // Routing cavalry at the walk
+    add(3, (float)i, 0.0f, 6.0f, true, 0);
+
+  constexpr float DT = 1.0f / 60.0f;
+  flecs::system systems[] = {
+      ecs.system(ecs.lookup("SpringDamperPhysics")),
+      ecs.system(ecs.lookup("SpringDamperRouting")),
+      ecs.system(ecs.lookup("SpringDamperCavalry"))};
+  for (int f = 0; f < 120; f++) {
+    for (auto &s : systems)
+      s.run(DT);
+    for (auto &pr : probes)
+      if (!pr.frozen)
+        reference_spring_step(pr.p, pr.v, pr.t, pr.bat, pr.routing, DT);
+  }
+
+  for (auto &pr : probes) {
+    const Position &p = pr.e.get<Position>();
+    CHECK(p.x == doctest::Approx(pr.p.x).epsilon(1e-3));
+    CHECK(p.z == doctest::Approx(pr.p.z).epsilon(1e-3));
+  }
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat1: Moving the anchor carries every slot with it") {
+  // Offsets are battalion-relative: shifting the double anchor is the only
+  // write needed to relocate the whole formation.
+  for (int i = 0; i < 30; i++)
+    spawn_armed_soldier(0, (float)(i / 3) * 0.8f, (float)(i % 3) * 1.2f,
+                        (uint8_t)(i % 3));
+  g_macro_battalions[0].anchor_x = 5.0;
+  g_macro_battalions[0].anchor_z = -3.0;
+
+  flecs::system spring = ecs.system(ecs.lookup("SpringDamperPhysics"));
+  for (int f = 0; f < 600; f++)
+    spring.run(1.0f / 60.0f);
+
+  ecs.each([](const Position &p, const SoldierFormationTarget &t) {
+    CHECK(p.x == doctest::Approx(5.0f + t.offset_x).epsilon(0.01));
+    CHECK(p.z == doctest::Approx(-3.0f + t.offset_z).epsilon(0.01));
+  });
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat1: March moves the battalion anchor, not its soldiers") {
+  // 60-man line, 20 files × 3 ranks, facing -Z at the origin
+  for (int i = 0; i < 60; i++)
+    spawn_armed_soldier(0, (float)(i / 3 - 10) * 0.8f, (float)(i % 3) * 1.2f,
+                        (uint8_t)(i % 3));
+  auto &mb = g_macro_battalions[0];
+  mb.ext_w = 10.0f;
+  mb.march_x = 30.0;
+  mb.march_z = 0.0;
+  mb.marching = true;
+
+  flecs::table table_before;
+  ecs.each([&](flecs::entity e, const SoldierFormationTarget &) {
+    table_before = e.table();
+  });
+  std::vector<SoldierFormationTarget> slots_before;
+  ecs.each([&](const SoldierFormationTarget &t) { slots_before.push_back(t); });
+
+  flecs::system march = ecs.system(ecs.lookup("BattalionMarchSystem"));
+  flecs::system spring = ecs.system(ecs.lookup("SpringDamperPhysics"));
+  for (int f = 0; f < 60 * 20; f++) { // 20s at 3 m/s covers the 30m
+    march.run(1.0f / 60.0f);
+    spring.run(1.0f / 60.0f);
+  }
+
+  SUBCASE("The anchor arrives and the line wheels to the heading") {
+    CHECK_FALSE(mb.marching);
+    CHECK(mb.anchor_x == doctest::Approx(30.0));
+    CHECK(mb.anchor_z == doctest::Approx(0.0));
+    CHECK(mb.dir_x == doctest::Approx(1.0f).epsilon(1e-3));
+    CHECK(mb.dir_z == doctest::Approx(0.0f).epsilon(1e-3));
+  }
+
+  SUBCASE("Soldiers keep their slots and archetype") {
+    size_t k = 0;
+    ecs.each([&](flecs::entity e, const Position &p,
+                 const SoldierFormationTarget &t) {
+      CHECK(e.table() == table_before);
+      CHECK(t.offset_x == slots_before[k].offset_x);
+      CHECK(t.offset_z == slots_before[k].offset_z);
+      k++;
+      float gx, gz;
+      battalion_to_world(t.offset_x, t.offset_z, mb.dir_x, mb.dir_z, gx, gz);
+      CHECK(p.x == doctest::Approx(30.0f + gx).epsilon(0.01));
+      CHECK(p.z == doctest::Approx(gz).epsilon(0.01));
+    });
+    CHECK(k == 60);
+  }
+}
+
+TEST_CASE("Cat1: Command ring delivers every push once, in push order") {
+  auto *q = new musket::SimCommandQueue();
+
+  SUBCASE("A full ring refuses and counts the drop") {
+    musket::SimCommand c = {musket::CMD_MARCH, {}, 0, 0, 0.0f, 0.0f};
+    for (uint32_t i = 0; i < musket::SIM_COMMAND_CAPACITY; i++)
+      REQUIRE(q->push(c));
+    CHECK_FALSE(q->push(c));
+    CHECK(q->dropped.load() == 1);
+    musket::SimCommand out;
+    CHECK(q->pop(out));
+    CHECK(q->push(c)); // One cell free again
+  }
+
+  SUBCASE("Concurrent producers, draining consumer") {
+    constexpr int PRODUCERS = 4;
+    constexpr int EACH = 20000;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++)
+      producers.emplace_back([q, p] {
+        for (int i = 0; i < EACH; i++) {
+          musket::SimCommand c = {musket::CMD_WHEEL, {}, p, i, 0.0f, 0.0f};
+          while (!q->push(c))
+            std::this_thread::yield(); // Consumer is a ring behind
+        }
+      });
+
+    int next[PRODUCERS] = {};
+    int received = 0;
+    bool ordered = true;
+    musket::SimCommand c;
+    while (received < PRODUCERS * EACH) {
+      if (!q->pop(c)) {
+        std::this_thread::yield();
+        continue;
+      }
+      ordered &= c.arg == next[c.target]++;
+      received++;
+    }
+    for (std::thread &t : producers)
+      t.join();
+    CHECK(ordered);
+    CHECK_FALSE(q->pop(c));
+    for (int p = 0; p < PRODUCERS; p++)
+      CHECK(next[p] == EACH);
+  }
+  delete q;
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat1: Orders apply at the next tick, not when issued") {
+  musket::SimCommandQueue *q = musket::register_sim_commands(ecs);
+  for (int i = 0; i < 30; i++) {
+    spawn_armed_soldier(0, (float)i, 0.0f);
+    spawn_armed_soldier(1, (float)i, 80.0f);
+  }
+  test_compute_centroids(ecs);
+
+  q->push({musket::CMD_FIRE, {}, 1, 0, 5.0f, 6.0f});
+  q->push({musket::CMD_FORMATION, {}, 0, SHAPE_COLUMN, 0.0f, 0.0f});
+  q->push({musket::CMD_FIRE_DISCIPLINE, {}, 9, 1, 0.0f, 0.0f}); // Not live
+  CHECK(g_pending_orders[1].type == ORDER_NONE);
+  CHECK(ecs.get<FormationRoster>().pending_count == 0);
+
+  musket::advance_simulation(ecs, SIM_TICK_DT, test_compute_centroids);
+  CHECK(g_pending_orders[1].type == ORDER_FIRE);
+  CHECK(g_pending_orders[1].target_x == 5.0f);
+  CHECK(g_pending_orders[0].type == ORDER_NONE); // Team 0 was not ordered
+  CHECK(g_pending_orders[9].type == ORDER_NONE);
+  CHECK(g_macro_battalions[0].shape == SHAPE_COLUMN); // Solved this tick
+  musket::SimCommand left;
+  CHECK_FALSE(q->pop(left));
+
+  musket::release_sim_commands(ecs);
+}
+
+// Replay spawner for the harness: a three-rank line with an officer
+static bool harness_replay_spawn(flecs::world &ecs,
+                                 const musket::ReplaySpawn &s, void *) {
+  const int id = g_battalion_pool.acquire();
+  if (id < 0)
+    return false;
+  for (int i = 0; i < s.count; i++) {
+    const float x = s.x + (float)(i / 3) * 0.8f;
+    const float z = s.z + (float)(i % 3) * 1.2f;
+    ecs.entity()
+        .set<Position>({x, z})
+        .set<Velocity>({0.0f, 0.0f})
+        .set<SoldierFormationTarget>({x, z, 50.0f, 2.0f, face_snorm(0.0f),
+                                      face_snorm(-1.0f), true,
+                                      (uint8_t)(i % 3), {}})
+        .set<MusketState>({0.0f, 60, 0})
+        .set<BattalionId>({(uint32_t)id})
+        .set<TeamId>({s.team})
+        .set<MovementStats>({4.0f, 8.0f})
+        .set<FormationDefense>({0.2f})
+        .add<IsAlive>();
+  }
+  ecs.entity()
+      .set<Position>({s.x, s.z - 2.0f})
+      .set<Velocity>({0.0f, 0.0f})
+      .set<BattalionId>({(uint32_t)id})
+      .set<TeamId>({s.team})
+      .set<MovementStats>({4.0f, 8.0f})
+      .add<IsAlive>()
+      .add<ElevatedLOS>();
+  return true;
+}
+
+// Records `ticks` of a two-battalion firefight with a reinforcement and
+// two orders mid-battle. Returns the final world hash.
+static uint64_t record_replay_battle(std::vector<uint8_t> &log, int ticks) {
+  EngineTestHarness h;
+  musket::SimCommandQueue *q = musket::register_sim_commands(h.ecs);
+  h.ecs.get_mut<SimRng>().seed = 1812;
+  REQUIRE(musket::begin_replay_recording(h.ecs, 120));
+
+  auto spawn = [&](uint8_t team, int count, float x, float z) {
+    const musket::ReplaySpawn s = {musket::REPLAY_SPAWN_INFANTRY, team, {},
+                                   count, x, z};
+    harness_replay_spawn(h.ecs, s, nullptr);
+    musket::record_replay_spawn(h.ecs, s);
+  };
+  spawn(0, 60, 0.0f, 0.0f);
+  spawn(1, 60, 0.0f, -50.0f);
+  for (int t = 0; t < ticks; t++) {
+    if (t == 200)
+      spawn(1, 30, 30.0f, -50.0f);
+    if (t == 250)
+      q->push({musket::CMD_FIRE_DISCIPLINE, {}, 0, DISCIPLINE_BY_RANK, 0, 0});
+    if (t == 400)
+      q->push({musket::CMD_WHEEL, {}, 1, 0, 0.6f, 0.8f});
+    musket::advance_simulation(h.ecs, SIM_TICK_DT, test_compute_centroids);
+  }
+  const uint64_t hash = musket::world_state_hash(h.ecs);
+  REQUIRE(musket::end_replay_recording(h.ecs, log));
+  musket::release_sim_commands(h.ecs);
+  return hash;
+}
+
+TEST_CASE("Cat1: Replay reproduces a recorded battle tick for tick") {
+  std::vector<uint8_t> log;
+  const uint64_t recorded = record_replay_battle(log, 600);
+
+  musket::ReplayPlayer p;
+  REQUIRE(p.load(log.data(), log.size()));
+  CHECK(p.seed == 1812);
+  CHECK(p.start_tick == 0);
+  CHECK(p.end_tick == 600);
+  CHECK(p.record_count == 3 + 2 + 5); // Spawns, orders, checkpoints
+  MESSAGE("600-tick replay: ", log.size(), " bytes");
+
+  EngineTestHarness h;
+  musket::register_sim_commands(h.ecs);
+  REQUIRE(musket::begin_replay_playback(h.ecs, p, test_compute_centroids));
+  const uint64_t ran = musket::fast_forward_replay(
+      h.ecs, p, ~0ULL, test_compute_centroids, harness_replay_spawn, nullptr);
+  CHECK(ran == 600);
+  CHECK(h.ecs.get<SimClock>().tick == 600);
+  CHECK_FALSE(p.diverged());
+  CHECK(p.checkpoints_ok == 5);
+  CHECK(musket::world_state_hash(h.ecs) == recorded);
+  musket::release_sim_commands(h.ecs);
+}
+
+// A spawner that drifts by 1cm stands in for a non-deterministic system
+static bool drifting_replay_spawn(flecs::world &ecs,
+                                  const musket::ReplaySpawn &s, void *) {
+  musket::ReplaySpawn moved = s;
+  moved.x += s.team == 1 && s.x > 0.0f ? 0.01f : 0.0f; // The reinforcement
+  return harness_replay_spawn(ecs, moved, nullptr);
+}
+
+TEST_CASE("Cat1: Replay flags the first checkpoint that diverges") {
+  std::vector<uint8_t> log;
+  record_replay_battle(log, 400);
+
+  musket::ReplayPlayer p;
+  REQUIRE(p.load(log.data(), log.size()));
+  EngineTestHarness h;
+  musket::register_sim_commands(h.ecs);
+  REQUIRE(musket::begin_replay_playback(h.ecs, p, test_compute_centroids));
+  musket::fast_forward_replay(h.ecs, p, ~0ULL, test_compute_centroids,
+                              drifting_replay_spawn, nullptr);
+  CHECK(p.checkpoints_ok == 2); // Ticks 0 and 120, before the spawn
+  CHECK(p.diverged_tick == 240);
+  musket::release_sim_commands(h.ecs);
+
+  // Truncated or trailing bytes are rejected before any tick runs
+  musket::ReplayPlayer bad;
+  CHECK_FALSE(bad.load(log.data(), log.size() - 1));
+  log.push_back(0);
+  CHECK_FALSE(bad.load(log.data(), log.size()));
+}
+
+TEST_CASE("Cat1: Restored snapshot plays on tick for tick") {
+  // Mid-battle capture: a re-form queued, orders in the drummer
+  // pipeline, dead soldiers in their own tables
+  std::vector<uint8_t> snap;
+  uint64_t at_capture, played_on;
+  size_t alive;
+  {
+    EngineTestHarness h;
+    h.ecs.get_mut<SimRng>().seed = 1812;
+    const musket::ReplaySpawn red = {musket::REPLAY_SPAWN_INFANTRY, 0, {},
+                                     60, 0.0f, 0.0f};
+    const musket::ReplaySpawn blue = {musket::REPLAY_SPAWN_INFANTRY, 1, {},
+                                      60, 0.0f, -50.0f};
+    harness_replay_spawn(h.ecs, red, nullptr);
+    harness_replay_spawn(h.ecs, blue, nullptr);
+    for (int t = 0; t < 300; t++)
+      musket::advance_simulation(h.ecs, SIM_TICK_DT, test_compute_centroids);
+    musket::apply_sim_command(h.ecs,
+                              {musket::CMD_WHEEL, {}, 1, 0, 0.6f, 0.8f});
+    musket::apply_sim_command(
+        h.ecs, {musket::CMD_FIRE_DISCIPLINE, {}, 0, DISCIPLINE_BY_RANK, 0, 0});
+
+    REQUIRE(musket::capture_world_snapshot(h.ecs, snap));
+    at_capture = musket::world_state_hash(h.ecs);
+    REQUIRE(h.ecs.count<IsAlive>() < 122); // Casualties in the capture
+    for (int t = 0; t < 300; t++)
+      musket::advance_simulation(h.ecs, SIM_TICK_DT, test_compute_centroids);
+    played_on = musket::world_state_hash(h.ecs);
+    alive = (size_t)h.ecs.count<IsAlive>();
+  }
+
+  EngineTestHarness h;
+  uint32_t remapped = ~0u;
+  REQUIRE(musket::restore_world_snapshot(h.ecs, snap.data(), snap.size(),
+                                         &remapped));
+  CHECK(remapped == 0); // Same registration: every id kept
+  CHECK(h.ecs.get<SimClock>().tick == 300);
+  CHECK(h.ecs.get<SimRng>().seed == 1812);
+  CHECK(h.ecs.get<FormationRoster>().pending_shape[1] == SHAPE_LINE);
+  CHECK(g_pending_orders[0].type == ORDER_DISCIPLINE);
+  CHECK(musket::world_state_hash(h.ecs) == at_capture);
+
+  for (int t = 0; t < 300; t++)
+    musket::advance_simulation(h.ecs, SIM_TICK_DT, test_compute_centroids);
+  CHECK((size_t)h.ecs.count<IsAlive>() == alive);
+  CHECK(musket::world_state_hash(h.ecs) == played_on);
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat1: Snapshot renumbers taken ids and their references") {
+  flecs::entity home = ecs.entity().set<Position>({5.0f, 5.0f});
+  home.set<Household>({10, 10, 4, 1, 0, 0.0f, 0});
+  flecs::entity shop = ecs.entity().set<Position>({9.0f, 5.0f});
+  shop.set<Workplace>({});
+  Citizen c = {};
+  c.home_id = home.id();
+  c.workplace_id = shop.id();
+  c.satisfaction = 0.7f;
+  ecs.entity().set<Position>({0.0f, 0.0f}).set<Citizen>(c).add<IsAlive>();
+  std::vector<uint8_t> snap;
+  REQUIRE(musket::capture_world_snapshot(ecs, snap));
+
+  // A truncated file is refused before anything is deleted
+  CHECK_FALSE(musket::restore_world_snapshot(ecs, snap.data(),
+                                             snap.size() - 1));
+  CHECK(ecs.count<Position>() == 3);
+
+  // Deleting the originals and creating bare entities reuses their ids
+  ecs.delete_with<Position>();
+  for (int i = 0; i < 3; i++)
+    ecs.entity();
+  uint32_t remapped = 0;
+  REQUIRE(musket::restore_world_snapshot(ecs, snap.data(), snap.size(),
+                                         &remapped));
+  CHECK(remapped == 3);
+  CHECK(ecs.count<Position>() == 3);
+
+  int citizens = 0;
+  ecs.each([&](const Citizen &cz) {
+    citizens++;
+    CHECK(cz.satisfaction == doctest::Approx(0.7f));
+    CHECK(ecs.entity(cz.home_id).get<Household>().living_population == 4);
+    CHECK(ecs.entity(cz.workplace_id).has<Workplace>());
+  });
+  CHECK(citizens == 1);
+
+  // A component this build cannot save fails the capture
+  ecs.entity().set<Position>({0.0f, 0.0f}).set<SimRng>({1});
+  CHECK_FALSE(musket::capture_world_snapshot(ecs, snap));
+}
+
+static const musket::ProfileEntry *profile_entry(const musket::SimProfiler &p,
+                                                 const char *name) {
+  for (const musket::ProfileEntry &e : p.entries)
+    if (e.name == name)
+      return &e;
+  return nullptr;
+}
+
+TEST_CASE("Cat1: Profiler times every system without changing the battle") {
+  auto battle = [](flecs::world &ecs, int ticks) {
+    for (int t = 0; t < ticks; t++)
+      musket::advance_simulation(ecs, SIM_TICK_DT, test_compute_centroids);
+  };
+  auto spawn = [](flecs::world &ecs) {
+    ecs.get_mut<SimRng>().seed = 1812;
+    harness_replay_spawn(
+        ecs, {musket::REPLAY_SPAWN_INFANTRY, 0, {}, 60, 0.0f, 0.0f}, nullptr);
+    harness_replay_spawn(
+        ecs, {musket::REPLAY_SPAWN_INFANTRY, 1, {}, 60, 0.0f, -50.0f},
+        nullptr);
+  };
+
+  // Registering creates the SimProfile component, which shifts every
+  // later entity id (and so the RNG). The plain run registers and
+  // releases at once: same ids, unwrapped systems.
+  uint64_t plain;
+  {
+    EngineTestHarness h;
+    musket::register_sim_profiler(h.ecs);
+    musket::release_sim_profiler(h.ecs);
+    spawn(h.ecs);
+    battle(h.ecs, 600);
+    plain = musket::world_state_hash(h.ecs);
+  }
+
+  EngineTestHarness h;
+  int systems = 0;
+  h.ecs.query_builder().with(flecs::System).build().each(
+      [&](flecs::entity e) { systems += e.parent() ? 0 : 1; });
+  musket::SimProfiler *p = musket::register_sim_profiler(h.ecs);
+  REQUIRE(p->entries.size() ==
+          (size_t)(musket::PROFILE_SECTION_COUNT + systems));
+  spawn(h.ecs);
+
+  // Off: the wrappers only call through
+  battle(h.ecs, 300);
+  CHECK(p->entries[musket::PROFILE_TICK].runs == 0);
+  CHECK(p->trace_count == 0);
+
+  musket::set_profiling(h.ecs, true);
+  battle(h.ecs, 300);
+  CHECK(musket::world_state_hash(h.ecs) == plain);
+
+  const musket::ProfileEntry &tick = p->entries[musket::PROFILE_TICK];
+  CHECK(tick.runs == 300);
+  CHECK(p->entries[musket::PROFILE_CENTROIDS].runs == 300);
+  CHECK(p->entries[musket::PROFILE_CENTROIDS].entities == 2);
+  CHECK(p->entries[musket::PROFILE_SYNC_BATTALIONS].runs == 0); // Headless
+  const musket::ProfileEntry *reload = profile_entry(*p, "MusketReloadTick");
+  REQUIRE(reload);
+  CHECK(reload->runs == 300);
+  CHECK(reload->entities > 0); // Live line soldiers
+  CHECK(reload->entities <= 120);
+  const musket::ProfileEntry *panic =
+      profile_entry(*p, "PanicDiffusionSystem");
+  REQUIRE(panic);
+  CHECK(panic->runs == 25); // 5Hz: only the ticks the rate filter passes
+
+  std::vector<musket::ProfileStats> stats;
+  musket::profile_stats(*p, stats);
+  REQUIRE(stats.size() == p->entries.size());
+  uint64_t runs = 0;
+  float systems_ms = 0.0f;
+  for (const musket::ProfileStats &s : stats) {
+    runs += s.runs;
+    CHECK(s.samples == std::min<uint64_t>(s.runs, musket::PROFILE_WINDOW));
+    if (s.samples) {
+      CHECK(s.min_ms <= s.avg_ms);
+      CHECK(s.avg_ms <= s.max_ms);
+      CHECK(s.p99_ms <= s.max_ms);
+    }
+    if (s.system)
+      systems_ms += s.avg_ms * (float)s.runs;
+  }
+  CHECK(p->trace_count == runs); // One trace event per run
+  // Every system runs inside a tick
+  CHECK(systems_ms <= stats[musket::PROFILE_TICK].avg_ms * 300.0f);
+
+  // Released: the systems' own callbacks are back and the battle goes on
+  musket::release_sim_profiler(h.ecs);
+  const uint64_t at = h.ecs.get<SimClock>().tick;
+  battle(h.ecs, 10);
+  CHECK(h.ecs.get<SimClock>().tick == at + 10);
+  CHECK_FALSE(musket::is_profiling(h.ecs));
+}
+
+TEST_CASE("Cat1: Worker pool finishes every claim loop, nested or not") {
+  musket::WorkerPool pool(3);
+  REQUIRE(pool.size() == 4);
+
+  constexpr int ITEMS = 1000;
+  std::vector<int> hits(ITEMS);
+  for (int round = 0; round < 200; round++) {
+    std::atomic<int> next(0);
+    std::atomic<int> seen_mask(0);
+    pool.run(1 + round % 5, [&](int worker) {
+      seen_mask.fetch_or(1 << worker);
+      for (int i; (i = next.fetch_add(1)) < ITEMS;)
+        hits[i]++;
+    });
+    // Ids stay inside the participants asked for (capped at the pool)
+    const int n = std::min(1 + round % 5, pool.size());
+    CHECK((seen_mask.load() & ~((1 << n) - 1)) == 0);
+    CHECK((seen_mask.load() & 1) == 1); // The caller always works
+  }
+  int wrong = 0;
+  for (int h : hits)
+    wrong += h != 200;
+  CHECK(wrong == 0);
+
+  // A fan-out inside a job runs on its caller alone instead of waiting
+  // for the pool it is already running on
+  std::atomic<int> outer(0), inner(0);
+  pool.run(4, [&](int) {
+    for (; outer.fetch_add(1) < 8;) {
+      std::atomic<int> next(0);
+      pool.run(4, [&](int worker) {
+        CHECK(worker == 0);
+        for (; next.fetch_add(1) < 10;)
+          inner++;
+      });
+    }
+  });
+  CHECK(inner.load() == 80);
+}
+
+TEST_CASE("Cat1: Render frame ring carries every range the reader missed") {
+  // The Godot-free half of RenderFrameExchange, over bare slots
+  std::vector<musket::RenderFrameSlots> slots(3);
+  auto ring = std::make_unique<musket::RenderFrameRing>(&slots[0], &slots[1],
+                                                        &slots[2]);
+  const int id = 5;
+  int32_t copy_lo, copy_hi;
+  auto publish = [&](int32_t lo, int32_t hi) {
+    ring->begin_fill();
+    ring->fill(id, lo, hi, copy_lo, copy_hi);
+    ring->swap();
+  };
+  auto front = [&]() -> const musket::RenderFrameSlots & {
+    return *ring->slots[ring->front];
+  };
+
+  CHECK_FALSE(ring->acquire()); // Nothing published yet
+
+  publish(0, 10);
+  CHECK(copy_lo == 0);
+  CHECK(copy_hi == 10);
+
+  // Published without an acquire: the dropped frame's range rides on
+  publish(20, 30);
+  CHECK(copy_lo == 0); // This frame also missed the first publish
+  CHECK(copy_hi == 30);
+  REQUIRE(ring->acquire());
+  CHECK(front().active_count == 1);
+  CHECK(front().active[0] == id);
+  CHECK(front().dirty_lo[id] == 0);
+  CHECK(front().dirty_hi[id] == 30);
+  CHECK(ring->seen_lo[id] == 0);
+  CHECK(ring->seen_hi[id] == 30);
+
+  // Acquired twice: no new frame, and the upload ack is left alone
+  ring->seen_lo[id] = ring->seen_hi[id] = 0;
+  CHECK_FALSE(ring->acquire());
+  CHECK(ring->seen_hi[id] == ring->seen_lo[id]);
+
+  // The frame coming round copies everything drained since it was
+  // last filled, not just this publish's range
+  publish(40, 41);
+  CHECK(copy_lo == 20);
+  CHECK(copy_hi == 41);
+
+  // A frame never filled before copies the whole backlog, and a publish
+  // that drained nothing still reports the range the reader may lack
+  publish(0, 0);
+  CHECK(copy_lo == 0);
+  CHECK(copy_hi == 41);
+  REQUIRE(ring->acquire());
+  CHECK(front().dirty_lo[id] == 40);
+  CHECK(front().dirty_hi[id] == 41);
+
+  // Once every frame is caught up a standing battalion copies nothing
+  publish(0, 0);
+  publish(0, 0);
+  publish(0, 0);
+  CHECK(copy_hi <= copy_lo);
+  REQUIRE(ring->acquire());
+  CHECK(front().dirty_hi[id] <= front().dirty_lo[id]);
+}
+
+TEST_CASE("Cat1: Headless server world fights without the rendering bridge") {
+  // What bin/musket_server runs: init_ecs' world minus the render bridge
+  auto battle = [](uint32_t seed, int &casualties) {
+    std::fill(std::begin(g_macro_battalions), std::end(g_macro_battalions),
+              MacroBattalion());
+    std::fill(std::begin(g_pending_orders), std::end(g_pending_orders),
+              PendingOrder());
+    g_battalion_pool.reset();
+
+    flecs::world ecs;
+    musket::SimCommandQueue *commands = musket::init_sim_world(ecs);
+    ecs.get_mut<SimRng>().seed = seed;
+    std::vector<Position> pos;
+    for (int team = 0; team < 2; team++) {
+      const int id = g_battalion_pool.acquire();
+      const float z = team == 0 ? 40.0f : -40.0f;
+      musket::spawn_line_battalion(ecs, (uint32_t)id, 150, 0.0f, z, team, 0,
+                                   pos);
+      if (team == 1) // Face the other line
+        commands->push({musket::CMD_WHEEL, {}, id, 0, 0.0f, 1.0f});
+      commands->push({musket::CMD_FIRE, {}, team, 0, 0.0f, -z});
+    }
+    for (int t = 0; t < 600; t++)
+      musket::step_simulation(ecs, [](flecs::world &w) {
+        musket::run_centroid_pass(w, nullptr);
+      });
+
+    casualties = 300 - ecs.count<IsAlive>();
+    const uint64_t hash = musket::world_state_hash(ecs);
+    musket::release_sim_profiler(ecs);
+    musket::release_sim_commands(ecs);
+    ecs.get_mut<VoxelGrid>().release();
+    ecs.get_mut<TerrainHeightmap>().release();
+    return hash;
+  };
+  int a_dead, b_dead, c_dead;
+  const uint64_t a = battle(7, a_dead), b = battle(7, b_dead),
+                 c = battle(8, c_dead);
+  CHECK(a_dead > 0); // The lines exchanged volleys
+  CHECK(a_dead == b_dead);
+  CHECK(a == b);
+  CHECK(a != c);
+}
@@ -15,19 +15,48 @@
 // ── Pure C++ engine code (Godot-free) ───────────────────────
 #include "../src/ecs/musket_components.h"
 #include "../src/ecs/musket_systems.h"
+#include "../src/ecs/macro_sync.h"
+#include "../src/ecs/sim_commands.h"
+#include "../src/ecs/sim_replay.h"
+#include "../src/ecs/sim_snapshot.h"
+#include "../src/ecs/sim_profiler.h"
+#include "../src/ecs/worker_pool.h"
+#include "../src/ecs/render_frame_ring.h"
+#include "../src/ecs/platform.h"
+#include "../src/ecs/sim_world.h"
 
 // Define the globals that normally live in world_manager.cpp
 MacroBattalion g_macro_battalions[MAX_BATTALIONS];
 PendingOrder g_pending_orders[MAX_BATTALIONS];
+BattalionPool g_battalion_pool;
 
 // Include the systems implementation (Godot-free)
+#include "../src/ecs/worker_pool.cpp"
+#include "../src/ecs/render_frame_ring.cpp"
+#include "../src/ecs/voxel_storage.cpp"
+#include "../src/ecs/voxel_terrain.cpp"
+#include "../src/ecs/formation_layout.cpp"
 #include "../src/ecs/musket_systems.cpp"
+#include "../src/ecs/sim_commands.cpp"
+#include "../src/ecs/sim_replay.cpp"
+#include "../src/ecs/sim_snapshot.cpp"
+#include "../src/ecs/sim_profiler.cpp"
+#include "../src/ecs/macro_sync.cpp"
+#include "../src/ecs/voxel_file.cpp"
+
+// The headless server's world setup, on the stdio platform
+#include "../src/ecs/platform_stdio.cpp"
+#include "../src/ecs/prefab_loader.cpp"
+#include "../src/ecs/sim_world.cpp"
 
 // ── Test Infrastructure ─────────────────────────────────────
 #include "test_harness.h"
 
 // ── Test Suites (domain-based) ──────────────────────────────
 #include "test_combat.cpp"
+#include "test_formation.cpp"
 #include "test_invariants.cpp"
+#include "test_net.cpp"
 #include "test_perf.cpp"
+#include "test_voxel.cpp"
 
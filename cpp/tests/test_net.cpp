@@ -0,0 +1,389 @@
+// ═════════════════════════════════════════════════════════════
+// Category 9: NETWORKING — macro-state sync (GDD §4.3)
+// ═════════════════════════════════════════════════════════════
+
+static void set_macro(int id, float cx, float cz, int alive, uint32_t team) {
+  g_battalion_pool.claim(id);
+  MacroBattalion &mb = g_macro_battalions[id];
+  mb.cx = cx;
+  mb.cz = cz;
+  mb.anchor_x = cx;
+  mb.anchor_z = cz - 3.0;
+  mb.alive_count = alive;
+  mb.team_id = team;
+  mb.flag_alive = mb.officer_alive = true;
+}
+
+static bool same_frame(const musket::MacroSyncFrame &a,
+                       const musket::MacroSyncFrame &b) {
+  return a.id_end == b.id_end && a.tick == b.tick &&
+         std::memcmp(a.bat, b.bat, sizeof(a.bat)) == 0 &&
+         std::memcmp(a.grid, b.grid, sizeof(a.grid)) == 0;
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat9: Macro snapshots decode to the server's frames") {
+  musket::MacroSyncHistory h = {};
+  musket::MacroSyncReceiver client = {};
+  h.allocate();
+  client.allocate();
+  std::vector<uint8_t> full, delta;
+  PanicGrid &panic = ecs.get_mut<PanicGrid>();
+
+  set_macro(0, 10.0f, -40.0f, 600, 0);
+  set_macro(1, -20.0f, 40.0f, 600, 1);
+  set_macro(300, 500.0f, 500.0f, 120, 1); // Past the old 8-bit id space
+  panic.read_buf[1][100] = 0.5f;
+
+  const uint32_t s1 = musket::capture_macro_sync(h, 60, &panic, nullptr);
+  REQUIRE(musket::encode_macro_sync(h, s1, 0, full) > 0);
+  const musket::MacroSyncFrame *f1 =
+      musket::decode_macro_sync(client, full.data(), full.size());
+  REQUIRE(f1 != nullptr);
+  CHECK(same_frame(*f1, *h.find(s1)));
+  CHECK(f1->bat[300].alive == 120);
+  CHECK(f1->bat[2].team == musket::MACRO_SYNC_ABSENT);
+
+  // Battalion 0 advances and takes casualties, 1 is destroyed, 7 arrives
+  g_macro_battalions[0].cz = -38.7f;
+  g_macro_battalions[0].alive_count = 597;
+  g_macro_battalions[0].dir_x = 1.0f;
+  g_macro_battalions[0].dir_z = 0.0f;
+  g_macro_battalions[0].fire_discipline = DISCIPLINE_BY_RANK;
+  release_battalion(1);
+  set_macro(7, 0.0f, 0.0f, 40, 0);
+  panic.read_buf[1][100] = 0.6f;
+  panic.read_buf[0][4000] = 1.0f;
+  musket::log_macro_sync_death(h, 0, 5);
+  musket::log_macro_sync_death(h, 300, 40);
+  musket::log_macro_sync_death(h, 0, 2);
+  musket::log_macro_sync_death(h, 0, 3);
+
+  const uint32_t s2 = musket::capture_macro_sync(h, 66, &panic, nullptr);
+  musket::encode_macro_sync(h, s2, s1, delta);
+  musket::encode_macro_sync(h, s2, 0, full);
+  CHECK(delta.size() < full.size());
+
+  const musket::MacroSyncFrame *f2 =
+      musket::decode_macro_sync(client, delta.data(), delta.size());
+  REQUIRE(f2 != nullptr);
+  CHECK(same_frame(*f2, *h.find(s2)));
+  CHECK(client.latest_seq == s2);
+  CHECK(f2->bat[1].team == musket::MACRO_SYNC_ABSENT);
+  CHECK(f2->bat[7].alive == 40);
+  CHECK(f2->bat[0].centroid_z() == doctest::Approx(-38.7f).epsilon(0.01));
+  CHECK(f2->bat[0].discipline() == DISCIPLINE_BY_RANK);
+  float fx, fz;
+  f2->bat[0].facing_dir(fx, fz);
+  CHECK(fx == doctest::Approx(1.0f).epsilon(1e-3));
+  CHECK(std::fabs(fz) < 1e-3f);
+
+  // Deaths arrive batched per battalion, slots ascending
+  REQUIRE(client.death_count == 4);
+  CHECK(client.deaths[0].bat == 0);
+  CHECK(client.deaths[0].slot == 2);
+  CHECK(client.deaths[1].slot == 3);
+  CHECK(client.deaths[2].slot == 5);
+  CHECK(client.deaths[3].bat == 300);
+  CHECK(client.deaths[3].slot == 40);
+
+  SUBCASE("A client without the baseline rejects the delta") {
+    musket::MacroSyncReceiver fresh = {};
+    fresh.allocate();
+    CHECK(musket::decode_macro_sync(fresh, delta.data(), delta.size()) ==
+          nullptr);
+    CHECK(musket::decode_macro_sync(fresh, full.data(), full.size()) !=
+          nullptr);
+    CHECK(fresh.death_count == 0); // Full snapshots carry no deaths
+    fresh.release();
+  }
+
+  SUBCASE("An aged-out baseline falls back to a full snapshot") {
+    uint32_t last = s2;
+    for (int i = 0; i < musket::MACRO_SYNC_HISTORY; i++)
+      last = musket::capture_macro_sync(h, 72 + i * 6, &panic, nullptr);
+    musket::encode_macro_sync(h, last, s1, delta);
+    REQUIRE(delta.size() > 10);
+    CHECK(delta[6] == 0); // baseline_seq field
+    const musket::MacroSyncFrame *f =
+        musket::decode_macro_sync(client, delta.data(), delta.size());
+    REQUIRE(f != nullptr);
+    CHECK(same_frame(*f, *h.find(last)));
+  }
+
+  SUBCASE("Truncated packets are rejected") {
+    for (size_t n = 0; n < delta.size(); n++)
+      CHECK(musket::decode_macro_sync(client, delta.data(), n) == nullptr);
+  }
+
+  client.release();
+  h.release();
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat9: Capture runs at 10Hz and logs deaths by slot") {
+  musket::register_macro_sync(ecs);
+  flecs::entity eleventh;
+  for (int i = 0; i < 20; i++) {
+    flecs::entity e = spawn_soldier(3, (float)i, 0.0f);
+    e.set<RenderSlot>({3, (uint32_t)i});
+    if (i == 11)
+      eleventh = e;
+  }
+
+  for (int t = 0; t < 60; t++)
+    musket::advance_simulation(ecs, SIM_TICK_DT, test_compute_centroids);
+  const musket::MacroSyncHistory &h = ecs.get<musket::MacroSyncHistory>();
+  CHECK(h.latest_seq == 10);
+  REQUIRE(h.find(h.latest_seq) != nullptr);
+  CHECK(h.find(h.latest_seq)->bat[3].alive == 20);
+
+  eleventh.remove<IsAlive>();
+  CHECK(h.death_total == 1);
+  CHECK(h.deaths[0].bat == 3);
+  CHECK(h.deaths[0].slot == 11);
+
+  ecs.get_mut<musket::MacroSyncHistory>().release();
+}
+
+// ── Loopback client (Visual ECS) ────────────────────────────
+// Server block laid out like the client will lay it out, RenderSlots
+// from 0, so server slots and client slots name the same soldier.
+static std::vector<flecs::entity_t> spawn_line(flecs::world &ecs, uint32_t id,
+                                               int n, float ax, float az) {
+  g_battalion_pool.claim((int)id);
+  MacroBattalion &mb = g_macro_battalions[id];
+  mb.anchor_x = ax;
+  mb.anchor_z = az;
+  FormationRoster &r = ecs.get_mut<FormationRoster>();
+  float ext_w, ext_d;
+  r.layout(0, n, SHAPE_LINE, ext_w, ext_d);
+  std::vector<Position> pos(n);
+  std::vector<SoldierFormationTarget> target(n);
+  for (int k = 0; k < n; k++) {
+    float gx, gz;
+    battalion_to_world(r.slot_x[k], r.slot_z[k], mb.dir_x, mb.dir_z, gx, gz);
+    pos[k] = {ax + gx, az + gz};
+    target[k] = {r.slot_x[k], r.slot_z[k], 50.0f, 2.0f, r.slot_face_x[k],
+                 r.slot_face_z[k], true, r.slot_rank[k], {}};
+  }
+  musket::InfantryBlock block = {};
+  block.count = n;
+  block.bat_id = id;
+  block.team = 0; // One side: nobody fires
+  block.pos = pos.data();
+  block.target = target.data();
+  block.stats = {4.0f, 8.0f};
+  block.defense = {0.2f};
+  const flecs::entity_t *ids = musket::spawn_infantry_block(ecs, block);
+  return std::vector<flecs::entity_t>(ids, ids + n);
+}
+
+static int visual_alive(flecs::world &w, uint32_t bat, int *total = nullptr,
+                        float *cx = nullptr) {
+  int alive = 0, all = 0;
+  float sx = 0.0f;
+  w.each([&](flecs::entity e, const BattalionId &b, const Position &p) {
+    if (b.id != bat)
+      return;
+    all++;
+    if (e.has<IsAlive>()) {
+      alive++;
+      sx += p.x;
+    }
+  });
+  if (total)
+    *total = all;
+  if (cx)
+    *cx = alive ? sx / alive : 0.0f;
+  return alive;
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat9: Loopback client rebuilds soldiers from snapshots") {
+  musket::register_macro_sync(ecs);
+  std::vector<flecs::entity_t> first = spawn_line(ecs, 0, 120, 0.0f, 0.0f);
+  std::vector<flecs::entity_t> second = spawn_line(ecs, 1, 60, 300.0f, 0.0f);
+
+  // Two clients fed the same packets must end up identical
+  flecs::world client[2];
+  for (flecs::world &c : client) {
+    musket::register_sim_clock(c);
+    musket::register_visual_client(c);
+  }
+  std::vector<uint8_t> packet;
+  uint32_t ack = 0, sent = 0;
+  size_t bytes = 0;
+  bool deliver = true;
+  auto run = [&](int ticks, float march) {
+    for (int t = 0; t < ticks; t++) {
+      g_macro_battalions[0].anchor_x += march;
+      musket::advance_simulation(ecs, SIM_TICK_DT, test_compute_centroids);
+      const musket::MacroSyncHistory &h = ecs.get<musket::MacroSyncHistory>();
+      if (deliver && h.latest_seq != sent) {
+        sent = h.latest_seq;
+        bytes += musket::encode_macro_sync(h, sent, ack, packet);
+        for (flecs::world &c : client)
+          ack = musket::receive_macro_sync(c, packet.data(), packet.size());
+      }
+      for (flecs::world &c : client)
+        musket::advance_simulation(c, SIM_TICK_DT, nullptr);
+    }
+  };
+
+  run(60, 0.0f);
+  CHECK(visual_alive(client[0], 0) == 120);
+  CHECK(visual_alive(client[0], 1) == 60);
+
+  // March 6m at 1.5m/s, then settle: the springs follow the anchor
+  run(240, 1.5f * (float)SIM_TICK_DT);
+  run(120, 0.0f);
+  float server_cx, client_cx;
+  visual_alive(ecs, 0, nullptr, &server_cx);
+  visual_alive(client[0], 0, nullptr, &client_cx);
+  CHECK(server_cx == doctest::Approx(6.0f).epsilon(0.05));
+  CHECK(std::fabs(client_cx - server_cx) < 0.25f);
+  MESSAGE("Macro sync: ", bytes * 60 / 420, " bytes/s for 180 soldiers");
+  CHECK(bytes * 60 / 420 < 2048);
+
+  // Server deaths fall on the same client slots
+  ecs.entity(first[5]).remove<IsAlive>();
+  ecs.entity(first[17]).remove<IsAlive>();
+  ecs.entity(first[40]).remove<IsAlive>();
+  run(30, 0.0f);
+  CHECK(visual_alive(client[0], 0) == 117);
+  const musket::MacroSyncClient &mc = client[0].get<musket::MacroSyncClient>();
+  CHECK(mc.picked == 0);
+  CHECK(mc.bat[0].living[5] == 0);
+  CHECK(mc.bat[0].living[17] == 0);
+  CHECK(mc.bat[0].living[40] == 0);
+  CHECK(mc.bat[0].living[6] == 1);
+
+  // Blackout past the ring: the resync is a full snapshot without the
+  // deaths, so each client picks them, and both pick the same soldiers
+  deliver = false;
+  for (int k = 60; k < 70; k++)
+    ecs.entity(first[k]).remove<IsAlive>();
+  run(6 * (musket::MACRO_SYNC_HISTORY + 2), 0.0f);
+  deliver = true;
+  run(30, 0.0f);
+  const musket::MacroSyncClient &mc1 = client[1].get<musket::MacroSyncClient>();
+  CHECK(visual_alive(client[0], 0) == 107);
+  CHECK(mc.picked == 10);
+  CHECK(mc.bat[0].living == mc1.bat[0].living);
+
+  // A destroyed battalion leaves nothing behind on the client
+  for (flecs::entity_t e : second)
+    ecs.entity(e).remove<IsAlive>();
+  run(30, 0.0f);
+  int total = -1;
+  CHECK(visual_alive(client[0], 1, &total) == 0);
+  CHECK(total == 0);
+
+  for (flecs::world &c : client)
+    c.get_mut<musket::MacroSyncClient>().release();
+  ecs.get_mut<musket::MacroSyncHistory>().release();
+}
+
+// Hand-built packet: header, battalion records (gap, team), no grids,
+// then death groups (gap, slots). Gaps are raw varints, so a test can
+// send any 32-bit value.
+struct RawSyncPacket {
+  std::vector<uint8_t> b;
+
+  void u8(uint8_t v) { b.push_back(v); }
+  void u16(uint16_t v) {
+    u8((uint8_t)v);
+    u8((uint8_t)(v >> 8));
+  }
+  void u32(uint32_t v) {
+    u16((uint16_t)v);
+    u16((uint16_t)(v >> 16));
+  }
+  void varint(uint32_t v) {
+    while (v >= 0x80) {
+      u8((uint8_t)(v | 0x80));
+      v >>= 7;
+    }
+    u8((uint8_t)v);
+  }
+  RawSyncPacket(uint32_t id_end, const std::vector<uint32_t> &bat_gaps,
+                const std::vector<uint32_t> &death_gaps) {
+    u8('M');
+    u8(1);
+    u32(1); // seq
+    u32(0); // full
+    u32(60);
+    varint(id_end);
+    u16((uint16_t)bat_gaps.size());
+    for (uint32_t gap : bat_gaps) {
+      varint(gap);
+      u8(musket::SNAP_TEAM);
+      u8(0);
+    }
+    u8(0); // No grid layers
+    varint((uint32_t)death_gaps.size());
+    for (uint32_t gap : death_gaps) {
+      varint(gap);
+      varint(1);
+      varint(7);
+    }
+  }
+};
+
+TEST_CASE("Cat9: Malformed packets never index outside the battalion table") {
+  musket::MacroSyncReceiver client = {};
+  client.allocate();
+  auto decodes = [&](const RawSyncPacket &p) {
+    return musket::decode_macro_sync(client, p.b.data(), p.b.size()) !=
+           nullptr;
+  };
+
+  // Well-formed: battalions 4 and 9, a death in battalion 4
+  REQUIRE(decodes(RawSyncPacket(10, {4, 4}, {4})));
+  CHECK(client.frames[1].bat[4].team == 0);
+  CHECK(client.frames[1].bat[9].team == 0);
+  REQUIRE(client.death_count == 1);
+  CHECK(client.deaths[0].bat == 4);
+  CHECK(client.deaths[0].slot == 7);
+
+  // Gaps that wrapped the id negative before they were range-checked
+  const uint32_t huge[] = {0xFFFFFFFFu, 0xFFFFFFFEu, 0x80000000u,
+                           0x7FFFFFFFu, (uint32_t)MAX_BATTALIONS};
+  for (uint32_t gap : huge) {
+    CHECK_FALSE(decodes(RawSyncPacket(MAX_BATTALIONS, {gap}, {})));
+    CHECK_FALSE(decodes(RawSyncPacket(MAX_BATTALIONS, {0, gap}, {})));
+    CHECK_FALSE(decodes(RawSyncPacket(10, {}, {gap})));
+    CHECK_FALSE(decodes(RawSyncPacket(10, {}, {3, gap})));
+  }
+  // The last id fits; one past it does not
+  CHECK(decodes(RawSyncPacket(MAX_BATTALIONS, {MAX_BATTALIONS - 1}, {})));
+  CHECK_FALSE(decodes(RawSyncPacket(MAX_BATTALIONS, {0, MAX_BATTALIONS - 1},
+                                    {})));
+  CHECK(decodes(RawSyncPacket(10, {}, {MAX_BATTALIONS - 1})));
+  CHECK_FALSE(decodes(RawSyncPacket(10, {}, {0, MAX_BATTALIONS - 1})));
+  // Records stay below the packet's id_end; the frame's live end
+  // ignores the absent tail
+  CHECK_FALSE(decodes(RawSyncPacket(10, {10}, {})));
+  CHECK(decodes(RawSyncPacket(10, {9}, {})));
+  CHECK(client.frames[1].id_end == 10);
+  // More records than the id range holds
+  CHECK_FALSE(decodes(RawSyncPacket(1, {0, 0}, {})));
+
+  // Random byte flips in a valid packet: whatever decodes stays in range
+  const RawSyncPacket valid(10, {4, 4}, {4, 1});
+  uint32_t lcg = 1805;
+  for (int round = 0; round < 2000; round++) {
+    std::vector<uint8_t> b = valid.b;
+    for (int k = 0; k < 3; k++) {
+      lcg = lcg * 1664525u + 1013904223u;
+      const size_t at = 14 + (lcg >> 8) % (b.size() - 14); // Past the header
+      b[at] = (uint8_t)(lcg >> 24) | 0x80;
+    }
+    if (musket::decode_macro_sync(client, b.data(), b.size())) {
+      for (int d = 0; d < client.death_count; d++)
+        REQUIRE(client.deaths[d].bat < MAX_BATTALIONS);
+    }
+  }
+  client.release();
+}
@@ -2,6 +2,7 @@
 // Category 6: PERFORMANCE — Regression Bounds
 // ═════════════════════════════════════════════════════════════
 #include <chrono>
+#include <cstdlib>
 
 TEST_CASE_FIXTURE(EngineTestHarness, "Cat6: 1K entities tick under 50ms") {
   // NOTE: VolleyFireSystem does O(N) w.each() per soldier for micro-targeting,
@@ -29,18 +30,545 @@ TEST_CASE_FIXTURE(EngineTestHarness, "Cat6: 1K entities tick under 50ms") {
   CHECK(ms < 50);
 }
 
-TEST_CASE_FIXTURE(EngineTestHarness, "Cat6: Spawn 5K entities under 50ms") {
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat6: Bulk spawn 100K soldiers under 50ms") {
+  constexpr int PER_BAT = 500;
+  constexpr int BATS = 200; // 100K soldiers
+  std::vector<Position> pos(PER_BAT);
+  std::vector<SoldierFormationTarget> target(PER_BAT);
+
   auto start = std::chrono::high_resolution_clock::now();
 
-  for (int i = 0; i < 5000; i++) {
-    spawn_armed_soldier((uint32_t)(i / 200), (float)(i % 200) * 0.8f, 0.0f,
-                        (uint8_t)(i % 2));
+  for (int b = 0; b < BATS; b++) {
+    for (int i = 0; i < PER_BAT; i++) {
+      float x = (float)(i / 3) * 0.8f, z = (float)b * 10.0f + (i % 3) * 1.2f;
+      pos[i] = {x, z};
+      target[i] = {x, z, 50.0f, 2.0f, face_snorm(0.0f), face_snorm(-1.0f),
+                   true, (uint8_t)(i % 3), {}};
+    }
+    musket::InfantryBlock block = {};
+    block.count = PER_BAT;
+    block.bat_id = (uint32_t)b;
+    block.team = (uint8_t)(b % 2);
+    block.first_slot = 0;
+    block.pos = pos.data();
+    block.target = target.data();
+    block.stats = {4.0f, 8.0f};
+    block.musket = {0.0f, 30, 13};
+    block.defense = {0.2f};
+    musket::spawn_infantry_block(ecs, block);
   }
 
   auto end = std::chrono::high_resolution_clock::now();
-  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
-                .count();
+  double ms = std::chrono::duration<double, std::milli>(end - start).count();
 
-  MESSAGE("5K spawn time: ", ms, "ms");
-  CHECK(ms < 50);
+  MESSAGE("100K bulk spawn time: ", ms, "ms");
+  CHECK(ecs.count<IsAlive>() == PER_BAT * BATS);
+  CHECK(ms < 50.0);
+
+  SUBCASE("Soldiers land with their block's constants and slots") {
+    int checked = 0, wrong = 0;
+    ecs.each([&](const Position &p, const BattalionId &b, const TeamId &t,
+                 const RenderSlot &rs, const MusketState &m) {
+      wrong += (t.team != b.id % 2) || (rs.battalion_id != b.id) ||
+               (rs.mm_slot >= (uint32_t)PER_BAT) || (m.ammo_count != 30) ||
+               (p.z < (float)b.id * 10.0f);
+      checked++;
+    });
+    CHECK(checked == PER_BAT * BATS);
+    CHECK(wrong == 0);
+  }
+}
+
+TEST_CASE("Cat6: get_voxel on packed chunks") {
+  VoxelGrid g = {};
+  g.allocate();
+
+  // 8×8 chunks: earth footing, stone walls, wood hoardings (2-bit palette)
+  constexpr int SPAN = 8 * CHUNK_SIZE;
+  for (int y = 0; y < CHUNK_SIZE; y++)
+    for (int z = 0; z < SPAN; z++)
+      for (int x = 0; x < SPAN; x++) {
+        int lx = x % CHUNK_SIZE, lz = z % CHUNK_SIZE;
+        uint8_t m = (y < 4)                        ? VMAT_EARTH
+                    : (lx >= 6 && lx < 10 && y < 12) ? VMAT_STONE
+                    : (lz == 0 && y == 12)           ? VMAT_WOOD
+                                                     : VMAT_AIR;
+        g.set_voxel(x, y, z, m);
+      }
+
+  constexpr int READS = 1 << 22; // 4M lookups
+  auto bench = [&]() {
+    uint32_t lcg = 12345u;
+    uint32_t sum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < READS; i++) {
+      lcg = lcg * 1664525u + 1013904223u;
+      sum += g.get_voxel((int)(lcg >> 8) % SPAN, (int)(lcg >> 4) % CHUNK_SIZE,
+                         (int)(lcg >> 16) % SPAN);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    CHECK(sum > 0);
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           READS;
+  };
+
+  double hot_ns = bench(); // All 64 chunks resident in the hot cache
+  g.flush_hot_cache();
+  double cold_ns = bench(); // Decoded from 2-bit palettes
+
+  MESSAGE("get_voxel hot: ", hot_ns, "ns  packed: ", cold_ns, "ns");
+  CHECK(cold_ns < 50.0);
+
+  g.release();
+}
+
+TEST_CASE("Cat6: 60-gun bombardment resolves within one frame") {
+  VoxelGrid g = {};
+  g.allocate();
+
+  // 12×12 chunk fortress block: earth footing, stone walls, hoardings
+  constexpr int SPAN = 12 * CHUNK_SIZE;
+  for (int y = 0; y < 2 * CHUNK_SIZE; y++)
+    for (int z = 0; z < SPAN; z++)
+      for (int x = 0; x < SPAN; x++) {
+        int lx = x % CHUNK_SIZE, lz = z % CHUNK_SIZE;
+        uint8_t m = (y < CHUNK_SIZE)                 ? VMAT_EARTH
+                    : (lx >= 6 && lx < 10 && y < 28) ? VMAT_STONE
+                    : (lz == 0 && y == 28)           ? VMAT_WOOD
+                                                     : VMAT_AIR;
+        g.set_voxel(x, y, z, m);
+      }
+  g.flush_hot_cache(); // Start cold, as after a save/load
+
+  // One full battery volley: 60 roundshot impacts along the wall line
+  DestructionQueue dq;
+  uint32_t lcg = 777u;
+  for (int i = 0; i < 60; i++) {
+    lcg = lcg * 1664525u + 1013904223u;
+    VoxelDestructionEvent evt;
+    evt.x = (float)((lcg >> 8) % SPAN) - VOXEL_WORLD_OFFSET;
+    evt.y = (float)(CHUNK_SIZE + (lcg >> 4) % 12);
+    evt.z = (float)((lcg >> 16) % SPAN) - VOXEL_WORLD_OFFSET;
+    evt.radius = 3.0f;
+    evt.is_box = false;
+    dq.events.push_back(evt);
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (auto &evt : dq.events)
+    musket::destroy_sphere(g, evt.x, evt.y, evt.z, evt.radius);
+  auto end = std::chrono::high_resolution_clock::now();
+  double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+  MESSAGE("60-gun bombardment: ", ms, "ms");
+  CHECK(ms < 16.0);
+  g.release();
+}
+
+TEST_CASE("Cat6: 4km fortified map saves and loads under a second") {
+  const char *path = "musket_test_map.mvox";
+  VoxelGrid g = {};
+  g.allocate();
+
+  // Full 4096m × 4096m earth floor (sentinels) ...
+  for (int cz = 0; cz < MAP_CHUNKS_Z; cz++)
+    for (int cx = 0; cx < MAP_CHUNKS_X; cx++)
+      g.chunk_map[VoxelGrid::chunk_index(cx, 0, cz)] = 1;
+
+  // ... plus a 640m fortified district: walls + hoardings, two layers
+  constexpr int DISTRICT = 40 * CHUNK_SIZE;
+  g.edit_region(0, CHUNK_SIZE, 0, DISTRICT - 1, 3 * CHUNK_SIZE - 1,
+                DISTRICT - 1, false,
+                [](uint8_t *voxels, const VoxelEditSpan &s) -> VoxelEditResult {
+                  int solids = 0;
+                  for (int ly = 0; ly < CHUNK_SIZE; ly++)
+                    for (int lz = 0; lz < CHUNK_SIZE; lz++)
+                      for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+                        uint8_t m = VMAT_AIR;
+                        if (lx >= 6 && lx < 10 && (s.oy + ly) < 28)
+                          m = VMAT_STONE;
+                        else if (lz == 0 && ly == 12)
+                          m = VMAT_WOOD;
+                        voxels[VoxelGrid::local_index(lx, ly, lz)] = m;
+                        solids += (m != VMAT_AIR);
+                      }
+                  return {CHUNK_VOLUME, solids};
+                });
+
+  auto t0 = std::chrono::high_resolution_clock::now();
+  REQUIRE(g.save_file(path));
+  auto t1 = std::chrono::high_resolution_clock::now();
+
+  VoxelGrid loaded = {};
+  loaded.allocate();
+  REQUIRE(loaded.load_file(path));
+  auto t2 = std::chrono::high_resolution_clock::now();
+
+  double save_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+  double load_ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+  MESSAGE("4km map: ", loaded.active_chunk_count - 2, " chunks  save=",
+          save_ms, "ms  load=", load_ms, "ms");
+  CHECK(loaded.active_chunk_count == g.active_chunk_count);
+  CHECK(loaded.get_voxel(7, CHUNK_SIZE + 3, 5) == VMAT_STONE);
+  CHECK(loaded.get_voxel(4000, 5, 4000) == VMAT_EARTH);
+  CHECK(load_ms < 250.0);
+
+  loaded.release();
+  g.release();
+  std::remove(path);
+}
+
+TEST_CASE("Cat6: Full-map terrain generation") {
+  VoxelGrid g = {};
+  g.allocate();
+  const int hw = musket::shared_worker_pool().size();
+
+  auto start = std::chrono::high_resolution_clock::now();
+  const bool ok = g.generate_terrain(TerrainParams{}, hw);
+  auto end = std::chrono::high_resolution_clock::now();
+  REQUIRE(ok);
+  double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+  int earth = 0;
+  for (int i = 0; i < TOTAL_MAP_CHUNKS; i++)
+    earth += (g.chunk_map[i] == 1);
+  MESSAGE("4km terrain: ", ms, "ms on ", hw, " threads  surface chunks=",
+          g.active_chunk_count - 2, " earth sentinels=", earth,
+          " packed=", g.storage_bytes() / (1024 * 1024), "MB");
+  CHECK(g.active_chunk_count > 2);
+  CHECK(ms < 5000.0);
+  g.release();
+}
+
+TEST_CASE("Cat6: Projectile pool cost stays flat over an hour of bombardment") {
+  flecs::world ecs;
+  auto *init = new ProjectilePool();
+  std::memset(init, 0, sizeof(ProjectilePool));
+  ecs.set<ProjectilePool>(*init);
+  delete init;
+  musket::register_artillery_systems(ecs);
+
+  // 10 six-gun batteries firing at 300m, re-ordered as soon as they reload
+  std::vector<flecs::entity> batteries;
+  for (int b = 0; b < 10; b++) {
+    batteries.push_back(ecs.entity()
+                            .set<Position>({(float)b * 20.0f - 100.0f, 0.0f})
+                            .set<ArtilleryBattery>(
+                                {6, 0.0f, 0.0f, 100000, 0, false, 0.0f})
+                            .set<TeamId>({(uint8_t)(b % 2)}));
+  }
+
+  // 20Hz keeps an hour of battle to 72K frames; shots still arc and land
+  constexpr float DT = 1.0f / 20.0f;
+  constexpr int FRAMES_PER_MINUTE = 20 * 60;
+  int peak_live = 0;
+  double first_minute_ms = 0.0, last_minute_ms = 0.0;
+
+  for (int minute = 0; minute < 60; minute++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int f = 0; f < FRAMES_PER_MINUTE; f++) {
+      for (auto &b : batteries)
+        if (!b.has<FireOrder>())
+          b.set<FireOrder>({b.get<Position>().x, -300.0f});
+      ecs.progress(DT);
+      int live = ecs.get<ProjectilePool>().count;
+      peak_live = live > peak_live ? live : peak_live;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    if (minute == 0)
+      first_minute_ms = ms;
+    last_minute_ms = ms;
+  }
+
+  const ProjectilePool &pool = ecs.get<ProjectilePool>();
+  MESSAGE("Projectile pool: first minute ", first_minute_ms,
+          "ms  60th minute ", last_minute_ms, "ms  peak live=", peak_live);
+  // 60 shots per 15s volley, each in flight a few seconds
+  CHECK(peak_live <= 60 * 2);
+  CHECK(pool.dropped == 0);
+  CHECK(last_minute_ms < first_minute_ms * 2.0 + 5.0);
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat6: Spring-damper integrates 100K soldiers under 1ms") {
+  // 100 battalions of 1000, every slot 2m off so the springs are loaded
+  for (int i = 0; i < 100000; i++) {
+    uint32_t bat = (uint32_t)(i / 1000);
+    float x = (float)(i % 1000) * 0.8f;
+    float z = (float)bat * 10.0f;
+    spawn_armed_soldier(bat, x, z).set<SoldierFormationTarget>(
+        {x + 2.0f, z, 50.0f, 2.0f, face_snorm(0.0f), face_snorm(-1.0f), true,
+         0, {}});
+  }
+
+  flecs::system spring = ecs.system(ecs.lookup("SpringDamperPhysics"));
+  spring.run(1.0f / 60.0f); // Warm caches
+
+  double best_ms = 1e9;
+  for (int r = 0; r < 10; r++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    spring.run(1.0f / 60.0f);
+    auto end = std::chrono::high_resolution_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    best_ms = ms < best_ms ? ms : best_ms;
+  }
+
+  MESSAGE("100K spring-damper: ", best_ms, "ms");
+  CHECK(best_ms < 1.0);
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat6: 100 battalions form square and wheel in one frame") {
+  // 100 battalions of 500 in line, all ordered into square facing +X
+  for (int i = 0; i < 50000; i++) {
+    uint32_t bat = (uint32_t)(i / 500);
+    int k = i % 500;
+    spawn_armed_soldier(bat, (float)(k / 3) * 0.8f,
+                        (float)bat * 300.0f + (float)(k % 3) * 1.2f,
+                        (uint8_t)(k % 3));
+  }
+  flecs::system solve = ecs.system(ecs.lookup("FormationSolveSystem"));
+  solve.run(1.0f / 60.0f); // Warm the cached query
+
+  auto &roster = ecs.get_mut<FormationRoster>();
+  for (int b = 0; b < 100; b++)
+    roster.request(b, SHAPE_SQUARE, 1.0f, 0.0f);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  solve.run(1.0f / 60.0f);
+  auto end = std::chrono::high_resolution_clock::now();
+  double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+  MESSAGE("100 battalions re-formed: ", ms, "ms");
+  CHECK(ms < 16.6);
+  CHECK(g_macro_battalions[99].shape == SHAPE_SQUARE);
+  CHECK(ecs.get<FormationRoster>().bat_start[100] == 50000);
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat6: 150-battalion macro snapshot fits the byte budget") {
+  musket::MacroSyncHistory h = {};
+  h.allocate();
+  std::vector<uint8_t> buf;
+  PanicGrid &panic = ecs.get_mut<PanicGrid>();
+
+  // 75 battalions a side, 600 men each, facing each other 300m apart
+  for (int b = 0; b < 150; b++) {
+    g_battalion_pool.claim(b);
+    MacroBattalion &mb = g_macro_battalions[b];
+    mb.team_id = (uint32_t)(b % 2);
+    mb.cx = (float)(b / 2) * 40.0f - 1500.0f;
+    mb.cz = mb.team_id ? 150.0f : -150.0f;
+    mb.anchor_x = mb.cx;
+    mb.anchor_z = mb.cz;
+    mb.dir_z = mb.team_id ? -1.0f : 1.0f;
+    mb.alive_count = 600;
+    mb.flag_alive = mb.drummer_alive = mb.officer_alive = true;
+  }
+  // A diffused fear plume over each line (5×50 cells per team)
+  auto plume = [&](float scale) {
+    for (int t = 0; t < 2; t++)
+      for (int z = 0; z < 5; z++)
+        for (int x = 0; x < 50; x++) {
+          float &p = panic.read_buf[t][(28 + t * 4 + z) * 64 + 7 + x];
+          p = scale < 0.0f ? 0.9f - 0.01f * (float)x : p * scale;
+        }
+  };
+  plume(-1.0f);
+
+  uint32_t base = musket::capture_macro_sync(h, 0, &panic, nullptr);
+  size_t full = musket::encode_macro_sync(h, base, 0, buf);
+
+  // 5 seconds at 10Hz: both lines advance at ~1.5m/s, ~100 casualties
+  // and a decaying plume per snapshot, client acks one snapshot late
+  size_t total = 0, worst = 0;
+  double worst_ms = 0.0;
+  uint32_t slot = 0;
+  for (int s = 1; s <= 50; s++) {
+    for (int b = 0; b < 150; b++) {
+      MacroBattalion &mb = g_macro_battalions[b];
+      mb.cz += mb.dir_z * 0.15f;
+      mb.anchor_z += mb.dir_z * 0.15;
+      if ((b + s) % 3 == 0)
+        mb.alive_count -= 2;
+      mb.flag_cohesion = 1.0f - 0.002f * (float)s;
+    }
+    for (int d = 0; d < 100; d++)
+      musket::log_macro_sync_death(h, (uint32_t)((d * 7 + s) % 150), slot++);
+    plume(0.97f);
+
+    const uint32_t seq =
+        musket::capture_macro_sync(h, (uint64_t)s * 6, &panic, nullptr);
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t bytes = musket::encode_macro_sync(h, seq, seq > 2 ? seq - 2 : base,
+                                             buf);
+    auto end = std::chrono::high_resolution_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    total += bytes;
+    worst = bytes > worst ? bytes : worst;
+    worst_ms = ms > worst_ms ? ms : worst_ms;
+  }
+
+  MESSAGE("Macro snapshot: full ", full, "B, delta avg ", total / 50,
+          "B worst ", worst, "B, encode worst ", worst_ms, "ms");
+  CHECK(full < 8 * 1024);
+  CHECK(worst < 4 * 1024); // 40KB/s per client at 10Hz
+  CHECK(worst_ms < 1.0);
+  h.release();
+}
+
+TEST_CASE("Cat6: Replay fast-forwards a minute of battle in under 5s") {
+  // The regression workload: a recorded battle, replayed headless with
+  // no clock in the loop
+  std::vector<uint8_t> log;
+  const uint64_t recorded = record_replay_battle(log, 3600);
+
+  musket::ReplayPlayer p;
+  REQUIRE(p.load(log.data(), log.size()));
+  EngineTestHarness h;
+  musket::register_sim_commands(h.ecs);
+  REQUIRE(musket::begin_replay_playback(h.ecs, p, test_compute_centroids));
+
+  auto start = std::chrono::high_resolution_clock::now();
+  const uint64_t ran = musket::fast_forward_replay(
+      h.ecs, p, ~0ULL, test_compute_centroids, harness_replay_spawn, nullptr);
+  auto end = std::chrono::high_resolution_clock::now();
+  double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+  MESSAGE("Replay fast-forward: ", ran, " ticks in ", ms, "ms (",
+          ran / (ms / 1000.0), " ticks/s), log ", log.size(), " bytes");
+  CHECK(ran == 3600);
+  CHECK_FALSE(p.diverged());
+  CHECK(musket::world_state_hash(h.ecs) == recorded);
+  CHECK(ms < 5000.0); // 12× real time
+  musket::release_sim_commands(h.ecs);
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat6: 200K-soldier snapshot saves and restores in ~100ms") {
+  constexpr int PER_BAT = 500;
+  constexpr int BATS = 400; // 200K soldiers
+  std::vector<Position> pos(PER_BAT);
+  std::vector<SoldierFormationTarget> target(PER_BAT);
+  for (int b = 0; b < BATS; b++) {
+    for (int i = 0; i < PER_BAT; i++) {
+      float x = (float)(i / 3) * 0.8f, z = (float)b * 10.0f + (i % 3) * 1.2f;
+      pos[i] = {x, z};
+      target[i] = {x, z, 50.0f, 2.0f, face_snorm(0.0f), face_snorm(-1.0f),
+                   true, (uint8_t)(i % 3), {}};
+    }
+    g_battalion_pool.claim(b);
+    musket::InfantryBlock block = {};
+    block.count = PER_BAT;
+    block.bat_id = (uint32_t)b;
+    block.team = (uint8_t)(b % 2);
+    block.pos = pos.data();
+    block.target = target.data();
+    block.stats = {4.0f, 8.0f};
+    block.musket = {0.0f, 30, 13};
+    block.defense = {0.2f};
+    musket::spawn_infantry_block(ecs, block);
+  }
+  step(2);
+  const uint64_t before = musket::world_state_hash(ecs);
+  const int alive = ecs.count<IsAlive>();
+
+  std::vector<uint8_t> snap;
+  snap.reserve(32 << 20);
+  auto t0 = std::chrono::high_resolution_clock::now();
+  REQUIRE(musket::capture_world_snapshot(ecs, snap));
+  auto t1 = std::chrono::high_resolution_clock::now();
+  REQUIRE(musket::restore_world_snapshot(ecs, snap.data(), snap.size()));
+  auto t2 = std::chrono::high_resolution_clock::now();
+  double save_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+  double load_ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+  MESSAGE("200K snapshot: ", snap.size() >> 20, "MB, save ", save_ms,
+          "ms, restore ", load_ms, "ms");
+  CHECK(ecs.count<IsAlive>() == alive);
+  CHECK(musket::world_state_hash(ecs) == before);
+  CHECK(save_ms < 100.0);
+  CHECK(load_ms < 100.0); // Includes deleting the 200K it replaces
+}
+
+TEST_CASE_FIXTURE(EngineTestHarness,
+                  "Cat6: Profiler names the slowest systems in a 10K battle") {
+  // Set MUSKET_PROFILE_TRACE=<path> to keep the Chrome trace
+  const char *keep = std::getenv("MUSKET_PROFILE_TRACE");
+  const char *path = keep ? keep : "musket_test_profile.json";
+
+  constexpr int PER_BAT = 500;
+  constexpr int BATS = 20; // Two facing lines of 10 battalions
+  std::vector<Position> pos(PER_BAT);
+  std::vector<SoldierFormationTarget> target(PER_BAT);
+  for (int b = 0; b < BATS; b++) {
+    const float line_z = (b % 2) ? -60.0f : 0.0f;
+    for (int i = 0; i < PER_BAT; i++) {
+      float x = (float)(b / 2) * 140.0f + (float)(i / 3) * 0.8f;
+      float z = line_z + (i % 3) * 1.2f;
+      pos[i] = {x, z};
+      target[i] = {x, z, 50.0f, 2.0f, face_snorm(0.0f), face_snorm(-1.0f),
+                   true, (uint8_t)(i % 3), {}};
+    }
+    g_battalion_pool.claim(b);
+    musket::InfantryBlock block = {};
+    block.count = PER_BAT;
+    block.bat_id = (uint32_t)b;
+    block.team = (uint8_t)(b % 2);
+    block.pos = pos.data();
+    block.target = target.data();
+    block.stats = {4.0f, 8.0f};
+    block.musket = {0.0f, 30, 13};
+    block.defense = {0.2f};
+    musket::spawn_infantry_block(ecs, block);
+  }
+
+  musket::SimProfiler *p = musket::register_sim_profiler(ecs);
+  musket::set_profiling(ecs, true);
+  for (int t = 0; t < 120; t++)
+    musket::step_simulation(ecs, test_compute_centroids);
+
+  std::vector<musket::ProfileStats> stats;
+  musket::profile_stats(*p, stats);
+  const musket::ProfileStats &tick = stats[musket::PROFILE_TICK];
+  CHECK(tick.samples == 120);
+  std::vector<const musket::ProfileStats *> slowest;
+  for (const musket::ProfileStats &s : stats)
+    if (s.system && s.samples)
+      slowest.push_back(&s);
+  REQUIRE(slowest.size() >= 5);
+  std::sort(slowest.begin(), slowest.end(),
+            [](const musket::ProfileStats *a, const musket::ProfileStats *b) {
+              return a->p99_ms > b->p99_ms;
+            });
+  MESSAGE("10K battle tick: avg ", tick.avg_ms, "ms, p99 ", tick.p99_ms,
+          "ms, Flecs allocs/tick ", tick.allocs_avg);
+  for (int k = 0; k < 5; k++)
+    MESSAGE("  ", std::string(slowest[k]->name), ": p99 ", slowest[k]->p99_ms, "ms avg ",
+            slowest[k]->avg_ms, "ms, ", slowest[k]->entities, " entities, ",
+            slowest[k]->allocs_avg, " allocs/run");
+  CHECK(slowest[0]->p99_ms <= tick.max_ms);
+
+  // The trace holds one complete event per run
+  REQUIRE(musket::write_profile_trace(*p, path));
+  FILE *f = std::fopen(path, "rb");
+  REQUIRE(f);
+  std::string json;
+  char buf[4096];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0)
+    json.append(buf, n);
+  std::fclose(f);
+  size_t events = 0;
+  for (size_t at = json.find("\"ph\":\"X\""); at != std::string::npos;
+       at = json.find("\"ph\":\"X\"", at + 1))
+    events++;
+  CHECK(events == p->trace_count);
+  CHECK(json.compare(0, 17, "{\"displayTimeUnit") == 0);
+  CHECK(json.find("\"name\":\"VolleyFireSystem\"") != std::string::npos);
+  if (!keep)
+    std::remove(path);
+  musket::release_sim_profiler(ecs);
 }
@@ -0,0 +1,717 @@
+// ═════════════════════════════════════════════════════════════
+// Category 8: VOXEL — Chunk Storage & Destruction
+// ═════════════════════════════════════════════════════════════
+
+// RAII owner for a heap-backed VoxelGrid (no ECS world needed)
+struct VoxelTestGrid {
+  VoxelGrid g = {};
+  VoxelTestGrid() { g.allocate(); }
+  ~VoxelTestGrid() { g.release(); }
+};
+
+// Fortified-city column, three chunk layers high:
+//   y  0-15: earth with stone cellar walls          (2 materials)
+//   y 16-31: stone curtain wall + wood hoardings    (3 materials)
+//   y 32-47: timber roofs over open air             (2 materials)
+static uint8_t city_material(int x, int y, int z) {
+  int lx = x % CHUNK_SIZE, ly = y % CHUNK_SIZE, lz = z % CHUNK_SIZE;
+  if (y < CHUNK_SIZE)
+    return (lx >= 6 && lx < 10) ? VMAT_STONE : VMAT_EARTH;
+  if (y < 2 * CHUNK_SIZE) {
+    if (lx >= 6 && lx < 10 && ly < 12)
+      return VMAT_STONE;
+    if (lz == 0 && ly == 12)
+      return VMAT_WOOD;
+    return VMAT_AIR;
+  }
+  if (y < 3 * CHUNK_SIZE)
+    return (lx >= 4 && lx < 12 && ly < 4) ? VMAT_WOOD : VMAT_AIR;
+  return VMAT_AIR;
+}
+
+static void fill_chunk(VoxelGrid &g, int cy) {
+  for (int y = cy * CHUNK_SIZE; y < (cy + 1) * CHUNK_SIZE; y++)
+    for (int z = 0; z < CHUNK_SIZE; z++)
+      for (int x = 0; x < CHUNK_SIZE; x++)
+        g.set_voxel(x, y, z, city_material(x, y, z));
+}
+
+TEST_CASE("Cat8: Chunk storage layout") {
+  CHECK(sizeof(VoxelChunk) == 64);
+  CHECK(alignof(VoxelChunk) == 64);
+  CHECK(sizeof(VoxelHotChunk) == 4160);
+  CHECK(sizeof(VoxelRun) == 4);
+}
+
+TEST_CASE("Cat8: Palette chunk round-trips through the hot cache") {
+  VoxelTestGrid vt;
+  VoxelGrid &g = vt.g;
+
+  fill_chunk(g, 1); // Wall layer: air + stone + wood
+  g.flush_hot_cache();
+
+  const VoxelChunk &c =
+      g.chunk_pool[g.chunk_map[VoxelGrid::chunk_index(0, 1, 0)]];
+  CHECK(c.hot_slot == VOXEL_NO_HOT_SLOT);
+  CHECK(c.storage == VSTORE_PALETTE);
+  CHECK(c.bits == 2);
+  CHECK(c.payload_bytes == CHUNK_VOLUME / 4);
+
+  int mismatches = 0;
+  int solids = 0;
+  for (int y = CHUNK_SIZE; y < 2 * CHUNK_SIZE; y++)
+    for (int z = 0; z < CHUNK_SIZE; z++)
+      for (int x = 0; x < CHUNK_SIZE; x++) {
+        uint8_t m = g.get_voxel(x, y, z);
+        if (m != city_material(x, y, z))
+          mismatches++;
+        if (m != VMAT_AIR)
+          solids++;
+      }
+  CHECK(mismatches == 0);
+  CHECK(c.solid_count == solids);
+}
+
+TEST_CASE("Cat8: Layered chunk packs as RLE") {
+  VoxelTestGrid vt;
+  VoxelGrid &g = vt.g;
+
+  // Rubble settled on earth under open air — 3 runs, 12 bytes
+  for (int y = 0; y < CHUNK_SIZE; y++)
+    for (int z = 0; z < CHUNK_SIZE; z++)
+      for (int x = 0; x < CHUNK_SIZE; x++)
+        g.set_voxel(x, y, z,
+                    y < 5 ? VMAT_EARTH : (y < 7 ? VMAT_RUBBLE : VMAT_AIR));
+
+  g.flush_hot_cache();
+  const VoxelChunk &c = g.chunk_pool[g.chunk_map[0]];
+  CHECK(c.storage == VSTORE_RLE);
+  CHECK(c.payload_bytes == 3 * sizeof(VoxelRun));
+  CHECK(g.get_voxel(3, 4, 9) == VMAT_EARTH);
+  CHECK(g.get_voxel(3, 6, 9) == VMAT_RUBBLE);
+  CHECK(g.get_voxel(3, 7, 9) == VMAT_AIR);
+}
+
+TEST_CASE("Cat8: Write-through keeps palette payload current") {
+  VoxelTestGrid vt;
+  VoxelGrid &g = vt.g;
+
+  fill_chunk(g, 1);
+  g.flush_hot_cache();
+
+  // Fault back in, then write a material already in the palette
+  g.set_voxel(2, CHUNK_SIZE + 14, 9, VMAT_STONE);
+  const VoxelChunk &c =
+      g.chunk_pool[g.chunk_map[VoxelGrid::chunk_index(0, 1, 0)]];
+  CHECK(c.hot_slot != VOXEL_NO_HOT_SLOT);
+  CHECK(c.payload_stale == 0);
+  CHECK(c.read_packed(VoxelGrid::local_index(2, 14, 9)) == VMAT_STONE);
+
+  // Earth takes the spare 4th entry of the 2-bit palette, in sorted
+  // order: the payload matches a fresh repack byte for byte
+  g.set_voxel(3, CHUNK_SIZE + 14, 9, VMAT_EARTH);
+  CHECK(c.payload_stale == 0);
+  CHECK(c.palette_count == 4);
+  CHECK(std::is_sorted(c.palette, c.palette + c.palette_count));
+  {
+    VoxelChunk fresh = {};
+    const uint32_t idx = g.chunk_map[VoxelGrid::chunk_index(0, 1, 0)];
+    g.pack_voxels(fresh, g.hot_voxels(idx));
+    CHECK(fresh.bits == c.bits);
+    CHECK(std::memcmp(fresh.palette, c.palette, c.palette_count) == 0);
+    CHECK(std::memcmp(fresh.payload, c.payload, c.payload_bytes) == 0);
+    delete[] fresh.payload;
+  }
+
+  // Rubble overflows the 2-bit table → repacked on eviction
+  g.set_voxel(4, CHUNK_SIZE + 14, 9, VMAT_RUBBLE);
+  CHECK(c.payload_stale == 1);
+  g.flush_hot_cache();
+  CHECK(c.payload_stale == 0);
+  CHECK(g.get_voxel(4, CHUNK_SIZE + 14, 9) == VMAT_RUBBLE);
+  CHECK(g.get_voxel(3, CHUNK_SIZE + 14, 9) == VMAT_EARTH);
+  CHECK(g.get_voxel(2, CHUNK_SIZE + 14, 9) == VMAT_STONE);
+}
+
+TEST_CASE("Cat8: Fortified city uses >=4x less chunk memory") {
+  VoxelTestGrid vt;
+  VoxelGrid &g = vt.g;
+
+  // 16×16 chunk footprint (256m square), three layers of city blocks
+  constexpr int SPAN = 16 * CHUNK_SIZE;
+  for (int y = 0; y < 3 * CHUNK_SIZE; y++)
+    for (int z = 0; z < SPAN; z++)
+      for (int x = 0; x < SPAN; x++)
+        g.set_voxel(x, y, z, city_material(x, y, z));
+  g.flush_hot_cache();
+
+  int chunks = g.active_chunk_count - 2;
+  size_t raw_bytes = (size_t)chunks * sizeof(VoxelHotChunk);
+  size_t packed_bytes = g.storage_bytes();
+  MESSAGE("City chunks: ", chunks, " raw=", raw_bytes, "B packed=",
+          packed_bytes, "B");
+  CHECK(chunks == 16 * 16 * 3);
+  CHECK(packed_bytes * 4 <= raw_bytes);
+}
+
+// Per-voxel reference for destroy_sphere (pre-M13.6 algorithm)
+static void reference_destroy_sphere(VoxelGrid &g, int cx, int cy, int cz,
+                                     int r) {
+  struct Spawn {
+    int x, y, z;
+  };
+  std::vector<Spawn> rubble;
+  for (int dz = -r; dz <= r; dz++)
+    for (int dy = -r; dy <= r; dy++)
+      for (int dx = -r; dx <= r; dx++) {
+        if (dx * dx + dy * dy + dz * dz > r * r)
+          continue;
+        int vx = cx + dx, vy = cy + dy, vz = cz + dz;
+        uint8_t mat = g.get_voxel(vx, vy, vz);
+        if (mat == VMAT_AIR || mat == VMAT_BEDROCK)
+          continue;
+        g.set_voxel(vx, vy, vz, VMAT_AIR);
+        if (mat == VMAT_STONE && musket::yields_rubble(vx, vy, vz))
+          rubble.push_back({vx, vy, vz});
+      }
+  for (auto &rb : rubble) {
+    int fy = rb.y;
+    while (fy > 0 && g.get_voxel(rb.x, fy - 1, rb.z) == VMAT_AIR)
+      fy--;
+    g.set_voxel(rb.x, fy, rb.z, VMAT_RUBBLE);
+  }
+}
+
+static void fill_city(VoxelGrid &g, int span) {
+  for (int y = 0; y < 3 * CHUNK_SIZE; y++)
+    for (int z = 0; z < span; z++)
+      for (int x = 0; x < span; x++)
+        g.set_voxel(x, y, z, city_material(x, y, z));
+}
+
+TEST_CASE("Cat8: Chunk-coherent destroy_sphere matches per-voxel carve") {
+  VoxelTestGrid a, b;
+  constexpr int SPAN = 3 * CHUNK_SIZE;
+  fill_city(a.g, SPAN);
+  fill_city(b.g, SPAN);
+
+  // Blasts straddling chunk seams in all three axes, plus a deep one
+  // that reaches bedrock-free earth and a wide one spanning 27 chunks
+  const int blasts[][4] = {{16, 16, 16, 3}, {24, 20, 8, 3},
+                           {31, 31, 33, 5}, {20, 4, 20, 4},
+                           {24, 24, 24, 12}};
+  for (auto &bl : blasts) {
+    musket::destroy_sphere(a.g, (float)bl[0] - VOXEL_WORLD_OFFSET, (float)bl[1],
+                   (float)bl[2] - VOXEL_WORLD_OFFSET, (float)bl[3]);
+    reference_destroy_sphere(b.g, bl[0], bl[1], bl[2], bl[3]);
+  }
+
+  int mismatches = 0;
+  for (int y = 0; y < 3 * CHUNK_SIZE; y++)
+    for (int z = 0; z < SPAN; z++)
+      for (int x = 0; x < SPAN; x++)
+        if (a.g.get_voxel(x, y, z) != b.g.get_voxel(x, y, z))
+          mismatches++;
+  CHECK(mismatches == 0);
+
+  // Bulk solid_count must agree with a recount of every chunk
+  for (uint32_t i = 2; i < a.g.active_chunk_count; i++) {
+    const uint8_t *v = a.g.hot_voxels(i);
+    int solids = 0;
+    for (int k = 0; k < CHUNK_VOLUME; k++)
+      solids += (v[k] != VMAT_AIR);
+    CHECK(a.g.chunk_pool[i].solid_count == solids);
+  }
+}
+
+TEST_CASE("Cat8: destroy_box spares bedrock and skips empty chunks") {
+  VoxelTestGrid vt;
+  VoxelGrid &g = vt.g;
+
+  for (int z = 0; z < CHUNK_SIZE; z++)
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+      g.set_voxel(x, 0, z, VMAT_BEDROCK);
+      for (int y = 1; y < 8; y++)
+        g.set_voxel(x, y, z, VMAT_EARTH);
+    }
+  int chunks_before = g.active_chunk_count;
+
+  // Trench reaching up into the (sentinel) air chunk above
+  musket::destroy_box(g, 8.0f - VOXEL_WORLD_OFFSET, 4.0f,
+              8.0f - VOXEL_WORLD_OFFSET, 6.0f);
+
+  CHECK(g.active_chunk_count == chunks_before); // No air chunk allocated
+  CHECK(g.get_voxel(8, 0, 8) == VMAT_BEDROCK);
+  CHECK(g.get_voxel(8, 4, 8) == VMAT_AIR);
+  CHECK(g.get_voxel(2, 7, 2) == VMAT_AIR);
+  CHECK(g.get_voxel(1, 7, 1) == VMAT_EARTH); // Outside the 13³ box
+  const VoxelChunk &c =
+      g.chunk_pool[g.chunk_map[VoxelGrid::chunk_index(0, 0, 0)]];
+  CHECK(c.solid_count == CHUNK_SIZE * CHUNK_SIZE * 8 - 13 * 13 * 7);
+  CHECK(c.dirty_mesh == 1);
+  CHECK(c.payload_stale == 1);
+}
+
+// Siege volley: clustered impacts (overlapping → serialized groups)
+// plus scattered ones (disjoint → parallel groups)
+static std::vector<VoxelDestructionEvent> siege_volley(int count, int span) {
+  std::vector<VoxelDestructionEvent> events;
+  uint32_t lcg = 4242u;
+  for (int i = 0; i < count; i++) {
+    lcg = lcg * 1664525u + 1013904223u;
+    VoxelDestructionEvent evt;
+    bool clustered = (i % 3) == 0;
+    int x = clustered ? 40 + (int)((lcg >> 8) % 8) : (int)((lcg >> 8) % span);
+    int z = clustered ? 40 + (int)((lcg >> 16) % 8)
+                      : (int)((lcg >> 16) % span);
+    evt.x = (float)x - VOXEL_WORLD_OFFSET;
+    evt.y = (float)(CHUNK_SIZE + (lcg >> 4) % 14);
+    evt.z = (float)z - VOXEL_WORLD_OFFSET;
+    evt.radius = (i % 7 == 0) ? 5.0f : 3.0f;
+    evt.is_box = (i % 11 == 0);
+    events.push_back(evt);
+  }
+  return events;
+}
+
+TEST_CASE("Cat8: Parallel destruction is independent of thread count") {
+  constexpr int SPAN = 8 * CHUNK_SIZE;
+  VoxelTestGrid serial, one, many;
+  fill_city(serial.g, SPAN);
+  fill_city(one.g, SPAN);
+  fill_city(many.g, SPAN);
+
+  auto events = siege_volley(120, SPAN);
+  for (const auto &evt : events) {
+    if (evt.is_box)
+      musket::destroy_box(serial.g, evt.x, evt.y, evt.z, evt.radius);
+    else
+      musket::destroy_sphere(serial.g, evt.x, evt.y, evt.z, evt.radius);
+  }
+  musket::resolve_destruction_events(one.g, events, 1);
+  musket::resolve_destruction_events(many.g, events, 4);
+
+  int vs_one = 0, vs_serial = 0;
+  for (int y = 0; y < 3 * CHUNK_SIZE; y++)
+    for (int z = 0; z < SPAN; z++)
+      for (int x = 0; x < SPAN; x++) {
+        uint8_t m = many.g.get_voxel(x, y, z);
+        vs_one += (m != one.g.get_voxel(x, y, z));
+        vs_serial += (m != serial.g.get_voxel(x, y, z));
+      }
+  CHECK(vs_one == 0);
+  // Rubble over pre-faulted chunks lands exactly as the serial drain
+  CHECK(vs_serial == 0);
+
+  for (uint32_t i = 2; i < many.g.active_chunk_count; i++) {
+    const uint8_t *v = many.g.hot_voxels(i);
+    int solids = 0;
+    for (int k = 0; k < CHUNK_VOLUME; k++)
+      solids += (v[k] != VMAT_AIR);
+    CHECK(many.g.chunk_pool[i].solid_count == solids);
+  }
+}
+
+TEST_CASE("Cat8: Destruction wave survives a full hot cache") {
+  constexpr int SPAN = 8 * CHUNK_SIZE;
+  VoxelTestGrid serial, wave;
+  VoxelGrid *grids[2] = {&serial.g, &wave.g};
+
+  // One wall chunk per event, every event its own group
+  std::vector<VoxelDestructionEvent> events;
+  for (int i = 0; i < 16; i++) {
+    VoxelDestructionEvent evt;
+    const int x = (2 * (i % 4) + 1) * CHUNK_SIZE + 8;
+    const int z = (2 * (i / 4) + 1) * CHUNK_SIZE + 8;
+    evt.x = (float)x - VOXEL_WORLD_OFFSET;
+    evt.y = (float)(CHUNK_SIZE + 4);
+    evt.z = (float)z - VOXEL_WORLD_OFFSET;
+    evt.radius = 4.0f;
+    evt.is_box = false;
+    events.push_back(evt);
+  }
+
+  for (VoxelGrid *g : grids) {
+    fill_city(*g, SPAN);
+    // Filler chunks well clear of the city, more than the cache holds
+    for (int i = 0; i < VOXEL_HOT_SLOTS + 64; i++)
+      g->set_voxel((16 + i % 64) * CHUNK_SIZE, 0,
+                   (16 + i / 64) * CHUNK_SIZE, VMAT_EARTH);
+    g->flush_hot_cache();
+
+    // Early events' chunks go hot first, then fillers wind the clock
+    // right back onto them: every later miss would evict one
+    for (int i = 0; i < 4; i++) {
+      int b[6];
+      musket::destruction_chunk_box(events[i], b);
+      for (int cy = b[1]; cy <= b[4]; cy++)
+        for (int cz = b[2]; cz <= b[5]; cz++)
+          for (int cx = b[0]; cx <= b[3]; cx++) {
+            uint32_t idx = g->chunk_map[VoxelGrid::chunk_index(cx, cy, cz)];
+            if (idx >= 2)
+              g->hot_voxels(idx);
+          }
+    }
+    for (int i = 0; g->hot_cursor != 0; i++)
+      g->hot_voxels(g->chunk_map[VoxelGrid::chunk_index(
+          16 + i % 64, 0, 16 + i / 64)]);
+  }
+
+  for (const auto &evt : events)
+    musket::destroy_sphere(serial.g, evt.x, evt.y, evt.z, evt.radius);
+  // Workers fault nothing (asserted in hot_voxels), so no race to lose
+  musket::resolve_destruction_events(wave.g, events, 4);
+
+  int mismatches = 0;
+  for (int y = 0; y < 3 * CHUNK_SIZE; y++)
+    for (int z = 0; z < SPAN; z++)
+      for (int x = 0; x < SPAN; x++)
+        mismatches += (wave.g.get_voxel(x, y, z) != serial.g.get_voxel(x, y, z));
+  CHECK(mismatches == 0);
+  CHECK(wave.g.hot_frozen == 0);
+  for (int s = 0; s < VOXEL_HOT_SLOTS; s++)
+    CHECK(wave.g.hot_pool[s].pinned == 0);
+}
+
+TEST_CASE("Cat8: Later events in a group see rubble deferred by earlier "
+          "ones") {
+  VoxelTestGrid serial, wave;
+  VoxelGrid *grids[2] = {&serial.g, &wave.g};
+
+  // Four stone towers on chunk layer 2 over an unallocated air layer:
+  // the first blast drops rubble into air (deferred), the second one, in
+  // the same column group, blasts the spot it lands on
+  std::vector<VoxelDestructionEvent> events;
+  for (int t = 0; t < 4; t++) {
+    const int tx = 2 * t * CHUNK_SIZE + 8;
+    for (VoxelGrid *g : grids)
+      for (int y = 0; y < 3 * CHUNK_SIZE; y++)
+        for (int z = 0; z < CHUNK_SIZE; z++)
+          for (int x = tx - 8; x < tx + 8; x++) {
+            if (y < CHUNK_SIZE)
+              g->set_voxel(x, y, z, VMAT_EARTH);
+            else if (y >= 2 * CHUNK_SIZE && x > tx - 5 && x < tx + 5 &&
+                     z > 3 && z < 13)
+              g->set_voxel(x, y, z, VMAT_STONE);
+          }
+    VoxelDestructionEvent evt;
+    evt.x = (float)tx - VOXEL_WORLD_OFFSET;
+    evt.z = 8.0f - VOXEL_WORLD_OFFSET;
+    evt.radius = 3.0f;
+    evt.is_box = false;
+    evt.y = (float)(2 * CHUNK_SIZE);
+    events.push_back(evt);
+    evt.y = (float)CHUNK_SIZE;
+    evt.radius = 2.0f;
+    events.push_back(evt);
+  }
+  REQUIRE(wave.g.chunk_map[VoxelGrid::chunk_index(0, 1, 0)] == 0);
+
+  for (const auto &evt : events)
+    musket::destroy_sphere(serial.g, evt.x, evt.y, evt.z, evt.radius);
+  musket::resolve_destruction_events(wave.g, events, 4);
+
+  int mismatches = 0, rubble = 0;
+  for (int y = 0; y < 3 * CHUNK_SIZE; y++)
+    for (int z = 0; z < CHUNK_SIZE; z++)
+      for (int x = 0; x < 8 * CHUNK_SIZE; x++) {
+        uint8_t m = wave.g.get_voxel(x, y, z);
+        mismatches += (m != serial.g.get_voxel(x, y, z));
+        rubble += (m == VMAT_RUBBLE);
+      }
+  CHECK(mismatches == 0);
+  // Rubble outside the second blast survives it; inside, none does
+  CHECK(rubble > 0);
+  CHECK(wave.g.get_voxel(8, CHUNK_SIZE, 8) != VMAT_RUBBLE);
+}
+
+// ── M13.8: Save Files ──────────────────────────────────────────
+
+static int count_mismatches(VoxelGrid &a, VoxelGrid &b, int span, int height) {
+  int mismatches = 0;
+  for (int y = 0; y < height; y++)
+    for (int z = 0; z < span; z++)
+      for (int x = 0; x < span; x++)
+        mismatches += (a.get_voxel(x, y, z) != b.get_voxel(x, y, z));
+  return mismatches;
+}
+
+TEST_CASE("Cat8: Save file round-trips through a mapped load") {
+  const char *path = "musket_test_roundtrip.mvox";
+  constexpr int SPAN = 3 * CHUNK_SIZE;
+  VoxelTestGrid src, dst;
+  fill_city(src.g, SPAN);
+  for (int cz = 0; cz < 8; cz++) // Untouched earth beyond the city
+    for (int cx = 4; cx < 12; cx++)
+      src.g.chunk_map[VoxelGrid::chunk_index(cx, 0, cz)] = 1;
+
+  REQUIRE(src.g.save_file(path));
+  REQUIRE(dst.g.load_file(path));
+
+  CHECK(dst.g.active_chunk_count == src.g.active_chunk_count);
+  src.g.flush_hot_cache(); // Compare packed bytes only
+  CHECK(dst.g.storage_bytes() == src.g.storage_bytes());
+  CHECK(count_mismatches(src.g, dst.g, SPAN, 3 * CHUNK_SIZE) == 0);
+  CHECK(dst.g.get_voxel(5 * CHUNK_SIZE, 3, 2 * CHUNK_SIZE) == VMAT_EARTH);
+
+  // Payloads live in the mapping until touched
+  const VoxelChunk &wall =
+      dst.g.chunk_pool[dst.g.chunk_map[VoxelGrid::chunk_index(0, 1, 0)]];
+  CHECK(wall.payload_mapped == 1);
+
+  // Editing a mapped chunk copies on write; the file is never modified
+  dst.g.set_voxel(7, CHUNK_SIZE + 2, 3, VMAT_RUBBLE);
+  dst.g.flush_hot_cache();
+  CHECK(wall.payload_mapped == 0);
+  CHECK(dst.g.get_voxel(7, CHUNK_SIZE + 2, 3) == VMAT_RUBBLE);
+  CHECK(dst.g.get_voxel(8, CHUNK_SIZE + 2, 3) == VMAT_STONE);
+
+  // stream_in detaches a region ahead of use
+  dst.g.stream_in(0, 0, 2, 2);
+  int still_mapped = 0;
+  for (uint32_t i = 2; i < dst.g.active_chunk_count; i++)
+    still_mapped += dst.g.chunk_pool[i].payload_mapped;
+  CHECK(still_mapped == 0);
+
+  std::remove(path);
+}
+
+TEST_CASE("Cat8: Corrupted save files are rejected before any chunk loads") {
+  const char *path = "musket_test_corrupt.mvox";
+  VoxelTestGrid src;
+  fill_city(src.g, 2 * CHUNK_SIZE);
+  for (int y = 0; y < CHUNK_SIZE; y++) // One layered RLE chunk
+    for (int z = 0; z < CHUNK_SIZE; z++)
+      for (int x = 3 * CHUNK_SIZE; x < 4 * CHUNK_SIZE; x++)
+        src.g.set_voxel(x, y, z,
+                        y < 5 ? VMAT_EARTH : (y < 7 ? VMAT_RUBBLE : VMAT_AIR));
+  REQUIRE(src.g.save_file(path));
+  FILE *f = std::fopen(path, "rb");
+  REQUIRE(f);
+  std::vector<uint8_t> good(1 << 20);
+  good.resize(std::fread(good.data(), 1, good.size(), f));
+  std::fclose(f);
+
+  VoxelFileHeader hdr;
+  std::memcpy(&hdr, good.data(), sizeof(hdr));
+  REQUIRE(hdr.chunk_count >= 2);
+  auto entry = [&](std::vector<uint8_t> &b, uint32_t i) {
+    return reinterpret_cast<VoxelFileChunk *>(b.data() + hdr.index_offset) + i;
+  };
+  auto find = [&](uint8_t storage, bool payload) {
+    for (uint32_t i = 0; i < hdr.chunk_count; i++) {
+      const VoxelFileChunk *e = entry(good, i);
+      if (e->storage == storage && (e->payload_bytes > 0) == payload)
+        return (int)i;
+    }
+    return -1;
+  };
+  const int packed = find(VSTORE_PALETTE, true);
+  const int rle = find(VSTORE_RLE, true);
+  REQUIRE(packed >= 0);
+  REQUIRE(rle >= 0);
+
+  VoxelTestGrid dst;
+  auto loads = [&](const std::vector<uint8_t> &b) {
+    FILE *out = std::fopen(path, "wb");
+    REQUIRE(out);
+    std::fwrite(b.data(), 1, b.size(), out);
+    std::fclose(out);
+    return dst.g.load_file(path);
+  };
+  REQUIRE(loads(good));
+
+  auto corrupt = [&](int i, auto &&edit) {
+    std::vector<uint8_t> b = good;
+    edit(*entry(b, (uint32_t)i), b);
+    return loads(b);
+  };
+  auto rle_run = [&](std::vector<uint8_t> &b, const VoxelFileChunk &e,
+                     uint32_t r) {
+    return reinterpret_cast<VoxelRun *>(b.data() + e.offset) + r;
+  };
+
+  // Palette: odd widths, and payloads that disagree with the width
+  CHECK_FALSE(corrupt(packed, [](VoxelFileChunk &e, auto &) { e.bits = 3; }));
+  CHECK_FALSE(corrupt(packed, [](VoxelFileChunk &e, auto &) { e.bits = 8; }));
+  CHECK_FALSE(corrupt(packed, [](VoxelFileChunk &e, auto &) {
+    e.bits = e.bits == 4 ? 2 : (uint8_t)(e.bits * 2);
+  }));
+  CHECK_FALSE(corrupt(packed, [](VoxelFileChunk &e, auto &) {
+    e.palette_count = 0;
+  }));
+  // RAW needs the full 4KB
+  CHECK_FALSE(corrupt(packed, [](VoxelFileChunk &e, auto &) {
+    e.storage = VSTORE_RAW;
+  }));
+  // RLE: partial runs, runs that stop short or step backwards
+  CHECK_FALSE(corrupt(rle, [](VoxelFileChunk &e, auto &) {
+    e.payload_bytes -= 2;
+  }));
+  CHECK_FALSE(corrupt(rle, [&](VoxelFileChunk &e, auto &b) {
+    rle_run(b, e, e.payload_bytes / sizeof(VoxelRun) - 1)->end--;
+  }));
+  CHECK_FALSE(corrupt(rle, [&](VoxelFileChunk &e, auto &b) {
+    e.payload_bytes -= sizeof(VoxelRun); // Last run dropped
+  }));
+  CHECK_FALSE(corrupt(rle, [&](VoxelFileChunk &e, auto &b) {
+    rle_run(b, e, 0)->end = 0;
+  }));
+  CHECK_FALSE(corrupt(rle, [&](VoxelFileChunk &e, auto &b) {
+    rle_run(b, e, 0)->end = CHUNK_VOLUME + 1;
+  }));
+  // The same chunk twice, or out of order
+  CHECK_FALSE(corrupt(1, [&](VoxelFileChunk &e, auto &b) {
+    e.map_idx = entry(b, 0)->map_idx;
+  }));
+  CHECK_FALSE(corrupt(0, [&](VoxelFileChunk &e, auto &b) {
+    std::swap(e.map_idx, entry(b, 1)->map_idx);
+  }));
+
+  // A rejected file leaves the previous world in place
+  CHECK(dst.g.active_chunk_count == src.g.active_chunk_count);
+  std::remove(path);
+}
+
+TEST_CASE("Cat8: Delta save holds only edited chunks and chains in order") {
+  const char *base = "musket_test_base.mvox";
+  const char *delta = "musket_test_delta.mvox";
+  constexpr int SPAN = 4 * CHUNK_SIZE;
+  VoxelTestGrid live, restored;
+  fill_city(live.g, SPAN);
+  REQUIRE(live.g.save_file(base));
+
+  // One breach in a corner of the city: touches a handful of chunks
+  musket::destroy_sphere(live.g, 8.0f - VOXEL_WORLD_OFFSET, 20.0f,
+                         8.0f - VOXEL_WORLD_OFFSET, 3.0f);
+  REQUIRE(live.g.save_delta(delta));
+
+  FILE *f = std::fopen(delta, "rb");
+  REQUIRE(f != nullptr);
+  std::fseek(f, 0, SEEK_END);
+  long delta_bytes = std::ftell(f);
+  std::fclose(f);
+  f = std::fopen(base, "rb");
+  REQUIRE(f != nullptr);
+  std::fseek(f, 0, SEEK_END);
+  long base_bytes = std::ftell(f);
+  std::fclose(f);
+  MESSAGE("Base: ", base_bytes, "B  delta: ", delta_bytes, "B");
+  CHECK(delta_bytes * 10 < base_bytes);
+
+  REQUIRE(restored.g.load_file(base));
+  CHECK(restored.g.apply_delta(delta));
+  CHECK(count_mismatches(live.g, restored.g, SPAN, 3 * CHUNK_SIZE) == 0);
+
+  // Re-applying is out of order (base generation no longer matches)
+  CHECK_FALSE(restored.g.apply_delta(delta));
+
+  std::remove(base);
+  std::remove(delta);
+}
+
+// Byte-for-byte comparison of two generated maps: chunk map, then every
+// pool header's encoding and packed payload.
+static bool same_terrain(const VoxelGrid &a, const VoxelGrid &b) {
+  if (a.active_chunk_count != b.active_chunk_count)
+    return false;
+  if (std::memcmp(a.chunk_map, b.chunk_map,
+                  TOTAL_MAP_CHUNKS * sizeof(uint32_t)) != 0)
+    return false;
+  for (uint32_t i = 2; i < a.active_chunk_count; i++) {
+    const VoxelChunk &ca = a.chunk_pool[i];
+    const VoxelChunk &cb = b.chunk_pool[i];
+    if (ca.storage != cb.storage || ca.solid_count != cb.solid_count ||
+        ca.payload_bytes != cb.payload_bytes ||
+        std::memcmp(ca.palette, cb.palette, sizeof(ca.palette)) != 0 ||
+        std::memcmp(ca.payload, cb.payload, ca.payload_bytes) != 0)
+      return false;
+  }
+  return true;
+}
+
+TEST_CASE("Cat8: Terrain is deterministic and stores uniform chunks as "
+          "sentinels") {
+  VoxelTestGrid one, many, other;
+  REQUIRE(one.g.generate_terrain(TerrainParams{}, 1));
+  REQUIRE(many.g.generate_terrain(TerrainParams{}, 3));
+  CHECK(same_terrain(one.g, many.g));
+
+  // Only surface/transition chunks reach the pool
+  int uniform = 0;
+  for (uint32_t i = 2; i < one.g.active_chunk_count; i++) {
+    const VoxelChunk &c = one.g.chunk_pool[i];
+    if (c.solid_count == 0)
+      uniform++;
+    else if (c.solid_count == CHUNK_VOLUME) {
+      const uint8_t *v = one.g.hot_voxels(i);
+      int earth = 0;
+      for (int k = 0; k < CHUNK_VOLUME; k++)
+        earth += (v[k] == VMAT_EARTH);
+      uniform += (earth == CHUNK_VOLUME);
+    }
+  }
+  CHECK(uniform == 0);
+
+  // Every column is solid at the bottom and has an open surface above
+  int bad_columns = 0;
+  for (int x = 5; x < MAP_CHUNKS_X * CHUNK_SIZE; x += 97) {
+    for (int z = 11; z < MAP_CHUNKS_Z * CHUNK_SIZE; z += 89) {
+      int top = MAP_CHUNKS_Y * CHUNK_SIZE;
+      int floor_y = one.g.column_floor(x, top, z);
+      bool ok = floor_y >= 1 && one.g.get_voxel(x, 0, z) != VMAT_AIR &&
+                one.g.get_voxel(x, floor_y - 1, z) != VMAT_AIR &&
+                (floor_y == top || one.g.get_voxel(x, floor_y, z) == VMAT_AIR);
+      bad_columns += !ok;
+    }
+  }
+  CHECK(bad_columns == 0);
+
+  TerrainParams reseeded;
+  reseeded.seed = 1815;
+  REQUIRE(other.g.generate_terrain(reseeded, 1));
+  CHECK_FALSE(same_terrain(one.g, other.g));
+}
+
+// ── M13.10: Terrain Heightmap ──────────────────────────────────
+
+static int heightmap_mismatches(const TerrainHeightmap &hm, const VoxelGrid &g,
+                                int span) {
+  int mismatches = 0;
+  for (int z = 0; z < span; z++)
+    for (int x = 0; x < span; x++)
+      mismatches += (hm.height[z * HEIGHTMAP_WIDTH + x] !=
+                     g.column_floor(x, MAP_CHUNKS_Y * CHUNK_SIZE, z));
+  return mismatches;
+}
+
+TEST_CASE("Cat8: Heightmap tracks craters through dirty_height") {
+  VoxelTestGrid vt;
+  VoxelGrid &g = vt.g;
+  constexpr int SPAN = 3 * CHUNK_SIZE;
+  fill_city(g, SPAN);
+
+  TerrainHeightmap hm = {};
+  hm.allocate();
+  hm.rebuild(g);
+  CHECK(heightmap_mismatches(hm, g, SPAN + CHUNK_SIZE) == 0);
+  for (uint32_t i = 2; i < g.active_chunk_count; i++) {
+    CHECK(g.chunk_pool[i].dirty_height == 0);
+    CHECK(g.chunk_pool[i].dirty_flow == 1); // The flow field's, untouched
+  }
+
+  // Blast through the roofs: only the touched chunk columns go dirty
+  const float bx = 20.0f - VOXEL_WORLD_OFFSET;
+  const float bz = 20.0f - VOXEL_WORLD_OFFSET;
+  musket::destroy_sphere(g, bx, 40.0f, bz, 6.0f);
+  CHECK(heightmap_mismatches(hm, g, SPAN) > 0);
+
+  // A refresh away from the blast leaves the stale columns alone
+  hm.refresh(g, 2, 2, 3, 3);
+  CHECK(heightmap_mismatches(hm, g, SPAN) > 0);
+
+  hm.refresh(g, 0, 0, 2, 2);
+  CHECK(heightmap_mismatches(hm, g, SPAN) == 0);
+  CHECK(hm.surface(bx, bz) < 40.0f);
+  hm.release();
+}
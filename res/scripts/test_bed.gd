@@ -30,6 +30,7 @@ var last_l := false
 var last_c := false
 var last_v := false
 var last_s := false
+var last_t := false
 var blue_limbered := false
 var scale_spawned := false
 
@@ -64,6 +65,7 @@ func _ready() -> void:
 	server.spawn_test_cavalry(CAVALRY_COUNT, CAVALRY_POS.x, CAVALRY_POS.z, 0)
 
 	# ── Legacy MultiMesh (hidden by default) ──
+	server.set_legacy_sync(use_legacy)  # Repack runs only while shown
 	legacy_mm_instance = MultiMeshInstance3D.new()
 	var legacy_mm := MultiMesh.new()
 	legacy_mm.transform_format = MultiMesh.TRANSFORM_3D
@@ -96,6 +98,7 @@ func _ready() -> void:
 	print("  [B] France artillery [N] Russia artillery")
 	print("  [L] Toggle limber    [C] Cavalry charge!")
 	print("  [V] Toggle legacy/battalion rendering")
+	print("  [T] Toggle simulation thread")
 	print("  [1] March z+50  [2] March z-50  [3] Halt")
 	print("  [S] SCALE TEST — spawn 5,000+ units")
 	print("  ── M7.5: Fire Discipline (bat 0) ──")
@@ -176,11 +179,19 @@ func _process(delta: float) -> void:
 	if v_now and not last_v:
 		use_legacy = not use_legacy
 		legacy_mm_instance.visible = use_legacy
+		server.set_legacy_sync(use_legacy)
 		for mmi in battalion_mms.values():
 			mmi.visible = not use_legacy
 		print("[RENDER] Mode: %s" % ("LEGACY" if use_legacy else "BATTALION"))
 	last_v = v_now
 
+	# ── Input: toggle simulation thread ──
+	var t_now := Input.is_physical_key_pressed(KEY_T)
+	if t_now and not last_t:
+		server.set_threaded_simulation(not server.is_threaded_simulation())
+		print("[SIM] Thread: %s" % ("ON" if server.is_threaded_simulation() else "OFF"))
+	last_t = t_now
+
 	# ── Input: march ──
 	if Input.is_physical_key_pressed(KEY_1):
 		server.order_march(0.0, 50.0)
@@ -216,10 +227,12 @@ func _process(delta: float) -> void:
 
 	# ═══════════════════════════════════════════════════════════
 	# RENDERING: Battalion path (new — O(B) where B=battalions)
+	# Only battalions that changed since their last upload; a line at
+	# rest is skipped entirely
 	# ═══════════════════════════════════════════════════════════
 	if not use_legacy:
-		var active_bats = server.get_active_battalions()
-		for bat_id in active_bats:
+		var dirty_bats = server.get_dirty_battalions()
+		for bat_id in dirty_bats:
 			var inst_count = server.get_battalion_instance_count(bat_id)
 			if inst_count == 0:
 				continue
@@ -236,6 +249,7 @@ func _process(delta: float) -> void:
 				mm.instance_count = inst_count
 
 			# ONE bulk upload — zero-copy from C++ shadow buffer
+			# (fetching it acknowledges the dirty range)
 			var buffer = server.get_battalion_buffer(bat_id)
 			if buffer.size() > 0:
 				RenderingServer.multimesh_set_buffer(mm.get_rid(), buffer)